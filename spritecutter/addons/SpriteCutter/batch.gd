@@ -0,0 +1,74 @@
+extends SceneTree
+
+# Slices sprite sheets without opening the editor.
+#
+# godot --headless --path spritecutter --script res://addons/SpriteCutter/batch.gd -- [options] <dir|glob|file>...
+#
+#   --jobs N        Images sliced in parallel (default: one per core)
+#   --format F      json (default), tres or res (binary SpriteCutterRegionSet)
+#   --out DIR       Output folder (default: next to each image)
+#   --threshold T   Alpha threshold 0-255, pixels above it are opaque (default: 0)
+#   --recursive     Scan directories recursively
+#   --pack          Also repack the sprites of each sheet into <name>.packed.png
+#   --padding P     Pixels between repacked sprites (default: 2)
+#   --dedupe M      exact or near: mark frames repeating an earlier one, across every sheet
+
+func _usage():
+    print("usage: godot --headless --script res://addons/SpriteCutter/batch.gd -- [--jobs N] [--format json|tres|res] [--out DIR] [--threshold T] [--recursive] [--pack] [--padding P] [--dedupe exact|near] <dir|glob|file>...")
+
+func _init():
+    var args := OS.get_cmdline_user_args()
+    var batch := SpriteCutterBatch.new()
+    var inputs := PackedStringArray()
+
+    var i := 0
+    while i < args.size():
+        var arg := args[i]
+        var has_value := i + 1 < args.size()
+        if arg == "--jobs" and has_value:
+            i += 1
+            batch.jobs = args[i].to_int()
+        elif arg == "--format" and has_value:
+            i += 1
+            batch.output_format = args[i]
+        elif arg == "--out" and has_value:
+            i += 1
+            batch.output_dir = args[i]
+        elif arg == "--threshold" and has_value:
+            i += 1
+            batch.alpha_threshold = args[i].to_int()
+        elif arg == "--recursive":
+            batch.recursive = true
+        elif arg == "--pack":
+            batch.pack = true
+        elif arg == "--padding" and has_value:
+            i += 1
+            batch.pack_padding = args[i].to_int()
+        elif arg == "--dedupe" and has_value:
+            i += 1
+            var modes := ["off", "exact", "near"]
+            if not modes.has(args[i]):
+                printerr("unknown dedupe mode: ", args[i])
+                _usage()
+                quit(2)
+                return
+            batch.dedupe = modes.find(args[i])
+        elif arg.begins_with("--"):
+            printerr("unknown option: ", arg)
+            _usage()
+            quit(2)
+            return
+        else:
+            inputs.append(arg)
+        i += 1
+
+    if inputs.is_empty():
+        _usage()
+        quit(2)
+        return
+
+    var stats := batch.run(inputs)
+    if stats.is_empty() or stats.images == 0:
+        quit(1)
+        return
+    quit(1 if stats.failed > 0 else 0)
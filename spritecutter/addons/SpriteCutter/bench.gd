@@ -0,0 +1,91 @@
+extends SceneTree
+
+# Times each slicing stage on the project's sheets and on synthetic ones.
+#
+# godot --headless --path spritecutter --script res://addons/SpriteCutter/bench.gd -- [options]
+#
+#   --iterations N    Runs per case, the median is reported (default: 5)
+#   --assets DIR      Real sheets to time, "none" to skip (default: res://assets)
+#   --suite S         Synthetic suite: quick (default), full (adds 8k and 16k) or none
+#   --size WxH        A single custom sheet instead of the suite, with
+#   --sprites N --shape rect|disc|blob|mixed --specks N --gap N --seed N
+#   --out FILE        Save the results as JSON
+#   --compare FILE    Flag stages slower than a saved result file, exit 1 on regression
+#   --tolerance F     Allowed slowdown before flagging, 0.1 = 10% (default)
+#
+# Under --headless textures can't be read back, the fetch stage then copies the
+# source image instead. The populate stage needs the editor classes and is skipped.
+
+func _usage():
+    print("usage: godot --headless --script res://addons/SpriteCutter/bench.gd -- [--iterations N] [--assets DIR|none] [--suite quick|full|none] [--size WxH --sprites N --shape S --specks N --gap N --seed N] [--out FILE] [--compare FILE] [--tolerance F]")
+
+func _init():
+    var args := OS.get_cmdline_user_args()
+    var bench := SpriteCutterBenchmark.new()
+    var assets := "res://assets"
+    var suite := "quick"
+    var custom := {}
+    var out := ""
+    var baseline := ""
+    var tolerance := 0.1
+
+    var i := 0
+    while i < args.size():
+        var arg := args[i]
+        if i + 1 >= args.size():
+            _usage()
+            quit(2)
+            return
+        var value := args[i + 1]
+        match arg:
+            "--iterations": bench.iterations = value.to_int()
+            "--assets": assets = value
+            "--suite": suite = value
+            "--size":
+                var size := value.split("x")
+                if size.size() != 2:
+                    _usage()
+                    quit(2)
+                    return
+                custom.width = size[0].to_int()
+                custom.height = size[1].to_int()
+            "--sprites": custom.sprites = value.to_int()
+            "--shape": custom.shape = value
+            "--specks": custom.specks = value.to_int()
+            "--gap": custom.gap = value.to_int()
+            "--seed": custom.seed = value.to_int()
+            "--out": out = value
+            "--compare": baseline = value
+            "--tolerance": tolerance = value.to_float()
+            _:
+                printerr("unknown option: ", arg)
+                _usage()
+                quit(2)
+                return
+        i += 2
+
+    var files := PackedStringArray()
+    if assets != "none":
+        files = SpriteCutterBatch.new().collect_inputs(PackedStringArray([assets]))
+
+    var sheets := []
+    if not custom.is_empty():
+        sheets.append(custom)
+    elif suite == "quick" or suite == "full":
+        sheets = bench.get_standard_sheets(suite == "full")
+    elif suite != "none":
+        printerr("unknown suite: ", suite)
+        quit(2)
+        return
+
+    var results := bench.run(files, sheets)
+    if out != "" and not SpriteCutterBenchmark.save_results(results, out):
+        quit(2)
+        return
+
+    if baseline != "":
+        var regressions := SpriteCutterBenchmark.compare(results, baseline, tolerance)
+        if regressions != 0:
+            quit(1 if regressions > 0 else 2)
+            return
+    quit(0)
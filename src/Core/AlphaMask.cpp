@@ -0,0 +1,351 @@
+#include "AlphaMask.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SC_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#else
+#define SC_X86 0
+#endif
+
+// MSVC compiles any intrinsic without extra flags, GCC/Clang need a per-function target
+#if defined(_MSC_VER) && !defined(__clang__)
+#define SC_TARGET(x)
+#else
+#define SC_TARGET(x) __attribute__((target(x)))
+#endif
+
+namespace spritecutter {
+
+    namespace {
+        // Threshold in both integer and normalized float form
+        struct Threshold {
+            uint8_t u8;
+            float f;
+        };
+
+        float half_to_float(uint16_t h) {
+            uint32_t sign = uint32_t(h & 0x8000) << 16;
+            uint32_t exp = (h >> 10) & 0x1F;
+            uint32_t mant = h & 0x3FF;
+            uint32_t bits;
+
+            if (exp == 0) {
+                if (mant == 0) {
+                    bits = sign;
+                } else {
+                    // Subnormal: renormalize
+                    exp = 127 - 15 + 1;
+                    while (!(mant & 0x400)) {
+                        mant <<= 1;
+                        --exp;
+                    }
+                    bits = sign | (exp << 23) | ((mant & 0x3FF) << 13);
+                }
+            } else if (exp == 0x1F) {
+                bits = sign | 0x7F800000 | (mant << 13);
+            } else {
+                bits = sign | ((exp + 127 - 15) << 23) | (mant << 13);
+            }
+
+            float f;
+            memcpy(&f, &bits, sizeof(f));
+            return f;
+        }
+
+        // Alpha read kernels, one per pixel layout. `STRIDE` is the pixel size in bytes
+        // and `above()` tells whether the pixel at `p` has its alpha above the threshold.
+
+        // 8-bit channel formats (LA8, RGBA8)
+        template <int Stride, int AlphaOffset>
+        struct AlphaU8 {
+            static constexpr size_t STRIDE = Stride;
+            static bool above(const uint8_t* p, const Threshold& t) { return p[AlphaOffset] > t.u8; }
+        };
+
+        // 4-bit packed RGBA4444, alpha lives in the low nibble of a little-endian uint16
+        struct AlphaRGBA4444 {
+            static constexpr size_t STRIDE = 2;
+            static bool above(const uint8_t* p, const Threshold& t) { return (p[0] & 0x0F) * 17 > t.u8; }
+        };
+
+        // Half-float channel formats (RGBAH)
+        template <int Stride, int AlphaOffset>
+        struct AlphaHalf {
+            static constexpr size_t STRIDE = Stride;
+            static bool above(const uint8_t* p, const Threshold& t) {
+                uint16_t h;
+                memcpy(&h, p + AlphaOffset, sizeof(h));
+                return half_to_float(h) > t.f;
+            }
+        };
+
+        // Float channel formats (RGBAF)
+        template <int Stride, int AlphaOffset>
+        struct AlphaFloat {
+            static constexpr size_t STRIDE = Stride;
+            static bool above(const uint8_t* p, const Threshold& t) {
+                float a;
+                memcpy(&a, p + AlphaOffset, sizeof(a));
+                return a > t.f;
+            }
+        };
+
+        // Formats without an alpha channel: every pixel reads back with alpha = 1
+        struct AlphaNone {
+            static constexpr size_t STRIDE = 0;
+            static bool above(const uint8_t*, const Threshold& t) { return t.u8 < 255; }
+        };
+
+        // Packs pixels [x, w) of one row with the scalar kernel. `dst` must be zeroed.
+        template <typename Kernel>
+        void pack_row_scalar(const uint8_t* src, int x, int w, const Threshold& t, uint64_t* dst) {
+            for (; x < w; ++x) {
+                if (Kernel::above(src + size_t(x) * Kernel::STRIDE, t))
+                    dst[x >> 6] |= uint64_t(1) << (x & 63);
+            }
+        }
+
+#if SC_X86
+        // RGBA8, 16 pixels per step: isolate alpha bytes, pack them down and compare
+        SC_TARGET("sse2")
+        void pack_row_rgba8_sse2(const uint8_t* src, int w, const Threshold& t, uint64_t* dst) {
+            // Unsigned compare through the signed one: flip the sign bit on both sides
+            const __m128i bias = _mm_set1_epi8(char(0x80));
+            const __m128i thr = _mm_set1_epi8(char(t.u8 ^ 0x80));
+
+            int x = 0;
+            for (; x + 16 <= w; x += 16) {
+                const __m128i* p = reinterpret_cast<const __m128i*>(src + size_t(x) * 4);
+                __m128i a0 = _mm_srli_epi32(_mm_loadu_si128(p + 0), 24);
+                __m128i a1 = _mm_srli_epi32(_mm_loadu_si128(p + 1), 24);
+                __m128i a2 = _mm_srli_epi32(_mm_loadu_si128(p + 2), 24);
+                __m128i a3 = _mm_srli_epi32(_mm_loadu_si128(p + 3), 24);
+                __m128i a = _mm_packus_epi16(_mm_packs_epi32(a0, a1), _mm_packs_epi32(a2, a3));
+
+                __m128i gt = _mm_cmpgt_epi8(_mm_xor_si128(a, bias), thr);
+                uint64_t m = uint32_t(_mm_movemask_epi8(gt));
+                dst[x >> 6] |= m << (x & 63);
+            }
+            pack_row_scalar<AlphaU8<4, 3>>(src, x, w, t, dst);
+        }
+
+        // LA8, 16 pixels per step
+        SC_TARGET("sse2")
+        void pack_row_la8_sse2(const uint8_t* src, int w, const Threshold& t, uint64_t* dst) {
+            const __m128i bias = _mm_set1_epi8(char(0x80));
+            const __m128i thr = _mm_set1_epi8(char(t.u8 ^ 0x80));
+
+            int x = 0;
+            for (; x + 16 <= w; x += 16) {
+                const __m128i* p = reinterpret_cast<const __m128i*>(src + size_t(x) * 2);
+                __m128i a0 = _mm_srli_epi16(_mm_loadu_si128(p + 0), 8);
+                __m128i a1 = _mm_srli_epi16(_mm_loadu_si128(p + 1), 8);
+                __m128i a = _mm_packus_epi16(a0, a1);
+
+                __m128i gt = _mm_cmpgt_epi8(_mm_xor_si128(a, bias), thr);
+                uint64_t m = uint32_t(_mm_movemask_epi8(gt));
+                dst[x >> 6] |= m << (x & 63);
+            }
+            pack_row_scalar<AlphaU8<2, 1>>(src, x, w, t, dst);
+        }
+
+        // RGBA8, 32 pixels per step. The in-lane packs leave 4-pixel groups interleaved
+        // across the two 128-bit lanes, the final permute puts them back in order.
+        SC_TARGET("avx2")
+        void pack_row_rgba8_avx2(const uint8_t* src, int w, const Threshold& t, uint64_t* dst) {
+            const __m256i bias = _mm256_set1_epi8(char(0x80));
+            const __m256i thr = _mm256_set1_epi8(char(t.u8 ^ 0x80));
+            const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+            int x = 0;
+            for (; x + 32 <= w; x += 32) {
+                const __m256i* p = reinterpret_cast<const __m256i*>(src + size_t(x) * 4);
+                __m256i a0 = _mm256_srli_epi32(_mm256_loadu_si256(p + 0), 24);
+                __m256i a1 = _mm256_srli_epi32(_mm256_loadu_si256(p + 1), 24);
+                __m256i a2 = _mm256_srli_epi32(_mm256_loadu_si256(p + 2), 24);
+                __m256i a3 = _mm256_srli_epi32(_mm256_loadu_si256(p + 3), 24);
+                __m256i a = _mm256_packus_epi16(_mm256_packs_epi32(a0, a1), _mm256_packs_epi32(a2, a3));
+                a = _mm256_permutevar8x32_epi32(a, order);
+
+                __m256i gt = _mm256_cmpgt_epi8(_mm256_xor_si256(a, bias), thr);
+                uint64_t m = uint32_t(_mm256_movemask_epi8(gt));
+                dst[x >> 6] |= m << (x & 63);
+            }
+            pack_row_scalar<AlphaU8<4, 3>>(src, x, w, t, dst);
+        }
+
+        // LA8, 32 pixels per step
+        SC_TARGET("avx2")
+        void pack_row_la8_avx2(const uint8_t* src, int w, const Threshold& t, uint64_t* dst) {
+            const __m256i bias = _mm256_set1_epi8(char(0x80));
+            const __m256i thr = _mm256_set1_epi8(char(t.u8 ^ 0x80));
+
+            int x = 0;
+            for (; x + 32 <= w; x += 32) {
+                const __m256i* p = reinterpret_cast<const __m256i*>(src + size_t(x) * 2);
+                __m256i a0 = _mm256_srli_epi16(_mm256_loadu_si256(p + 0), 8);
+                __m256i a1 = _mm256_srli_epi16(_mm256_loadu_si256(p + 1), 8);
+                __m256i a = _mm256_packus_epi16(a0, a1);
+                a = _mm256_permute4x64_epi64(a, _MM_SHUFFLE(3, 1, 2, 0));
+
+                __m256i gt = _mm256_cmpgt_epi8(_mm256_xor_si256(a, bias), thr);
+                uint64_t m = uint32_t(_mm256_movemask_epi8(gt));
+                dst[x >> 6] |= m << (x & 63);
+            }
+            pack_row_scalar<AlphaU8<2, 1>>(src, x, w, t, dst);
+        }
+#endif
+
+        typedef void (*PackRowFn)(const uint8_t* src, int w, const Threshold& t, uint64_t* dst);
+
+        template <typename Kernel>
+        void pack_row(const uint8_t* src, int w, const Threshold& t, uint64_t* dst) {
+            pack_row_scalar<Kernel>(src, 0, w, t, dst);
+        }
+
+        // Picks the row packer for a format and instruction set
+        bool select_packer(PixelFormat format, AlphaMask::Isa isa, PackRowFn& fn) {
+            switch (format) {
+                case FORMAT_LA8:
+                    fn = pack_row<AlphaU8<2, 1>>;
+#if SC_X86
+                    if (isa == AlphaMask::ISA_AVX2) fn = pack_row_la8_avx2;
+                    else if (isa == AlphaMask::ISA_SSE2) fn = pack_row_la8_sse2;
+#endif
+                    return true;
+
+                case FORMAT_RGBA8:
+                    fn = pack_row<AlphaU8<4, 3>>;
+#if SC_X86
+                    if (isa == AlphaMask::ISA_AVX2) fn = pack_row_rgba8_avx2;
+                    else if (isa == AlphaMask::ISA_SSE2) fn = pack_row_rgba8_sse2;
+#endif
+                    return true;
+
+                case FORMAT_RGBA4444: fn = pack_row<AlphaRGBA4444>;      return true;
+                case FORMAT_RGBAH:    fn = pack_row<AlphaHalf<8, 6>>;    return true;
+                case FORMAT_RGBAF:    fn = pack_row<AlphaFloat<16, 12>>; return true;
+                case FORMAT_OPAQUE:   fn = pack_row<AlphaNone>;          return true;
+
+                default:
+                    return false;
+            }
+        }
+
+        // -1 until the first call to get_isa(). Atomic: worker threads read it while building
+        // masks, and set_isa() may run meanwhile. Each build reads it once.
+        std::atomic<int> active_isa{ -1 };
+    }
+
+    AlphaMask::Isa AlphaMask::detect_isa() {
+#if SC_X86
+#if defined(_MSC_VER) && !defined(__clang__)
+        int info[4];
+        __cpuid(info, 0);
+        int max_leaf = info[0];
+
+        __cpuid(info, 1);
+        bool sse2 = (info[3] & (1 << 26)) != 0;
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool avx = (info[2] & (1 << 28)) != 0;
+
+        bool avx2 = false;
+        if (max_leaf >= 7 && osxsave && avx) {
+            // The OS must save the YMM registers on context switch
+            bool ymm_enabled = (_xgetbv(0) & 0x6) == 0x6;
+            __cpuidex(info, 7, 0);
+            avx2 = ymm_enabled && (info[1] & (1 << 5)) != 0;
+        }
+
+        if (avx2) return ISA_AVX2;
+        if (sse2) return ISA_SSE2;
+#else
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) return ISA_AVX2;
+        if (__builtin_cpu_supports("sse2")) return ISA_SSE2;
+#endif
+#endif
+        return ISA_SCALAR;
+    }
+
+    AlphaMask::Isa AlphaMask::get_isa() {
+        int isa = active_isa.load(std::memory_order_relaxed);
+        if (isa >= 0) return Isa(isa);
+
+        // A set_isa() racing the first call wins over detection
+        int detected = int(detect_isa());
+        if (active_isa.compare_exchange_strong(isa, detected, std::memory_order_relaxed)) return Isa(detected);
+        return Isa(isa);
+    }
+
+    void AlphaMask::set_isa(Isa isa) {
+        active_isa.store(std::min(int(isa), int(detect_isa())), std::memory_order_relaxed);
+    }
+
+    int AlphaMask::ctz(uint64_t v) {
+#if defined(_MSC_VER) && !defined(__clang__) && defined(_M_X64)
+        unsigned long idx;
+        _BitScanForward64(&idx, v);
+        return int(idx);
+#elif defined(_MSC_VER) && !defined(__clang__)
+        unsigned long idx;
+        if (_BitScanForward(&idx, uint32_t(v))) return int(idx);
+        _BitScanForward(&idx, uint32_t(v >> 32));
+        return int(idx) + 32;
+#else
+        return __builtin_ctzll(v);
+#endif
+    }
+
+    int AlphaMask::clz(uint64_t v) {
+#if defined(_MSC_VER) && !defined(__clang__) && defined(_M_X64)
+        unsigned long idx;
+        _BitScanReverse64(&idx, v);
+        return 63 - int(idx);
+#elif defined(_MSC_VER) && !defined(__clang__)
+        unsigned long idx;
+        if (_BitScanReverse(&idx, uint32_t(v >> 32))) return 31 - int(idx);
+        _BitScanReverse(&idx, uint32_t(v));
+        return 63 - int(idx);
+#else
+        return __builtin_clzll(v);
+#endif
+    }
+
+    void AlphaMask::reset(int w, int h) {
+        width = w;
+        height = h;
+        words_per_row = (w + 63) >> 6;
+        bits.assign(size_t(words_per_row) * size_t(h), 0);
+    }
+
+    bool AlphaMask::build(const PixelView& pixels, uint8_t threshold) {
+        if (pixels.width < 0 || pixels.height < 0) return false;
+        reset(pixels.width, pixels.height);
+        return build_rows(pixels, 0, threshold);
+    }
+
+    bool AlphaMask::build_rows(const PixelView& pixels, int y0, uint8_t threshold) {
+        PackRowFn pack = nullptr;
+        if (pixels.width != width || pixels.height < 0 || y0 < 0 || pixels.height > height - y0)
+            return false;
+        if (!select_packer(pixels.format, get_isa(), pack)) return false;
+        if (pixels.height > 0 && pixels.format != FORMAT_OPAQUE) {
+            if (!pixels.data || pixels.row_pitch < size_t(pixels.width) * pixel_size(pixels.format))
+                return false;
+        }
+
+        Threshold t{ threshold, float(threshold) / 255.0f };
+        for (int y = 0; y < pixels.height; ++y) {
+            pack(pixels.format == FORMAT_OPAQUE ? nullptr : pixels.row(y), width, t, get_row(y0 + y));
+        }
+        return true;
+    }
+}
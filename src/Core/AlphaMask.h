@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "PixelView.h"
+
+namespace spritecutter {
+
+    /**
+     * @brief Bit-packed occupancy mask of an image, one bit per pixel.
+     *
+     * A pixel is set when its alpha is strictly above the threshold (0-255 scale).
+     *
+     * Rows are stored as 64-bit words, bit `x & 63` of word `x >> 6`, so empty rows
+     *
+     * and runs can be skipped with word compares and bit scans.
+     *
+     * The 8-bit alpha formats are packed with SSE2 or AVX2 when the CPU supports it,
+     *
+     * every other layout goes through a scalar kernel.
+     */
+    class AlphaMask {
+        public:
+            /**
+             * @brief Instruction set used to pack the mask.
+             */
+            enum Isa {
+                ISA_SCALAR,
+                ISA_SSE2,
+                ISA_AVX2,
+            };
+
+            /**
+             * @brief Returns the best instruction set supported by the running CPU.
+             */
+            static Isa detect_isa();
+
+            /**
+             * @brief Returns the instruction set `build()` will use.
+             *
+             * Defaults to detect_isa() unless overridden with set_isa().
+             */
+            static Isa get_isa();
+
+            /**
+             * @brief Forces the instruction set used by `build()`.
+             *
+             * Requests above what the CPU supports are clamped to detect_isa(). Safe to call
+             * while other threads build masks, each build uses the value it read on entry.
+             */
+            static void set_isa(Isa isa);
+
+            /**
+             * @brief Packs the alpha channel of a pixel buffer into the mask.
+             *
+             * @param pixels The pixels to read. Rows must hold at least `width` pixels.
+             * @param threshold Pixels with alpha strictly above this value are set.
+             * @return false if the view is malformed.
+             */
+            bool build(const PixelView& pixels, uint8_t threshold = 0);
+
+            /**
+             * @brief Packs a strip of rows into a mask sized by reset().
+             *
+             * Lets a decoder fill the mask as rows come, without a full-size pixel buffer.
+             *
+             * @param pixels The rows to read, `get_width()` pixels wide.
+             * @param y0 Row of the mask the first row of `pixels` goes to.
+             * @param threshold Pixels with alpha strictly above this value are set.
+             * @return false if the view is malformed or doesn't fit the mask.
+             */
+            bool build_rows(const PixelView& pixels, int y0, uint8_t threshold = 0);
+
+            /**
+             * @brief Resizes and zeroes the word storage for a `w` x `h` mask.
+             */
+            void reset(int w, int h);
+
+            int get_width() const { return width; }
+            int get_height() const { return height; }
+            int get_words_per_row() const { return words_per_row; }
+
+            const uint64_t* get_row(int y) const { return bits.data() + size_t(y) * words_per_row; }
+            uint64_t* get_row(int y) { return bits.data() + size_t(y) * words_per_row; }
+
+            bool is_set(int x, int y) const { return (get_row(y)[x >> 6] >> (x & 63)) & 1; }
+            void clear(int x, int y) { get_row(y)[x >> 6] &= ~(uint64_t(1) << (x & 63)); }
+
+            /**
+             * @brief Returns the index of the lowest set bit. `v` must not be 0.
+             */
+            static int ctz(uint64_t v);
+
+            /**
+             * @brief Returns the number of leading zero bits. `v` must not be 0.
+             */
+            static int clz(uint64_t v);
+
+        private:
+            int width = 0;
+            int height = 0;
+            int words_per_row = 0;
+
+            // Row-major bit storage, words_per_row words per row
+            std::vector<uint64_t> bits;
+    };
+}
@@ -0,0 +1,313 @@
+#include "AtlasPacker.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+namespace spritecutter {
+
+    namespace {
+        struct Rect {
+            int x, y, w, h;
+        };
+
+        // Atlas widths tried per heuristic, as multiples of the square root of the area
+        constexpr float WIDTH_FACTORS[] = { 1.0f, 1.1f, 1.25f, 1.5f, 2.0f };
+        constexpr int WIDTH_COUNT = int(sizeof(WIDTH_FACTORS) / sizeof(WIDTH_FACTORS[0]));
+
+        bool contains(const Rect& outer, const Rect& inner) {
+            return inner.x >= outer.x && inner.y >= outer.y
+                && inner.x + inner.w <= outer.x + outer.w && inner.y + inner.h <= outer.y + outer.h;
+        }
+
+        bool intersects(const Rect& a, const Rect& b) {
+            return a.x < b.x + b.w && b.x < a.x + a.w && a.y < b.y + b.h && b.y < a.y + a.h;
+        }
+
+        /**
+         * @brief Free rectangles of a bin, split around each placed sprite.
+         */
+        class MaxRectsBin {
+            public:
+                MaxRectsBin(int width, int height) { free.push_back({ 0, 0, width, height }); }
+
+                /**
+                 * @brief Finds the best free spot for a `w` x `h` rectangle and takes it.
+                 */
+                bool place(int w, int h, PackHeuristic heuristic, bool rotate, int& x, int& y, bool& rotated) {
+                    long long best_primary = LLONG_MAX, best_secondary = LLONG_MAX;
+                    Rect best{ 0, 0, 0, 0 };
+                    bool best_rotated = false;
+
+                    for (const Rect& f : free) {
+                        for (int turn = 0; turn < (rotate ? 2 : 1); ++turn) {
+                            int rw = turn ? h : w, rh = turn ? w : h;
+                            if (rw > f.w || rh > f.h) continue;
+
+                            long long primary, secondary;
+                            int left_w = f.w - rw, left_h = f.h - rh;
+                            switch (heuristic) {
+                                case PACK_MAXRECTS_AREA:
+                                    primary = (long long)f.w * f.h - (long long)rw * rh;
+                                    secondary = std::min(left_w, left_h);
+                                    break;
+                                case PACK_MAXRECTS_BOTTOM_LEFT:
+                                    primary = f.y + rh;
+                                    secondary = f.x;
+                                    break;
+                                default:
+                                    primary = std::min(left_w, left_h);
+                                    secondary = std::max(left_w, left_h);
+                                    break;
+                            }
+                            if (primary < best_primary || (primary == best_primary && secondary < best_secondary)) {
+                                best_primary = primary;
+                                best_secondary = secondary;
+                                best = { f.x, f.y, rw, rh };
+                                best_rotated = turn == 1;
+                            }
+                        }
+                    }
+                    if (best_primary == LLONG_MAX) return false;
+
+                    split(best);
+                    x = best.x;
+                    y = best.y;
+                    rotated = best_rotated;
+                    return true;
+                }
+
+            private:
+                /**
+                 * @brief Cuts the free rectangles overlapping `used` into what's left around it.
+                 */
+                void split(const Rect& used) {
+                    std::vector<Rect> added;
+                    for (size_t i = 0; i < free.size();) {
+                        Rect f = free[i];
+                        if (!intersects(f, used)) {
+                            ++i;
+                            continue;
+                        }
+                        if (used.x > f.x) added.push_back({ f.x, f.y, used.x - f.x, f.h });
+                        if (used.x + used.w < f.x + f.w) added.push_back({ used.x + used.w, f.y, f.x + f.w - used.x - used.w, f.h });
+                        if (used.y > f.y) added.push_back({ f.x, f.y, f.w, used.y - f.y });
+                        if (used.y + used.h < f.y + f.h) added.push_back({ f.x, used.y + used.h, f.w, f.y + f.h - used.y - used.h });
+                        free[i] = free.back();
+                        free.pop_back();
+                    }
+
+                    // The list was already pruned, so only the new pieces can be redundant
+                    size_t kept = free.size();
+                    for (size_t i = 0; i < added.size(); ++i) {
+                        bool redundant = false;
+                        for (size_t j = 0; j < kept && !redundant; ++j) redundant = contains(free[j], added[i]);
+                        for (size_t j = 0; j < added.size() && !redundant; ++j) {
+                            if (j == i || !contains(added[j], added[i])) continue;
+                            // Of two equal pieces, keep the first
+                            redundant = !contains(added[i], added[j]) || j < i;
+                        }
+                        if (!redundant) free.push_back(added[i]);
+                    }
+                }
+
+                std::vector<Rect> free;
+        };
+
+        /**
+         * @brief Top edge of the placed sprites, as horizontal segments from left to right.
+         */
+        class SkylineBin {
+            public:
+                SkylineBin(int p_width, int p_height) : width(p_width), height(p_height) { nodes.push_back({ 0, 0, p_width }); }
+
+                bool place(int w, int h, bool rotate, int& x, int& y, bool& rotated) {
+                    int best_top = INT_MAX, best_x = INT_MAX, best_index = -1, best_y = 0;
+                    bool best_rotated = false;
+
+                    for (int turn = 0; turn < (rotate ? 2 : 1); ++turn) {
+                        int rw = turn ? h : w, rh = turn ? w : h;
+                        for (size_t i = 0; i < nodes.size(); ++i) {
+                            int top;
+                            if (!fits(i, rw, rh, top)) continue;
+                            if (top + rh < best_top || (top + rh == best_top && nodes[i].x < best_x)) {
+                                best_top = top + rh;
+                                best_x = nodes[i].x;
+                                best_y = top;
+                                best_index = int(i);
+                                best_rotated = turn == 1;
+                            }
+                        }
+                    }
+                    if (best_index < 0) return false;
+
+                    int rw = best_rotated ? h : w, rh = best_rotated ? w : h;
+                    add(size_t(best_index), rw, best_y + rh);
+                    x = best_x;
+                    y = best_y;
+                    rotated = best_rotated;
+                    return true;
+                }
+
+            private:
+                struct Node {
+                    int x, y, w;
+                };
+
+                // Height a `w` wide sprite rests at when its left edge is on node `i`
+                bool fits(size_t i, int w, int h, int& top) const {
+                    int x = nodes[i].x;
+                    if (x + w > width) return false;
+                    top = 0;
+                    for (int left = w; left > 0 && i < nodes.size(); ++i) {
+                        top = std::max(top, nodes[i].y);
+                        if (top + h > height) return false;
+                        left -= nodes[i].w;
+                    }
+                    return true;
+                }
+
+                void add(size_t i, int w, int top) {
+                    Node node{ nodes[i].x, top, w };
+                    nodes.insert(nodes.begin() + i, node);
+
+                    // Trim or drop the segments the sprite now covers
+                    int end = node.x + node.w;
+                    size_t j = i + 1;
+                    while (j < nodes.size() && nodes[j].x < end) {
+                        int shrink = end - nodes[j].x;
+                        if (shrink >= nodes[j].w) {
+                            nodes.erase(nodes.begin() + j);
+                            continue;
+                        }
+                        nodes[j].x += shrink;
+                        nodes[j].w -= shrink;
+                        break;
+                    }
+
+                    // Neighbours at the same height become one segment
+                    for (size_t k = 0; k + 1 < nodes.size();) {
+                        if (nodes[k].y == nodes[k + 1].y) {
+                            nodes[k].w += nodes[k + 1].w;
+                            nodes.erase(nodes.begin() + k + 1);
+                        } else {
+                            ++k;
+                        }
+                    }
+                }
+
+                int width, height;
+                std::vector<Node> nodes;
+        };
+
+        bool better(const PackResult& a, const PackResult& b) {
+            long long area_a = (long long)a.width * a.height, area_b = (long long)b.width * b.height;
+            if (area_a != area_b) return area_a < area_b;
+            return std::max(a.width, a.height) < std::max(b.width, b.height);
+        }
+    }
+
+    bool pack_regions_with(const std::vector<Region>& regions, PackHeuristic heuristic, int width, const PackOptions& options, PackResult& result) {
+        int pad = std::max(0, options.padding);
+        result = PackResult();
+        result.heuristic = heuristic;
+        result.sprites.assign(regions.size(), PackedSprite{ 0, 0, false });
+
+        // Largest first: the skyline wants them tallest first, MaxRects longest side first
+        std::vector<int> order(regions.size());
+        std::iota(order.begin(), order.end(), 0);
+        bool skyline = heuristic == PACK_SKYLINE_BOTTOM_LEFT;
+        auto key = [&](int i) { return skyline ? regions[i].h : std::max(regions[i].w, regions[i].h); };
+        std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+            if (key(a) != key(b)) return key(a) > key(b);
+            return (long long)regions[a].w * regions[a].h > (long long)regions[b].w * regions[b].h;
+        });
+
+        // Every sprite reserves its padding on the right and below, the bin grows to match
+        int bin_w = width + pad, bin_h = options.max_side + pad;
+        MaxRectsBin maxrects(bin_w, bin_h);
+        SkylineBin skyline_bin(bin_w, bin_h);
+
+        for (int i : order) {
+            const Region& r = regions[i];
+            if (r.w <= 0 || r.h <= 0) continue;
+
+            int x, y;
+            bool rotated;
+            bool placed = skyline
+                ? skyline_bin.place(r.w + pad, r.h + pad, options.allow_rotation, x, y, rotated)
+                : maxrects.place(r.w + pad, r.h + pad, heuristic, options.allow_rotation, x, y, rotated);
+            if (!placed) return false;
+
+            result.sprites[i] = { x, y, rotated };
+            result.width = std::max(result.width, x + (rotated ? r.h : r.w));
+            result.height = std::max(result.height, y + (rotated ? r.w : r.h));
+            result.used_area += (long long)r.w * r.h;
+        }
+        return result.width <= options.max_side && result.height <= options.max_side;
+    }
+
+    bool pack_regions(const std::vector<Region>& regions, const PackOptions& options, PackResult& result, const ParallelFor& parallel_for) {
+        int pad = std::max(0, options.padding);
+        long long area = 0;
+        int narrowest = 1;
+        for (const Region& r : regions) {
+            if (r.w <= 0 || r.h <= 0) continue;
+            area += (long long)(r.w + pad) * (r.h + pad);
+            int side = options.allow_rotation ? std::min(r.w, r.h) : r.w;
+            narrowest = std::max(narrowest, side);
+        }
+        if (narrowest > options.max_side) return false;
+
+        // Each heuristic with each width, as independent tasks
+        int base = std::max(narrowest, (int)std::ceil(std::sqrt(double(area))));
+        std::vector<PackResult> results(size_t(PACK_HEURISTIC_COUNT) * WIDTH_COUNT);
+        std::vector<char> ok(results.size(), 0);
+        parallel_for((int)results.size(), [&](int job) {
+            PackHeuristic heuristic = PackHeuristic(job / WIDTH_COUNT);
+            int width = std::min(options.max_side, std::max(narrowest, int(base * WIDTH_FACTORS[job % WIDTH_COUNT])));
+            ok[job] = pack_regions_with(regions, heuristic, width, options, results[job]);
+        });
+
+        int best = -1;
+        for (int job = 0; job < (int)results.size(); ++job) {
+            if (ok[job] && (best < 0 || better(results[job], results[best]))) best = job;
+        }
+        if (best < 0) return false;
+
+        result = std::move(results[best]);
+        return true;
+    }
+
+    bool blit_packed(const PixelView& source, const std::vector<Region>& regions, const PackResult& result, std::vector<uint8_t>& rgba) {
+        if (source.format != FORMAT_RGBA8) return false;
+
+        size_t pitch = size_t(result.width) * 4;
+        rgba.assign(pitch * size_t(result.height), 0);
+
+        for (size_t i = 0; i < regions.size() && i < result.sprites.size(); ++i) {
+            const Region& r = regions[i];
+            const PackedSprite& s = result.sprites[i];
+            if (r.w <= 0 || r.h <= 0 || r.x < 0 || r.y < 0 || r.x + r.w > source.width || r.y + r.h > source.height) continue;
+
+            if (!s.rotated) {
+                for (int y = 0; y < r.h; ++y) {
+                    memcpy(&rgba[size_t(s.y + y) * pitch + size_t(s.x) * 4], source.row(r.y + y) + size_t(r.x) * 4, size_t(r.w) * 4);
+                }
+                continue;
+            }
+
+            // Turned clockwise: source row y becomes atlas column h - 1 - y
+            for (int y = 0; y < r.h; ++y) {
+                const uint8_t* src = source.row(r.y + y) + size_t(r.x) * 4;
+                int column = s.x + r.h - 1 - y;
+                for (int x = 0; x < r.w; ++x) {
+                    memcpy(&rgba[size_t(s.y + x) * pitch + size_t(column) * 4], src + size_t(x) * 4, 4);
+                }
+            }
+        }
+        return true;
+    }
+}
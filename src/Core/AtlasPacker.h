@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "ParallelFor.h"
+#include "PixelView.h"
+#include "SliceTypes.h"
+
+namespace spritecutter {
+
+    /**
+     * @brief Placement rules tried by pack_regions().
+     *
+     * The MaxRects variants keep every free rectangle and score each of them,
+     *
+     * the skyline only tracks the top edge of what was placed: faster, a bit less dense.
+     */
+    enum PackHeuristic {
+        // Free rectangle leaving the smallest leftover on its shorter side
+        PACK_MAXRECTS_SHORT_SIDE,
+        // Free rectangle with the smallest area
+        PACK_MAXRECTS_AREA,
+        // Lowest, then leftmost position
+        PACK_MAXRECTS_BOTTOM_LEFT,
+        // Lowest, then leftmost position on the skyline
+        PACK_SKYLINE_BOTTOM_LEFT,
+        PACK_HEURISTIC_COUNT,
+    };
+
+    struct PackOptions {
+        // Empty pixels between two sprites
+        int padding = 2;
+
+        // Sprites may be stored turned 90° clockwise when it packs tighter
+        bool allow_rotation = false;
+
+        // Largest width or height of the atlas
+        int max_side = 16384;
+    };
+
+    /**
+     * @brief Where a region lands in the packed atlas.
+     *
+     * A rotated sprite takes `h` x `w` pixels of the atlas, turned 90° clockwise.
+     */
+    struct PackedSprite {
+        int x, y;
+        bool rotated;
+    };
+
+    struct PackResult {
+        int width = 0;
+        int height = 0;
+
+        // Rule that gave the smallest atlas
+        PackHeuristic heuristic = PACK_MAXRECTS_SHORT_SIDE;
+
+        // One per region, in the order of the regions
+        std::vector<PackedSprite> sprites;
+
+        // Pixels covered by sprites, padding excluded
+        long long used_area = 0;
+
+        /**
+         * @brief Returns the share of the atlas covered by sprites, in [0, 1].
+         */
+        double get_fill_ratio() const {
+            long long area = (long long)width * height;
+            return area > 0 ? double(used_area) / double(area) : 0.0;
+        }
+    };
+
+    /**
+     * @brief Packs the regions' rectangles into the smallest atlas found.
+     *
+     * Every heuristic is tried with a few atlas widths around the square root of the
+     *
+     * total area, each combination as its own task. The smallest atlas wins, ties go to
+     *
+     * the squarer one then the first heuristic, so the result doesn't depend on scheduling.
+     *
+     * @param regions Rectangles to place, only `w` and `h` are read.
+     * @param options Padding, rotation and size limit.
+     * @param result Output placement.
+     * @param parallel_for Scheduler for the combinations.
+     * @return false if the regions don't fit in `max_side` x `max_side`.
+     */
+    bool pack_regions(const std::vector<Region>& regions, const PackOptions& options, PackResult& result, const ParallelFor& parallel_for = serial_for);
+
+    /**
+     * @brief Packs the regions with a single heuristic into a `width` wide strip.
+     *
+     * @param regions Rectangles to place, only `w` and `h` are read.
+     * @param heuristic Placement rule.
+     * @param width Width of the strip.
+     * @param options Padding, rotation and height limit.
+     * @param result Output placement.
+     * @return false if a region doesn't fit.
+     */
+    bool pack_regions_with(const std::vector<Region>& regions, PackHeuristic heuristic, int width, const PackOptions& options, PackResult& result);
+
+    /**
+     * @brief Copies each region of an RGBA8 image to its packed place.
+     *
+     * @param source RGBA8 pixels the regions were detected in.
+     * @param regions Regions given to pack_regions(), inside `source`.
+     * @param result Their placement.
+     * @param rgba Output atlas pixels, `result.width` x `result.height` RGBA8, transparent between sprites.
+     * @return false if `source` isn't RGBA8.
+     */
+    bool blit_packed(const PixelView& source, const std::vector<Region>& regions, const PackResult& result, std::vector<uint8_t>& rgba);
+}
@@ -0,0 +1,419 @@
+#include "BlockAlpha.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace spritecutter {
+
+    namespace {
+        // Interpolation weights of BC7 indices, out of 64
+        constexpr uint8_t BC7_WEIGHTS2[4] = { 0, 21, 43, 64 };
+        constexpr uint8_t BC7_WEIGHTS3[8] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+        constexpr uint8_t BC7_WEIGHTS4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+        // BC7 two-subset partitions, bit i is the subset of pixel i, and the anchor pixel of subset 1
+        constexpr uint16_t BC7_PARTITIONS2[64] = {
+            0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80,
+            0xC800, 0xFFEC, 0xFE80, 0xE800, 0xFFE8, 0xFF00, 0xFFF0, 0xF000,
+            0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310, 0x3100, 0x8CCE,
+            0x088C, 0x3110, 0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C,
+            0xAAAA, 0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696, 0xA55A,
+            0x73CE, 0x13C8, 0x324C, 0x3BDC, 0x6996, 0xC33C, 0x9966, 0x0660,
+            0x0272, 0x04E4, 0x4E40, 0x2720, 0xC936, 0x936C, 0x39C6, 0x639C,
+            0x9336, 0x9CC6, 0x817E, 0xE718, 0xCCF0, 0x0FCC, 0x7744, 0xEE22,
+        };
+        constexpr uint8_t BC7_ANCHORS2[64] = {
+            15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+            15, 2, 8, 2, 2, 8, 8, 15, 2, 8, 2, 2, 8, 8, 2, 2,
+            15, 15, 6, 8, 2, 8, 15, 15, 2, 8, 2, 2, 2, 15, 15, 6,
+            6, 2, 6, 8, 15, 15, 2, 2, 15, 15, 15, 15, 15, 2, 2, 15,
+        };
+
+        // EAC modifiers, per table index
+        constexpr int8_t EAC_MODIFIERS[16][8] = {
+            { -3, -6, -9, -15, 2, 5, 8, 14 },
+            { -3, -7, -10, -13, 2, 6, 9, 12 },
+            { -2, -5, -8, -13, 1, 4, 7, 12 },
+            { -2, -4, -6, -13, 1, 3, 5, 12 },
+            { -3, -6, -8, -12, 2, 5, 7, 11 },
+            { -3, -7, -9, -11, 2, 6, 8, 10 },
+            { -4, -7, -8, -11, 3, 6, 7, 10 },
+            { -3, -5, -8, -11, 2, 4, 7, 10 },
+            { -2, -6, -8, -10, 1, 5, 7, 9 },
+            { -2, -5, -8, -10, 1, 4, 7, 9 },
+            { -2, -4, -8, -10, 1, 3, 7, 9 },
+            { -2, -5, -7, -10, 1, 4, 6, 9 },
+            { -3, -4, -7, -10, 2, 3, 6, 9 },
+            { -1, -2, -3, -10, 0, 1, 2, 9 },
+            { -4, -6, -8, -9, 3, 5, 7, 8 },
+            { -3, -5, -7, -9, 2, 4, 6, 8 },
+        };
+
+        uint64_t read_le64(const uint8_t* p) {
+            uint64_t v = 0;
+            for (int i = 7; i >= 0; --i) v = (v << 8) | p[i];
+            return v;
+        }
+
+        uint64_t read_be64(const uint8_t* p) {
+            uint64_t v = 0;
+            for (int i = 0; i < 8; ++i) v = (v << 8) | p[i];
+            return v;
+        }
+
+        BlockCoverage coverage_of_range(int lo, int hi, uint8_t threshold) {
+            if (lo > threshold) return COVERAGE_FULL;
+            if (hi <= threshold) return COVERAGE_NONE;
+            return COVERAGE_MIXED;
+        }
+
+        // Bit i of a mask is set for each pixel i that is transparent, the others are opaque
+        BlockCoverage coverage_of_punch_through(uint32_t transparent, uint32_t all, uint8_t threshold) {
+            if (threshold == 255 || transparent == all) return COVERAGE_NONE;
+            return transparent == 0 ? COVERAGE_FULL : COVERAGE_MIXED;
+        }
+
+        // Little-endian bit stream over a 128-bit BC7 block
+        struct BitReader {
+            uint64_t lo, hi;
+            int pos;
+
+            BitReader(const uint8_t* block, int start) : lo(read_le64(block)), hi(read_le64(block + 8)), pos(start) {}
+
+            uint32_t read(int n) {
+                uint64_t v;
+                if (pos >= 64) v = hi >> (pos - 64);
+                else if (pos + n <= 64) v = lo >> pos;
+                else v = (lo >> pos) | (hi << (64 - pos));
+                pos += n;
+                return uint32_t(v & ((uint64_t(1) << n) - 1));
+            }
+        };
+
+        int expand_bits(uint32_t v, int n) {
+            return int((v << (8 - n)) | (v >> (2 * n - 8)));
+        }
+
+        int interpolate(int e0, int e1, int w) {
+            return ((64 - w) * e0 + w * e1 + 32) >> 6;
+        }
+
+        // BC7 mode: index of the lowest set bit of the first byte, 8 if none (invalid block)
+        int bc7_mode(const uint8_t* block) {
+            int mode = 0;
+            while (mode < 8 && !(block[0] & (1 << mode))) ++mode;
+            return mode;
+        }
+
+        // Reads 16 indices of `bits` bits, anchors have one bit less
+        void read_indices(BitReader& r, int bits, int anchor2, uint8_t out[16]) {
+            for (int i = 0; i < 16; ++i) out[i] = uint8_t(r.read(i == 0 || i == anchor2 ? bits - 1 : bits));
+        }
+
+        BlockCoverage classify_bc7(const uint8_t* block, uint8_t threshold) {
+            int mode = bc7_mode(block);
+            switch (mode) {
+                case 0: case 1: case 2: case 3:
+                    return coverage_of_range(255, 255, threshold);
+
+                case 4: case 5: {
+                    // A rotation swaps alpha with a color channel, whose range is not bounded here
+                    BitReader r(block, mode + 1);
+                    if (r.read(2) != 0) return COVERAGE_MIXED;
+                    int a0, a1;
+                    if (mode == 4) {
+                        r.pos += 1 + 30;
+                        a0 = expand_bits(r.read(6), 6);
+                        a1 = expand_bits(r.read(6), 6);
+                    } else {
+                        r.pos += 42;
+                        a0 = int(r.read(8));
+                        a1 = int(r.read(8));
+                    }
+                    return coverage_of_range(std::min(a0, a1), std::max(a0, a1), threshold);
+                }
+
+                case 6: {
+                    BitReader r(block, 7 + 42);
+                    uint32_t a0 = r.read(7), a1 = r.read(7);
+                    a0 = (a0 << 1) | r.read(1);
+                    a1 = (a1 << 1) | r.read(1);
+                    return coverage_of_range(int(std::min(a0, a1)), int(std::max(a0, a1)), threshold);
+                }
+
+                case 7: {
+                    BitReader r(block, 8 + 6 + 60);
+                    uint32_t a[4];
+                    for (uint32_t& v : a) v = r.read(5);
+                    int lo = 255, hi = 0;
+                    for (uint32_t& v : a) {
+                        int e = expand_bits((v << 1) | r.read(1), 6);
+                        lo = std::min(lo, e);
+                        hi = std::max(hi, e);
+                    }
+                    return coverage_of_range(lo, hi, threshold);
+                }
+
+                default:
+                    // Reserved mode, decodes to transparent black
+                    return COVERAGE_NONE;
+            }
+        }
+
+        void decode_bc7(const uint8_t* block, uint8_t alpha[16]) {
+            int mode = bc7_mode(block);
+            switch (mode) {
+                case 0: case 1: case 2: case 3:
+                    std::fill(alpha, alpha + 16, uint8_t(255));
+                    return;
+
+                case 4: case 5: {
+                    BitReader r(block, mode + 1);
+                    int rotation = int(r.read(2));
+                    int index_mode = mode == 4 ? int(r.read(1)) : 0;
+                    int color_bits = mode == 4 ? 5 : 7, alpha_bits = mode == 4 ? 6 : 8;
+
+                    int color[3][2], a[2];
+                    for (auto& c : color)
+                        for (int& e : c) e = expand_bits(r.read(color_bits), color_bits);
+                    for (int& e : a) e = expand_bits(r.read(alpha_bits), alpha_bits);
+
+                    // Mode 4 has 2-bit and 3-bit indices, index_mode picks which set colors use
+                    uint8_t primary[16], secondary[16];
+                    read_indices(r, 2, -1, primary);
+                    read_indices(r, mode == 4 ? 3 : 2, -1, secondary);
+                    const uint8_t* color_index = index_mode ? secondary : primary;
+                    const uint8_t* alpha_index = index_mode ? primary : secondary;
+                    const uint8_t* color_weights = mode == 4 && index_mode ? BC7_WEIGHTS3 : BC7_WEIGHTS2;
+                    const uint8_t* alpha_weights = mode == 4 && !index_mode ? BC7_WEIGHTS3 : BC7_WEIGHTS2;
+
+                    for (int i = 0; i < 16; ++i) {
+                        if (rotation == 0) alpha[i] = uint8_t(interpolate(a[0], a[1], alpha_weights[alpha_index[i]]));
+                        else {
+                            const int* c = color[rotation - 1];
+                            alpha[i] = uint8_t(interpolate(c[0], c[1], color_weights[color_index[i]]));
+                        }
+                    }
+                    return;
+                }
+
+                case 6: {
+                    BitReader r(block, 7 + 42);
+                    uint32_t a0 = r.read(7), a1 = r.read(7);
+                    a0 = (a0 << 1) | r.read(1);
+                    a1 = (a1 << 1) | r.read(1);
+                    uint8_t index[16];
+                    read_indices(r, 4, -1, index);
+                    for (int i = 0; i < 16; ++i) alpha[i] = uint8_t(interpolate(int(a0), int(a1), BC7_WEIGHTS4[index[i]]));
+                    return;
+                }
+
+                case 7: {
+                    BitReader r(block, 8);
+                    int partition = int(r.read(6));
+                    r.pos += 60;
+                    uint32_t raw[4];
+                    for (uint32_t& v : raw) v = r.read(5);
+                    int a[4];
+                    for (int e = 0; e < 4; ++e) a[e] = expand_bits((raw[e] << 1) | r.read(1), 6);
+
+                    uint8_t index[16];
+                    read_indices(r, 2, BC7_ANCHORS2[partition], index);
+                    for (int i = 0; i < 16; ++i) {
+                        int s = (BC7_PARTITIONS2[partition] >> i) & 1;
+                        alpha[i] = uint8_t(interpolate(a[2 * s], a[2 * s + 1], BC7_WEIGHTS2[index[i]]));
+                    }
+                    return;
+                }
+
+                default:
+                    std::fill(alpha, alpha + 16, uint8_t(0));
+                    return;
+            }
+        }
+
+        // EAC alpha: the eight values an index can take, clamped
+        void eac_palette(const uint8_t* block, int values[8]) {
+            int base = block[0], multiplier = block[1] >> 4;
+            const int8_t* modifiers = EAC_MODIFIERS[block[1] & 15];
+            for (int k = 0; k < 8; ++k) values[k] = std::min(255, std::max(0, base + modifiers[k] * multiplier));
+        }
+
+        // ETC2 RGB8A1: pixels made transparent by the punch-through, bit i for pixel i in
+        // column-major order. Planar blocks and blocks with the opaque bit set have none.
+        uint32_t etc2_transparent(const uint8_t* block) {
+            uint64_t v = read_be64(block);
+            if ((v >> 33) & 1) return 0;
+
+            // Differential, T and H modes have the punch-through, planar (only B overflows) not
+            auto in_range = [&](int shift) {
+                int base = int((v >> (shift + 3)) & 31);
+                int delta = int((v >> shift) & 7);
+                if (delta >= 4) delta -= 8;
+                return base + delta >= 0 && base + delta <= 31;
+            };
+            if (in_range(56) && in_range(48) && !in_range(40)) return 0;
+
+            uint32_t msb = uint32_t(v >> 16) & 0xFFFF, lsb = uint32_t(v) & 0xFFFF;
+            return msb & ~lsb;
+        }
+
+        // Column-major ETC pixel order to raster order
+        int etc_pixel(int i) {
+            return (i & 3) * 4 + (i >> 2);
+        }
+    }
+
+    BlockCoverage classify_block(BlockFormat format, const uint8_t* block, uint8_t threshold) {
+        switch (format) {
+            case BLOCK_BC1: {
+                uint32_t c0 = block[0] | (block[1] << 8), c1 = block[2] | (block[3] << 8);
+                if (c0 > c1) return coverage_of_range(255, 255, threshold);
+                uint32_t indices = uint32_t(read_le64(block) >> 32);
+                return coverage_of_punch_through(indices & (indices >> 1) & 0x55555555u, 0x55555555u, threshold);
+            }
+
+            case BLOCK_BC2: {
+                uint64_t a = read_le64(block);
+                if (a == ~uint64_t(0)) return coverage_of_range(255, 255, threshold);
+                if (a == 0) return coverage_of_range(0, 0, threshold);
+                return COVERAGE_MIXED;
+            }
+
+            case BLOCK_BC3:
+                // With a0 <= a1 the indices may also pick 0 and 255
+                if (block[0] > block[1]) return coverage_of_range(block[1], block[0], threshold);
+                return COVERAGE_MIXED;
+
+            case BLOCK_BC7:
+                return classify_bc7(block, threshold);
+
+            case BLOCK_ETC2_RGBA8: {
+                int values[8];
+                eac_palette(block, values);
+                return coverage_of_range(*std::min_element(values, values + 8), *std::max_element(values, values + 8), threshold);
+            }
+
+            case BLOCK_ETC2_RGB8A1:
+                return coverage_of_punch_through(etc2_transparent(block), 0xFFFF, threshold);
+        }
+        return COVERAGE_MIXED;
+    }
+
+    void decode_block_alpha(BlockFormat format, const uint8_t* block, uint8_t alpha[16]) {
+        switch (format) {
+            case BLOCK_BC1: {
+                uint32_t c0 = block[0] | (block[1] << 8), c1 = block[2] | (block[3] << 8);
+                uint32_t indices = uint32_t(read_le64(block) >> 32);
+                for (int i = 0; i < 16; ++i)
+                    alpha[i] = c0 <= c1 && ((indices >> (2 * i)) & 3) == 3 ? 0 : 255;
+                return;
+            }
+
+            case BLOCK_BC2: {
+                uint64_t a = read_le64(block);
+                for (int i = 0; i < 16; ++i) alpha[i] = uint8_t(((a >> (4 * i)) & 15) * 17);
+                return;
+            }
+
+            case BLOCK_BC3: {
+                int a0 = block[0], a1 = block[1];
+                int values[8] = { a0, a1 };
+                if (a0 > a1) {
+                    for (int k = 1; k < 7; ++k) values[k + 1] = ((7 - k) * a0 + k * a1) / 7;
+                } else {
+                    for (int k = 1; k < 5; ++k) values[k + 1] = ((5 - k) * a0 + k * a1) / 5;
+                    values[6] = 0;
+                    values[7] = 255;
+                }
+                uint64_t indices = read_le64(block) >> 16;
+                for (int i = 0; i < 16; ++i) alpha[i] = uint8_t(values[(indices >> (3 * i)) & 7]);
+                return;
+            }
+
+            case BLOCK_BC7:
+                decode_bc7(block, alpha);
+                return;
+
+            case BLOCK_ETC2_RGBA8: {
+                int values[8];
+                eac_palette(block, values);
+                uint64_t indices = read_be64(block);
+                for (int i = 0; i < 16; ++i) alpha[etc_pixel(i)] = uint8_t(values[(indices >> (45 - 3 * i)) & 7]);
+                return;
+            }
+
+            case BLOCK_ETC2_RGB8A1: {
+                uint32_t transparent = etc2_transparent(block);
+                for (int i = 0; i < 16; ++i) alpha[etc_pixel(i)] = (transparent >> i) & 1 ? 0 : 255;
+                return;
+            }
+        }
+    }
+
+    bool build_block_mask(const BlockView& blocks, uint8_t threshold, AlphaMask& mask,
+        const ParallelFor& parallel_for, int tasks, BlockMaskStats* stats) {
+        if (blocks.width < 0 || blocks.height < 0) return false;
+        if (blocks.width > 0 && blocks.height > 0 && !blocks.data) return false;
+
+        mask.reset(blocks.width, blocks.height);
+        int blocks_x = blocks.get_blocks_x(), blocks_y = blocks.get_blocks_y();
+        if (blocks_x == 0 || blocks_y == 0) return true;
+
+        size_t bytes = block_size(blocks.format);
+        size_t row_bytes = size_t(blocks_x) * bytes;
+
+        // Bits of the last block column that fall inside the image
+        uint32_t last_columns = blocks.width & 3 ? (1u << (blocks.width & 3)) - 1 : 15;
+
+        tasks = std::max(1, std::min(tasks, blocks_y));
+        std::vector<BlockMaskStats> task_stats(tasks);
+        parallel_for(tasks, [&](int t) {
+            BlockMaskStats& s = task_stats[t];
+            int by0 = int(int64_t(blocks_y) * t / tasks), by1 = int(int64_t(blocks_y) * (t + 1) / tasks);
+            uint8_t alpha[16];
+
+            for (int by = by0; by < by1; ++by) {
+                const uint8_t* row = blocks.data + size_t(by) * row_bytes;
+                int rows = std::min(4, blocks.height - by * 4);
+                uint64_t* out[4];
+                for (int r = 0; r < rows; ++r) out[r] = mask.get_row(by * 4 + r);
+
+                for (int bx = 0; bx < blocks_x; ++bx) {
+                    uint32_t nibbles[4] = { 15, 15, 15, 15 };
+                    switch (classify_block(blocks.format, row + size_t(bx) * bytes, threshold)) {
+                        case COVERAGE_NONE:
+                            ++s.empty;
+                            continue;
+                        case COVERAGE_FULL:
+                            ++s.full;
+                            break;
+                        case COVERAGE_MIXED:
+                            ++s.decoded;
+                            decode_block_alpha(blocks.format, row + size_t(bx) * bytes, alpha);
+                            for (int r = 0; r < 4; ++r) {
+                                nibbles[r] = 0;
+                                for (int c = 0; c < 4; ++c) nibbles[r] |= uint32_t(alpha[r * 4 + c] > threshold) << c;
+                            }
+                            break;
+                    }
+
+                    // A block's 4 bits never straddle two words
+                    uint32_t columns = bx == blocks_x - 1 ? last_columns : 15;
+                    int x = bx * 4;
+                    for (int r = 0; r < rows; ++r) out[r][x >> 6] |= uint64_t(nibbles[r] & columns) << (x & 63);
+                }
+            }
+        });
+
+        if (stats) {
+            *stats = BlockMaskStats();
+            for (const BlockMaskStats& s : task_stats) {
+                stats->empty += s.empty;
+                stats->full += s.full;
+                stats->decoded += s.decoded;
+            }
+        }
+        return true;
+    }
+}
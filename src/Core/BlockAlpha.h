@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "AlphaMask.h"
+#include "ParallelFor.h"
+
+namespace spritecutter {
+
+    /**
+     * @brief Block-compressed layouts the core reads alpha from without decompressing.
+     */
+    enum BlockFormat {
+        BLOCK_BC1,         // DXT1, 1-bit punch-through alpha
+        BLOCK_BC2,         // DXT3, explicit 4-bit alpha
+        BLOCK_BC3,         // DXT5, interpolated alpha
+        BLOCK_BC7,         // BPTC RGBA, eight modes
+        BLOCK_ETC2_RGBA8,  // EAC alpha block followed by ETC2 color
+        BLOCK_ETC2_RGB8A1, // ETC2 with punch-through alpha
+    };
+
+    /**
+     * @brief Returns the size of one 4x4 block in bytes.
+     */
+    inline size_t block_size(BlockFormat format) {
+        return format == BLOCK_BC1 || format == BLOCK_ETC2_RGB8A1 ? 8 : 16;
+    }
+
+    /**
+     * @brief Non-owning view of the top level of a block-compressed image.
+     *
+     * Blocks are stored row by row, `(width + 3) / 4` per row; pixels past the
+     *
+     * width or height in the last blocks are ignored.
+     */
+    struct BlockView {
+        const uint8_t* data = nullptr;
+        int width = 0;
+        int height = 0;
+        BlockFormat format = BLOCK_BC3;
+
+        int get_blocks_x() const { return (width + 3) / 4; }
+        int get_blocks_y() const { return (height + 3) / 4; }
+        size_t get_size() const { return size_t(get_blocks_x()) * size_t(get_blocks_y()) * block_size(format); }
+    };
+
+    /**
+     * @brief What a block's alpha is, as far as a threshold is concerned.
+     */
+    enum BlockCoverage {
+        COVERAGE_NONE,  // every pixel at or below the threshold
+        COVERAGE_FULL,  // every pixel above the threshold
+        COVERAGE_MIXED, // can't tell without decoding the pixels
+    };
+
+    /**
+     * @brief Classifies a block from its alpha endpoints and mode bits only.
+     *
+     * Interpolated values never leave the range of their endpoints, so a range
+     *
+     * entirely on one side of the threshold settles the block. Punch-through
+     *
+     * formats are settled with a few bitwise operations on the index bits.
+     */
+    BlockCoverage classify_block(BlockFormat format, const uint8_t* block, uint8_t threshold);
+
+    /**
+     * @brief Decodes the 16 alpha values of a block, in raster order.
+     */
+    void decode_block_alpha(BlockFormat format, const uint8_t* block, uint8_t alpha[16]);
+
+    /**
+     * @brief Counters of build_block_mask(), to see how much the classification saved.
+     */
+    struct BlockMaskStats {
+        size_t empty = 0;
+        size_t full = 0;
+        size_t decoded = 0;
+    };
+
+    /**
+     * @brief Packs the alpha of a block-compressed image into an occupancy mask.
+     *
+     * Blocks settled by classify_block() are written as a whole, only the mixed
+     *
+     * ones are decoded. Rows of blocks are split between `tasks` tasks run by
+     *
+     * `parallel_for`; each writes its own rows of the mask.
+     *
+     * @param blocks The blocks to read. `blocks.data` must hold get_size() bytes.
+     * @param threshold Pixels with alpha strictly above this value are set.
+     * @param mask Output mask, resized to the view.
+     * @param parallel_for Scheduler for the tasks.
+     * @param tasks Number of tasks, 1 to stay on the calling thread.
+     * @param stats Optional counters, summed over all tasks.
+     * @return false if the view is malformed.
+     */
+    bool build_block_mask(const BlockView& blocks, uint8_t threshold, AlphaMask& mask,
+        const ParallelFor& parallel_for = serial_for, int tasks = 1, BlockMaskStats* stats = nullptr);
+}
@@ -0,0 +1,207 @@
+#include "FrameIndex.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "Hash.h"
+
+namespace spritecutter {
+
+    namespace {
+        // Perceptual grid: one more column than bits per row, the bits compare neighbours
+        constexpr int GRID_W = 9;
+        constexpr int GRID_H = 8;
+
+        // A near duplicate may be this much larger or smaller on each side
+        constexpr int NEAR_SIZE = 1;
+
+        // ... and its mean color this far off on each channel
+        constexpr int NEAR_MEAN = 8;
+
+        // Bands are never narrower than this, so the lookup keys stay selective
+        constexpr int MIN_BAND_BITS = 4;
+
+        int channel(uint32_t color, int c) {
+            return int((color >> (c * 8)) & 0xff);
+        }
+    }
+
+    FrameHash hash_frame(const PixelView& source, const Region& region) {
+        FrameHash hash;
+        int x0 = std::max(0, region.x), y0 = std::max(0, region.y);
+        int x1 = std::min(source.width, region.x + region.w), y1 = std::min(source.height, region.y + region.h);
+        if (source.format != FORMAT_RGBA8 || x1 <= x0 || y1 <= y0) return hash;
+        int w = x1 - x0, h = y1 - y0;
+
+        // Grid cell of each column, rows map the same way
+        std::vector<uint8_t> columns(static_cast<size_t>(w));
+        for (int x = 0; x < w; ++x) columns[x] = uint8_t(x * GRID_W / w);
+
+        uint64_t cells[GRID_H][GRID_W] = {};
+        uint32_t counts[GRID_H][GRID_W] = {};
+        uint64_t sum_r = 0, sum_g = 0, sum_b = 0, sum_a = 0;
+
+        uint64_t exact = hash_combine(hash_combine(0, uint64_t(w)), uint64_t(h));
+        for (int y = y0; y < y1; ++y) {
+            const uint8_t* row = source.row(y) + size_t(x0) * 4;
+            exact = hash_bytes(row, size_t(w) * 4, exact);
+
+            int cy = (y - y0) * GRID_H / h;
+            uint64_t* cell_row = cells[cy];
+            uint32_t* count_row = counts[cy];
+            for (int x = 0; x < w; ++x) {
+                const uint8_t* p = row + size_t(x) * 4;
+                uint32_t a = p[3];
+                uint32_t luma = (p[0] * 77u + p[1] * 150u + p[2] * 29u) >> 8;
+                cell_row[columns[x]] += luma * a;
+                ++count_row[columns[x]];
+                sum_r += p[0] * a;
+                sum_g += p[1] * a;
+                sum_b += p[2] * a;
+                sum_a += a;
+            }
+        }
+        hash.exact = exact;
+
+        for (int cy = 0; cy < GRID_H; ++cy) {
+            uint64_t values[GRID_W];
+            for (int cx = 0; cx < GRID_W; ++cx)
+                values[cx] = counts[cy][cx] ? cells[cy][cx] / counts[cy][cx] : 0;
+            for (int cx = 0; cx + 1 < GRID_W; ++cx) {
+                if (values[cx] < values[cx + 1]) hash.perceptual |= uint64_t(1) << (cy * (GRID_W - 1) + cx);
+            }
+        }
+
+        if (sum_a > 0) {
+            uint32_t r = uint32_t((sum_r + sum_a / 2) / sum_a);
+            uint32_t g = uint32_t((sum_g + sum_a / 2) / sum_a);
+            uint32_t b = uint32_t((sum_b + sum_a / 2) / sum_a);
+            uint64_t area = uint64_t(w) * uint64_t(h);
+            uint32_t a = uint32_t((sum_a + area / 2) / area);
+            hash.mean = r | (g << 8) | (b << 16) | (a << 24);
+        }
+        return hash;
+    }
+
+    bool hash_frames(const PixelView& source, const std::vector<Region>& regions, std::vector<FrameHash>& hashes,
+        const ParallelFor& parallel_for, int tasks, const SliceProgress* progress) {
+        hashes.assign(regions.size(), FrameHash());
+        if (source.format != FORMAT_RGBA8) return false;
+
+        // Every region writes its own slot
+        int count = (int)regions.size();
+        tasks = std::max(1, std::min(tasks, count));
+        int per_task = count > 0 ? (count + tasks - 1) / tasks : 0;
+        TaskFn task = [&](int t) {
+            int end = std::min(count, (t + 1) * per_task);
+            for (int i = t * per_task; i < end; ++i) {
+                if (progress && progress->is_cancelled()) return;
+                hashes[i] = hash_frame(source, regions[i]);
+            }
+        };
+        if (tasks == 1) task(0);
+        else parallel_for(tasks, task);
+
+        return !(progress && progress->is_cancelled());
+    }
+
+    int hamming_distance(uint64_t a, uint64_t b) {
+        uint64_t x = a ^ b;
+        int bits = 0;
+        while (x) {
+            x &= x - 1;
+            ++bits;
+        }
+        return bits;
+    }
+
+    FrameIndex::FrameIndex(int p_max_distance) {
+        // At most 64 / MIN_BAND_BITS bands, so at most that many minus one bits apart
+        max_distance = std::max(0, std::min(p_max_distance, 64 / MIN_BAND_BITS - 1));
+        band_count = max_distance > 0 ? max_distance + 1 : 0;
+        band_bits = band_count > 0 ? 64 / band_count : 0;
+        by_band.resize(size_t(band_count));
+    }
+
+    int FrameIndex::add_sheet() {
+        return next_sheet++;
+    }
+
+    void FrameIndex::remove_sheet(int sheet) {
+        // Buckets keep the index, lookups skip removed entries
+        for (Entry& e : entries) {
+            if (e.ref.sheet != sheet || e.removed) continue;
+            e.removed = true;
+            --live;
+        }
+    }
+
+    uint64_t FrameIndex::band(uint64_t perceptual, int b) const {
+        // The last band also takes the bits 64 doesn't divide evenly into
+        int shift = b * band_bits;
+        int bits = b + 1 == band_count ? 64 - shift : band_bits;
+        uint64_t mask = bits >= 64 ? ~uint64_t(0) : (uint64_t(1) << bits) - 1;
+        return (perceptual >> shift) & mask;
+    }
+
+    bool FrameIndex::is_near(const Entry& e, const Region& region, const FrameHash& hash) const {
+        if (std::abs(e.w - region.w) > NEAR_SIZE || std::abs(e.h - region.h) > NEAR_SIZE) return false;
+
+        // Opaque pixel counts within 1/16, so a frame and its outline don't match
+        int slack = std::max(2, std::max(e.count, region.count) / 16);
+        if (std::abs(e.count - region.count) > slack) return false;
+
+        for (int c = 0; c < 4; ++c) {
+            if (std::abs(channel(e.hash.mean, c) - channel(hash.mean, c)) > NEAR_MEAN) return false;
+        }
+        return hamming_distance(e.hash.perceptual, hash.perceptual) <= max_distance;
+    }
+
+    FrameRef FrameIndex::find_or_add(int sheet, int index, const Region& region, const FrameHash& hash, FrameMatch& match) {
+        auto exact = by_exact.find(hash.exact);
+        if (exact != by_exact.end()) {
+            for (int i : exact->second) {
+                const Entry& e = entries[i];
+                if (e.removed || e.w != region.w || e.h != region.h || e.hash.mean != hash.mean) continue;
+                match = FRAME_EXACT;
+                return e.ref;
+            }
+        }
+
+        // Lowest distance wins, ties go to the frame added first
+        int best = -1, best_distance = max_distance + 1;
+        for (int b = 0; b < band_count; ++b) {
+            auto bucket = by_band[b].find(band(hash.perceptual, b));
+            if (bucket == by_band[b].end()) continue;
+            for (int i : bucket->second) {
+                const Entry& e = entries[i];
+                if (e.removed || !is_near(e, region, hash)) continue;
+                int distance = hamming_distance(e.hash.perceptual, hash.perceptual);
+                if (distance < best_distance || (distance == best_distance && i < best)) {
+                    best = i;
+                    best_distance = distance;
+                }
+            }
+        }
+        if (best >= 0) {
+            match = FRAME_NEAR;
+            return entries[best].ref;
+        }
+
+        int id = (int)entries.size();
+        entries.push_back({ FrameRef{ sheet, index }, region.w, region.h, region.count, hash, false });
+        by_exact[hash.exact].push_back(id);
+        for (int b = 0; b < band_count; ++b) by_band[b][band(hash.perceptual, b)].push_back(id);
+        ++live;
+
+        match = FRAME_UNIQUE;
+        return entries[id].ref;
+    }
+
+    void FrameIndex::clear() {
+        entries.clear();
+        by_exact.clear();
+        for (auto& bucket : by_band) bucket.clear();
+        live = 0;
+    }
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "ParallelFor.h"
+#include "PixelView.h"
+#include "SliceProgress.h"
+#include "SliceTypes.h"
+
+namespace spritecutter {
+
+    /**
+     * @brief Fingerprints of one frame.
+     */
+    struct FrameHash {
+        // hash_bytes() of the size and every pixel: equal only for identical frames
+        uint64_t exact = 0;
+
+        // Difference hash of the alpha-weighted luma on a 9 x 8 grid, one bit per
+        // horizontal neighbour pair: frames that look alike differ in a few bits
+        uint64_t perceptual = 0;
+
+        // Alpha-weighted mean color, R G B A from the low byte up
+        uint32_t mean = 0;
+    };
+
+    /**
+     * @brief Fingerprints one region of an RGBA8 image.
+     *
+     * @param source RGBA8 pixels.
+     * @param region Frame to hash, inside `source`.
+     */
+    FrameHash hash_frame(const PixelView& source, const Region& region);
+
+    /**
+     * @brief Fingerprints every region, split between `tasks` tasks.
+     *
+     * @param source RGBA8 pixels the regions were detected in.
+     * @param regions Frames to hash, inside `source`.
+     * @param hashes Output fingerprints, one per region.
+     * @param parallel_for Scheduler for the tasks.
+     * @param tasks Number of tasks, 1 to stay on the calling thread.
+     * @param progress Optional cancellation, checked between regions.
+     * @return false if `source` isn't RGBA8 or on cancellation.
+     */
+    bool hash_frames(const PixelView& source, const std::vector<Region>& regions, std::vector<FrameHash>& hashes,
+        const ParallelFor& parallel_for = serial_for, int tasks = 1, const SliceProgress* progress = nullptr);
+
+    /**
+     * @brief Number of bits that differ between two hashes.
+     */
+    int hamming_distance(uint64_t a, uint64_t b);
+
+    /**
+     * @brief A frame of a sheet added to a FrameIndex.
+     */
+    struct FrameRef {
+        int sheet = -1;
+        int index = -1;
+
+        bool is_valid() const { return sheet >= 0; }
+    };
+
+    /**
+     * @brief How a frame matched what the index already held.
+     */
+    enum FrameMatch {
+        FRAME_UNIQUE,
+        FRAME_EXACT,
+        FRAME_NEAR,
+    };
+
+    /**
+     * @brief Frames seen so far, across sheets, to find duplicates of new ones.
+     *
+     * Only the first frame of each group of duplicates is kept: later copies are
+     *
+     * answered with it. Near lookups split the perceptual hash into `max_distance + 1`
+     *
+     * bands, a frame within that distance shares at least one band exactly, so only
+     *
+     * frames in the same buckets are compared.
+     *
+     * Not thread-safe: hash on worker threads, then add the frames from one thread.
+     */
+    class FrameIndex {
+        public:
+            /**
+             * @param max_distance Largest number of differing perceptual bits of a near duplicate,
+             *        0 to only fold exact duplicates.
+             */
+            explicit FrameIndex(int max_distance = 3);
+
+            /**
+             * @brief Starts a new sheet and returns its id.
+             */
+            int add_sheet();
+
+            /**
+             * @brief Forgets the frames of a sheet, e.g. before slicing it again.
+             */
+            void remove_sheet(int sheet);
+
+            /**
+             * @brief Looks a frame up and adds it when nothing matches.
+             *
+             * @param sheet Sheet the frame belongs to, from add_sheet().
+             * @param index Index of the frame in its sheet.
+             * @param region Its rectangle, for the size and opaque pixel count.
+             * @param hash Its fingerprints.
+             * @param match How it matched.
+             * @return The frame it duplicates, or itself when unique.
+             */
+            FrameRef find_or_add(int sheet, int index, const Region& region, const FrameHash& hash, FrameMatch& match);
+
+            /**
+             * @brief Number of unique frames held.
+             */
+            size_t size() const { return live; }
+
+            int get_max_distance() const { return max_distance; }
+
+            void clear();
+
+        private:
+            struct Entry {
+                FrameRef ref;
+                int w, h, count;
+                FrameHash hash;
+                bool removed;
+            };
+
+            bool is_near(const Entry& e, const Region& region, const FrameHash& hash) const;
+            uint64_t band(uint64_t perceptual, int b) const;
+
+            int max_distance;
+            int band_count;
+            int band_bits;
+            int next_sheet = 0;
+            size_t live = 0;
+
+            std::vector<Entry> entries;
+            std::unordered_map<uint64_t, std::vector<int>> by_exact;
+
+            // One map per band, keyed by the band's bits
+            std::vector<std::unordered_map<uint64_t, std::vector<int>>> by_band;
+    };
+}
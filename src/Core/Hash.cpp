@@ -0,0 +1,100 @@
+#include "Hash.h"
+
+#include <cstring>
+
+namespace spritecutter {
+
+    namespace {
+        constexpr uint64_t PRIME1 = 0x9E3779B185EBCA87ULL;
+        constexpr uint64_t PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+        constexpr uint64_t PRIME3 = 0x165667B19E3779F9ULL;
+        constexpr uint64_t PRIME4 = 0x85EBCA77C2B2AE63ULL;
+        constexpr uint64_t PRIME5 = 0x27D4EB2F165667C5ULL;
+
+        inline uint64_t rotl(uint64_t v, int r) { return (v << r) | (v >> (64 - r)); }
+
+        // Little-endian loads, memcpy keeps unaligned reads legal
+        inline uint64_t read64(const uint8_t* p) {
+            uint64_t v;
+            std::memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+            v = __builtin_bswap64(v);
+#endif
+            return v;
+        }
+
+        inline uint32_t read32(const uint8_t* p) {
+            uint32_t v;
+            std::memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+            v = __builtin_bswap32(v);
+#endif
+            return v;
+        }
+
+        inline uint64_t round(uint64_t acc, uint64_t input) {
+            acc += input * PRIME2;
+            return rotl(acc, 31) * PRIME1;
+        }
+
+        inline uint64_t merge_round(uint64_t acc, uint64_t lane) {
+            acc ^= round(0, lane);
+            return acc * PRIME1 + PRIME4;
+        }
+    }
+
+    uint64_t hash_bytes(const void* data, size_t size, uint64_t seed) {
+        const uint8_t* p = static_cast<const uint8_t*>(data);
+        const uint8_t* end = p + size;
+        uint64_t h;
+
+        if (size >= 32) {
+            uint64_t v1 = seed + PRIME1 + PRIME2;
+            uint64_t v2 = seed + PRIME2;
+            uint64_t v3 = seed;
+            uint64_t v4 = seed - PRIME1;
+
+            const uint8_t* limit = end - 32;
+            do {
+                v1 = round(v1, read64(p));
+                v2 = round(v2, read64(p + 8));
+                v3 = round(v3, read64(p + 16));
+                v4 = round(v4, read64(p + 24));
+                p += 32;
+            } while (p <= limit);
+
+            h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+            h = merge_round(h, v1);
+            h = merge_round(h, v2);
+            h = merge_round(h, v3);
+            h = merge_round(h, v4);
+        } else {
+            h = seed + PRIME5;
+        }
+
+        h += uint64_t(size);
+
+        while (end - p >= 8) {
+            h ^= round(0, read64(p));
+            h = rotl(h, 27) * PRIME1 + PRIME4;
+            p += 8;
+        }
+        if (end - p >= 4) {
+            h ^= uint64_t(read32(p)) * PRIME1;
+            h = rotl(h, 23) * PRIME2 + PRIME3;
+            p += 4;
+        }
+        while (p < end) {
+            h ^= uint64_t(*p) * PRIME5;
+            h = rotl(h, 11) * PRIME1;
+            ++p;
+        }
+
+        h ^= h >> 33;
+        h *= PRIME2;
+        h ^= h >> 29;
+        h *= PRIME3;
+        h ^= h >> 32;
+        return h;
+    }
+}
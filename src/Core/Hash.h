@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace spritecutter {
+
+    /**
+     * @brief 64-bit XXH64 hash of a byte buffer.
+     *
+     * Fast enough to fingerprint a whole sprite sheet before slicing it: it reads
+     *
+     * four independent lanes per 32-byte stripe and runs at memory bandwidth.
+     *
+     * Not cryptographic, only meant to tell buffers apart.
+     *
+     * @param data Bytes to hash, may be null when `size` is 0.
+     * @param size Number of bytes.
+     * @param seed Starting value, chains hashes of several buffers.
+     */
+    uint64_t hash_bytes(const void* data, size_t size, uint64_t seed = 0);
+
+    /**
+     * @brief Folds a 64-bit value into a running hash.
+     */
+    inline uint64_t hash_combine(uint64_t seed, uint64_t value) {
+        return hash_bytes(&value, sizeof(value), seed);
+    }
+}
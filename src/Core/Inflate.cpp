@@ -0,0 +1,297 @@
+#include "Inflate.h"
+
+#include <cstring>
+
+namespace spritecutter {
+
+    namespace {
+        // Base lengths and extra bits of length symbols 257..285
+        constexpr uint16_t LENGTH_BASE[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+            35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+        constexpr uint8_t LENGTH_EXTRA[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+            3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+
+        // Base distances and extra bits of distance symbols 0..29
+        constexpr uint16_t DIST_BASE[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+            257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+        constexpr uint8_t DIST_EXTRA[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+            7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+        // Order of the code length code lengths in a dynamic block header
+        constexpr uint8_t CLEN_ORDER[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+        uint32_t reverse_bits(uint32_t code, int len) {
+            uint32_t r = 0;
+            for (int i = 0; i < len; ++i) {
+                r = (r << 1) | (code & 1);
+                code >>= 1;
+            }
+            return r;
+        }
+    }
+
+    bool Inflater::Huffman::build(const uint8_t* lengths, int n) {
+        std::memset(counts, 0, sizeof(counts));
+        for (int i = 0; i < n; ++i) counts[lengths[i]]++;
+        counts[0] = 0;
+
+        // Reject over-subscribed codes, incomplete ones are legal (e.g. a single distance code)
+        int left = 1;
+        for (int len = 1; len < 16; ++len) {
+            left <<= 1;
+            left -= counts[len];
+            if (left < 0) return false;
+        }
+
+        uint16_t offsets[16];
+        offsets[1] = 0;
+        for (int len = 1; len < 15; ++len) offsets[len + 1] = uint16_t(offsets[len] + counts[len]);
+        for (int i = 0; i < n; ++i)
+            if (lengths[i]) symbols[offsets[lengths[i]]++] = uint16_t(i);
+
+        // Canonical codes in symbol order, stored bit-reversed since the stream is LSB first
+        std::memset(fast, 0, sizeof(fast));
+        uint32_t code = 0;
+        int k = 0;
+        for (int len = 1; len < 16; ++len) {
+            for (int i = 0; i < counts[len]; ++i, ++code, ++k) {
+                if (len > FAST_BITS) continue;
+                uint16_t entry = uint16_t((symbols[k] << 4) | len);
+                for (uint32_t r = reverse_bits(code, len); r < (1u << FAST_BITS); r += 1u << len) fast[r] = entry;
+            }
+            code <<= 1;
+        }
+        return true;
+    }
+
+    Inflater::Inflater() : window(WINDOW_SIZE) {}
+
+    bool Inflater::reset(const std::vector<ByteSpan>* p_spans, bool zlib) {
+        spans = p_spans;
+        span = 0;
+        in = in_end = nullptr;
+        if (spans && !spans->empty()) {
+            in = (*spans)[0].data;
+            in_end = in + (*spans)[0].size;
+        }
+        bits = 0;
+        bit_count = 0;
+        pad_bits = 0;
+        final_block = false;
+        stored_left = 0;
+        match_left = 0;
+        window_pos = 0;
+        state = STATE_HEADER;
+
+        if (zlib) {
+            // Deflate, window up to 32 KiB, no preset dictionary
+            uint32_t cmf = take(8), flg = take(8);
+            if ((cmf & 15) != 8 || (cmf >> 4) > 7 || ((cmf << 8) | flg) % 31 != 0 || (flg & 0x20) || overrun()) {
+                state = STATE_ERROR;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void Inflater::refill() {
+        while (bit_count <= 56) {
+            while (in == in_end && spans && span + 1 < spans->size()) {
+                ++span;
+                in = (*spans)[span].data;
+                in_end = in + (*spans)[span].size;
+            }
+            if (in == in_end) {
+                // Past the end: feed zeros and let overrun() report it if they get used
+                pad_bits += 8;
+                bit_count += 8;
+                continue;
+            }
+            bits |= uint64_t(*in++) << bit_count;
+            bit_count += 8;
+        }
+    }
+
+    uint32_t Inflater::peek(int n) {
+        if (bit_count < n) refill();
+        return uint32_t(bits & ((uint64_t(1) << n) - 1));
+    }
+
+    uint32_t Inflater::take(int n) {
+        uint32_t v = peek(n);
+        consume(n);
+        return v;
+    }
+
+    int Inflater::decode(const Huffman& h) {
+        uint32_t v = peek(15);
+        uint16_t entry = h.fast[v & ((1u << FAST_BITS) - 1)];
+        if (entry) {
+            consume(entry & 15);
+            return entry >> 4;
+        }
+
+        // Longer code: walk the canonical code one bit at a time
+        int code = 0, first = 0, index = 0;
+        for (int len = 1; len < 16; ++len) {
+            code |= (v >> (len - 1)) & 1;
+            int count = h.counts[len];
+            if (code - first < count) {
+                consume(len);
+                return h.symbols[index + code - first];
+            }
+            index += count;
+            first = (first + count) << 1;
+            code <<= 1;
+        }
+        return -1;
+    }
+
+    bool Inflater::read_header() {
+        final_block = take(1) != 0;
+        switch (take(2)) {
+            case 0: {
+                consume(bit_count & 7);
+                uint32_t len = take(16), nlen = take(16);
+                if ((len ^ 0xFFFF) != nlen) return false;
+                stored_left = len;
+                state = STATE_STORED;
+                return true;
+            }
+            case 1: {
+                uint8_t lengths[288 + 30];
+                std::memset(lengths, 8, 144);
+                std::memset(lengths + 144, 9, 112);
+                std::memset(lengths + 256, 7, 24);
+                std::memset(lengths + 280, 8, 8);
+                std::memset(lengths + 288, 5, 30);
+                lit.build(lengths, 288);
+                dist.build(lengths + 288, 30);
+                state = STATE_HUFFMAN;
+                return true;
+            }
+            case 2:
+                if (!read_dynamic_tables()) return false;
+                state = STATE_HUFFMAN;
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    bool Inflater::read_dynamic_tables() {
+        int nlit = int(take(5)) + 257;
+        int ndist = int(take(5)) + 1;
+        int nclen = int(take(4)) + 4;
+        if (nlit > 286 || ndist > 30) return false;
+
+        uint8_t lengths[286 + 30] = {};
+        for (int i = 0; i < nclen; ++i) lengths[CLEN_ORDER[i]] = uint8_t(take(3));
+
+        Huffman clen;
+        if (!clen.build(lengths, 19)) return false;
+
+        // Literal/length and distance code lengths, run-length coded
+        std::memset(lengths, 0, sizeof(lengths));
+        int total = nlit + ndist;
+        for (int i = 0; i < total;) {
+            int sym = decode(clen);
+            if (sym < 0) return false;
+            if (sym < 16) {
+                lengths[i++] = uint8_t(sym);
+                continue;
+            }
+
+            uint8_t len = 0;
+            int repeat;
+            if (sym == 16) {
+                if (i == 0) return false;
+                len = lengths[i - 1];
+                repeat = 3 + int(take(2));
+            } else if (sym == 17) {
+                repeat = 3 + int(take(3));
+            } else {
+                repeat = 11 + int(take(7));
+            }
+            if (i + repeat > total) return false;
+            while (repeat--) lengths[i++] = len;
+        }
+
+        // A block without end-of-block code could never finish
+        if (lengths[256] == 0) return false;
+        return lit.build(lengths, nlit) && dist.build(lengths + nlit, ndist) && !overrun();
+    }
+
+    long Inflater::read(uint8_t* out, size_t size) {
+        size_t n = 0;
+        while (n < size) {
+            if (overrun()) state = STATE_ERROR;
+
+            switch (state) {
+                case STATE_ERROR:
+                    return -1;
+
+                case STATE_DONE:
+                    return long(n);
+
+                case STATE_HEADER:
+                    if (!read_header()) state = STATE_ERROR;
+                    break;
+
+                case STATE_STORED:
+                    for (; stored_left && n < size; --stored_left) emit(uint8_t(take(8)), out, n);
+                    if (!stored_left) state = final_block ? STATE_DONE : STATE_HEADER;
+                    break;
+
+                case STATE_HUFFMAN:
+                    while (n < size) {
+                        // Finish the pending match first, it may span several reads
+                        if (match_left) {
+                            for (; match_left && n < size; --match_left)
+                                emit(window[(window_pos - match_dist) & WINDOW_MASK], out, n);
+                            continue;
+                        }
+
+                        int sym = decode(lit);
+                        if (sym < 256) {
+                            if (sym < 0) {
+                                state = STATE_ERROR;
+                                break;
+                            }
+                            emit(uint8_t(sym), out, n);
+                            continue;
+                        }
+                        if (sym == 256) {
+                            state = final_block ? STATE_DONE : STATE_HEADER;
+                            break;
+                        }
+
+                        // Length extra bits come before the distance code
+                        sym -= 257;
+                        if (sym >= 29) {
+                            state = STATE_ERROR;
+                            break;
+                        }
+                        int length = LENGTH_BASE[sym] + int(take(LENGTH_EXTRA[sym]));
+                        int ds = decode(dist);
+                        if (ds < 0 || ds >= 30) {
+                            state = STATE_ERROR;
+                            break;
+                        }
+                        match_left = length;
+                        match_dist = DIST_BASE[ds] + take(DIST_EXTRA[ds]);
+                        if (match_dist > window_pos) {
+                            state = STATE_ERROR;
+                            break;
+                        }
+                    }
+                    break;
+            }
+        }
+        if (overrun()) {
+            state = STATE_ERROR;
+            return -1;
+        }
+        return long(n);
+    }
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace spritecutter {
+
+    /**
+     * @brief Input of an Inflater: a list of byte spans read back to back.
+     *
+     * PNG splits its zlib stream over IDAT chunks, the spans point at their payloads
+     *
+     * where they lie, typically in a memory-mapped file.
+     */
+    struct ByteSpan {
+        const uint8_t* data;
+        size_t size;
+    };
+
+    /**
+     * @brief Pull-based DEFLATE (RFC 1951) decoder.
+     *
+     * Decodes on demand into the caller's buffer and keeps only the 32 KiB window,
+     *
+     * so a whole image never has to be decompressed at once. Huffman codes up to
+     *
+     * FAST_BITS long are decoded with one table lookup.
+     */
+    class Inflater {
+        public:
+            Inflater();
+
+            /**
+             * @brief Starts decoding a raw DEFLATE stream.
+             *
+             * @param spans Input, kept by pointer: it must outlive the decoding.
+             * @param zlib true to check and skip the 2-byte zlib header first.
+             * @return false on a bad zlib header.
+             */
+            bool reset(const std::vector<ByteSpan>* spans, bool zlib);
+
+            /**
+             * @brief Decodes up to `size` bytes.
+             *
+             * @return The number of bytes written, less than `size` only at the end of the
+             *         stream, or -1 on malformed or truncated input.
+             */
+            long read(uint8_t* out, size_t size);
+
+            bool is_done() const { return state == STATE_DONE; }
+
+            static constexpr int FAST_BITS = 10;
+
+        private:
+            // Canonical Huffman code, see build()
+            struct Huffman {
+                // (symbol << 4) | length for codes up to FAST_BITS long, 0 otherwise
+                uint16_t fast[1 << FAST_BITS];
+                uint16_t counts[16];
+                uint16_t symbols[288];
+
+                bool build(const uint8_t* lengths, int n);
+            };
+
+            enum State {
+                STATE_HEADER,
+                STATE_STORED,
+                STATE_HUFFMAN,
+                STATE_DONE,
+                STATE_ERROR,
+            };
+
+            // Bit buffer, LSB first
+            void refill();
+            uint32_t peek(int n);
+            void consume(int n) { bits >>= n; bit_count -= n; }
+            uint32_t take(int n);
+            bool overrun() const { return pad_bits > bit_count; }
+
+            int decode(const Huffman& h);
+            bool read_header();
+            bool read_dynamic_tables();
+
+            void emit(uint8_t b, uint8_t* out, size_t& n) {
+                window[window_pos++ & WINDOW_MASK] = b;
+                out[n++] = b;
+            }
+
+            const std::vector<ByteSpan>* spans = nullptr;
+            size_t span = 0;
+            const uint8_t* in = nullptr;
+            const uint8_t* in_end = nullptr;
+
+            uint64_t bits = 0;
+            int bit_count = 0;
+
+            // Zero bits appended past the end of the input
+            int pad_bits = 0;
+
+            State state = STATE_DONE;
+            bool final_block = false;
+            uint32_t stored_left = 0;
+
+            // Rest of a match that did not fit the last read()
+            int match_left = 0;
+            uint32_t match_dist = 0;
+
+            Huffman lit;
+            Huffman dist;
+
+            static constexpr size_t WINDOW_SIZE = 32768;
+            static constexpr size_t WINDOW_MASK = WINDOW_SIZE - 1;
+            std::vector<uint8_t> window;
+            size_t window_pos = 0;
+    };
+}
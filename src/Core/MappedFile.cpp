@@ -0,0 +1,100 @@
+#include "MappedFile.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace spritecutter {
+
+    namespace {
+        // Maps the whole file read-only, returns null on failure or for an empty file
+        void* map_file(const std::string& path, size_t& size) {
+#if defined(_WIN32)
+            std::wstring wide = std::filesystem::u8path(path).wstring();
+            HANDLE file = CreateFileW(wide.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+            if (file == INVALID_HANDLE_VALUE) return nullptr;
+
+            void* view = nullptr;
+            LARGE_INTEGER length;
+            if (GetFileSizeEx(file, &length) && length.QuadPart > 0 && uint64_t(length.QuadPart) <= SIZE_MAX) {
+                HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+                if (mapping) {
+                    view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+                    CloseHandle(mapping);
+                }
+                size = size_t(length.QuadPart);
+            }
+            CloseHandle(file);
+            return view;
+#else
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0) return nullptr;
+
+            void* view = nullptr;
+            struct stat st;
+            if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+                size = size_t(st.st_size);
+                view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (view == MAP_FAILED) view = nullptr;
+                else madvise(view, size, MADV_SEQUENTIAL);
+            }
+            ::close(fd);
+            return view;
+#endif
+        }
+
+        void unmap_file(void* view, size_t size) {
+#if defined(_WIN32)
+            (void)size;
+            UnmapViewOfFile(view);
+#else
+            munmap(view, size);
+#endif
+        }
+    }
+
+    bool MappedFile::open(const std::string& path) {
+        close();
+
+        size_t mapped_size = 0;
+        mapping = map_file(path, mapped_size);
+        if (mapping) {
+            data = static_cast<const uint8_t*>(mapping);
+            size = mapped_size;
+            return true;
+        }
+
+        // No mapping (empty file, exotic file system): read it all
+        std::ifstream file(std::filesystem::u8path(path), std::ios::binary);
+        if (!file) return false;
+        buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        if (file.bad()) {
+            buffer.clear();
+            return false;
+        }
+        data = buffer.data();
+        size = buffer.size();
+        return true;
+    }
+
+    void MappedFile::close() {
+        if (mapping) unmap_file(mapping, size);
+        mapping = nullptr;
+        data = nullptr;
+        size = 0;
+        buffer.clear();
+        buffer.shrink_to_fit();
+    }
+}
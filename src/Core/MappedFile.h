@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace spritecutter {
+
+    /**
+     * @brief Read-only view of a whole file, memory-mapped when the platform allows it.
+     *
+     * Pages are loaded by the OS as a reader walks through them and can be dropped
+     *
+     * again under memory pressure, so a large file costs no heap. Where mapping
+     *
+     * fails the file is read into a buffer instead, get_data() works the same.
+     */
+    class MappedFile {
+        public:
+            MappedFile() = default;
+            ~MappedFile() { close(); }
+            MappedFile(const MappedFile&) = delete;
+            MappedFile& operator=(const MappedFile&) = delete;
+
+            /**
+             * @brief Maps a file, closing the previous one.
+             *
+             * @param path UTF-8 path of the file.
+             * @return false if the file can't be read.
+             */
+            bool open(const std::string& path);
+
+            /**
+             * @brief Unmaps the file. get_data() is invalid afterwards.
+             */
+            void close();
+
+            const uint8_t* get_data() const { return data; }
+            size_t get_size() const { return size; }
+
+            /**
+             * @brief Returns true if the data is mapped rather than copied.
+             */
+            bool is_mapped() const { return mapping != nullptr; }
+
+        private:
+            const uint8_t* data = nullptr;
+            size_t size = 0;
+
+            // Base address of the mapping, null when the buffer fallback is used
+            void* mapping = nullptr;
+            std::vector<uint8_t> buffer;
+    };
+}
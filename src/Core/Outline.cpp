@@ -0,0 +1,359 @@
+#include "Outline.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace spritecutter {
+
+    namespace {
+        // Tolerance increases tried before falling back to the convex hull
+        constexpr int MAX_ATTEMPTS = 8;
+
+        // Factor the tolerance grows by when the outline is over budget
+        constexpr float EPSILON_GROWTH = 1.5f;
+
+        // Unit steps with y down; turning right adds one
+        constexpr int DX[4] = { 1, 0, -1, 0 };
+        constexpr int DY[4] = { 0, 1, 0, -1 };
+
+        /**
+         * @brief Opaque pixels of a region grown by `grow`, with a `grow` wide border.
+         */
+        struct Grid {
+            int width = 0;
+            int height = 0;
+            std::vector<uint8_t> cells;
+
+            bool at(int x, int y) const {
+                return x >= 0 && y >= 0 && x < width && y < height && cells[size_t(y) * width + x];
+            }
+        };
+
+        void build_grid(const AlphaMask& mask, const Region& r, int grow, Grid& grid) {
+            grid.width = r.w + 2 * grow;
+            grid.height = r.h + 2 * grow;
+            grid.cells.assign(size_t(grid.width) * grid.height, 0);
+            for (int y = 0; y < r.h; ++y) {
+                uint8_t* row = &grid.cells[size_t(y + grow) * grid.width + grow];
+                for (int x = 0; x < r.w; ++x) row[x] = mask.is_set(r.x + x, r.y + y);
+            }
+            if (grow <= 0) return;
+
+            // Square dilation, one axis at a time
+            std::vector<uint8_t> tmp(grid.cells.size(), 0);
+            for (int y = 0; y < grid.height; ++y) {
+                const uint8_t* src = &grid.cells[size_t(y) * grid.width];
+                uint8_t* dst = &tmp[size_t(y) * grid.width];
+                for (int x = 0; x < grid.width; ++x) {
+                    if (!src[x]) continue;
+                    int x0 = std::max(0, x - grow), x1 = std::min(grid.width - 1, x + grow);
+                    std::fill(dst + x0, dst + x1 + 1, uint8_t(1));
+                }
+            }
+            std::fill(grid.cells.begin(), grid.cells.end(), uint8_t(0));
+            for (int y = 0; y < grid.height; ++y) {
+                const uint8_t* src = &tmp[size_t(y) * grid.width];
+                int y0 = std::max(0, y - grow), y1 = std::min(grid.height - 1, y + grow);
+                for (int yy = y0; yy <= y1; ++yy) {
+                    uint8_t* dst = &grid.cells[size_t(yy) * grid.width];
+                    for (int x = 0; x < grid.width; ++x) dst[x] |= src[x];
+                }
+            }
+        }
+
+        /**
+         * @brief Walks the outer boundary of the first component in raster order.
+         *
+         * Opaque pixels stay on the right of the walk, diagonal neighbours count as connected
+         *
+         * like in the labeller. Only the corners where the walk turns are kept.
+         */
+        bool trace(const Grid& grid, Outline& points) {
+            points.clear();
+            int sx = -1, sy = -1;
+            for (int y = 0; y < grid.height && sx < 0; ++y)
+                for (int x = 0; x < grid.width; ++x)
+                    if (grid.at(x, y)) {
+                        sx = x;
+                        sy = y;
+                        break;
+                    }
+            if (sx < 0) return false;
+
+            // The top-left corner of the first pixel is always a turn
+            int x = sx, y = sy, dir = 0;
+            points.push_back({ x, y });
+            for (;;) {
+                x += DX[dir];
+                y += DY[dir];
+                if (x == sx && y == sy) break;
+
+                // Pixels ahead of the corner, on the left and on the right of the walk
+                int right = (dir + 1) & 3;
+                int fx = DX[dir] + DX[right], fy = DY[dir] + DY[right];
+                int lx = DX[dir] - DX[right], ly = DY[dir] - DY[right];
+                bool ahead_right = grid.at(x + (fx < 0 ? -1 : 0), y + (fy < 0 ? -1 : 0));
+                bool ahead_left = grid.at(x + (lx < 0 ? -1 : 0), y + (ly < 0 ? -1 : 0));
+
+                int next = ahead_left ? (dir + 3) & 3 : (ahead_right ? dir : right);
+                if (next != dir) points.push_back({ x, y });
+                dir = next;
+            }
+            return true;
+        }
+
+        double segment_distance(const OutlinePoint& p, const OutlinePoint& a, const OutlinePoint& b) {
+            double dx = b.x - a.x, dy = b.y - a.y;
+            double len = dx * dx + dy * dy;
+            double t = len > 0.0 ? ((p.x - a.x) * dx + (p.y - a.y) * dy) / len : 0.0;
+            t = std::min(1.0, std::max(0.0, t));
+            double ex = a.x + t * dx - p.x, ey = a.y + t * dy - p.y;
+            return std::sqrt(ex * ex + ey * ey);
+        }
+
+        /**
+         * @brief Douglas-Peucker on a closed polygon, split at the vertex farthest from the first.
+         */
+        void simplify(const Outline& points, float epsilon, Outline& out) {
+            size_t n = points.size();
+            out.clear();
+            if (n <= 3) {
+                out = points;
+                return;
+            }
+
+            size_t far = 0;
+            double far_d = -1.0;
+            for (size_t i = 1; i < n; ++i) {
+                double dx = points[i].x - points[0].x, dy = points[i].y - points[0].y;
+                double d = dx * dx + dy * dy;
+                if (d > far_d) {
+                    far_d = d;
+                    far = i;
+                }
+            }
+
+            // Index n stands for the first point again, closing the polygon
+            std::vector<uint8_t> keep(n + 1, 0);
+            keep[0] = keep[far] = keep[n] = 1;
+            std::vector<std::pair<size_t, size_t>> stack = { { 0, far }, { far, n } };
+            while (!stack.empty()) {
+                std::pair<size_t, size_t> span = stack.back();
+                stack.pop_back();
+                const OutlinePoint& a = points[span.first % n];
+                const OutlinePoint& b = points[span.second % n];
+                double worst = -1.0;
+                size_t at = 0;
+                for (size_t i = span.first + 1; i < span.second; ++i) {
+                    double d = segment_distance(points[i], a, b);
+                    if (d > worst) {
+                        worst = d;
+                        at = i;
+                    }
+                }
+                if (worst > epsilon) {
+                    keep[at] = 1;
+                    stack.push_back({ span.first, at });
+                    stack.push_back({ at, span.second });
+                }
+            }
+            for (size_t i = 0; i < n; ++i)
+                if (keep[i]) out.push_back(points[i]);
+        }
+
+        long long cross(const OutlinePoint& o, const OutlinePoint& a, const OutlinePoint& b) {
+            return (long long)(a.x - o.x) * (b.y - o.y) - (long long)(a.y - o.y) * (b.x - o.x);
+        }
+
+        bool on_segment(const OutlinePoint& p, const OutlinePoint& a, const OutlinePoint& b) {
+            return std::min(a.x, b.x) <= p.x && p.x <= std::max(a.x, b.x) && std::min(a.y, b.y) <= p.y && p.y <= std::max(a.y, b.y);
+        }
+
+        bool segments_meet(const OutlinePoint& a, const OutlinePoint& b, const OutlinePoint& c, const OutlinePoint& d) {
+            long long d1 = cross(c, d, a), d2 = cross(c, d, b), d3 = cross(a, b, c), d4 = cross(a, b, d);
+            if (((d1 > 0 && d2 < 0) || (d1 < 0 && d2 > 0)) && ((d3 > 0 && d4 < 0) || (d3 < 0 && d4 > 0))) return true;
+            return (d1 == 0 && on_segment(a, c, d)) || (d2 == 0 && on_segment(b, c, d))
+                || (d3 == 0 && on_segment(c, a, b)) || (d4 == 0 && on_segment(d, a, b));
+        }
+
+        /**
+         * @brief Returns true if no two edges meet besides neighbours at their shared vertex.
+         *
+         * Simplification may fold a thin part over itself, which meshes can't be built from.
+         */
+        bool is_simple(const Outline& outline) {
+            size_t n = outline.size();
+            for (size_t i = 0; i < n; ++i) {
+                for (size_t j = i + 1; j < n; ++j) {
+                    if (j == i + 1 || (i == 0 && j == n - 1)) continue;
+                    if (segments_meet(outline[i], outline[(i + 1) % n], outline[j], outline[(j + 1) % n])) return false;
+                }
+            }
+            return true;
+        }
+
+        /**
+         * @brief Convex hull of the opaque pixels' corners, clockwise with y down.
+         */
+        void convex_hull(const AlphaMask& mask, const Region& r, Outline& hull) {
+            Outline corners;
+            for (int y = 0; y < r.h; ++y) {
+                int left = -1, right = -1;
+                for (int x = 0; x < r.w; ++x) {
+                    if (!mask.is_set(r.x + x, r.y + y)) continue;
+                    if (left < 0) left = x;
+                    right = x;
+                }
+                if (left < 0) continue;
+                corners.push_back({ left, y });
+                corners.push_back({ left, y + 1 });
+                corners.push_back({ right + 1, y });
+                corners.push_back({ right + 1, y + 1 });
+            }
+            hull.clear();
+            if (corners.empty()) return;
+            std::sort(corners.begin(), corners.end(), [](const OutlinePoint& a, const OutlinePoint& b) {
+                return a.x != b.x ? a.x < b.x : a.y < b.y;
+            });
+
+            // Monotone chain, collinear points dropped
+            hull.assign(corners.size() * 2, OutlinePoint{ 0, 0 });
+            size_t k = 0;
+            for (size_t i = 0; i < corners.size(); ++i) {
+                while (k >= 2 && cross(hull[k - 2], hull[k - 1], corners[i]) <= 0) --k;
+                hull[k++] = corners[i];
+            }
+            for (size_t i = corners.size() - 1, lower = k + 1; i-- > 0;) {
+                while (k >= lower && cross(hull[k - 2], hull[k - 1], corners[i]) <= 0) --k;
+                hull[k++] = corners[i];
+            }
+            hull.resize(k > 1 ? k - 1 : k);
+        }
+
+        void rectangle(const Region& r, Outline& outline) {
+            outline = { { 0, 0 }, { r.w, 0 }, { r.w, r.h }, { 0, r.h } };
+        }
+
+        // True if the segment crosses the open unit square at (px, py)
+        bool crosses_pixel(const OutlinePoint& a, const OutlinePoint& b, int px, int py) {
+            double t0 = 0.0, t1 = 1.0;
+            double d[2] = { double(b.x - a.x), double(b.y - a.y) };
+            double p[2] = { double(a.x), double(a.y) };
+            double lo[2] = { double(px), double(py) };
+            for (int axis = 0; axis < 2; ++axis) {
+                if (d[axis] == 0.0) {
+                    if (p[axis] <= lo[axis] || p[axis] >= lo[axis] + 1.0) return false;
+                    continue;
+                }
+                double ta = (lo[axis] - p[axis]) / d[axis];
+                double tb = (lo[axis] + 1.0 - p[axis]) / d[axis];
+                if (ta > tb) std::swap(ta, tb);
+                t0 = std::max(t0, ta);
+                t1 = std::min(t1, tb);
+            }
+            return t0 < t1;
+        }
+    }
+
+    bool outline_covers(const AlphaMask& mask, const Region& r, const Outline& outline) {
+        size_t n = outline.size();
+        if (n < 3) return false;
+
+        // Every opaque pixel center is strictly inside, row by row
+        std::vector<double> crossings;
+        for (int y = 0; y < r.h; ++y) {
+            double cy = y + 0.5;
+            crossings.clear();
+            for (size_t i = 0; i < n; ++i) {
+                const OutlinePoint& a = outline[i];
+                const OutlinePoint& b = outline[(i + 1) % n];
+                if ((a.y <= cy) == (b.y <= cy)) continue;
+                crossings.push_back(a.x + (cy - a.y) * double(b.x - a.x) / double(b.y - a.y));
+            }
+            std::sort(crossings.begin(), crossings.end());
+
+            size_t span = 0;
+            for (int x = 0; x < r.w; ++x) {
+                if (!mask.is_set(r.x + x, r.y + y)) continue;
+                double cx = x + 0.5;
+                while (span + 1 < crossings.size() && crossings[span + 1] <= cx) span += 2;
+                if (span + 1 >= crossings.size() || !(crossings[span] < cx && cx < crossings[span + 1])) return false;
+            }
+        }
+
+        // And no edge cuts through an opaque pixel
+        for (size_t i = 0; i < n; ++i) {
+            const OutlinePoint& a = outline[i];
+            const OutlinePoint& b = outline[(i + 1) % n];
+            int y0 = std::max(0, std::min(a.y, b.y)), y1 = std::min(r.h, std::max(a.y, b.y));
+            int x0 = std::max(0, std::min(a.x, b.x)), x1 = std::min(r.w, std::max(a.x, b.x));
+            if (a.x == b.x || a.y == b.y) continue;
+            for (int y = y0; y < y1; ++y) {
+                // Columns the edge spans within this row
+                double ya = y, yb = y + 1.0;
+                double xa = a.x + (ya - a.y) * double(b.x - a.x) / double(b.y - a.y);
+                double xb = a.x + (yb - a.y) * double(b.x - a.x) / double(b.y - a.y);
+                int c0 = std::max(x0, (int)std::floor(std::min(xa, xb)));
+                int c1 = std::min(x1, (int)std::ceil(std::max(xa, xb)));
+                for (int x = c0; x < c1; ++x) {
+                    if (mask.is_set(r.x + x, r.y + y) && crosses_pixel(a, b, x, y)) return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    void trace_outline(const AlphaMask& mask, const Region& region, const OutlineOptions& options, Outline& outline) {
+        int max_vertices = std::max(4, options.max_vertices);
+        float epsilon = std::max(0.0f, options.epsilon);
+
+        Grid grid;
+        Outline traced, simplified;
+        for (int attempt = 0; attempt < MAX_ATTEMPTS; ++attempt) {
+            // Growing by the tolerance keeps the simplified edges off the pixels
+            int grow = (int)std::ceil(epsilon);
+            build_grid(mask, region, grow, grid);
+            if (!trace(grid, traced)) {
+                rectangle(region, outline);
+                return;
+            }
+            simplify(traced, epsilon, simplified);
+
+            if ((int)simplified.size() <= max_vertices) {
+                for (OutlinePoint& p : simplified) {
+                    p.x = std::min(region.w, std::max(0, p.x - grow));
+                    p.y = std::min(region.h, std::max(0, p.y - grow));
+                }
+                if (is_simple(simplified) && outline_covers(mask, region, simplified)) {
+                    outline = simplified;
+                    return;
+                }
+            }
+            epsilon = epsilon > 0.0f ? epsilon * EPSILON_GROWTH : 1.0f;
+        }
+
+        // Several components or a budget too tight for the shape
+        convex_hull(mask, region, outline);
+        if (outline.size() < 3 || (int)outline.size() > max_vertices) rectangle(region, outline);
+    }
+
+    bool trace_outlines(const AlphaMask& mask, const std::vector<Region>& regions, const OutlineOptions& options,
+        std::vector<Outline>& outlines, const ParallelFor& parallel_for, int tasks, const SliceProgress* progress) {
+        int count = (int)regions.size();
+        outlines.assign(regions.size(), Outline());
+
+        tasks = std::max(1, std::min(tasks, count));
+        int per_task = count > 0 ? (count + tasks - 1) / tasks : 0;
+        TaskFn task = [&](int t) {
+            int end = std::min(count, (t + 1) * per_task);
+            for (int i = t * per_task; i < end; ++i) {
+                if (progress && progress->is_cancelled()) return;
+                trace_outline(mask, regions[i], options, outlines[i]);
+            }
+        };
+        if (tasks == 1) task(0);
+        else parallel_for(tasks, task);
+
+        return !(progress && progress->is_cancelled());
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <vector>
+
+#include "AlphaMask.h"
+#include "ParallelFor.h"
+#include "SliceProgress.h"
+#include "SliceTypes.h"
+
+namespace spritecutter {
+
+    /**
+     * @brief A polygon vertex on the pixel corner grid, relative to the region's top-left.
+     */
+    struct OutlinePoint {
+        int x, y;
+    };
+
+    using Outline = std::vector<OutlinePoint>;
+
+    struct OutlineOptions {
+        // Largest distance, in pixels, the simplified outline may stray from the traced one
+        float epsilon = 2.0f;
+
+        // Vertex budget: the tolerance is raised until the outline fits
+        int max_vertices = 16;
+    };
+
+    /**
+     * @brief Traces a short polygon around the opaque pixels of a region.
+     *
+     * The pixels are grown by the tolerance, their outer boundary is traced with marching
+     *
+     * squares and simplified with Douglas-Peucker. The result always covers every opaque
+     *
+     * pixel of the region: when a simplified outline doesn't, e.g. for a region holding
+     *
+     * several far apart components, the convex hull is used, then the rectangle itself.
+     *
+     * @param mask Occupancy mask the region was detected in.
+     * @param region Rectangle to trace, inside the mask.
+     * @param options Tolerance and vertex budget.
+     * @param outline Output polygon, clockwise with y down, inside [0, w] x [0, h].
+     */
+    void trace_outline(const AlphaMask& mask, const Region& region, const OutlineOptions& options, Outline& outline);
+
+    /**
+     * @brief Traces every region, split between `tasks` tasks.
+     *
+     * @param mask Occupancy mask the regions were detected in.
+     * @param regions Rectangles to trace, inside the mask.
+     * @param options Tolerance and vertex budget.
+     * @param outlines Output polygons, one per region.
+     * @param parallel_for Scheduler for the tasks.
+     * @param tasks Number of tasks, 1 to stay on the calling thread.
+     * @param progress Optional cancellation, checked between regions.
+     * @return false if cancelled.
+     */
+    bool trace_outlines(const AlphaMask& mask, const std::vector<Region>& regions, const OutlineOptions& options,
+        std::vector<Outline>& outlines, const ParallelFor& parallel_for = serial_for, int tasks = 1, const SliceProgress* progress = nullptr);
+
+    /**
+     * @brief Returns true if every opaque pixel of the region lies entirely inside the outline.
+     */
+    bool outline_covers(const AlphaMask& mask, const Region& region, const Outline& outline);
+}
@@ -0,0 +1,38 @@
+#include "ParallelFor.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace spritecutter {
+
+    void serial_for(int count, const TaskFn& task) {
+        for (int i = 0; i < count; ++i) task(i);
+    }
+
+    ParallelFor thread_for(int threads) {
+        if (threads <= 0)
+            threads = std::max(1, (int)std::thread::hardware_concurrency());
+
+        return [threads](int count, const TaskFn& task) {
+            int workers = std::min(threads, count);
+            if (workers <= 1) {
+                serial_for(count, task);
+                return;
+            }
+
+            // Workers pull indices from a shared counter so uneven tasks balance out
+            std::atomic<int> next{ 0 };
+            auto work = [&]() {
+                for (int i = next++; i < count; i = next++) task(i);
+            };
+
+            std::vector<std::thread> pool;
+            pool.reserve(workers - 1);
+            for (int t = 1; t < workers; ++t) pool.emplace_back(work);
+            work();
+            for (std::thread& th : pool) th.join();
+        };
+    }
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <functional>
+
+namespace spritecutter {
+
+    /**
+     * @brief Indexed task body, called once per index, possibly from several threads at once.
+     */
+    using TaskFn = std::function<void(int index)>;
+
+    /**
+     * @brief Runs `task(i)` for every `i` in [0, count) and returns once all calls are done.
+     *
+     * The core never creates threads on its own: callers plug in the scheduler they have,
+     *
+     * the WorkerThreadPool inside Godot, serial_for() or thread_for() elsewhere.
+     */
+    using ParallelFor = std::function<void(int count, const TaskFn& task)>;
+
+    /**
+     * @brief Runs every index on the calling thread.
+     */
+    void serial_for(int count, const TaskFn& task);
+
+    /**
+     * @brief Returns a ParallelFor that spreads the indices over `threads` std::threads.
+     *
+     * Threads are started and joined on each call, which is fine for a handful of
+     *
+     * coarse tasks. Meant for the native test and benchmark tools.
+     *
+     * @param threads Number of threads, <= 0 for std::thread::hardware_concurrency().
+     */
+    ParallelFor thread_for(int threads);
+}
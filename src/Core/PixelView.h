@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace spritecutter {
+
+    /**
+     * @brief Pixel layouts the core can read alpha from.
+     *
+     * FORMAT_OPAQUE stands for any layout without an alpha channel: every pixel
+     *
+     * reads back with alpha = 1 and its bytes are never touched.
+     */
+    enum PixelFormat {
+        FORMAT_OPAQUE,
+        FORMAT_LA8,
+        FORMAT_RGBA8,
+        FORMAT_RGBA4444,
+        FORMAT_RGBAH,
+        FORMAT_RGBAF,
+    };
+
+    /**
+     * @brief Returns the size of one pixel in bytes, 0 for FORMAT_OPAQUE.
+     */
+    inline size_t pixel_size(PixelFormat format) {
+        switch (format) {
+            case FORMAT_LA8: return 2;
+            case FORMAT_RGBA8: return 4;
+            case FORMAT_RGBA4444: return 2;
+            case FORMAT_RGBAH: return 8;
+            case FORMAT_RGBAF: return 16;
+            default: return 0;
+        }
+    }
+
+    /**
+     * @brief Non-owning view of an uncompressed pixel buffer.
+     *
+     * Rows are `row_pitch` bytes apart, which may be more than `width * pixel_size()`.
+     */
+    struct PixelView {
+        const uint8_t* data = nullptr;
+        int width = 0;
+        int height = 0;
+        size_t row_pitch = 0;
+        PixelFormat format = FORMAT_RGBA8;
+
+        /**
+         * @brief Makes a view of a tightly packed buffer.
+         */
+        static PixelView packed(const uint8_t* data, int width, int height, PixelFormat format) {
+            PixelView v;
+            v.data = data;
+            v.width = width;
+            v.height = height;
+            v.row_pitch = size_t(width > 0 ? width : 0) * pixel_size(format);
+            v.format = format;
+            return v;
+        }
+
+        const uint8_t* row(int y) const { return data + size_t(y) * row_pitch; }
+    };
+}
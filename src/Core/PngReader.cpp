@@ -0,0 +1,222 @@
+#include "PngReader.h"
+
+#include <cstring>
+#include <utility>
+
+namespace spritecutter {
+
+    namespace {
+        constexpr uint8_t SIGNATURE[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+
+        uint32_t read_be32(const uint8_t* p) {
+            return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+        }
+
+        uint16_t read_be16(const uint8_t* p) {
+            return uint16_t((p[0] << 8) | p[1]);
+        }
+
+        bool is_chunk(const uint8_t* type, const char* name) {
+            return std::memcmp(type, name, 4) == 0;
+        }
+
+        // Sample `x` of a row packed at 1, 2, 4 or 8 bits, most significant bits first
+        uint32_t read_sample(const uint8_t* row, int x, int depth) {
+            size_t bit = size_t(x) * depth;
+            return (row[bit >> 3] >> (8 - depth - int(bit & 7))) & ((1u << depth) - 1);
+        }
+
+        // 16 to 8 bits, rounded like libpng's PNG_DIV257
+        uint8_t reduce16(uint16_t v) {
+            return uint8_t((uint32_t(v) * 255 + 32895) >> 16);
+        }
+
+        uint8_t paeth(int a, int b, int c) {
+            int p = a + b - c;
+            int pa = p > a ? p - a : a - p;
+            int pb = p > b ? p - b : b - p;
+            int pc = p > c ? p - c : c - p;
+            if (pa <= pb && pa <= pc) return uint8_t(a);
+            return uint8_t(pb <= pc ? b : c);
+        }
+
+        bool unfilter(uint8_t filter, uint8_t* row, const uint8_t* prev, size_t n, size_t bpp) {
+            switch (filter) {
+                case 0:
+                    return true;
+                case 1:
+                    for (size_t i = bpp; i < n; ++i) row[i] = uint8_t(row[i] + row[i - bpp]);
+                    return true;
+                case 2:
+                    for (size_t i = 0; i < n; ++i) row[i] = uint8_t(row[i] + prev[i]);
+                    return true;
+                case 3:
+                    for (size_t i = 0; i < bpp && i < n; ++i) row[i] = uint8_t(row[i] + (prev[i] >> 1));
+                    for (size_t i = bpp; i < n; ++i) row[i] = uint8_t(row[i] + ((row[i - bpp] + prev[i]) >> 1));
+                    return true;
+                case 4:
+                    for (size_t i = 0; i < bpp && i < n; ++i) row[i] = uint8_t(row[i] + prev[i]);
+                    for (size_t i = bpp; i < n; ++i) row[i] = uint8_t(row[i] + paeth(row[i - bpp], prev[i], prev[i - bpp]));
+                    return true;
+                default:
+                    return false;
+            }
+        }
+    }
+
+    bool PngReader::open(const uint8_t* data, size_t size) {
+        width = height = 0;
+        next_row = 0;
+        format = FORMAT_OPAQUE;
+        palette_alpha_count = 0;
+        has_key = false;
+        idat.clear();
+        if (!data || size < sizeof(SIGNATURE) || std::memcmp(data, SIGNATURE, sizeof(SIGNATURE)) != 0) return false;
+
+        bool header = false;
+        size_t pos = sizeof(SIGNATURE);
+        while (size - pos >= 12) {
+            uint32_t len = read_be32(data + pos);
+            const uint8_t* type = data + pos + 4;
+            const uint8_t* body = data + pos + 8;
+            if (len > size - pos - 12) return false;
+            pos += 12 + size_t(len);
+
+            if (!header) {
+                if (!is_chunk(type, "IHDR") || len != 13) return false;
+                uint32_t w = read_be32(body), h = read_be32(body + 4);
+                if (w == 0 || h == 0 || w > 0x7FFFFFFF || h > 0x7FFFFFFF) return false;
+                width = int(w);
+                height = int(h);
+                bit_depth = body[8];
+                color_type = body[9];
+
+                // Compression and filter methods 0, no interlacing
+                if (body[10] != 0 || body[11] != 0 || body[12] != 0) return false;
+                header = true;
+                continue;
+            }
+
+            if (is_chunk(type, "IDAT")) {
+                idat.push_back({ body, len });
+            } else if (is_chunk(type, "tRNS")) {
+                if (color_type == COLOR_PALETTE && len <= 256) {
+                    std::memcpy(palette_alpha, body, len);
+                    palette_alpha_count = int(len);
+                } else if (color_type == COLOR_GRAY && len == 2) {
+                    key[0] = read_be16(body);
+                    has_key = true;
+                } else if (color_type == COLOR_RGB && len == 6) {
+                    for (int c = 0; c < 3; ++c) key[c] = read_be16(body + 2 * c);
+                    has_key = true;
+                }
+            } else if (is_chunk(type, "IEND")) {
+                break;
+            } else if (!(type[0] & 0x20) && !is_chunk(type, "PLTE")) {
+                // Unknown critical chunk: the image can't be decoded without it
+                return false;
+            }
+        }
+        if (!header || idat.empty()) return false;
+
+        int channels;
+        bool depth_ok;
+        switch (color_type) {
+            case COLOR_GRAY:
+                channels = 1;
+                depth_ok = bit_depth == 1 || bit_depth == 2 || bit_depth == 4 || bit_depth == 8 || bit_depth == 16;
+                break;
+            case COLOR_PALETTE:
+                channels = 1;
+                depth_ok = bit_depth == 1 || bit_depth == 2 || bit_depth == 4 || bit_depth == 8;
+                break;
+            case COLOR_RGB:
+                channels = 3;
+                depth_ok = bit_depth == 8 || bit_depth == 16;
+                break;
+            case COLOR_GRAY_ALPHA:
+                channels = 2;
+                depth_ok = bit_depth == 8 || bit_depth == 16;
+                break;
+            case COLOR_RGBA:
+                channels = 4;
+                depth_ok = bit_depth == 8 || bit_depth == 16;
+                break;
+            default:
+                return false;
+        }
+        if (!depth_ok) return false;
+
+        size_t bits_per_pixel = size_t(channels) * size_t(bit_depth);
+        filter_bytes = bits_per_pixel >= 8 ? bits_per_pixel / 8 : 1;
+        row_bytes = (size_t(width) * bits_per_pixel + 7) / 8;
+
+        if (color_type == COLOR_RGBA && bit_depth == 8) format = FORMAT_RGBA8;
+        else if (color_type == COLOR_RGBA || color_type == COLOR_GRAY_ALPHA) format = FORMAT_LA8;
+        else if (palette_alpha_count > 0 || has_key) format = FORMAT_LA8;
+        else return true;
+
+        prev.assign(row_bytes + 1, 0);
+        cur.assign(row_bytes + 1, 0);
+        return inflater.reset(&idat, true);
+    }
+
+    bool PngReader::read_rows(int rows, uint8_t* out, size_t pitch) {
+        if (rows < 0 || rows > height - next_row) return false;
+        if (format == FORMAT_OPAQUE) {
+            next_row += rows;
+            return true;
+        }
+
+        // 8-bit RGBA and gray + alpha are already in a layout the mask reads
+        bool direct = bit_depth == 8 && (color_type == COLOR_RGBA || color_type == COLOR_GRAY_ALPHA);
+        for (int r = 0; r < rows; ++r) {
+            if (inflater.read(cur.data(), cur.size()) != long(cur.size())) return false;
+            if (!unfilter(cur[0], cur.data() + 1, prev.data() + 1, row_bytes, filter_bytes)) return false;
+
+            uint8_t* dst = out + size_t(r) * pitch;
+            if (direct) std::memcpy(dst, cur.data() + 1, row_bytes);
+            else convert_row(cur.data() + 1, dst);
+
+            std::swap(prev, cur);
+            ++next_row;
+        }
+        return true;
+    }
+
+    void PngReader::convert_row(const uint8_t* row, uint8_t* out) const {
+        for (int x = 0; x < width; ++x) {
+            uint8_t a = 255;
+            switch (color_type) {
+                case COLOR_GRAY_ALPHA:
+                    a = reduce16(read_be16(row + 4 * size_t(x) + 2));
+                    break;
+                case COLOR_RGBA:
+                    a = reduce16(read_be16(row + 8 * size_t(x) + 6));
+                    break;
+                case COLOR_PALETTE: {
+                    uint32_t index = read_sample(row, x, bit_depth);
+                    if (int(index) < palette_alpha_count) a = palette_alpha[index];
+                    break;
+                }
+                case COLOR_GRAY: {
+                    uint32_t v = bit_depth == 16 ? read_be16(row + 2 * size_t(x)) : read_sample(row, x, bit_depth);
+                    if (v == key[0]) a = 0;
+                    break;
+                }
+                case COLOR_RGB: {
+                    bool match = true;
+                    for (int c = 0; c < 3; ++c) {
+                        size_t i = size_t(x) * 3 + c;
+                        uint32_t v = bit_depth == 16 ? read_be16(row + 2 * i) : row[i];
+                        match = match && v == key[c];
+                    }
+                    if (match) a = 0;
+                    break;
+                }
+            }
+            out[2 * x] = 0;
+            out[2 * x + 1] = a;
+        }
+    }
+}
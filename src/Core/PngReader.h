@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Inflate.h"
+#include "PixelView.h"
+
+namespace spritecutter {
+
+    /**
+     * @brief Streaming PNG decoder that only recovers what the alpha mask needs.
+     *
+     * Reads an encoded file in place, typically memory-mapped, and hands out rows
+     *
+     * top to bottom: memory is one row of filtered data and the inflate window,
+     *
+     * whatever the image size.
+     *
+     * RGBA8 files come out as FORMAT_RGBA8 and gray + alpha 8 as FORMAT_LA8, both
+     *
+     * copied as is. Every other layout with transparency (16-bit, palette with tRNS,
+     *
+     * color key) comes out as FORMAT_LA8 holding only the alpha, reduced to 8 bits
+     *
+     * the way libpng does. Files without transparency are FORMAT_OPAQUE and never decoded.
+     *
+     * Interlaced files are not supported. Chunk CRCs and the Adler-32 are not checked.
+     */
+    class PngReader {
+        public:
+            PngReader() = default;
+            PngReader(const PngReader&) = delete;
+            PngReader& operator=(const PngReader&) = delete;
+
+            /**
+             * @brief Parses the chunks and positions the reader on the first row.
+             *
+             * @param data Encoded file, kept by pointer: it must outlive the reader.
+             * @param size Size of the file in bytes.
+             * @return false if the file is not a PNG this reader supports.
+             */
+            bool open(const uint8_t* data, size_t size);
+
+            /**
+             * @brief Decodes the next `rows` rows.
+             *
+             * @param rows Rows to decode, at most get_height() - get_next_row().
+             * @param out Output pixels in get_format(). Unused for FORMAT_OPAQUE.
+             * @param pitch Bytes between two output rows.
+             * @return false on malformed or truncated data.
+             */
+            bool read_rows(int rows, uint8_t* out, size_t pitch);
+
+            int get_width() const { return width; }
+            int get_height() const { return height; }
+            int get_next_row() const { return next_row; }
+
+            /**
+             * @brief Returns the layout of the rows read_rows() hands out.
+             */
+            PixelFormat get_format() const { return format; }
+
+        private:
+            enum ColorType {
+                COLOR_GRAY = 0,
+                COLOR_RGB = 2,
+                COLOR_PALETTE = 3,
+                COLOR_GRAY_ALPHA = 4,
+                COLOR_RGBA = 6,
+            };
+
+            // Rebuilds the alpha of one unfiltered row into LA8
+            void convert_row(const uint8_t* row, uint8_t* out) const;
+
+            int width = 0;
+            int height = 0;
+            int bit_depth = 0;
+            int color_type = 0;
+            PixelFormat format = FORMAT_OPAQUE;
+
+            // Bytes per complete pixel (at least 1) and per filtered row, filter byte excluded
+            size_t filter_bytes = 0;
+            size_t row_bytes = 0;
+
+            // tRNS: palette alphas, or the gray / RGB color key as 16-bit samples
+            uint8_t palette_alpha[256];
+            int palette_alpha_count = 0;
+            bool has_key = false;
+            uint16_t key[3] = {};
+
+            std::vector<ByteSpan> idat;
+            Inflater inflater;
+
+            // Previous and current filtered rows, filter byte first
+            std::vector<uint8_t> prev;
+            std::vector<uint8_t> cur;
+            int next_row = 0;
+    };
+}
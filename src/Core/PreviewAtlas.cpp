@@ -0,0 +1,203 @@
+#include "PreviewAtlas.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace spritecutter {
+
+    namespace {
+        // Empty pixels between thumbnails, keeps filtering from bleeding a neighbour in
+        constexpr int GAP = 1;
+
+        // Icon size kept at each shrink step when the atlas doesn't fit
+        constexpr int SHRINK_NUM = 3;
+        constexpr int SHRINK_DEN = 4;
+
+        /**
+         * @brief Clips a region to the image, returns false if nothing is left.
+         */
+        bool clip(const Region& r, int width, int height, PreviewRect& out) {
+            int x0 = std::max(0, r.x), y0 = std::max(0, r.y);
+            int x1 = std::min(width, r.x + r.w), y1 = std::min(height, r.y + r.h);
+            if (x1 <= x0 || y1 <= y0) return false;
+            out = { x0, y0, x1 - x0, y1 - y0 };
+            return true;
+        }
+
+        /**
+         * @brief Sizes and packs the thumbnails for one icon size, returns the atlas height.
+         */
+        int layout(const std::vector<PreviewRect>& sources, int icon, std::vector<PreviewRect>& rects, int& width) {
+            std::vector<PreviewRect> sizes(sources.size());
+            long long area = 0;
+            int widest = 1;
+            for (size_t i = 0; i < sources.size(); ++i) {
+                int w = 0, h = 0;
+                if (sources[i].w > 0) fit_thumbnail(sources[i].w, sources[i].h, icon, w, h);
+                sizes[i] = { 0, 0, w + GAP, h + GAP };
+                area += (long long)sizes[i].w * sizes[i].h;
+                widest = std::max(widest, sizes[i].w);
+            }
+
+            // Roughly square, shelves waste a little so aim slightly wider
+            width = (int)std::ceil(std::sqrt(double(area)) * 1.1);
+            width = std::min(MAX_PREVIEW_SIDE, std::max(widest, width));
+
+            int height = pack_shelves(sizes, width, rects);
+            for (PreviewRect& r : rects) {
+                r.w = std::max(0, r.w - GAP);
+                r.h = std::max(0, r.h - GAP);
+            }
+            return height;
+        }
+    }
+
+    void fit_thumbnail(int w, int h, int icon, int& out_w, int& out_h) {
+        icon = std::max(1, icon);
+        if (w <= icon && h <= icon) {
+            out_w = std::max(1, w);
+            out_h = std::max(1, h);
+            return;
+        }
+
+        if (w >= h) {
+            out_w = icon;
+            out_h = (int)((long long)h * icon / w);
+        } else {
+            out_h = icon;
+            out_w = (int)((long long)w * icon / h);
+        }
+        out_w = std::max(1, out_w);
+        out_h = std::max(1, out_h);
+    }
+
+    int pack_shelves(const std::vector<PreviewRect>& sizes, int width, std::vector<PreviewRect>& placed) {
+        placed.assign(sizes.size(), PreviewRect{ 0, 0, 0, 0 });
+
+        std::vector<int> order(sizes.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return sizes[a].h > sizes[b].h; });
+
+        int x = 0, y = 0, shelf_height = 0;
+        for (int i : order) {
+            const PreviewRect& s = sizes[i];
+            if (x > 0 && x + s.w > width) {
+                y += shelf_height;
+                x = 0;
+                shelf_height = 0;
+            }
+            placed[i] = { x, y, s.w, s.h };
+            x += s.w;
+            shelf_height = std::max(shelf_height, s.h);
+        }
+        return y + shelf_height;
+    }
+
+    void downscale_box(const PixelView& source, const PreviewRect& rect, uint8_t* out, size_t out_pitch, int out_w, int out_h) {
+        if (out_w <= 0 || out_h <= 0) return;
+
+        // Source columns each output column covers, at least one since we never enlarge
+        std::vector<int> x_bounds(size_t(out_w) + 1);
+        for (int ox = 0; ox <= out_w; ++ox)
+            x_bounds[ox] = rect.x + int((long long)ox * rect.w / out_w);
+
+        // Per output column: alpha-weighted r, g, b, then alpha
+        std::vector<uint64_t> sums(size_t(out_w) * 4);
+        for (int oy = 0; oy < out_h; ++oy) {
+            int y0 = rect.y + int((long long)oy * rect.h / out_h);
+            int y1 = rect.y + int((long long)(oy + 1) * rect.h / out_h);
+            std::fill(sums.begin(), sums.end(), 0);
+
+            for (int y = y0; y < y1; ++y) {
+                const uint8_t* row = source.row(y);
+                for (int ox = 0; ox < out_w; ++ox) {
+                    uint64_t r = 0, g = 0, b = 0, a = 0;
+                    for (int x = x_bounds[ox]; x < x_bounds[ox + 1]; ++x) {
+                        const uint8_t* p = row + size_t(x) * 4;
+                        uint32_t alpha = p[3];
+                        r += p[0] * alpha;
+                        g += p[1] * alpha;
+                        b += p[2] * alpha;
+                        a += alpha;
+                    }
+                    uint64_t* s = &sums[size_t(ox) * 4];
+                    s[0] += r;
+                    s[1] += g;
+                    s[2] += b;
+                    s[3] += a;
+                }
+            }
+
+            uint8_t* dst = out + size_t(oy) * out_pitch;
+            for (int ox = 0; ox < out_w; ++ox) {
+                const uint64_t* s = &sums[size_t(ox) * 4];
+                uint64_t count = uint64_t(x_bounds[ox + 1] - x_bounds[ox]) * uint64_t(y1 - y0);
+                uint64_t a = s[3];
+                uint8_t* p = dst + size_t(ox) * 4;
+                if (a == 0) {
+                    p[0] = p[1] = p[2] = p[3] = 0;
+                    continue;
+                }
+                p[0] = uint8_t((s[0] + a / 2) / a);
+                p[1] = uint8_t((s[1] + a / 2) / a);
+                p[2] = uint8_t((s[2] + a / 2) / a);
+                p[3] = uint8_t((a + count / 2) / count);
+            }
+        }
+    }
+
+    bool build_preview_atlas(const PixelView& source, const std::vector<Region>& regions, int icon_size, size_t max_bytes,
+        PreviewAtlas& atlas, const ParallelFor& parallel_for, int tasks, const SliceProgress* progress) {
+        atlas = PreviewAtlas();
+        if (source.format != FORMAT_RGBA8) return false;
+
+        // Empty regions keep a 0x0 rect so indices still line up
+        std::vector<PreviewRect> sources(regions.size(), PreviewRect{ 0, 0, 0, 0 });
+        for (size_t i = 0; i < regions.size(); ++i) {
+            if (!clip(regions[i], source.width, source.height, sources[i])) sources[i] = { 0, 0, 0, 0 };
+        }
+
+        // Lower the icon size until the atlas fits the side limit and the budget
+        int icon = std::max(1, icon_size);
+        int width = 0, height = 0;
+        for (;;) {
+            height = layout(sources, icon, atlas.rects, width);
+            bool fits = height <= MAX_PREVIEW_SIDE && size_t(width) * size_t(height) * 4 <= max_bytes;
+            if (fits || icon == 1) break;
+            icon = std::max(1, icon * SHRINK_NUM / SHRINK_DEN);
+        }
+
+        // Only reachable with millions of regions: the ones past the limit get no thumbnail
+        if (height > MAX_PREVIEW_SIDE) {
+            height = MAX_PREVIEW_SIDE;
+            for (PreviewRect& r : atlas.rects)
+                if (r.y + r.h > height) r = { 0, 0, 0, 0 };
+        }
+
+        atlas.width = width;
+        atlas.height = std::max(1, height);
+        atlas.icon_size = icon;
+        atlas.rgba.assign(size_t(atlas.width) * atlas.height * 4, 0);
+
+        // Thumbnails don't overlap, so tasks write without locking
+        int count = (int)regions.size();
+        tasks = std::max(1, std::min(tasks, count));
+        int per_task = count > 0 ? (count + tasks - 1) / tasks : 0;
+        size_t pitch = size_t(atlas.width) * 4;
+        TaskFn task = [&](int t) {
+            int end = std::min(count, (t + 1) * per_task);
+            for (int i = t * per_task; i < end; ++i) {
+                if (progress && progress->is_cancelled()) return;
+                const PreviewRect& dst = atlas.rects[i];
+                if (sources[i].w <= 0 || dst.w <= 0) continue;
+                uint8_t* out = atlas.rgba.data() + size_t(dst.y) * pitch + size_t(dst.x) * 4;
+                downscale_box(source, sources[i], out, pitch, dst.w, dst.h);
+            }
+        };
+        if (tasks == 1) task(0);
+        else parallel_for(tasks, task);
+
+        return !(progress && progress->is_cancelled());
+    }
+}
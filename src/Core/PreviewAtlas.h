@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "ParallelFor.h"
+#include "PixelView.h"
+#include "SliceProgress.h"
+#include "SliceTypes.h"
+
+namespace spritecutter {
+
+    /**
+     * @brief Where a thumbnail lies in a PreviewAtlas.
+     */
+    struct PreviewRect {
+        int x, y, w, h;
+    };
+
+    /**
+     * @brief Downscaled copies of many regions packed into one RGBA8 image.
+     */
+    struct PreviewAtlas {
+        int width = 0;
+        int height = 0;
+
+        // Side of the square the thumbnails were fitted in, smaller than asked when the budget forced it
+        int icon_size = 0;
+
+        // Tightly packed RGBA8, transparent between thumbnails
+        std::vector<uint8_t> rgba;
+
+        // One per region, in the order of the regions
+        std::vector<PreviewRect> rects;
+    };
+
+    /**
+     * @brief Returns the size of a `w` x `h` region fitted in an `icon` square.
+     *
+     * Keeps the aspect ratio, never enlarges, and is at least 1x1.
+     */
+    void fit_thumbnail(int w, int h, int icon, int& out_w, int& out_h);
+
+    /**
+     * @brief Packs rectangles on shelves of a `width` wide strip, tallest first.
+     *
+     * @param sizes Sizes to place, only `w` and `h` are read.
+     * @param width Width of the strip. Rectangles wider than it are placed alone on a shelf.
+     * @param placed Output positions, in the order of `sizes`.
+     * @return The height used.
+     */
+    int pack_shelves(const std::vector<PreviewRect>& sizes, int width, std::vector<PreviewRect>& placed);
+
+    /**
+     * @brief Shrinks a rectangle of an RGBA8 image with a box filter.
+     *
+     * Each output pixel averages the source pixels it covers.
+     *
+     * Colors are weighted by alpha, so transparent pixels don't darken the edges.
+     *
+     * @param source RGBA8 pixels.
+     * @param rect Rectangle of `source` to read, inside its bounds.
+     * @param out First output pixel, RGBA8.
+     * @param out_pitch Bytes between two output rows.
+     * @param out_w Output width, at most `rect.w`.
+     * @param out_h Output height, at most `rect.h`.
+     */
+    void downscale_box(const PixelView& source, const PreviewRect& rect, uint8_t* out, size_t out_pitch, int out_w, int out_h);
+
+    /**
+     * @brief Builds one preview image holding a thumbnail of every region.
+     *
+     * Thumbnails are fitted in `icon_size` squares; if the atlas would exceed `max_bytes`
+     *
+     * or MAX_PREVIEW_SIDE, the icon size is lowered until it fits. Regions are split
+     *
+     * between `tasks` tasks, each writing its own thumbnails.
+     *
+     * @param source RGBA8 pixels of the sliced image.
+     * @param regions Regions to preview, clipped to `source`.
+     * @param icon_size Side of the square each thumbnail fits in.
+     * @param max_bytes Memory allowed for the atlas pixels.
+     * @param atlas Output atlas. Regions outside `source` get a 0x0 rect.
+     * @param parallel_for Scheduler for the tasks.
+     * @param tasks Number of tasks, 1 to stay on the calling thread.
+     * @param progress Optional cancellation, checked between regions.
+     * @return false if `source` isn't RGBA8 or the build was cancelled.
+     */
+    bool build_preview_atlas(const PixelView& source, const std::vector<Region>& regions, int icon_size, size_t max_bytes,
+        PreviewAtlas& atlas, const ParallelFor& parallel_for = serial_for, int tasks = 1, const SliceProgress* progress = nullptr);
+
+    // Largest width or height of a preview atlas, what every GPU takes
+    constexpr int MAX_PREVIEW_SIDE = 8192;
+}
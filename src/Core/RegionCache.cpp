@@ -0,0 +1,388 @@
+#include "RegionCache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <system_error>
+
+#include "Hash.h"
+
+namespace fs = std::filesystem;
+
+namespace spritecutter {
+
+    namespace {
+        constexpr uint8_t MAGIC[4] = { 'S', 'C', 'R', 'C' };
+        constexpr uint8_t VERSION = 1;
+        constexpr const char* EXTENSION = ".scr";
+
+        // Rough per-entry bookkeeping: list node, index slot, vector header
+        constexpr size_t ENTRY_OVERHEAD = 96;
+
+        uint32_t float_bits(float f) {
+            uint32_t bits;
+            std::memcpy(&bits, &f, sizeof(bits));
+            return bits;
+        }
+
+        void put_u32(std::vector<uint8_t>& out, uint32_t v) {
+            for (int i = 0; i < 4; ++i) out.push_back(uint8_t(v >> (8 * i)));
+        }
+
+        void put_u64(std::vector<uint8_t>& out, uint64_t v) {
+            for (int i = 0; i < 8; ++i) out.push_back(uint8_t(v >> (8 * i)));
+        }
+
+        void put_varint(std::vector<uint8_t>& out, uint32_t v) {
+            while (v >= 0x80) {
+                out.push_back(uint8_t(v | 0x80));
+                v >>= 7;
+            }
+            out.push_back(uint8_t(v));
+        }
+
+        // Bounds-checked reader over a serialized table
+        struct Reader {
+            const uint8_t* p;
+            const uint8_t* end;
+
+            bool u8(uint8_t& v) {
+                if (p >= end) return false;
+                v = *p++;
+                return true;
+            }
+
+            bool u32(uint32_t& v) {
+                if (end - p < 4) return false;
+                v = 0;
+                for (int i = 0; i < 4; ++i) v |= uint32_t(p[i]) << (8 * i);
+                p += 4;
+                return true;
+            }
+
+            bool u64(uint64_t& v) {
+                if (end - p < 8) return false;
+                v = 0;
+                for (int i = 0; i < 8; ++i) v |= uint64_t(p[i]) << (8 * i);
+                p += 8;
+                return true;
+            }
+
+            bool varint(uint32_t& v) {
+                v = 0;
+                for (int shift = 0; shift < 35; shift += 7) {
+                    uint8_t b;
+                    if (!u8(b)) return false;
+                    v |= uint32_t(b & 0x7F) << shift;
+                    if (!(b & 0x80)) return true;
+                }
+                return false;
+            }
+        };
+
+        size_t entry_bytes(const std::vector<Region>& regions) {
+            return regions.size() * sizeof(Region) + ENTRY_OVERHEAD;
+        }
+
+        bool parse_id(const std::string& stem, uint64_t& id) {
+            if (stem.size() != 16) return false;
+            char* end = nullptr;
+            id = std::strtoull(stem.c_str(), &end, 16);
+            return end == stem.c_str() + stem.size();
+        }
+    }
+
+    uint64_t CacheKey::id() const {
+        uint64_t h = hash_combine(content, alpha_threshold);
+        h = hash_combine(h, uint64_t(uint32_t(min_pixels)));
+        return hash_combine(h, float_bits(merge_margin));
+    }
+
+    bool CacheKey::operator==(const CacheKey& other) const {
+        return content == other.content
+            && alpha_threshold == other.alpha_threshold
+            && min_pixels == other.min_pixels
+            && float_bits(merge_margin) == float_bits(other.merge_margin);
+    }
+
+    void encode_regions(const CacheKey& key, const std::vector<Region>& regions, std::vector<uint8_t>& out) {
+        out.clear();
+        out.reserve(32 + regions.size() * 8);
+        out.insert(out.end(), MAGIC, MAGIC + 4);
+        out.push_back(VERSION);
+        put_u64(out, key.content);
+        out.push_back(key.alpha_threshold);
+        put_u32(out, uint32_t(key.min_pixels));
+        put_u32(out, float_bits(key.merge_margin));
+        put_varint(out, uint32_t(regions.size()));
+
+        for (const Region& r : regions) {
+            put_varint(out, uint32_t(r.x));
+            put_varint(out, uint32_t(r.y));
+            put_varint(out, uint32_t(r.w));
+            put_varint(out, uint32_t(r.h));
+            put_varint(out, uint32_t(r.count));
+        }
+
+        put_u64(out, hash_bytes(out.data(), out.size()));
+    }
+
+    bool decode_regions(const uint8_t* data, size_t size, CacheKey& key, std::vector<Region>& regions) {
+        if (size < 8 + 4 || std::memcmp(data, MAGIC, 4) != 0) return false;
+
+        // Checksum first, so nothing below runs on damaged bytes
+        size_t body = size - 8;
+        Reader tail{ data + body, data + size };
+        uint64_t checksum;
+        if (!tail.u64(checksum) || checksum != hash_bytes(data, body)) return false;
+
+        Reader in{ data + 4, data + body };
+        uint8_t version;
+        uint32_t min_pixels, margin_bits, count;
+        if (!in.u8(version) || version != VERSION) return false;
+        if (!in.u64(key.content) || !in.u8(key.alpha_threshold) || !in.u32(min_pixels) || !in.u32(margin_bits)) return false;
+        if (!in.varint(count)) return false;
+        key.min_pixels = int(min_pixels);
+        std::memcpy(&key.merge_margin, &margin_bits, sizeof(margin_bits));
+
+        // Each region takes at least 5 bytes, reject counts the buffer can't hold
+        if (count > size_t(in.end - in.p) / 5) return false;
+
+        regions.resize(count);
+        for (Region& r : regions) {
+            uint32_t v[5];
+            for (uint32_t& f : v)
+                if (!in.varint(f)) return false;
+            r = Region{ int(v[0]), int(v[1]), int(v[2]), int(v[3]), int(v[4]) };
+        }
+        return in.p == in.end;
+    }
+
+    RegionCache::RegionCache(size_t p_memory_budget, size_t p_disk_budget)
+        : memory_budget(p_memory_budget), disk_budget(p_disk_budget) {}
+
+    bool RegionCache::open(const std::string& p_directory) {
+        std::lock_guard<std::mutex> lock(mutex);
+        disk.clear();
+        disk_index.clear();
+        disk_size = 0;
+        directory.clear();
+        if (p_directory.empty()) return true;
+
+        std::error_code ec;
+        fs::path dir = fs::u8path(p_directory);
+        fs::create_directories(dir, ec);
+        if (!fs::is_directory(dir, ec)) return false;
+        directory = p_directory;
+
+        // Index what previous sessions left, oldest first
+        struct Found {
+            uint64_t id;
+            size_t bytes;
+            fs::file_time_type time;
+        };
+        std::vector<Found> found;
+        for (fs::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+            const fs::path& path = it->path();
+            uint64_t id;
+            if (path.extension() != EXTENSION || !parse_id(path.stem().string(), id)) continue;
+            std::error_code file_ec;
+            size_t bytes = size_t(it->file_size(file_ec));
+            fs::file_time_type time = it->last_write_time(file_ec);
+            if (!file_ec) found.push_back({ id, bytes, time });
+        }
+        std::sort(found.begin(), found.end(), [](const Found& a, const Found& b) { return a.time > b.time; });
+
+        for (const Found& f : found) {
+            disk.push_back({ f.id, f.bytes });
+            disk_index[f.id] = std::prev(disk.end());
+            disk_size += f.bytes;
+        }
+        trim();
+        return true;
+    }
+
+    void RegionCache::close() {
+        std::lock_guard<std::mutex> lock(mutex);
+        directory.clear();
+        disk.clear();
+        disk_index.clear();
+        disk_size = 0;
+    }
+
+    bool RegionCache::find(const CacheKey& key, std::vector<Region>& regions) {
+        std::lock_guard<std::mutex> lock(mutex);
+        uint64_t id = key.id();
+
+        auto it = memory_index.find(id);
+        if (it != memory_index.end() && it->second->key == key) {
+            memory.splice(memory.begin(), memory, it->second);
+            regions = it->second->regions;
+            return true;
+        }
+
+        std::vector<Region> loaded;
+        if (!read_disk(key, loaded)) return false;
+        regions = loaded;
+        insert_memory(key, loaded);
+        trim();
+        return true;
+    }
+
+    void RegionCache::insert(const CacheKey& key, const std::vector<Region>& regions) {
+        std::lock_guard<std::mutex> lock(mutex);
+        insert_memory(key, regions);
+        write_disk(key, regions);
+        trim();
+    }
+
+    void RegionCache::erase(const CacheKey& key) {
+        std::lock_guard<std::mutex> lock(mutex);
+        uint64_t id = key.id();
+        auto it = memory_index.find(id);
+        if (it != memory_index.end()) {
+            memory_size -= it->second->bytes;
+            memory.erase(it->second);
+            memory_index.erase(it);
+        }
+        erase_disk(id);
+    }
+
+    void RegionCache::clear() {
+        std::lock_guard<std::mutex> lock(mutex);
+        memory.clear();
+        memory_index.clear();
+        memory_size = 0;
+        while (!disk.empty()) erase_disk(disk.back().id);
+    }
+
+    void RegionCache::set_budgets(size_t p_memory_budget, size_t p_disk_budget) {
+        std::lock_guard<std::mutex> lock(mutex);
+        memory_budget = p_memory_budget;
+        disk_budget = p_disk_budget;
+        trim();
+    }
+
+    size_t RegionCache::get_memory_size() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return memory_size;
+    }
+
+    size_t RegionCache::get_disk_size() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return disk_size;
+    }
+
+    size_t RegionCache::get_memory_entries() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return memory.size();
+    }
+
+    size_t RegionCache::get_disk_entries() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return disk.size();
+    }
+
+    void RegionCache::insert_memory(const CacheKey& key, const std::vector<Region>& regions) {
+        uint64_t id = key.id();
+        auto it = memory_index.find(id);
+        if (it != memory_index.end()) {
+            memory_size -= it->second->bytes;
+            memory.erase(it->second);
+            memory_index.erase(it);
+        }
+
+        size_t bytes = entry_bytes(regions);
+        memory.push_front({ key, regions, bytes });
+        memory_index[id] = memory.begin();
+        memory_size += bytes;
+    }
+
+    bool RegionCache::read_disk(const CacheKey& key, std::vector<Region>& regions) {
+        if (directory.empty()) return false;
+        uint64_t id = key.id();
+        auto it = disk_index.find(id);
+        if (it == disk_index.end()) return false;
+
+        std::string path = file_path(id);
+        std::vector<uint8_t> bytes;
+        {
+            std::ifstream file(fs::u8path(path), std::ios::binary);
+            if (file) bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+
+        CacheKey stored;
+        if (!decode_regions(bytes.data(), bytes.size(), stored, regions) || !(stored == key)) {
+            // Damaged, truncated or an id collision: not worth keeping
+            erase_disk(id);
+            return false;
+        }
+
+        // Touch the file so the next session sees it as recently used
+        std::error_code ec;
+        fs::last_write_time(fs::u8path(path), fs::file_time_type::clock::now(), ec);
+        disk.splice(disk.begin(), disk, it->second);
+        return true;
+    }
+
+    void RegionCache::write_disk(const CacheKey& key, const std::vector<Region>& regions) {
+        if (directory.empty()) return;
+        uint64_t id = key.id();
+        std::vector<uint8_t> bytes;
+        encode_regions(key, regions, bytes);
+
+        // Write aside then rename, readers in other processes never see half a file
+        std::string path = file_path(id);
+        std::string temp = path + ".tmp";
+        {
+            std::ofstream file(fs::u8path(temp), std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char*>(bytes.data()), std::streamsize(bytes.size()));
+            if (!file) return;
+        }
+        std::error_code ec;
+        fs::rename(fs::u8path(temp), fs::u8path(path), ec);
+        if (ec) {
+            fs::remove(fs::u8path(temp), ec);
+            return;
+        }
+
+        auto it = disk_index.find(id);
+        if (it != disk_index.end()) {
+            disk_size -= it->second->bytes;
+            disk.erase(it->second);
+        }
+        disk.push_front({ id, bytes.size() });
+        disk_index[id] = disk.begin();
+        disk_size += bytes.size();
+    }
+
+    void RegionCache::erase_disk(uint64_t id) {
+        auto it = disk_index.find(id);
+        if (it == disk_index.end()) return;
+
+        std::error_code ec;
+        fs::remove(fs::u8path(file_path(id)), ec);
+        disk_size -= it->second->bytes;
+        disk.erase(it->second);
+        disk_index.erase(it);
+    }
+
+    void RegionCache::trim() {
+        while (memory_size > memory_budget && !memory.empty()) {
+            memory_size -= memory.back().bytes;
+            memory_index.erase(memory.back().key.id());
+            memory.pop_back();
+        }
+        while (disk_size > disk_budget && !disk.empty()) erase_disk(disk.back().id);
+    }
+
+    std::string RegionCache::file_path(uint64_t id) const {
+        char name[24];
+        std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(id));
+        return (fs::u8path(directory) / (std::string(name) + EXTENSION)).u8string();
+    }
+}
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "SliceTypes.h"
+
+namespace spritecutter {
+
+    /**
+     * @brief Everything a region table depends on: the pixels and the slicing parameters.
+     */
+    struct CacheKey {
+        // hash_bytes() of the pixel data, its size and format
+        uint64_t content = 0;
+
+        uint8_t alpha_threshold = 0;
+        int min_pixels = 0;
+        float merge_margin = 0.0f;
+
+        /**
+         * @brief Hash of every field, names the entry on disk.
+         */
+        uint64_t id() const;
+
+        bool operator==(const CacheKey& other) const;
+    };
+
+    /**
+     * @brief Serializes a region table with its key.
+     *
+     * Layout: a header (magic, version, key, region count), the regions as LEB128
+     *
+     * varints, and an XXH64 checksum of everything before it. Typical sheets take
+     *
+     * 5 to 8 bytes per region.
+     */
+    void encode_regions(const CacheKey& key, const std::vector<Region>& regions, std::vector<uint8_t>& out);
+
+    /**
+     * @brief Reads back a table written by encode_regions().
+     *
+     * @param data Serialized bytes.
+     * @param size Number of bytes.
+     * @param key Output key stored with the table.
+     * @param regions Output regions.
+     * @return false on a truncated, corrupted or foreign buffer.
+     */
+    bool decode_regions(const uint8_t* data, size_t size, CacheKey& key, std::vector<Region>& regions);
+
+    /**
+     * @brief Region tables of already sliced sheets, in memory and optionally on disk.
+     *
+     * Both levels are least-recently-used lists capped in bytes. A disk hit is
+     *
+     * promoted to memory, a new table is written to both. Each disk entry is one
+     *
+     * `<id>.scr` file, so the cache survives restarts and is shared by every process
+     *
+     * pointed at the same directory. Files that fail their checksum are deleted.
+     *
+     * Thread-safe.
+     */
+    class RegionCache {
+        public:
+            explicit RegionCache(size_t memory_budget = DEFAULT_MEMORY_BUDGET, size_t disk_budget = DEFAULT_DISK_BUDGET);
+
+            /**
+             * @brief Keeps entries in `directory` as well, creating it if needed.
+             *
+             * Existing files are indexed, least recently used first by modification time.
+             *
+             * @param directory Native path, UTF-8. Empty to keep entries in memory only.
+             * @return false if the directory can't be created.
+             */
+            bool open(const std::string& directory);
+
+            /**
+             * @brief Stops using the disk directory. Memory entries are kept.
+             */
+            void close();
+
+            /**
+             * @brief Copies the regions stored for `key` into `regions`.
+             *
+             * @return false on a miss, `regions` is then untouched.
+             */
+            bool find(const CacheKey& key, std::vector<Region>& regions);
+
+            /**
+             * @brief Stores the regions sliced for `key`, evicting the oldest entries over budget.
+             */
+            void insert(const CacheKey& key, const std::vector<Region>& regions);
+
+            /**
+             * @brief Drops the entry of `key` from memory and disk.
+             */
+            void erase(const CacheKey& key);
+
+            /**
+             * @brief Drops every entry, including the files of the disk directory.
+             */
+            void clear();
+
+            void set_budgets(size_t p_memory_budget, size_t p_disk_budget);
+
+            size_t get_memory_size() const;
+            size_t get_disk_size() const;
+            size_t get_memory_entries() const;
+            size_t get_disk_entries() const;
+
+            // 8 MiB hold the tables of a few hundred sheets of a thousand sprites
+            static constexpr size_t DEFAULT_MEMORY_BUDGET = size_t(8) << 20;
+            static constexpr size_t DEFAULT_DISK_BUDGET = size_t(64) << 20;
+
+        private:
+            struct MemoryEntry {
+                CacheKey key;
+                std::vector<Region> regions;
+                size_t bytes;
+            };
+
+            struct DiskEntry {
+                uint64_t id;
+                size_t bytes;
+            };
+
+            void insert_memory(const CacheKey& key, const std::vector<Region>& regions);
+            bool read_disk(const CacheKey& key, std::vector<Region>& regions);
+            void write_disk(const CacheKey& key, const std::vector<Region>& regions);
+            void erase_disk(uint64_t id);
+            void trim();
+            std::string file_path(uint64_t id) const;
+
+            mutable std::mutex mutex;
+
+            // Most recently used at the front
+            std::list<MemoryEntry> memory;
+            std::unordered_map<uint64_t, std::list<MemoryEntry>::iterator> memory_index;
+            size_t memory_size = 0;
+
+            std::string directory;
+            std::list<DiskEntry> disk;
+            std::unordered_map<uint64_t, std::list<DiskEntry>::iterator> disk_index;
+            size_t disk_size = 0;
+
+            size_t memory_budget;
+            size_t disk_budget;
+    };
+}
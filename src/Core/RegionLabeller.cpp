@@ -0,0 +1,540 @@
+#include "RegionLabeller.h"
+
+#include <algorithm>
+#include <atomic>
+#include <numeric>
+
+#include "Hash.h"
+
+namespace spritecutter {
+
+    namespace {
+        // Horizontal run of opaque pixels [x0, x1) on row y
+        struct Run {
+            int x0, x1, y;
+        };
+
+        // Runs and local union-find forest of one horizontal tile
+        struct Tile {
+            int y0 = 0, y1 = 0;
+            std::vector<Run> runs;
+            std::vector<int> parent;
+
+            // Runs [0, first_row_end) lie on row y0, runs [last_row_begin, size) on row y1 - 1
+            int first_row_end = 0;
+            int last_row_begin = 0;
+        };
+
+        // Bounds and pixel count of a component of label_regions()
+        struct LabelComponent {
+            int minx, miny, maxx, maxy;
+            int count;
+        };
+
+        int find_root(std::vector<int>& parent, int i) {
+            while (parent[i] != i) {
+                parent[i] = parent[parent[i]];
+                i = parent[i];
+            }
+            return i;
+        }
+
+        // Links the two sets under the smaller index, so a root is always the
+        // first run of its component in raster order
+        void unite(std::vector<int>& parent, int a, int b) {
+            a = find_root(parent, a);
+            b = find_root(parent, b);
+            if (a == b) return;
+            if (a < b) parent[b] = a;
+            else parent[a] = b;
+        }
+
+        // Calls f(p, c) for every pair of 8-connected runs of two consecutive rows.
+        // Both rows are sorted by x and only need x0 and x1.
+        template<class Above, class Below, class F>
+        void for_each_contact(const Above* above, int above_count, const Below* below, int below_count, F&& f) {
+            int p = 0;
+            for (int c = 0; c < below_count; ++c) {
+                // Skip previous-row runs that end left of this run (diagonal contact included)
+                while (p < above_count && above[p].x1 < below[c].x0) ++p;
+
+                // Every run starting at or before x1 touches this one, the last may also touch the next
+                for (int q = p; q < above_count && above[q].x0 <= below[c].x1; ++q) f(q, c);
+            }
+        }
+
+        // Unites every run of [cur, cur_end) with the 8-connected runs of [prev, prev_end)
+        void unite_rows(std::vector<int>& parent, const Run* runs, int prev, int prev_end, int cur, int cur_end) {
+            for_each_contact(runs + prev, prev_end - prev, runs + cur, cur_end - cur,
+                [&](int q, int c) { unite(parent, prev + q, cur + c); });
+        }
+
+        // Appends the runs of one mask row
+        void extract_runs(const uint64_t* row, int words, int y, std::vector<Run>& runs) {
+            int wi = 0;
+            uint64_t word = words > 0 ? row[0] : 0;
+            for (;;) {
+                // Skip empty words
+                while (word == 0) {
+                    if (++wi >= words) return;
+                    word = row[wi];
+                }
+                int x0 = (wi << 6) + AlphaMask::ctz(word);
+
+                // Scan for the first clear bit at or after x0
+                uint64_t inv = ~row[wi] & (~uint64_t(0) << (x0 & 63));
+                while (inv == 0) {
+                    if (++wi >= words) break;
+                    inv = ~row[wi];
+                }
+                if (wi >= words) {
+                    runs.push_back({ x0, words << 6, y });
+                    return;
+                }
+
+                int x1 = (wi << 6) + AlphaMask::ctz(inv);
+                runs.push_back({ x0, x1, y });
+                word = row[wi] & (~uint64_t(0) << (x1 & 63));
+            }
+        }
+
+        // Extracts and labels the runs of rows [tile.y0, tile.y1)
+        void label_tile(const AlphaMask& mask, Tile& tile, const SliceProgress* progress) {
+            int words = mask.get_words_per_row();
+            int prev = 0, prev_end = 0;
+
+            for (int y = tile.y0; y < tile.y1; ++y) {
+                if (progress && (y & 63) == 0 && progress->is_cancelled()) return;
+
+                int cur = (int)tile.runs.size();
+                extract_runs(mask.get_row(y), words, y, tile.runs);
+                int cur_end = (int)tile.runs.size();
+
+                for (int i = cur; i < cur_end; ++i) tile.parent.push_back(i);
+                if (y > tile.y0)
+                    unite_rows(tile.parent, tile.runs.data(), prev, prev_end, cur, cur_end);
+                if (y == tile.y0)
+                    tile.first_row_end = cur_end;
+
+                prev = cur;
+                prev_end = cur_end;
+            }
+            tile.last_row_begin = prev;
+        }
+
+        // Reduces a labelled tile to its components (minx, miny, maxx, maxy, count) in raster
+        // order of their first run, and the runs of its first and last rows (x0, x1, component).
+        // Rows are shifted by y_offset.
+        template<class Comp, class Edge>
+        void summarize_tile(Tile& tile, int y_offset, std::vector<Comp>& comps, std::vector<Edge>& top, std::vector<Edge>& bottom) {
+            int run_count = (int)tile.runs.size();
+            std::vector<int> comp_of(run_count);
+            for (int r = 0; r < run_count; ++r) {
+                const Run& run = tile.runs[r];
+                int y = run.y + y_offset;
+                int root = find_root(tile.parent, r);
+                if (root == r) {
+                    comp_of[r] = (int)comps.size();
+                    comps.push_back({ run.x0, y, run.x1 - 1, y, 0 });
+                }
+                comp_of[r] = comp_of[root];
+
+                Comp& c = comps[comp_of[r]];
+                c.minx = std::min(c.minx, run.x0);
+                c.maxx = std::max(c.maxx, run.x1 - 1);
+                c.maxy = std::max(c.maxy, y);
+                c.count += run.x1 - run.x0;
+            }
+            for (int r = 0; r < tile.first_row_end; ++r)
+                top.push_back({ tile.runs[r].x0, tile.runs[r].x1, comp_of[r] });
+            for (int r = tile.last_row_begin; r < run_count; ++r)
+                bottom.push_back({ tile.runs[r].x0, tile.runs[r].x1, comp_of[r] });
+        }
+    }
+
+    struct LabelWorkspace::Buffers {
+        // Only the first tile_count tiles are used, the others keep their capacity
+        std::vector<Tile> tiles;
+        std::vector<int> offsets;
+        std::vector<Run> runs;
+        std::vector<int> parent;
+        std::vector<LabelComponent> comps;
+        std::vector<int> comp_of;
+    };
+
+    LabelWorkspace::LabelWorkspace() = default;
+    LabelWorkspace::~LabelWorkspace() = default;
+
+    void label_regions(const AlphaMask& mask, const LabelOptions& options, std::vector<Region>& regions,
+        const ParallelFor& parallel_for, SliceProgress* progress) {
+        LabelWorkspace workspace;
+        label_regions(mask, options, regions, workspace, parallel_for, progress);
+    }
+
+    void label_regions(const AlphaMask& mask, const LabelOptions& options, std::vector<Region>& regions,
+        LabelWorkspace& workspace, const ParallelFor& parallel_for, SliceProgress* progress) {
+        int h = mask.get_height();
+        if (h <= 0 || mask.get_width() <= 0) return;
+        if (!workspace.buffers) workspace.buffers.reset(new LabelWorkspace::Buffers);
+        LabelWorkspace::Buffers& b = *workspace.buffers;
+
+        // Split the rows into horizontal tiles, a few per thread so uneven tiles balance out
+        int threads = std::max(1, options.threads);
+        int tile_h = threads > 1 ? std::max(std::max(1, options.min_tile_rows), (h + threads * 4 - 1) / (threads * 4)) : h;
+        int tile_count = (h + tile_h - 1) / tile_h;
+
+        std::vector<Tile>& tiles = b.tiles;
+        if ((int)tiles.size() < tile_count) tiles.resize(tile_count);
+        for (int i = 0; i < tile_count; ++i) {
+            Tile& tile = tiles[i];
+            tile.y0 = i * tile_h;
+            tile.y1 = std::min(h, (i + 1) * tile_h);
+            tile.runs.clear();
+            tile.parent.clear();
+            tile.first_row_end = tile.last_row_begin = 0;
+        }
+
+        // Label each tile independently. Only wrapped in a TaskFn when scheduled.
+        std::atomic<int> tiles_done{ 0 };
+        auto task = [&](int i) {
+            label_tile(mask, tiles[i], progress);
+            if (progress) progress->report(++tiles_done, tile_count);
+        };
+        if (tile_count == 1) task(0);
+        else parallel_for(tile_count, TaskFn(task));
+        if (progress && progress->is_cancelled()) return;
+
+        // Concatenate the tiles into one forest. Runs stay in raster order.
+        std::vector<int>& offsets = b.offsets;
+        offsets.resize(tile_count);
+        int total = 0;
+        for (int i = 0; i < tile_count; ++i) {
+            offsets[i] = total;
+            total += (int)tiles[i].runs.size();
+        }
+
+        std::vector<Run>& runs = b.runs;
+        std::vector<int>& parent = b.parent;
+        runs.resize(total);
+        parent.resize(total);
+        for (int i = 0; i < tile_count; ++i) {
+            const Tile& t = tiles[i];
+            for (size_t r = 0; r < t.runs.size(); ++r) {
+                runs[offsets[i] + r] = t.runs[r];
+                parent[offsets[i] + r] = offsets[i] + t.parent[r];
+            }
+        }
+
+        // Join labels across tile seams
+        for (int i = 1; i < tile_count; ++i) {
+            const Tile& above = tiles[i - 1];
+            const Tile& below = tiles[i];
+            unite_rows(parent, runs.data(),
+                offsets[i - 1] + above.last_row_begin, offsets[i - 1] + (int)above.runs.size(),
+                offsets[i], offsets[i] + below.first_row_end);
+        }
+
+        // Accumulate bounds and pixel counts. Roots come first in raster order, so
+        // components are created in the order a raster scan would first meet them.
+        std::vector<LabelComponent>& comps = b.comps;
+        std::vector<int>& comp_of = b.comp_of;
+        comps.clear();
+        comp_of.resize(total);
+
+        for (int i = 0; i < total; ++i) {
+            const Run& r = runs[i];
+            int root = find_root(parent, i);
+            if (root == i) {
+                comp_of[i] = (int)comps.size();
+                comps.push_back({ r.x0, r.y, r.x1 - 1, r.y, 0 });
+            }
+
+            LabelComponent& c = comps[comp_of[root]];
+            c.minx = std::min(c.minx, r.x0);
+            c.maxx = std::max(c.maxx, r.x1 - 1);
+            c.maxy = std::max(c.maxy, r.y);
+            c.count += r.x1 - r.x0;
+        }
+
+        // Add regions that contain enough pixels
+        for (const LabelComponent& c : comps) {
+            if (c.count >= options.min_pixels) {
+                regions.push_back({ c.minx, c.miny, c.maxx - c.minx + 1, c.maxy - c.miny + 1, c.count });
+            }
+        }
+    }
+
+    void label_regions_reference(const AlphaMask& mask, int min_pixels, std::vector<Region>& regions) {
+        const int w = mask.get_width();
+        const int h = mask.get_height();
+        std::vector<char> seen(size_t(w) * h, 0);
+        std::vector<int> stack;
+
+        for (int y = 0; y < h; ++y) {
+            for (int x = 0; x < w; ++x) {
+                size_t start = size_t(y) * w + x;
+                if (seen[start] || !mask.is_set(x, y)) continue;
+
+                int minx = x, maxx = x, miny = y, maxy = y, count = 0;
+                seen[start] = 1;
+                stack.assign(1, int(start));
+                while (!stack.empty()) {
+                    int p = stack.back();
+                    stack.pop_back();
+                    int px = p % w, py = p / w;
+                    ++count;
+                    minx = std::min(minx, px);
+                    maxx = std::max(maxx, px);
+                    miny = std::min(miny, py);
+                    maxy = std::max(maxy, py);
+
+                    for (int dy = -1; dy <= 1; ++dy) {
+                        for (int dx = -1; dx <= 1; ++dx) {
+                            int nx = px + dx, ny = py + dy;
+                            if (nx < 0 || ny < 0 || nx >= w || ny >= h) continue;
+                            size_t n = size_t(ny) * w + nx;
+                            if (seen[n] || !mask.is_set(nx, ny)) continue;
+                            seen[n] = 1;
+                            stack.push_back(int(n));
+                        }
+                    }
+                }
+                if (count >= min_pixels)
+                    regions.push_back({ minx, miny, maxx - minx + 1, maxy - miny + 1, count });
+            }
+        }
+    }
+
+    int strip_rows_for_budget(int width, size_t pixel_bytes, size_t budget) {
+        if (width <= 0) return 1;
+        size_t row_bytes = size_t(width) * pixel_bytes + size_t((width + 63) / 64) * sizeof(uint64_t);
+        return (int)std::max<size_t>(1, std::min<size_t>(budget / row_bytes, size_t(1) << 30));
+    }
+
+    bool label_strips(int width, int height, int strip_rows, const StripReader& read, uint8_t alpha_threshold,
+        const LabelOptions& options, std::vector<Region>& regions, SliceProgress* progress) {
+        if (width <= 0 || height <= 0) return true;
+        strip_rows = std::max(1, std::min(strip_rows, height));
+
+        // Components seen so far, compacted to the open ones after each strip.
+        // `first` numbers them in raster order of their first run, the order of the output.
+        struct Component {
+            int minx, miny, maxx, maxy;
+            int count;
+            int first;
+        };
+        struct Edge {
+            int x0, x1;
+            int component;
+        };
+        std::vector<Component> comps;
+        std::vector<int> parent;
+        std::vector<Edge> carry, top, bottom;
+        std::vector<std::pair<int, Region>> closed;
+        int next_first = 0;
+
+        // Joins two sets under the one met first, folding bounds and counts into its root
+        auto join = [&](int a, int b) {
+            a = find_root(parent, a);
+            b = find_root(parent, b);
+            if (a == b) return;
+            if (comps[b].first < comps[a].first) std::swap(a, b);
+            Component& r = comps[a];
+            const Component& o = comps[b];
+            r.minx = std::min(r.minx, o.minx);
+            r.miny = std::min(r.miny, o.miny);
+            r.maxx = std::max(r.maxx, o.maxx);
+            r.maxy = std::max(r.maxy, o.maxy);
+            r.count += o.count;
+            parent[b] = a;
+        };
+
+        auto close = [&](const Component& c) {
+            if (c.count >= options.min_pixels)
+                closed.push_back({ c.first, { c.minx, c.miny, c.maxx - c.minx + 1, c.maxy - c.miny + 1, c.count } });
+        };
+
+        AlphaMask mask;
+        for (int y0 = 0; y0 < height; y0 += strip_rows) {
+            if (progress && progress->is_cancelled()) return false;
+            int rows = std::min(strip_rows, height - y0);
+
+            PixelView strip;
+            if (!read(y0, rows, strip) || strip.width != width || strip.height != rows) return false;
+            if (!mask.build(strip, alpha_threshold)) return false;
+
+            Tile tile;
+            tile.y1 = rows;
+            label_tile(mask, tile, nullptr);
+
+            // Append the strip's components after the open ones
+            int base = (int)comps.size();
+            struct Local {
+                int minx, miny, maxx, maxy;
+                int count;
+            };
+            std::vector<Local> local;
+            top.clear();
+            bottom.clear();
+            summarize_tile(tile, y0, local, top, bottom);
+            for (const Local& l : local) {
+                comps.push_back({ l.minx, l.miny, l.maxx, l.maxy, l.count, next_first++ });
+                parent.push_back((int)parent.size());
+            }
+
+            // Join across the seam with the last row of the previous strip
+            for_each_contact(carry.data(), (int)carry.size(), top.data(), (int)top.size(),
+                [&](int q, int c) { join(carry[q].component, base + top[c].component); });
+
+            // Whatever does not reach the strip's last row is complete
+            std::vector<int> slot(comps.size(), -1);
+            for (const Edge& e : bottom) slot[find_root(parent, base + e.component)] = 0;
+
+            std::vector<Component> open;
+            for (int i = 0; i < (int)comps.size(); ++i) {
+                if (parent[i] != i) continue;
+                if (slot[i] < 0) {
+                    close(comps[i]);
+                } else {
+                    slot[i] = (int)open.size();
+                    open.push_back(comps[i]);
+                }
+            }
+
+            carry.clear();
+            for (const Edge& e : bottom) carry.push_back({ e.x0, e.x1, slot[find_root(parent, base + e.component)] });
+            comps.swap(open);
+            parent.resize(comps.size());
+            for (int i = 0; i < (int)parent.size(); ++i) parent[i] = i;
+
+            if (progress) progress->report(y0 + rows, height);
+        }
+        for (const Component& c : comps) close(c);
+
+        // Back to the order a raster scan meets the components
+        std::sort(closed.begin(), closed.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+        for (const auto& c : closed) regions.push_back(c.second);
+        return true;
+    }
+
+    IncrementalLabeller::IncrementalLabeller(int p_band_rows) : band_rows(std::max(1, p_band_rows)) {}
+
+    void IncrementalLabeller::label(const AlphaMask& mask, const LabelOptions& options, std::vector<Region>& regions,
+        const ParallelFor& parallel_for, SliceProgress* progress) {
+        std::lock_guard<std::mutex> lock(mutex);
+        relabelled = 0;
+        int w = mask.get_width(), h = mask.get_height();
+        if (h <= 0 || w <= 0) return;
+
+        if (w != width || h != height) {
+            bands.clear();
+            width = w;
+            height = h;
+        }
+
+        // Hash the bits of every band, the ones that differ are relabelled
+        int band_count = (h + band_rows - 1) / band_rows;
+        size_t row_bytes = size_t(mask.get_words_per_row()) * sizeof(uint64_t);
+        std::vector<uint64_t> hashes(band_count);
+        std::vector<int> dirty;
+        for (int i = 0; i < band_count; ++i) {
+            int y0 = i * band_rows;
+            int y1 = std::min(h, y0 + band_rows);
+            hashes[i] = hash_bytes(mask.get_row(y0), row_bytes * size_t(y1 - y0));
+            if (bands.empty() || bands[i].hash != hashes[i]) dirty.push_back(i);
+        }
+
+        // Label the dirty bands aside, so a cancelled call keeps the previous state
+        int dirty_count = (int)dirty.size();
+        std::vector<Band> fresh(dirty_count);
+        std::atomic<int> bands_done{ 0 };
+        TaskFn task = [&](int k) {
+            Tile tile;
+            tile.y0 = dirty[k] * band_rows;
+            tile.y1 = std::min(h, tile.y0 + band_rows);
+            label_tile(mask, tile, progress);
+
+            // Reduce the runs to components, keeping the edge rows for the seams
+            Band& band = fresh[k];
+            band.hash = hashes[dirty[k]];
+            summarize_tile(tile, 0, band.components, band.top, band.bottom);
+
+            if (progress) progress->report(++bands_done, dirty_count);
+        };
+        if (options.threads <= 1 || dirty_count <= 1) {
+            for (int k = 0; k < dirty_count; ++k) task(k);
+        } else {
+            parallel_for(dirty_count, task);
+        }
+        if (progress && progress->is_cancelled()) return;
+
+        bands.resize(band_count);
+        for (int k = 0; k < dirty_count; ++k) bands[dirty[k]] = std::move(fresh[k]);
+        relabelled = dirty_count;
+
+        // One forest over the components of every band, joined across the seams
+        std::vector<int> offsets(band_count);
+        int total = 0;
+        for (int i = 0; i < band_count; ++i) {
+            offsets[i] = total;
+            total += (int)bands[i].components.size();
+        }
+        std::vector<int> parent(total);
+        std::iota(parent.begin(), parent.end(), 0);
+
+        for (int i = 1; i < band_count; ++i) {
+            const Band& above = bands[i - 1];
+            const Band& below = bands[i];
+            for_each_contact(above.bottom.data(), (int)above.bottom.size(), below.top.data(), (int)below.top.size(),
+                [&](int q, int c) {
+                    unite(parent, offsets[i - 1] + above.bottom[q].component, offsets[i] + below.top[c].component);
+                });
+        }
+
+        // Components are numbered in raster order of their first run and roots are the
+        // smallest index of their set, so this is the order label_regions() produces
+        std::vector<Component> joined;
+        std::vector<int> slot(total);
+        int index = 0;
+        for (const Band& band : bands) {
+            for (const Component& c : band.components) {
+                int root = find_root(parent, index);
+                if (root == index) {
+                    slot[index] = (int)joined.size();
+                    joined.push_back(c);
+                } else {
+                    Component& j = joined[slot[root]];
+                    j.minx = std::min(j.minx, c.minx);
+                    j.maxx = std::max(j.maxx, c.maxx);
+                    j.maxy = std::max(j.maxy, c.maxy);
+                    j.count += c.count;
+                }
+                ++index;
+            }
+        }
+
+        for (const Component& c : joined) {
+            if (c.count >= options.min_pixels) {
+                regions.push_back({ c.minx, c.miny, c.maxx - c.minx + 1, c.maxy - c.miny + 1, c.count });
+            }
+        }
+    }
+
+    void IncrementalLabeller::reset() {
+        std::lock_guard<std::mutex> lock(mutex);
+        bands.clear();
+        width = 0;
+        height = 0;
+        relabelled = 0;
+    }
+
+    int IncrementalLabeller::get_band_count() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return (int)bands.size();
+    }
+
+    int IncrementalLabeller::get_relabelled_count() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return relabelled;
+    }
+}
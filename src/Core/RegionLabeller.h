@@ -0,0 +1,218 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "AlphaMask.h"
+#include "ParallelFor.h"
+#include "SliceProgress.h"
+#include "SliceTypes.h"
+
+namespace spritecutter {
+
+    /**
+     * @brief Tuning of label_regions().
+     */
+    struct LabelOptions {
+        // Components with fewer pixels are dropped
+        int min_pixels = 100;
+
+        // Smallest tile height handed to a labelling task
+        int min_tile_rows = 64;
+
+        // Threads the ParallelFor may use, 1 to label the whole mask as one tile
+        int threads = 1;
+    };
+
+    class LabelWorkspace;
+
+    /**
+     * @brief Detects 8-connected components of set bits in the mask.
+     *
+     * Uses a run-based union-find labeller. The mask is split into horizontal tiles
+     *
+     * labelled through `parallel_for`, then labels meeting at tile seams are joined.
+     *
+     * Regions come out in the order a raster scan first reaches them, whatever the tiling.
+     *
+     * @param mask The occupancy mask to scan.
+     * @param options Pixel floor and tiling.
+     * @param regions Output list, regions are appended.
+     * @param parallel_for Scheduler for the tiles.
+     * @param progress Optional progress and cancellation state, reported per tile.
+     */
+    void label_regions(const AlphaMask& mask, const LabelOptions& options, std::vector<Region>& regions,
+        const ParallelFor& parallel_for = serial_for, SliceProgress* progress = nullptr);
+
+    /**
+     * @brief label_regions() with its runs, forests and components in `workspace`.
+     *
+     * Once the workspace has grown to the mask, a serial call allocates nothing.
+     * 
+     * Tiles scheduled through `parallel_for` still cost their TaskFn.
+     */
+    void label_regions(const AlphaMask& mask, const LabelOptions& options, std::vector<Region>& regions,
+        LabelWorkspace& workspace, const ParallelFor& parallel_for = serial_for, SliceProgress* progress = nullptr);
+
+    /**
+     * @brief Buffers label_regions() keeps between calls.
+     *
+     * Allocated by the first call, they grow to the largest mask labelled and are
+     * never released. A workspace serves one call at a time.
+     */
+    class LabelWorkspace {
+        public:
+            LabelWorkspace();
+            ~LabelWorkspace();
+
+            LabelWorkspace(const LabelWorkspace&) = delete;
+            LabelWorkspace& operator=(const LabelWorkspace&) = delete;
+
+        private:
+            friend void label_regions(const AlphaMask& mask, const LabelOptions& options, std::vector<Region>& regions,
+                LabelWorkspace& workspace, const ParallelFor& parallel_for, SliceProgress* progress);
+
+            // Defined next to the labeller's run and tile types
+            struct Buffers;
+            std::unique_ptr<Buffers> buffers;
+    };
+
+    /**
+     * @brief A plain 8-connected flood fill, started from each unvisited pixel in raster order.
+     *
+     * Slow and serial. Kept as the reference label_regions(), label_strips() and
+     *
+     * IncrementalLabeller are checked against.
+     *
+     * @param mask The occupancy mask to scan.
+     * @param min_pixels Components with fewer pixels are dropped.
+     * @param regions Output list, regions are appended.
+     */
+    void label_regions_reference(const AlphaMask& mask, int min_pixels, std::vector<Region>& regions);
+
+    /**
+     * @brief Supplies rows [y0, y0 + rows) of the image being labelled by label_strips().
+     *
+     * The view must be `rows` high and stay valid until the next call.
+     *
+     * @return false on a read error, which stops the labelling.
+     */
+    using StripReader = std::function<bool(int y0, int rows, PixelView& strip)>;
+
+    /**
+     * @brief Returns the strip height that keeps a strip of pixels and its mask within `budget` bytes.
+     *
+     * @param width Image width.
+     * @param pixel_bytes Bytes per pixel of the strips the reader hands out.
+     * @param budget Bytes allowed for one strip.
+     * @return At least 1.
+     */
+    int strip_rows_for_budget(int width, size_t pixel_bytes, size_t budget);
+
+    /**
+     * @brief label_regions() on an image read one strip of rows at a time.
+     *
+     * Only the current strip, its mask and the components still open at its last row
+     *
+     * are kept, so memory depends on the width and the strip height, never on the
+     *
+     * image height. Closed components are reduced to their region right away.
+     *
+     * Gives the same regions, in the same order, as label_regions() on the whole mask.
+     *
+     * Runs on the calling thread.
+     *
+     * @param width Image width.
+     * @param height Image height.
+     * @param strip_rows Rows per strip, see strip_rows_for_budget().
+     * @param read Supplies the strips, top to bottom.
+     * @param alpha_threshold Pixels with alpha strictly above this value are opaque.
+     * @param options Pixel floor. Tiling and threads are ignored.
+     * @param regions Output list, regions are appended.
+     * @param progress Optional progress and cancellation state, reported per strip.
+     * @return false on a read error, a malformed strip or cancellation.
+     */
+    bool label_strips(int width, int height, int strip_rows, const StripReader& read, uint8_t alpha_threshold,
+        const LabelOptions& options, std::vector<Region>& regions, SliceProgress* progress = nullptr);
+
+    /**
+     * @brief label_regions() that reuses its work on an edited version of the same sheet.
+     *
+     * The mask is cut into horizontal bands of `band_rows` rows. For each band it keeps
+     *
+     * the hash of its bits, its local components and the runs of its first and last rows.
+     *
+     * The next label() call relabels only the bands whose bits changed, then joins the
+     *
+     * components of every band across the seams. The pixel work scales with the edit,
+     *
+     * what remains is proportional to the number of components.
+     *
+     * Gives the same regions, in the same order, as label_regions(). A mask of another
+     *
+     * size starts over. Calls are serialized.
+     */
+    class IncrementalLabeller {
+        public:
+            explicit IncrementalLabeller(int band_rows = DEFAULT_BAND_ROWS);
+
+            /**
+             * @brief Labels `mask` like label_regions(), reusing the unchanged bands of the last call.
+             *
+             * @param mask The occupancy mask to scan.
+             * @param options Pixel floor and threads. Bands replace `min_tile_rows`.
+             * @param regions Output list, regions are appended.
+             * @param parallel_for Scheduler for the changed bands.
+             * @param progress Optional progress and cancellation state, reported per changed band.
+             *        A cancelled call leaves the stored bands as they were.
+             */
+            void label(const AlphaMask& mask, const LabelOptions& options, std::vector<Region>& regions,
+                const ParallelFor& parallel_for = serial_for, SliceProgress* progress = nullptr);
+
+            /**
+             * @brief Forgets every band, the next call labels the whole mask.
+             */
+            void reset();
+
+            int get_band_rows() const { return band_rows; }
+            int get_band_count() const;
+
+            /**
+             * @brief Returns how many bands the last label() call had to relabel.
+             */
+            int get_relabelled_count() const;
+
+            static constexpr int DEFAULT_BAND_ROWS = 64;
+
+        private:
+            // Bounds and pixel count of a component, local to a band until joined
+            struct Component {
+                int minx, miny, maxx, maxy;
+                int count;
+            };
+
+            // Run [x0, x1) on the first or last row of a band, with its local component
+            struct Seam {
+                int x0, x1;
+                int component;
+            };
+
+            struct Band {
+                uint64_t hash = 0;
+                std::vector<Component> components;
+                std::vector<Seam> top;
+                std::vector<Seam> bottom;
+            };
+
+            mutable std::mutex mutex;
+            int band_rows;
+            int width = 0;
+            int height = 0;
+            int relabelled = 0;
+            std::vector<Band> bands;
+    };
+}
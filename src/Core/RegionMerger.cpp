@@ -0,0 +1,212 @@
+#include "RegionMerger.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace spritecutter {
+
+    namespace {
+        Region bounding_union(const Region& a, const Region& b) {
+            int x1 = std::min(a.x, b.x);
+            int y1 = std::min(a.y, b.y);
+            int x2 = std::max(a.x + a.w, b.x + b.w);
+            int y2 = std::max(a.y + a.h, b.y + b.h);
+            return { x1, y1, x2 - x1, y2 - y1, a.count + b.count };
+        }
+
+        // Uniform grid over the regions' bounds, on cell lists kept by the caller. Each cell
+        // lists the boxes that overlap it.
+        class Grid {
+            public:
+                Grid(const Region* boxes, size_t count, float margin, std::vector<std::vector<int>>& p_cells) : cells(p_cells) {
+                    int minx = boxes[0].x, miny = boxes[0].y;
+                    int maxx = boxes[0].x + boxes[0].w, maxy = boxes[0].y + boxes[0].h;
+                    double extent = 0.0;
+                    for (size_t i = 0; i < count; ++i) {
+                        const Region& r = boxes[i];
+                        minx = std::min(minx, r.x);
+                        miny = std::min(miny, r.y);
+                        maxx = std::max(maxx, r.x + r.w);
+                        maxy = std::max(maxy, r.y + r.h);
+                        extent += r.w + r.h;
+                    }
+
+                    // Cells about the size of an average grown box, but never more cells than regions
+                    double area = double(maxx - minx) * double(maxy - miny);
+                    double by_size = extent / (2.0 * count) + 2.0 * margin;
+                    double by_count = std::sqrt(area / double(count));
+                    cell = std::max(1, (int)std::ceil(std::max(by_size, by_count)));
+
+                    origin_x = minx;
+                    origin_y = miny;
+                    cols = (maxx - minx) / cell + 1;
+                    rows = (maxy - miny) / cell + 1;
+                    size_t used = size_t(cols) * size_t(rows);
+                    if (cells.size() < used) cells.resize(used);
+                    for (size_t i = 0; i < used; ++i) cells[i].clear();
+                }
+
+                void insert(int id, const Region& r) {
+                    int cx0, cy0, cx1, cy1;
+                    cover(float(r.x), float(r.y), float(r.x + r.w), float(r.y + r.h), cx0, cy0, cx1, cy1);
+                    for (int cy = cy0; cy <= cy1; ++cy)
+                        for (int cx = cx0; cx <= cx1; ++cx)
+                            cells[size_t(cy) * cols + cx].push_back(id);
+                }
+
+                // Cell range overlapping [x0, x1] x [y0, y1], clamped to the grid
+                void cover(float x0, float y0, float x1, float y1, int& cx0, int& cy0, int& cx1, int& cy1) const {
+                    cx0 = clamp_col((int)std::floor((x0 - origin_x) / cell));
+                    cx1 = clamp_col((int)std::floor((x1 - origin_x) / cell));
+                    cy0 = clamp_row((int)std::floor((y0 - origin_y) / cell));
+                    cy1 = clamp_row((int)std::floor((y1 - origin_y) / cell));
+                }
+
+                const std::vector<int>& at(int cx, int cy) const { return cells[size_t(cy) * cols + cx]; }
+
+            private:
+                int clamp_col(int c) const { return std::min(std::max(c, 0), cols - 1); }
+                int clamp_row(int r) const { return std::min(std::max(r, 0), rows - 1); }
+
+                int cell = 1;
+                int origin_x = 0, origin_y = 0;
+                int cols = 1, rows = 1;
+                std::vector<std::vector<int>>& cells;
+        };
+
+        // Union-find root with path halving
+        int find(std::vector<int>& parent, int i) {
+            while (parent[i] != i) {
+                parent[i] = parent[parent[i]];
+                i = parent[i];
+            }
+            return i;
+        }
+    }
+
+    size_t merge_regions(Region* regions, size_t count, float margin) {
+        MergeWorkspace workspace;
+        return merge_regions(regions, count, margin, workspace);
+    }
+
+    size_t merge_regions(Region* regions, size_t count, float margin, MergeWorkspace& workspace) {
+        if (count < 2) return count;
+
+        // Sort by X, ties in input order like the reference's stable sort, so output
+        // positions line up. std::sort needs no buffer, unlike std::stable_sort.
+        std::vector<int>& order = workspace.order;
+        order.resize(count);
+        for (size_t i = 0; i < count; ++i) order[i] = (int)i;
+        std::sort(order.begin(), order.end(), [&](int a, int b) {
+            return regions[a].x < regions[b].x || (regions[a].x == regions[b].x && a < b);
+        });
+
+        std::vector<Region>& boxes = workspace.boxes;
+        std::vector<Region>& next = workspace.next;
+        std::vector<int>& parent = workspace.parent;
+        std::vector<int>& slot = workspace.slot;
+        std::vector<int>& seen = workspace.seen;
+        // Both reserved, since they swap after each round
+        boxes.reserve(count);
+        next.reserve(count);
+        boxes.resize(count);
+        for (size_t i = 0; i < count; ++i) boxes[i] = regions[order[i]];
+
+        // Each round joins every touching pair of the current boxes at once, then replaces
+        // each group by its bounding box. A grown box may reach boxes its members didn't,
+        // so rounds repeat until one joins nothing. Boxes stay in the order of their first
+        // member, which is where the reference leaves each merged region.
+        size_t n = count;
+        while (n > 1) {
+            Grid grid(boxes.data(), n, margin, workspace.cells);
+            for (size_t i = 0; i < n; ++i) grid.insert((int)i, boxes[i]);
+
+            parent.resize(n);
+            for (size_t i = 0; i < n; ++i) parent[i] = (int)i;
+
+            // Stamp per box so candidates listed in several cells are tested once per query
+            seen.assign(n, -1);
+            bool joined = false;
+
+            for (size_t i = 0; i < n; ++i) {
+                const Region& q = boxes[i];
+                int cx0, cy0, cx1, cy1;
+                grid.cover(float(q.x) - margin, float(q.y) - margin, float(q.x + q.w) + margin, float(q.y + q.h) + margin, cx0, cy0, cx1, cy1);
+
+                for (int cy = cy0; cy <= cy1; ++cy) {
+                    for (int cx = cx0; cx <= cx1; ++cx) {
+                        for (int id : grid.at(cx, cy)) {
+                            // Pairs are tested once, from their lower box
+                            if (id <= (int)i || seen[id] == (int)i) continue;
+                            seen[id] = (int)i;
+                            if (!regions_touch(q, boxes[id], margin)) continue;
+
+                            // The lower index stays the root, so a group keeps its first member's place
+                            int a = find(parent, (int)i), b = find(parent, id);
+                            if (a == b) continue;
+                            if (a < b) parent[b] = a;
+                            else parent[a] = b;
+                            joined = true;
+                        }
+                    }
+                }
+            }
+            if (!joined) break;
+
+            // Compact the groups, roots come before their members
+            slot.resize(n);
+            next.clear();
+            for (size_t i = 0; i < n; ++i) {
+                int root = find(parent, (int)i);
+                if (root == (int)i) {
+                    slot[i] = (int)next.size();
+                    next.push_back(boxes[i]);
+                } else {
+                    Region& group = next[slot[root]];
+                    group = bounding_union(group, boxes[i]);
+                }
+            }
+            boxes.swap(next);
+            n = boxes.size();
+        }
+
+        std::copy(boxes.begin(), boxes.begin() + n, regions);
+        return n;
+    }
+
+    size_t merge_regions_reference(Region* regions, size_t count, float margin) {
+        std::vector<Region> r(regions, regions + count);
+
+        // Insertion sort by X to make spatial merging faster
+        for (int i = 1; i < (int)r.size(); ++i) {
+            Region key = r[i];
+            int j = i - 1;
+            while (j >= 0 && r[j].x > key.x) {
+                r[j + 1] = r[j];
+                --j;
+            }
+            r[j + 1] = key;
+        }
+
+        // Merge overlapping/nearby regions using a margin
+        bool merged = true;
+        while (merged) {
+            merged = false;
+            for (int i = 0; i < (int)r.size(); ++i) {
+                for (int j = i + 1; j < (int)r.size(); ++j) {
+                    if (regions_touch(r[i], r[j], margin)) {
+                        r[i] = bounding_union(r[i], r[j]);
+                        r.erase(r.begin() + j);
+                        merged = true;
+                        break;
+                    }
+                }
+                if (merged) break;
+            }
+        }
+
+        std::copy(r.begin(), r.end(), regions);
+        return r.size();
+    }
+}
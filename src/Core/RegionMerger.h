@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "SliceTypes.h"
+
+namespace spritecutter {
+
+    /**
+     * @brief Merges regions whose bounding boxes, grown by `margin`, intersect.
+     *
+     * Merging repeats until no two grown boxes intersect. That fixed point does not
+     * depend on the order of the merges, so each round joins every touching pair found
+     * through a uniform grid with a union-find, then checks the groups' bounding boxes
+     * again. A round costs roughly O(n log n), and a chain of any length joins in one.
+     *
+     * The output order matches merge_regions_reference(): regions are stably sorted by X,
+     * then each merged region takes the place of its first member.
+     *
+     * @param regions Regions to merge. Merged regions are compacted at the front.
+     * @param count Number of regions.
+     * @param margin Distance under which two regions are merged.
+     * @return The number of regions left.
+     */
+    size_t merge_regions(Region* regions, size_t count, float margin);
+
+    class MergeWorkspace;
+
+    /**
+     * @brief merge_regions() with its sort, boxes, grid and union-find in `workspace`.
+     *
+     * Once the workspace has grown to `count` regions, a call allocates nothing.
+     */
+    size_t merge_regions(Region* regions, size_t count, float margin, MergeWorkspace& workspace);
+
+    /**
+     * @brief Buffers merge_regions() keeps between calls.
+     *
+     * Empty until the first call, they grow to the most regions merged and are never
+     * released. A workspace serves one call at a time.
+     */
+    class MergeWorkspace {
+        private:
+            friend size_t merge_regions(Region* regions, size_t count, float margin, MergeWorkspace& workspace);
+
+            std::vector<int> order;
+            std::vector<Region> boxes;
+            std::vector<Region> next;
+            std::vector<int> parent;
+            std::vector<int> slot;
+            std::vector<int> seen;
+
+            // Grid cells, only the first cols * rows are used, the others keep their capacity
+            std::vector<std::vector<int>> cells;
+    };
+
+    /**
+     * @brief The original insertion-sort and restart-on-merge implementation.
+     *
+     * O(n³) on large inputs. Kept as the reference the fast path is checked against.
+     *
+     * @param regions Regions to merge. Merged regions are compacted at the front.
+     * @param count Number of regions.
+     * @param margin Distance under which two regions are merged.
+     * @return The number of regions left.
+     */
+    size_t merge_regions_reference(Region* regions, size_t count, float margin);
+
+    /**
+     * @brief Same test as `Rect2::grow(margin).intersects()` on integer rectangles.
+     */
+    inline bool regions_touch(const Region& a, const Region& b, float margin) {
+        return float(a.x) - margin < float(b.x + b.w)
+            && float(a.x + a.w) + margin > float(b.x)
+            && float(a.y) - margin < float(b.y + b.h)
+            && float(a.y + a.h) + margin > float(b.y);
+    }
+}
@@ -0,0 +1,58 @@
+#include "RegionStages.h"
+
+#include <utility>
+
+#include "RegionMerger.h"
+
+namespace spritecutter {
+
+    void RegionStages::set_components(std::vector<Region> p_components) {
+        components = std::move(p_components);
+        filter_stale = true;
+        merge_stale = true;
+    }
+
+    void RegionStages::set_min_pixels(int p_min_pixels) {
+        if (p_min_pixels == min_pixels) return;
+        min_pixels = p_min_pixels;
+        filter_stale = true;
+        merge_stale = true;
+    }
+
+    void RegionStages::set_merge_margin(float p_margin) {
+        if (p_margin == merge_margin) return;
+        merge_margin = p_margin;
+        merge_stale = true;
+    }
+
+    const std::vector<Region>& RegionStages::get_regions(SliceStats* stats) {
+        if (filter_stale) {
+            // Same test as the labeller's pixel floor
+            filtered.clear();
+            for (const Region& r : components) {
+                if (r.count >= min_pixels) filtered.push_back(r);
+            }
+            filter_stale = false;
+        }
+
+        if (merge_stale) {
+            StageTimer timer(stats, STAGE_MERGE);
+            merged = filtered;
+            merged.resize(merge_regions(merged.data(), merged.size(), merge_margin));
+            merge_stale = false;
+            if (stats) {
+                stats->components += int(filtered.size());
+                stats->merges += int(filtered.size() - merged.size());
+            }
+        }
+        return merged;
+    }
+
+    void RegionStages::clear() {
+        components.clear();
+        filtered.clear();
+        merged.clear();
+        filter_stale = true;
+        merge_stale = true;
+    }
+}
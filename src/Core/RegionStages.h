@@ -0,0 +1,72 @@
+#pragma once
+
+#include <vector>
+
+#include "SliceStats.h"
+#include "SliceTypes.h"
+
+namespace spritecutter {
+
+    /**
+     * @brief The stages after labelling, each kept until a parameter it depends on changes.
+     *
+     * Holds every labelled component, labelled with a pixel floor of 1, then the ones
+     *
+     * that reach `min_pixels`, then their merge. A new floor filters the components
+     *
+     * again and merges the result, a new margin only merges again: neither reads a pixel,
+     *
+     * so both stay far below a frame on sheets of thousands of components.
+     *
+     * Filtering the components gives the same list, in the same order, as labelling
+     *
+     * with that floor, so get_regions() matches slice_pixels() with the same options.
+     */
+    class RegionStages {
+        public:
+            /**
+             * @brief Replaces the components, the later stages are run again on the next get_regions().
+             *
+             * @param p_components Every component, unmerged, in labelling order.
+             */
+            void set_components(std::vector<Region> p_components);
+            const std::vector<Region>& get_components() const { return components; }
+
+            /**
+             * @brief Sets the pixel floor. Only marks the stages stale if it changed.
+             */
+            void set_min_pixels(int p_min_pixels);
+            int get_min_pixels() const { return min_pixels; }
+
+            /**
+             * @brief Sets the merge margin. Only marks the merge stale if it changed.
+             */
+            void set_merge_margin(float p_margin);
+            float get_merge_margin() const { return merge_margin; }
+
+            /**
+             * @brief Returns the merged regions, running the stale stages first.
+             *
+             * @param stats Optional output: merge time and counters when the merge runs, added to.
+             */
+            const std::vector<Region>& get_regions(SliceStats* stats = nullptr);
+
+            /**
+             * @brief Returns true if get_regions() would run a stage.
+             */
+            bool is_stale() const { return filter_stale || merge_stale; }
+
+            void clear();
+
+        private:
+            std::vector<Region> components;
+            std::vector<Region> filtered;
+            std::vector<Region> merged;
+
+            int min_pixels = 100;
+            float merge_margin = 5.0f;
+
+            bool filter_stale = true;
+            bool merge_stale = true;
+    };
+}
@@ -0,0 +1,161 @@
+#include "SheetGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+
+namespace spritecutter {
+
+    namespace {
+        // Uniform integer in [lo, hi]
+        int uniform(std::mt19937& rng, int lo, int hi) {
+            return hi <= lo ? lo : lo + int(rng() % uint32_t(hi - lo + 1));
+        }
+
+        void put_pixel(uint8_t* rgba, int width, int x, int y, uint8_t alpha) {
+            uint8_t* p = &rgba[(size_t(y) * width + x) * 4];
+            p[0] = uint8_t(x * 7);
+            p[1] = uint8_t(y * 5);
+            p[2] = uint8_t((x ^ y) * 3);
+            p[3] = alpha;
+        }
+
+        // Fills the ellipse inscribed in [x0, x0 + w) x [y0, y0 + h)
+        void draw_ellipse(uint8_t* rgba, int width, int x0, int y0, int w, int h) {
+            double rx = w * 0.5, ry = h * 0.5;
+            double cx = x0 + rx, cy = y0 + ry;
+            for (int y = y0; y < y0 + h; ++y) {
+                double dy = (y + 0.5 - cy) / ry;
+                for (int x = x0; x < x0 + w; ++x) {
+                    double dx = (x + 0.5 - cx) / rx;
+                    if (dx * dx + dy * dy <= 1.0) put_pixel(rgba, width, x, y, 255);
+                }
+            }
+        }
+
+        void draw_sprite(uint8_t* rgba, int width, SpriteShape shape, int x0, int y0, int w, int h, std::mt19937& rng) {
+            switch (shape) {
+                case SHAPE_RECT:
+                    for (int y = y0; y < y0 + h; ++y)
+                        for (int x = x0; x < x0 + w; ++x) put_pixel(rgba, width, x, y, 255);
+                    break;
+
+                case SHAPE_DISC:
+                    draw_ellipse(rgba, width, x0, y0, w, h);
+                    break;
+
+                default: {
+                    // A few overlapping discs inside the box
+                    int parts = uniform(rng, 2, 5);
+                    for (int i = 0; i < parts; ++i) {
+                        int pw = uniform(rng, std::max(1, w / 3), w);
+                        int ph = uniform(rng, std::max(1, h / 3), h);
+                        draw_ellipse(rgba, width, x0 + uniform(rng, 0, w - pw), y0 + uniform(rng, 0, h - ph), pw, ph);
+                    }
+                    break;
+                }
+            }
+        }
+    }
+
+    int generate_sheet(const SheetSpec& spec, std::vector<uint8_t>& rgba) {
+        if (spec.width <= 0 || spec.height <= 0) return -1;
+        rgba.resize(sheet_size(spec));
+        return generate_sheet(spec, rgba.data());
+    }
+
+    int generate_sheet(const SheetSpec& spec, uint8_t* rgba) {
+        if (spec.width <= 0 || spec.height <= 0 || spec.sprites < 0 || spec.specks < 0 || spec.gap < 0 || spec.cell < 0)
+            return -1;
+
+        std::mt19937 rng(spec.seed);
+        std::memset(rgba, 0, sheet_size(spec));
+
+        // Square cells sized so the requested sprites fill the sheet, unless given
+        int placed = 0;
+        if (spec.sprites > 0) {
+            double area = double(spec.width) * double(spec.height) / spec.sprites;
+            int cell = std::max(spec.gap + 2, spec.cell > 0 ? spec.cell : (int)std::sqrt(area));
+            while (spec.cell == 0 && cell > spec.gap + 2 && int64_t(spec.width / cell) * (spec.height / cell) < spec.sprites) --cell;
+            int cols = spec.width / cell, rows = spec.height / cell;
+
+            std::vector<int> cells(size_t(std::max(0, cols)) * size_t(std::max(0, rows)));
+            for (size_t i = 0; i < cells.size(); ++i) cells[i] = int(i);
+            std::shuffle(cells.begin(), cells.end(), rng);
+            cells.resize(std::min(cells.size(), size_t(spec.sprites)));
+            std::sort(cells.begin(), cells.end());
+
+            // Sprites stay inside their cell minus the gap on the right and bottom
+            int room = cell - spec.gap;
+            for (int c : cells) {
+                int w = uniform(rng, std::max(1, room / 3), room);
+                int h = uniform(rng, std::max(1, room / 3), room);
+                int x0 = (c % cols) * cell + uniform(rng, 0, room - w);
+                int y0 = (c / cols) * cell + uniform(rng, 0, room - h);
+
+                SpriteShape shape = spec.shape == SHAPE_MIXED ? SpriteShape(rng() % 3) : spec.shape;
+                draw_sprite(rgba, spec.width, shape, x0, y0, w, h, rng);
+                ++placed;
+            }
+        }
+
+        // Specks with random alpha, on top of whatever is there
+        for (int i = 0; i < spec.specks; ++i) {
+            int x = uniform(rng, 0, spec.width - 1);
+            int y = uniform(rng, 0, spec.height - 1);
+            put_pixel(rgba, spec.width, x, y, uint8_t(uniform(rng, 1, 255)));
+        }
+        return placed;
+    }
+
+    bool parse_sprite_shape(const std::string& name, SpriteShape& shape) {
+        for (int s = SHAPE_RECT; s <= SHAPE_MIXED; ++s) {
+            if (name == sprite_shape_name(SpriteShape(s))) {
+                shape = SpriteShape(s);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    const char* sprite_shape_name(SpriteShape shape) {
+        switch (shape) {
+            case SHAPE_RECT: return "rect";
+            case SHAPE_DISC: return "disc";
+            case SHAPE_BLOB: return "blob";
+            default: return "mixed";
+        }
+    }
+
+    std::vector<SheetCase> standard_sheets(bool full) {
+        auto make = [](const char* name, int w, int h, int sprites, SpriteShape shape, int specks, int gap, int cell = 0) {
+            SheetCase c;
+            c.name = name;
+            c.spec.width = w;
+            c.spec.height = h;
+            c.spec.sprites = sprites;
+            c.spec.shape = shape;
+            c.spec.specks = specks;
+            c.spec.gap = gap;
+            c.spec.cell = cell;
+            c.spec.seed = 42;
+            return c;
+        };
+
+        std::vector<SheetCase> cases = {
+            make("1k-mixed", 1024, 1024, 200, SHAPE_MIXED, 0, 8),
+            make("2k-rect", 2048, 2048, 1000, SHAPE_RECT, 0, 8),
+            make("4k-mixed-specks", 4096, 4096, 2000, SHAPE_MIXED, 20000, 8),
+            make("4k-blob-tight", 4096, 4096, 4000, SHAPE_BLOB, 0, 3),
+            make("4k-particles", 4096, 4096, 30000, SHAPE_DISC, 0, 6),
+            make("4k-sparse", 4096, 4096, 400, SHAPE_MIXED, 0, 8, 96),
+        };
+        if (full) {
+            cases.push_back(make("8k-mixed", 8192, 8192, 8000, SHAPE_MIXED, 50000, 8));
+            cases.push_back(make("16k-mixed", 16384, 16384, 20000, SHAPE_MIXED, 100000, 8));
+            cases.push_back(make("16k-sparse", 16384, 16384, 3000, SHAPE_MIXED, 0, 8, 160));
+        }
+        return cases;
+    }
+}
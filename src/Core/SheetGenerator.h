@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace spritecutter {
+
+    /**
+     * @brief Outline of the sprites drawn by generate_sheet().
+     */
+    enum SpriteShape {
+        SHAPE_RECT,
+        SHAPE_DISC,
+        SHAPE_BLOB,
+        SHAPE_MIXED,
+    };
+
+    /**
+     * @brief Parameters of a synthetic sprite sheet. The same spec always yields the same pixels.
+     */
+    struct SheetSpec {
+        int width = 2048;
+        int height = 2048;
+
+        // Sprites to place, capped by what fits on the grid
+        int sprites = 500;
+
+        SpriteShape shape = SHAPE_MIXED;
+
+        // Isolated noise pixels scattered over the sheet
+        int specks = 0;
+
+        // Minimum transparent gap between two sprites, in pixels
+        int gap = 8;
+
+        // Grid cell size in pixels, 0 sizes the cells so the sprites fill the sheet.
+        // Bigger cells than that leave cells empty, like a sparse atlas.
+        int cell = 0;
+
+        uint32_t seed = 1;
+    };
+
+    /**
+     * @brief A named spec, one entry of a benchmark suite.
+     */
+    struct SheetCase {
+        std::string name;
+        SheetSpec spec;
+    };
+
+    /**
+     * @brief Draws a synthetic RGBA8 sprite sheet.
+     *
+     * Sprites sit on a grid of equal cells, one per cell, with random sizes and at least
+     *
+     * `gap` transparent pixels between neighbours. Blobs are unions of a few discs and may
+     *
+     * come out in several pieces, like real sprites with detached parts.
+     *
+     * @param spec Size, content and seed of the sheet.
+     * @param rgba Output pixels, tightly packed, resized to width * height * 4.
+     * @return The number of sprites drawn, -1 if the spec is invalid.
+     */
+    int generate_sheet(const SheetSpec& spec, std::vector<uint8_t>& rgba);
+
+    /**
+     * @brief Same as above, drawing into a caller-owned buffer of sheet_size() bytes.
+     */
+    int generate_sheet(const SheetSpec& spec, uint8_t* rgba);
+
+    /**
+     * @brief Returns the size in bytes of the RGBA8 pixels of a sheet.
+     */
+    inline size_t sheet_size(const SheetSpec& spec) {
+        return spec.width > 0 && spec.height > 0 ? size_t(spec.width) * size_t(spec.height) * 4 : 0;
+    }
+
+    /**
+     * @brief Parses "rect", "disc", "blob" or "mixed".
+     *
+     * @return false if the name is unknown.
+     */
+    bool parse_sprite_shape(const std::string& name, SpriteShape& shape);
+
+    /**
+     * @brief Returns the name parse_sprite_shape() accepts for the shape.
+     */
+    const char* sprite_shape_name(SpriteShape shape);
+
+    /**
+     * @brief The reproducible sheets shared by the native and in-engine benchmarks.
+     *
+     * @param full Adds the 8k and 16k sheets. The 16k one alone takes 1 GB of pixels.
+     */
+    std::vector<SheetCase> standard_sheets(bool full);
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+
+namespace spritecutter {
+
+    /**
+     * @brief Progress and cancellation shared between a slicing job and its observer.
+     *
+     * The pipeline is split into stages that each cover a slice of [0, 1].
+     *
+     * Stage bounds are set by the thread driving the pipeline, progress within a stage
+     *
+     * may be reported from any thread. The observer reads get() and may call cancel().
+     */
+    class SliceProgress {
+        public:
+            /**
+             * @brief Starts a stage covering [start, end] of the overall progress.
+             */
+            void begin_stage(float start, float end) {
+                stage_start = start;
+                stage_end = end;
+                value.store(start, std::memory_order_relaxed);
+            }
+
+            /**
+             * @brief Reports `done` out of `total` steps of the current stage.
+             */
+            void report(int done, int total) {
+                float f = total > 0 ? float(done) / float(total) : 1.0f;
+                value.store(stage_start + (stage_end - stage_start) * f, std::memory_order_relaxed);
+            }
+
+            /**
+             * @brief Marks the whole pipeline as complete.
+             */
+            void finish() { value.store(1.0f, std::memory_order_relaxed); }
+
+            /**
+             * @brief Returns the overall progress in [0, 1].
+             */
+            float get() const { return value.load(std::memory_order_relaxed); }
+
+            /**
+             * @brief Asks the pipeline to stop at the next check.
+             */
+            void cancel() { cancelled.store(true, std::memory_order_relaxed); }
+
+            bool is_cancelled() const { return cancelled.load(std::memory_order_relaxed); }
+
+        private:
+            std::atomic<float> value{ 0.0f };
+            std::atomic<bool> cancelled{ false };
+
+            // Bounds of the current stage, written before any concurrent report()
+            float stage_start = 0.0f;
+            float stage_end = 1.0f;
+    };
+}
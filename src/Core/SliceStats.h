@@ -0,0 +1,98 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace spritecutter {
+
+    /**
+     * @brief Timed stages of a slicing run, in pipeline order.
+     */
+    enum SliceStage {
+        // Texture readback, or mapping the source file
+        STAGE_FETCH,
+        STAGE_DECOMPRESS,
+
+        // Alpha mask and connected components, strip decoding included
+        STAGE_LABEL,
+        STAGE_MERGE,
+
+        // AtlasTextures, or the SpriteCutterRegionSet handing them out
+        STAGE_ATLAS,
+
+        // Filling the results panel
+        STAGE_POPULATE,
+        STAGE_COUNT,
+    };
+
+    /**
+     * @brief Returns the lowercase name of a stage, as used in logs and monitor paths.
+     */
+    inline const char* stage_name(SliceStage stage) {
+        static const char* const names[STAGE_COUNT] = { "fetch", "decompress", "label", "merge", "atlas", "populate" };
+        return stage >= 0 && stage < STAGE_COUNT ? names[stage] : "unknown";
+    }
+
+    /**
+     * @brief What one slicing run cost, stage by stage.
+     *
+     * Written by the thread driving the pipeline only, read once the run is over.
+     */
+    struct SliceStats {
+        uint64_t stage_usec[STAGE_COUNT] = {};
+
+        // Mask pixels tested against the threshold
+        uint64_t pixels_scanned = 0;
+
+        // Components kept by the labeller, and how many the merge folded away
+        int components = 0;
+        int merges = 0;
+
+        // Largest working set the run allocated at once: mask, converted copies, strips
+        size_t peak_scratch_bytes = 0;
+
+        /**
+         * @brief Records a working set, keeps the largest.
+         */
+        void note_scratch(size_t bytes) { peak_scratch_bytes = std::max(peak_scratch_bytes, bytes); }
+
+        uint64_t total_usec() const {
+            uint64_t total = 0;
+            for (uint64_t t : stage_usec) total += t;
+            return total;
+        }
+    };
+
+    /**
+     * @brief Adds the time until it goes out of scope, or until stop(), to one stage.
+     *
+     * Does nothing when `stats` is null, so stages can be timed unconditionally.
+     */
+    class StageTimer {
+        public:
+            StageTimer(SliceStats* p_stats, SliceStage p_stage) : stats(p_stats), stage(p_stage) {
+                if (stats) start = std::chrono::steady_clock::now();
+            }
+            ~StageTimer() { stop(); }
+
+            StageTimer(const StageTimer&) = delete;
+            StageTimer& operator=(const StageTimer&) = delete;
+
+            /**
+             * @brief Ends the measure early. Later calls do nothing.
+             */
+            void stop() {
+                if (!stats) return;
+                auto elapsed = std::chrono::steady_clock::now() - start;
+                stats->stage_usec[stage] += uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+                stats = nullptr;
+            }
+
+        private:
+            SliceStats* stats;
+            SliceStage stage;
+            std::chrono::steady_clock::time_point start;
+    };
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstdint>
+
+namespace spritecutter {
+
+    /**
+     * @brief A detected region: pixel bounds and number of opaque pixels.
+     */
+    struct Region {
+        int x, y, w, h;
+        int count;
+    };
+}
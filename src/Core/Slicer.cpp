@@ -0,0 +1,78 @@
+#include "Slicer.h"
+
+#include <algorithm>
+
+#include "AlphaMask.h"
+#include "RegionLabeller.h"
+#include "RegionMerger.h"
+
+namespace spritecutter {
+
+    namespace {
+        // Merges the labelled regions and counts what was folded
+        void merge_counted(std::vector<Region>& regions, float margin, SliceStats* stats) {
+            StageTimer timer(stats, STAGE_MERGE);
+            size_t found = regions.size();
+            regions.resize(merge_regions(regions.data(), regions.size(), margin));
+            if (!stats) return;
+            stats->components += int(found);
+            stats->merges += int(found - regions.size());
+        }
+    }
+
+    bool slice_pixels(const PixelView& pixels, const SliceOptions& options, std::vector<Region>& regions,
+        const ParallelFor& parallel_for, SliceProgress* progress, SliceStats* stats) {
+        regions.clear();
+        StageTimer label_timer(stats, STAGE_LABEL);
+
+        if (progress) progress->begin_stage(0.0f, 0.2f);
+        AlphaMask mask;
+        if (!mask.build(pixels, options.alpha_threshold)) return false;
+        if (stats) {
+            stats->pixels_scanned += uint64_t(pixels.width) * uint64_t(pixels.height);
+            stats->note_scratch(size_t(mask.get_words_per_row()) * sizeof(uint64_t) * size_t(pixels.height));
+        }
+        if (progress && progress->is_cancelled()) return false;
+
+        if (progress) progress->begin_stage(0.2f, 0.9f);
+        LabelOptions label;
+        label.min_pixels = options.min_pixels;
+        label.min_tile_rows = options.min_tile_rows;
+        label.threads = options.threads;
+        label_regions(mask, label, regions, parallel_for, progress);
+        label_timer.stop();
+        if (progress && progress->is_cancelled()) return false;
+
+        if (progress) progress->begin_stage(0.9f, 1.0f);
+        merge_counted(regions, options.merge_margin, stats);
+
+        if (progress) progress->finish();
+        return true;
+    }
+
+    bool slice_strips(int width, int height, PixelFormat format, const StripReader& read, const SliceOptions& options,
+        std::vector<Region>& regions, SliceProgress* progress, SliceStats* stats) {
+        regions.clear();
+
+        if (progress) progress->begin_stage(0.0f, 0.9f);
+        LabelOptions label;
+        label.min_pixels = options.min_pixels;
+        int rows = strip_rows_for_budget(width, pixel_size(format), options.memory_budget);
+        {
+            StageTimer timer(stats, STAGE_LABEL);
+            if (!label_strips(width, height, rows, read, options.alpha_threshold, label, regions, progress)) return false;
+        }
+        if (stats) {
+            // One strip of pixels and its mask alive at a time
+            stats->pixels_scanned += uint64_t(width) * uint64_t(height);
+            size_t strip = size_t(std::min(rows, height));
+            stats->note_scratch(size_t(width) * pixel_size(format) * strip + size_t((width + 63) / 64) * sizeof(uint64_t) * strip);
+        }
+
+        if (progress) progress->begin_stage(0.9f, 1.0f);
+        merge_counted(regions, options.merge_margin, stats);
+
+        if (progress) progress->finish();
+        return true;
+    }
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "ParallelFor.h"
+#include "PixelView.h"
+#include "RegionLabeller.h"
+#include "SliceProgress.h"
+#include "SliceStats.h"
+#include "SliceTypes.h"
+
+namespace spritecutter {
+
+    /**
+     * @brief Parameters of the whole slicing pipeline.
+     */
+    struct SliceOptions {
+        // Pixels with alpha (0-255) strictly above this value are opaque
+        uint8_t alpha_threshold = 0;
+
+        // Minimum pixels to consider a region valid
+        int min_pixels = 100;
+
+        // Margin used when merging nearby regions
+        float merge_margin = 5.0f;
+
+        // Smallest tile height handed to a labelling task
+        int min_tile_rows = 64;
+
+        // Threads the ParallelFor may use, 1 to stay on the calling thread
+        int threads = 1;
+
+        // Bytes slice_strips() may spend on a strip of pixels and its mask
+        size_t memory_budget = size_t(64) << 20;
+    };
+
+    /**
+     * @brief Runs the pixel pipeline on a buffer: alpha mask, labelling, merge.
+     *
+     * This is the entry point of the native tools. The editor runs the same stages
+     *
+     * from SpriteCutterAutoSlicer so it can release the image before labelling.
+     *
+     * @param pixels The pixels to slice.
+     * @param options Threshold, filtering, merge margin and threading.
+     * @param regions Output list of merged regions. Cleared first.
+     * @param parallel_for Scheduler for the labelling tiles.
+     * @param progress Optional progress and cancellation state.
+     * @param stats Optional output: stage times and counters, added to.
+     * @return false on a malformed view or cancellation.
+     */
+    bool slice_pixels(const PixelView& pixels, const SliceOptions& options, std::vector<Region>& regions,
+        const ParallelFor& parallel_for = serial_for, SliceProgress* progress = nullptr, SliceStats* stats = nullptr);
+
+    /**
+     * @brief Runs the pipeline on an image read strip by strip, see label_strips().
+     *
+     * No full-size buffer is ever allocated: strips are sized so that one strip of
+     *
+     * `format` pixels and its mask fit in `options.memory_budget`. Gives the same
+     *
+     * regions as slice_pixels().
+     *
+     * @param width Image width.
+     * @param height Image height.
+     * @param format Layout of the strips the reader hands out, used to size them.
+     * @param read Supplies the strips, top to bottom.
+     * @param options Threshold, filtering, merge margin and memory budget.
+     * @param regions Output list of merged regions. Cleared first.
+     * @param progress Optional progress and cancellation state.
+     * @param stats Optional output: stage times and counters, added to.
+     * @return false on a read error, a malformed strip or cancellation.
+     */
+    bool slice_strips(int width, int height, PixelFormat format, const StripReader& read, const SliceOptions& options,
+        std::vector<Region>& regions, SliceProgress* progress = nullptr, SliceStats* stats = nullptr);
+}
@@ -1,131 +1,731 @@
 #include "SpriteCutterAutoSlicer.h"
 
-godot::Array SpriteCutterAutoSlicer::slice(const godot::Ref<godot::Texture2D>& texture) {
-    godot::Array subs;
-    if (!texture.is_valid()) return subs;
+#include <cstring>
+#include <vector>
 
-    godot::Ref<godot::Image> img = texture->get_image();
-    if (!img.is_valid()) return subs;
+#include <godot_cpp/classes/config_file.hpp>
+#include <godot_cpp/classes/geometry2d.hpp>
+#include <godot_cpp/classes/os.hpp>
+#include <godot_cpp/classes/project_settings.hpp>
+#include <godot_cpp/classes/quad_mesh.hpp>
+#include <godot_cpp/classes/shader.hpp>
+#include <godot_cpp/classes/shader_material.hpp>
+#include <godot_cpp/classes/standard_material3d.hpp>
+#include <godot_cpp/variant/utility_functions.hpp>
 
-    // If the image is compressed, decompress it first
-    if (img->is_compressed() && img->decompress() != godot::OK) {
-        godot::UtilityFunctions::printerr("SpriteCutterAutoSlicer: can't decompress image");
-        return subs;
+#include "Core/BlockAlpha.h"
+#include "Core/PngReader.h"
+#include "Core/RegionMerger.h"
+#include "SpriteCutterMonitors.h"
+#include "SpriteCutterTaskGroup.h"
+
+namespace {
+    // Image layouts the core reads directly
+    bool to_pixel_format(godot::Image::Format format, spritecutter::PixelFormat& out) {
+        switch (format) {
+            case godot::Image::FORMAT_LA8:      out = spritecutter::FORMAT_LA8;      return true;
+            case godot::Image::FORMAT_RGBA8:    out = spritecutter::FORMAT_RGBA8;    return true;
+            case godot::Image::FORMAT_RGBA4444: out = spritecutter::FORMAT_RGBA4444; return true;
+            case godot::Image::FORMAT_RGBAH:    out = spritecutter::FORMAT_RGBAH;    return true;
+            case godot::Image::FORMAT_RGBAF:    out = spritecutter::FORMAT_RGBAF;    return true;
+
+            case godot::Image::FORMAT_L8:
+            case godot::Image::FORMAT_R8:
+            case godot::Image::FORMAT_RG8:
+            case godot::Image::FORMAT_RGB8:
+            case godot::Image::FORMAT_RGB565:
+            case godot::Image::FORMAT_RF:
+            case godot::Image::FORMAT_RGF:
+            case godot::Image::FORMAT_RGBF:
+            case godot::Image::FORMAT_RH:
+            case godot::Image::FORMAT_RGH:
+            case godot::Image::FORMAT_RGBH:
+            case godot::Image::FORMAT_RGBE9995:
+                out = spritecutter::FORMAT_OPAQUE;
+                return true;
+
+            default:
+                return false;
+        }
+    }
+
+    // Block-compressed layouts whose alpha the core reads from the blocks
+    bool to_block_format(godot::Image::Format format, spritecutter::BlockFormat& out) {
+        switch (format) {
+            case godot::Image::FORMAT_DXT1:        out = spritecutter::BLOCK_BC1;         return true;
+            case godot::Image::FORMAT_DXT3:        out = spritecutter::BLOCK_BC2;         return true;
+            case godot::Image::FORMAT_DXT5:        out = spritecutter::BLOCK_BC3;         return true;
+            case godot::Image::FORMAT_BPTC_RGBA:   out = spritecutter::BLOCK_BC7;         return true;
+            case godot::Image::FORMAT_ETC2_RGBA8:  out = spritecutter::BLOCK_ETC2_RGBA8;  return true;
+            case godot::Image::FORMAT_ETC2_RGB8A1: out = spritecutter::BLOCK_ETC2_RGB8A1; return true;
+            default: return false;
+        }
+    }
+
+    // Compressed layouts without an alpha channel
+    bool is_opaque_compressed(godot::Image::Format format) {
+        switch (format) {
+            case godot::Image::FORMAT_RGTC_R:
+            case godot::Image::FORMAT_RGTC_RG:
+            case godot::Image::FORMAT_BPTC_RGBF:
+            case godot::Image::FORMAT_BPTC_RGBFU:
+            case godot::Image::FORMAT_ETC:
+            case godot::Image::FORMAT_ETC2_R11:
+            case godot::Image::FORMAT_ETC2_R11S:
+            case godot::Image::FORMAT_ETC2_RG11:
+            case godot::Image::FORMAT_ETC2_RG11S:
+            case godot::Image::FORMAT_ETC2_RGB8:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    size_t mask_bytes(int w, int h) {
+        return size_t((w + 63) / 64) * sizeof(uint64_t) * size_t(h);
+    }
+
+    // Bytes the image holds now: its blocks while compressed, its pixels once decompressed
+    size_t image_bytes(const godot::Image* img) {
+        return size_t(img->get_data().size());
+    }
+
+    // Bytes build_mask() allocates for an uncompressed image: the mask, plus an RGBA8 copy
+    // for layouts the core can't read
+    size_t working_bytes(const godot::Image* img) {
+        size_t w = size_t(img->get_width()), h = size_t(img->get_height());
+        size_t bytes = mask_bytes(img->get_width(), img->get_height());
+        spritecutter::PixelFormat format;
+        if (!to_pixel_format(img->get_format(), format)) bytes += w * h * 4;
+        return bytes;
+    }
+
+    // Packs a top mip level the core can read, checking the buffer is large enough
+    bool pack_data(const godot::PackedByteArray& bytes, int w, int h, spritecutter::PixelFormat format, uint8_t threshold, spritecutter::AlphaMask& mask) {
+        spritecutter::PixelView view = spritecutter::PixelView::packed(bytes.ptr(), w, h, format);
+        if (size_t(bytes.size()) < view.row_pitch * size_t(h)) {
+            godot::UtilityFunctions::printerr("SpriteCutterAutoSlicer: pixel buffer smaller than expected");
+            return false;
+        }
+        return mask.build(view, threshold);
     }
+}
+
+godot::Array SpriteCutterAutoSlicer::slice(const godot::Ref<godot::Texture2D>& texture, uint8_t alpha_threshold) {
+    godot::Array subs;
+    spritecutter::SliceStats stats;
+    spritecutter::StageTimer fetch(&stats, spritecutter::STAGE_FETCH);
+    godot::Ref<godot::Image> img = fetch_image(texture);
+    fetch.stop();
+    if (!img.is_valid()) return subs;
 
     godot::LocalVector<Region> regions;
-    detect_regions(img.ptr(), regions);
+    if (!compute_regions(img, alpha_threshold, regions, nullptr, true, nullptr, &stats)) return subs;
+
+    if (!regions.is_empty()) {
+        spritecutter::StageTimer atlas(&stats, spritecutter::STAGE_ATLAS);
+        subs = build_atlas_textures(texture, regions);
+    }
+
+    SpriteCutterMonitors::record(texture->get_path(), stats);
+    return subs;
+}
+
+godot::Ref<godot::Image> SpriteCutterAutoSlicer::fetch_image(const godot::Ref<godot::Texture2D>& texture) {
+    if (!texture.is_valid()) return godot::Ref<godot::Image>();
+    return texture->get_image();
+}
+
+bool SpriteCutterAutoSlicer::open_source_file(const godot::Ref<godot::Texture2D>& texture, spritecutter::MappedFile& file) {
+    file.close();
+    if (!texture.is_valid()) return false;
+
+    // A PNG of its own: subresources and generated textures have no file to read
+    godot::String path = texture->get_path();
+    if (path.is_empty() || path.contains("::") || path.get_extension().to_lower() != "png") return false;
 
-    if (regions.is_empty()) return subs;
+    // The importer must leave the size and the alpha channel as they are in the file
+    godot::Ref<godot::ConfigFile> import;
+    import.instantiate();
+    if (import->load(path + ".import") != godot::OK) return false;
+    if (godot::String(import->get_value("remap", "importer", "")) != "texture") return false;
+    if (int(import->get_value("params", "process/size_limit", 0)) != 0) return false;
+    if (int(import->get_value("params", "process/channel_remap/alpha", IMPORT_ALPHA_CHANNEL)) != IMPORT_ALPHA_CHANNEL) return false;
 
-    merge_regions(regions);
+    godot::String absolute = godot::ProjectSettings::get_singleton()->globalize_path(path);
+    if (!file.open(absolute.utf8().get_data())) return false;
 
-    return build_atlas_textures(texture, regions);
+    // Only the chunk headers are read here, decoding happens on the worker
+    spritecutter::PngReader png;
+    if (png.open(file.get_data(), file.get_size()) && png.get_width() == texture->get_width() && png.get_height() == texture->get_height())
+        return true;
+
+    file.close();
+    return false;
 }
 
-void SpriteCutterAutoSlicer::detect_regions(godot::Image* img, godot::LocalVector<Region>& regions) {
+bool SpriteCutterAutoSlicer::compute_regions(godot::Ref<godot::Image>& img, uint8_t alpha_threshold, godot::LocalVector<Region>& regions, spritecutter::SliceProgress* progress, bool parallel, spritecutter::IncrementalLabeller* labeller, spritecutter::SliceStats* stats) {
+    if (!compute_components(img, alpha_threshold, get_min_pixels(), regions, progress, parallel, labeller, stats)) return false;
+
+    if (progress) progress->begin_stage(0.9f, 1.0f);
+    merge_regions(regions, stats);
+
+    if (progress) progress->finish();
+    return true;
+}
+
+bool SpriteCutterAutoSlicer::compute_components(godot::Ref<godot::Image>& img, uint8_t alpha_threshold, int min_pixels, godot::LocalVector<Region>& components, spritecutter::SliceProgress* progress, bool parallel, spritecutter::IncrementalLabeller* labeller, spritecutter::SliceStats* stats, spritecutter::AlphaMask* mask_out) {
+    if (!img.is_valid()) return false;
     int w = img->get_width(), h = img->get_height();
-    godot::LocalVector<bool> visited;
-    visited.resize(w * h);
-    godot::LocalVector<Pt> stack;
-
-    // 8 directions for neighborhood (orthogonal + diagonals)
-    static const int dirs[8][2] = {
-        {1,0},{-1,0},{0,1},{0,-1},
-        {1,1},{1,-1},{-1,1},{-1,-1}
-    };
+    if (stats) stats->pixels_scanned += uint64_t(w) * uint64_t(h);
 
-    for (int y = 0; y < h; ++y) {
-        for (int x = 0; x < w; ++x) {
-            int idx = y * w + x;
-
-            // Skip already visited or fully transparent pixels
-            if (visited[idx] || img->get_pixel(x, y).a == 0.0f) continue;
-
-            // New region detected — initialize bounds
-            int minx = x, maxx = x, miny = y, maxy = y, count = 0;
-            stack.clear();
-            stack.push_back({ x, y });
-            visited[idx] = true;
-
-            // Flood fill
-            while (!stack.is_empty()) {
-                Pt p = stack[stack.size() - 1];
-                stack.remove_at(stack.size() - 1);
-
-                img->set_pixel(p.x, p.y, godot::Color(0, 0, 0, 0));
-                ++count;
-
-                // Explore 8 neighbors
-                for (auto& d : dirs) {
-                    int nx = p.x + d[0], ny = p.y + d[1];
-                    if (nx < 0 || nx >= w || ny < 0 || ny >= h) continue;
-
-                    int nidx = ny * w + nx;
-                    if (visited[nidx]) continue;
-
-                    if (img->get_pixel(nx, ny).a > 0.0f) {
-                        visited[nidx] = true;
-                        stack.push_back({ nx, ny });
-
-                        // Update bounds
-                        minx = godot::MIN(minx, nx);
-                        maxx = godot::MAX(maxx, nx);
-                        miny = godot::MIN(miny, ny);
-                        maxy = godot::MAX(maxy, ny);
-                    }
-                }
+    // Compressed layouts with a known alpha are packed from their blocks, no decompression.
+    // Always cheaper than decompressing, even when the blocks and the mask exceed the budget.
+    if (progress) progress->begin_stage(0.0f, 0.3f);
+    size_t budget = get_memory_budget();
+    spritecutter::AlphaMask mask;
+    spritecutter::StageTimer block_timer(stats, spritecutter::STAGE_LABEL);
+    bool packed = img->is_compressed() && build_compressed_mask(img.ptr(), alpha_threshold, mask, parallel);
+    block_timer.stop();
+
+    if (packed) {
+        if (stats) stats->note_scratch(mask_bytes(w, h));
+    } else {
+        // If the image is compressed, decompress it first
+        if (progress) progress->begin_stage(0.0f, 0.15f);
+        if (img->is_compressed()) {
+            spritecutter::StageTimer timer(stats, spritecutter::STAGE_DECOMPRESS);
+            if (img->decompress() != godot::OK) {
+                godot::UtilityFunctions::printerr("SpriteCutterAutoSlicer: can't decompress image");
+                return false;
             }
+            if (stats) stats->note_scratch(size_t(img->get_data().size()));
+        }
+        if (progress && progress->is_cancelled()) return false;
 
-            // Add region if it contains enough pixels
-            if (count >= MIN_PIXELS) {
-                regions.push_back({
-                    godot::Rect2((float)minx, (float)miny, float(maxx - minx + 1), float(maxy - miny + 1)),
-                    count
-                    });
+        // The image stays resident while it is read: when it and the full mask would
+        // exceed the budget, label strip by strip in what the image leaves of it
+        size_t resident = image_bytes(img.ptr());
+        if (resident + working_bytes(img.ptr()) > budget) {
+            size_t strips = budget > resident + DECODE_STRIP_BYTES ? budget - resident : DECODE_STRIP_BYTES;
+            if (progress) progress->begin_stage(0.15f, 0.9f);
+            {
+                spritecutter::StageTimer timer(stats, spritecutter::STAGE_LABEL);
+                if (!detect_regions_in_strips(img.ptr(), alpha_threshold, min_pixels, strips, components, progress)) return false;
             }
+            if (stats) stats->note_scratch(strips);
+            img.unref();
+            return true;
         }
+
+        // Pack the alpha channel into a 1-bit occupancy mask
+        if (progress) progress->begin_stage(0.15f, 0.3f);
+        spritecutter::StageTimer timer(stats, spritecutter::STAGE_LABEL);
+        if (!build_mask(img.ptr(), alpha_threshold, mask)) return false;
+        if (stats) stats->note_scratch(working_bytes(img.ptr()));
+    }
+
+    // The source image is no longer needed once the mask is built
+    img.unref();
+    if (progress && progress->is_cancelled()) return false;
+
+    if (progress) progress->begin_stage(0.3f, 0.9f);
+    {
+        spritecutter::StageTimer timer(stats, spritecutter::STAGE_LABEL);
+        detect_regions(mask, min_pixels, components, progress, parallel, labeller);
     }
+    if (progress && progress->is_cancelled()) return false;
+
+    if (mask_out) *mask_out = std::move(mask);
+    return true;
 }
 
-void SpriteCutterAutoSlicer::merge_regions(godot::LocalVector<Region>& regions) {
-    // Insertion sort by X to make spatial merging faster
-    for (int i = 1; i < (int)regions.size(); ++i) {
-        Region key = regions[i];
-        int j = i - 1;
-        while (j >= 0 && regions[j].rect.position.x > key.rect.position.x) {
-            regions[j + 1] = regions[j];
-            --j;
-        }
-        regions[j + 1] = key;
-    }
-
-    // Merge overlapping/nearby regions using a margin
-    bool merged = true;
-    while (merged) {
-        merged = false;
-        for (int i = 0; i < (int)regions.size(); ++i) {
-            for (int j = i + 1; j < (int)regions.size(); ++j) {
-                if (regions[i].rect.grow(MERGE_MARGIN).intersects(regions[j].rect)) {
-                    godot::Rect2 A = regions[i].rect, B = regions[j].rect;
-
-                    // Create new bounding rect that covers both
-                    float x1 = godot::MIN(A.position.x, B.position.x);
-                    float y1 = godot::MIN(A.position.y, B.position.y);
-                    float x2 = godot::MAX(A.position.x + A.size.x, B.position.x + B.size.x);
-                    float y2 = godot::MAX(A.position.y + A.size.y, B.position.y + B.size.y);
-
-                    regions[i].rect = godot::Rect2(x1, y1, x2 - x1, y2 - y1);
-                    regions[i].count += regions[j].count;
-
-                    regions.remove_at(j);
-                    merged = true;
-                    break;
-                }
+bool SpriteCutterAutoSlicer::compute_regions_from_png(const uint8_t* data, size_t size, uint8_t alpha_threshold, godot::LocalVector<Region>& regions, spritecutter::SliceProgress* progress, bool parallel, spritecutter::IncrementalLabeller* labeller, spritecutter::SliceStats* stats) {
+    if (!compute_components_from_png(data, size, alpha_threshold, get_min_pixels(), regions, progress, parallel, labeller, stats)) return false;
+
+    if (progress) progress->begin_stage(0.9f, 1.0f);
+    merge_regions(regions, stats);
+
+    if (progress) progress->finish();
+    return true;
+}
+
+bool SpriteCutterAutoSlicer::compute_components_from_png(const uint8_t* data, size_t size, uint8_t alpha_threshold, int min_pixels, godot::LocalVector<Region>& components, spritecutter::SliceProgress* progress, bool parallel, spritecutter::IncrementalLabeller* labeller, spritecutter::SliceStats* stats, spritecutter::AlphaMask* mask_out) {
+    spritecutter::PngReader png;
+    if (!png.open(data, size)) {
+        godot::UtilityFunctions::printerr("SpriteCutterAutoSlicer: unsupported PNG file");
+        return false;
+    }
+
+    int w = png.get_width(), h = png.get_height();
+    spritecutter::PixelFormat format = png.get_format();
+    size_t pixel_bytes = spritecutter::pixel_size(format);
+    size_t pitch = size_t(w) * pixel_bytes;
+
+    // Decoding is part of labelling here, rows go straight into the mask
+    spritecutter::StageTimer label_timer(stats, spritecutter::STAGE_LABEL);
+    if (stats) stats->pixels_scanned += uint64_t(w) * uint64_t(h);
+
+    size_t budget = get_memory_budget();
+    if (mask_bytes(w, h) < budget) {
+        // The full mask fits: build it so the labeller can diff it with the previous slice
+        if (progress) progress->begin_stage(0.0f, 0.3f);
+        spritecutter::AlphaMask mask;
+        if (!build_png_mask(data, size, alpha_threshold, mask, progress, stats)) return false;
+
+        if (progress) progress->begin_stage(0.3f, 0.9f);
+        detect_regions(mask, min_pixels, components, progress, parallel, labeller);
+        if (progress && progress->is_cancelled()) return false;
+        if (mask_out) *mask_out = std::move(mask);
+    } else {
+        if (progress) progress->begin_stage(0.0f, 0.9f);
+
+        // Rows only ever go forward, one decoded strip is alive at a time
+        std::vector<uint8_t> strip;
+        spritecutter::StripReader read = [&](int y0, int rows, spritecutter::PixelView& view) {
+            strip.resize(pitch * size_t(rows));
+            if (y0 != png.get_next_row() || !png.read_rows(rows, strip.data(), pitch)) {
+                godot::UtilityFunctions::printerr("SpriteCutterAutoSlicer: corrupted PNG data at row ", y0);
+                return false;
             }
-            if (merged) break;
+            view = spritecutter::PixelView::packed(strip.data(), w, rows, format);
+            return true;
+        };
+
+        spritecutter::LabelOptions options;
+        options.min_pixels = min_pixels;
+        int rows = spritecutter::strip_rows_for_budget(w, pixel_bytes, budget);
+        if (stats) stats->note_scratch((pitch + mask_bytes(w, 1)) * size_t(godot::MIN(rows, h)));
+
+        std::vector<Region> found;
+        if (!spritecutter::label_strips(w, h, rows, read, alpha_threshold, options, found, progress)) return false;
+        components.resize(found.size());
+        for (size_t i = 0; i < found.size(); ++i) components[i] = found[i];
+    }
+    return true;
+}
+
+bool SpriteCutterAutoSlicer::build_mask(const godot::Image* img, uint8_t alpha_threshold, spritecutter::AlphaMask& mask) {
+    if (!img) return false;
+
+    int w = img->get_width(), h = img->get_height();
+    spritecutter::PixelFormat format;
+    if (to_pixel_format(img->get_format(), format))
+        return pack_data(img->get_data(), w, h, format, alpha_threshold, mask);
+
+    if (img->is_compressed()) {
+        godot::UtilityFunctions::printerr("SpriteCutterAutoSlicer: compressed image must be decompressed first");
+        return false;
+    }
+
+    // Unknown layout: convert a copy to RGBA8 and pack that
+    godot::Ref<godot::Image> copy = img->duplicate();
+    if (!copy.is_valid()) return false;
+    copy->convert(godot::Image::FORMAT_RGBA8);
+    if (copy->get_format() != godot::Image::FORMAT_RGBA8) {
+        godot::UtilityFunctions::printerr("SpriteCutterAutoSlicer: unsupported image format ", img->get_format());
+        return false;
+    }
+    return pack_data(copy->get_data(), w, h, spritecutter::FORMAT_RGBA8, alpha_threshold, mask);
+}
+
+bool SpriteCutterAutoSlicer::build_compressed_mask(const godot::Image* img, uint8_t alpha_threshold, spritecutter::AlphaMask& mask, bool parallel) {
+    if (!img || !img->is_compressed()) return false;
+
+    int w = img->get_width(), h = img->get_height();
+    godot::Image::Format image_format = img->get_format();
+    if (is_opaque_compressed(image_format))
+        return mask.build(spritecutter::PixelView::packed(nullptr, w, h, spritecutter::FORMAT_OPAQUE), alpha_threshold);
+
+    spritecutter::BlockView view;
+    if (!to_block_format(image_format, view.format)) return false;
+
+    // The top level comes first, mipmaps follow
+    godot::PackedByteArray bytes = img->get_data();
+    view.data = bytes.ptr();
+    view.width = w;
+    view.height = h;
+    if (size_t(bytes.size()) < view.get_size()) {
+        godot::UtilityFunctions::printerr("SpriteCutterAutoSlicer: compressed data smaller than expected");
+        return false;
+    }
+
+    // A few block rows per core on the WorkerThreadPool
+    int tasks = parallel ? 4 * godot::MAX(1, (int)godot::OS::get_singleton()->get_processor_count()) : 1;
+    spritecutter::ParallelFor pool = [](int count, const spritecutter::TaskFn& task) {
+        SpriteCutterTaskGroup::run(count, task, "SpriteCutter: read blocks");
+    };
+    return spritecutter::build_block_mask(view, alpha_threshold, mask, parallel ? pool : spritecutter::ParallelFor(spritecutter::serial_for), tasks);
+}
+
+bool SpriteCutterAutoSlicer::build_png_mask(const uint8_t* data, size_t size, uint8_t alpha_threshold, spritecutter::AlphaMask& mask, spritecutter::SliceProgress* progress, spritecutter::SliceStats* stats) {
+    spritecutter::PngReader png;
+    if (!png.open(data, size)) {
+        godot::UtilityFunctions::printerr("SpriteCutterAutoSlicer: unsupported PNG file");
+        return false;
+    }
+
+    int w = png.get_width(), h = png.get_height();
+    spritecutter::PixelFormat format = png.get_format();
+    size_t pixel_bytes = spritecutter::pixel_size(format);
+    size_t pitch = size_t(w) * pixel_bytes;
+    size_t budget = get_memory_budget();
+    size_t full_mask = mask_bytes(w, h);
+    if (full_mask >= budget) {
+        godot::UtilityFunctions::printerr("SpriteCutterAutoSlicer: mask exceeds the memory budget");
+        return false;
+    }
+
+    // Only one decoded strip is alive at a time
+    int rows = spritecutter::strip_rows_for_budget(w, pixel_bytes, godot::MIN(budget - full_mask, DECODE_STRIP_BYTES));
+    std::vector<uint8_t> strip(pitch * size_t(godot::MIN(rows, h)));
+    if (stats) stats->note_scratch(full_mask + strip.size());
+    mask.reset(w, h);
+    for (int y0 = 0; y0 < h; y0 += rows) {
+        if (progress && progress->is_cancelled()) return false;
+        int n = godot::MIN(rows, h - y0);
+        if (!png.read_rows(n, strip.data(), pitch)) {
+            godot::UtilityFunctions::printerr("SpriteCutterAutoSlicer: corrupted PNG data at row ", y0);
+            return false;
+        }
+        if (!mask.build_rows(spritecutter::PixelView::packed(strip.data(), w, n, format), y0, alpha_threshold)) return false;
+        if (progress) progress->report(y0 + n, h);
+    }
+    return true;
+}
+
+bool SpriteCutterAutoSlicer::build_texture_mask(const godot::Ref<godot::Texture2D>& texture, uint8_t alpha_threshold, spritecutter::AlphaMask& mask) {
+    spritecutter::MappedFile file;
+    if (open_source_file(texture, file)) return build_png_mask(file.get_data(), file.get_size(), alpha_threshold, mask);
+
+    godot::Ref<godot::Image> img = fetch_image(texture);
+    return build_image_mask(img, alpha_threshold, mask);
+}
+
+bool SpriteCutterAutoSlicer::build_image_mask(godot::Ref<godot::Image>& img, uint8_t alpha_threshold, spritecutter::AlphaMask& mask) {
+    if (!img.is_valid()) return false;
+
+    // The whole mask is needed next to the image, there is no strip by strip fallback.
+    // Decompressing never costs less than reading the blocks.
+    size_t budget = get_memory_budget();
+    if (img->is_compressed() && image_bytes(img.ptr()) + mask_bytes(img->get_width(), img->get_height()) > budget) {
+        godot::UtilityFunctions::printerr("SpriteCutterAutoSlicer: image too large to trace outlines within the memory budget");
+        return false;
+    }
+    if (img->is_compressed() && build_compressed_mask(img.ptr(), alpha_threshold, mask)) return true;
+    if (img->is_compressed() && img->decompress() != godot::OK) {
+        godot::UtilityFunctions::printerr("SpriteCutterAutoSlicer: can't decompress image");
+        return false;
+    }
+    if (image_bytes(img.ptr()) + working_bytes(img.ptr()) > budget) {
+        godot::UtilityFunctions::printerr("SpriteCutterAutoSlicer: image too large to trace outlines within the memory budget");
+        return false;
+    }
+    return build_mask(img.ptr(), alpha_threshold, mask);
+}
+
+void SpriteCutterAutoSlicer::detect_regions(const spritecutter::AlphaMask& mask, int min_pixels, godot::LocalVector<Region>& regions, spritecutter::SliceProgress* progress, bool parallel, spritecutter::IncrementalLabeller* labeller) {
+    // A few tiles per core on the WorkerThreadPool
+    spritecutter::LabelOptions options;
+    options.min_pixels = min_pixels;
+    options.min_tile_rows = MIN_TILE_ROWS;
+    options.threads = parallel ? godot::MAX(1, (int)godot::OS::get_singleton()->get_processor_count()) : 1;
+
+    std::vector<Region> found;
+    spritecutter::ParallelFor pool = [](int count, const spritecutter::TaskFn& task) {
+        SpriteCutterTaskGroup::run(count, task, "SpriteCutter: label tiles");
+    };
+    if (labeller) labeller->label(mask, options, found, pool, progress);
+    else spritecutter::label_regions(mask, options, found, pool, progress);
+
+    regions.resize(found.size());
+    for (size_t i = 0; i < found.size(); ++i) regions[i] = found[i];
+}
+
+bool SpriteCutterAutoSlicer::detect_regions_in_strips(const godot::Image* img, uint8_t alpha_threshold, int min_pixels, size_t budget, godot::LocalVector<Region>& regions, spritecutter::SliceProgress* progress) {
+    if (!img || img->is_compressed()) return false;
+
+    int w = img->get_width(), h = img->get_height();
+    spritecutter::PixelFormat format;
+    bool direct = to_pixel_format(img->get_format(), format);
+
+    // Known layouts are viewed in place, the strip then only costs its mask
+    godot::PackedByteArray bytes;
+    size_t pitch = 0;
+    if (direct) {
+        bytes = img->get_data();
+        pitch = size_t(w) * spritecutter::pixel_size(format);
+        if (size_t(bytes.size()) < pitch * size_t(h)) {
+            godot::UtilityFunctions::printerr("SpriteCutterAutoSlicer: pixel buffer smaller than expected");
+            return false;
+        }
+    }
+
+    // Other layouts: a region copy and its RGBA8 conversion, one strip at a time
+    godot::Ref<godot::Image> strip;
+    godot::PackedByteArray strip_bytes;
+    spritecutter::StripReader read = [&](int y0, int rows, spritecutter::PixelView& view) {
+        if (direct) {
+            view = spritecutter::PixelView::packed(bytes.ptr() + size_t(y0) * pitch, w, rows, format);
+            return true;
+        }
+        strip = img->get_region(godot::Rect2i(0, y0, w, rows));
+        if (!strip.is_valid()) return false;
+        strip->convert(godot::Image::FORMAT_RGBA8);
+        if (strip->get_format() != godot::Image::FORMAT_RGBA8) {
+            godot::UtilityFunctions::printerr("SpriteCutterAutoSlicer: unsupported image format ", img->get_format());
+            return false;
+        }
+        strip_bytes = strip->get_data();
+        view = spritecutter::PixelView::packed(strip_bytes.ptr(), w, rows, spritecutter::FORMAT_RGBA8);
+        return true;
+    };
+
+    spritecutter::LabelOptions options;
+    options.min_pixels = min_pixels;
+    int rows = spritecutter::strip_rows_for_budget(w, direct ? 0 : 8, budget);
+
+    std::vector<Region> found;
+    if (!spritecutter::label_strips(w, h, rows, read, alpha_threshold, options, found, progress)) return false;
+
+    regions.resize(found.size());
+    for (size_t i = 0; i < found.size(); ++i) regions[i] = found[i];
+    return true;
+}
+
+bool SpriteCutterAutoSlicer::compute_outlines(const spritecutter::AlphaMask& mask, const godot::LocalVector<Region>& regions, godot::LocalVector<godot::PackedVector2Array>& outlines, spritecutter::SliceProgress* progress, bool parallel) {
+    // A few regions per task, sizes vary a lot
+    std::vector<Region> rects(regions.ptr(), regions.ptr() + regions.size());
+    std::vector<spritecutter::Outline> traced;
+    spritecutter::OutlineOptions options;
+    options.epsilon = OUTLINE_EPSILON;
+    options.max_vertices = OUTLINE_MAX_VERTICES;
+    int tasks = parallel ? 4 * godot::MAX(1, (int)godot::OS::get_singleton()->get_processor_count()) : 1;
+    spritecutter::ParallelFor pool = [](int count, const spritecutter::TaskFn& task) {
+        SpriteCutterTaskGroup::run(count, task, "SpriteCutter: trace outlines");
+    };
+    if (!spritecutter::trace_outlines(mask, rects, options, traced, pool, tasks, progress)) return false;
+
+    outlines.resize(traced.size());
+    for (size_t i = 0; i < traced.size(); ++i) {
+        godot::PackedVector2Array& polygon = outlines[i];
+        polygon.resize(traced[i].size());
+        for (size_t j = 0; j < traced[i].size(); ++j) polygon.set(j, godot::Vector2(traced[i][j].x, traced[i][j].y));
+    }
+    return true;
+}
+
+bool SpriteCutterAutoSlicer::compute_frame_hashes(godot::Ref<godot::Image>& img, const godot::LocalVector<Region>& regions, std::vector<spritecutter::FrameHash>& hashes, spritecutter::SliceProgress* progress, bool parallel) {
+    if (!img.is_valid()) return false;
+
+    // Hashes read every pixel as RGBA8, other layouts need a full copy
+    if (img->get_format() != godot::Image::FORMAT_RGBA8) {
+        if (size_t(img->get_width()) * size_t(img->get_height()) * 4 > get_memory_budget()) {
+            godot::UtilityFunctions::printerr("SpriteCutterAutoSlicer: image too large to hash its frames within the memory budget");
+            return false;
+        }
+        if (img->is_compressed() && img->decompress() != godot::OK) {
+            godot::UtilityFunctions::printerr("SpriteCutterAutoSlicer: can't decompress image");
+            return false;
         }
+        img->convert(godot::Image::FORMAT_RGBA8);
+    }
+    if (progress && progress->is_cancelled()) return false;
+
+    godot::PackedByteArray bytes = img->get_data();
+    int w = img->get_width(), h = img->get_height();
+    spritecutter::PixelView view = spritecutter::PixelView::packed(bytes.ptr(), w, h, spritecutter::FORMAT_RGBA8);
+    if (size_t(bytes.size()) < view.row_pitch * size_t(h)) {
+        godot::UtilityFunctions::printerr("SpriteCutterAutoSlicer: pixel buffer smaller than expected");
+        return false;
+    }
+
+    std::vector<Region> rects(regions.ptr(), regions.ptr() + regions.size());
+    int tasks = parallel ? 4 * godot::MAX(1, (int)godot::OS::get_singleton()->get_processor_count()) : 1;
+    spritecutter::ParallelFor pool = [](int count, const spritecutter::TaskFn& task) {
+        SpriteCutterTaskGroup::run(count, task, "SpriteCutter: hash frames");
+    };
+    return spritecutter::hash_frames(view, rects, hashes, pool, tasks, progress);
+}
+
+int SpriteCutterAutoSlicer::get_dedupe_mode() {
+    int mode = godot::ProjectSettings::get_singleton()->get_setting(DEDUPE_SETTING, DEDUPE_OFF);
+    return godot::CLAMP(mode, int(DEDUPE_OFF), int(DEDUPE_NEAR));
+}
+
+godot::Ref<godot::ArrayMesh> SpriteCutterAutoSlicer::build_trimmed_mesh(const godot::Ref<godot::AtlasTexture>& atlas, const godot::PackedVector2Array& outline, float pixel_size) {
+    godot::Ref<godot::ArrayMesh> mesh;
+    if (!atlas.is_valid() || !atlas->get_atlas().is_valid() || outline.size() < 3) return mesh;
+
+    godot::PackedInt32Array indices = godot::Geometry2D::get_singleton()->triangulate_polygon(outline);
+    if (indices.is_empty()) return mesh;
+
+    // Centered on the region and facing +Z, like a Sprite3D; UVs address the whole atlas
+    godot::Rect2 region = atlas->get_region();
+    godot::Vector2 atlas_size = atlas->get_atlas()->get_size();
+    godot::PackedVector3Array vertices, normals;
+    godot::PackedVector2Array uvs;
+    for (int i = 0; i < outline.size(); ++i) {
+        godot::Vector2 p = outline[i];
+        vertices.push_back(godot::Vector3((p.x - region.size.x * 0.5f) * pixel_size, (region.size.y * 0.5f - p.y) * pixel_size, 0.0f));
+        normals.push_back(godot::Vector3(0.0f, 0.0f, 1.0f));
+        uvs.push_back((region.position + p) / atlas_size);
+    }
+
+    godot::Array arrays;
+    arrays.resize(godot::Mesh::ARRAY_MAX);
+    arrays[godot::Mesh::ARRAY_VERTEX] = vertices;
+    arrays[godot::Mesh::ARRAY_NORMAL] = normals;
+    arrays[godot::Mesh::ARRAY_TEX_UV] = uvs;
+    arrays[godot::Mesh::ARRAY_INDEX] = indices;
+    mesh.instantiate();
+    mesh->add_surface_from_arrays(godot::Mesh::PRIMITIVE_TRIANGLES, arrays);
+
+    // Same look as a default Sprite3D: unshaded, double sided, alpha cut out. Sampled like
+    // SPRITE_MULTIMESH_SHADER, so both spawn modes match and no neighbouring region bleeds in.
+    godot::Ref<godot::StandardMaterial3D> material;
+    material.instantiate();
+    material->set_texture(godot::BaseMaterial3D::TEXTURE_ALBEDO, atlas->get_atlas());
+    material->set_transparency(godot::BaseMaterial3D::TRANSPARENCY_ALPHA_SCISSOR);
+    material->set_alpha_scissor_threshold(0.5f);
+    material->set_texture_filter(godot::BaseMaterial3D::TEXTURE_FILTER_LINEAR);
+    material->set_flag(godot::BaseMaterial3D::FLAG_USE_TEXTURE_REPEAT, false);
+    material->set_shading_mode(godot::BaseMaterial3D::SHADING_MODE_UNSHADED);
+    material->set_cull_mode(godot::BaseMaterial3D::CULL_DISABLED);
+    mesh->surface_set_material(0, material);
+    return mesh;
+}
+
+godot::PackedVector3Array SpriteCutterAutoSlicer::layout_sprites(const godot::PackedInt32Array& rects, float pixel_size) {
+    godot::PackedVector3Array positions;
+    int count = int(rects.size() / 4);
+    if (count == 0) return positions;
+
+    // Uniform cells in a roughly square grid
+    int cell_w = 0, cell_h = 0;
+    for (int i = 0; i < count; ++i) {
+        cell_w = godot::MAX(cell_w, int(rects[i * 4 + 2]));
+        cell_h = godot::MAX(cell_h, int(rects[i * 4 + 3]));
+    }
+    cell_w += SPAWN_GAP;
+    cell_h += SPAWN_GAP;
+    int columns = 1;
+    while (columns * columns < count) ++columns;
+    int rows = (count + columns - 1) / columns;
+
+    positions.resize(count);
+    for (int i = 0; i < count; ++i) {
+        float x = (float(i % columns) - float(columns - 1) * 0.5f) * float(cell_w);
+        float y = (float(rows - 1) * 0.5f - float(i / columns)) * float(cell_h);
+        positions.set(i, godot::Vector3(x * pixel_size, y * pixel_size, 0.0f));
+    }
+    return positions;
+}
+
+godot::Ref<godot::MultiMesh> SpriteCutterAutoSlicer::build_sprite_multimesh(const godot::Ref<godot::Texture2D>& atlas, const godot::PackedInt32Array& rects, const godot::PackedVector3Array& positions, float pixel_size) {
+    godot::Ref<godot::MultiMesh> multimesh;
+    int count = int(godot::MIN(rects.size() / 4, positions.size()));
+    if (!atlas.is_valid() || count == 0) return multimesh;
+
+    godot::Ref<godot::Shader> shader;
+    shader.instantiate();
+    shader->set_code(SPRITE_MULTIMESH_SHADER);
+    godot::Ref<godot::ShaderMaterial> material;
+    material.instantiate();
+    material->set_shader(shader);
+    material->set_shader_parameter("atlas", atlas);
+
+    // Unit quad facing +Z, each instance scales it to its region
+    godot::Ref<godot::QuadMesh> quad;
+    quad.instantiate();
+    quad->set_size(godot::Vector2(1.0f, 1.0f));
+    quad->set_material(material);
+
+    multimesh.instantiate();
+    multimesh->set_transform_format(godot::MultiMesh::TRANSFORM_3D);
+    multimesh->set_use_custom_data(true);
+    multimesh->set_mesh(quad);
+    multimesh->set_instance_count(count);
+
+    godot::Vector2 atlas_size = atlas->get_size();
+    for (int i = 0; i < count; ++i) {
+        float x = float(rects[i * 4 + 0]), y = float(rects[i * 4 + 1]);
+        float w = float(rects[i * 4 + 2]), h = float(rects[i * 4 + 3]);
+        godot::Basis basis = godot::Basis().scaled(godot::Vector3(w * pixel_size, h * pixel_size, 1.0f));
+        multimesh->set_instance_transform(i, godot::Transform3D(basis, positions[i]));
+        multimesh->set_instance_custom_data(i, godot::Color(x / atlas_size.x, y / atlas_size.y, w / atlas_size.x, h / atlas_size.y));
     }
+    return multimesh;
+}
+
+bool SpriteCutterAutoSlicer::pack_atlas(godot::Ref<godot::Image>& img, const godot::LocalVector<Region>& regions, int padding, godot::Ref<godot::Image>& packed, godot::LocalVector<Region>& placed, bool parallel) {
+    if (!img.is_valid()) return false;
+    if (img->is_compressed() && img->decompress() != godot::OK) {
+        godot::UtilityFunctions::printerr("SpriteCutterAutoSlicer: can't decompress image");
+        return false;
+    }
+    if (img->get_format() != godot::Image::FORMAT_RGBA8) img->convert(godot::Image::FORMAT_RGBA8);
+
+    std::vector<Region> rects(regions.ptr(), regions.ptr() + regions.size());
+    spritecutter::PackOptions options;
+    options.padding = godot::MAX(0, padding);
+    options.max_side = PACK_MAX_SIDE;
+
+    // Each heuristic and atlas width is a task of its own
+    spritecutter::PackResult result;
+    spritecutter::ParallelFor pool = [](int count, const spritecutter::TaskFn& task) {
+        SpriteCutterTaskGroup::run(count, task, "SpriteCutter: pack");
+    };
+    if (!spritecutter::pack_regions(rects, options, result, parallel ? pool : spritecutter::ParallelFor(spritecutter::serial_for))) {
+        godot::UtilityFunctions::printerr("SpriteCutterAutoSlicer: sprites don't fit in a ", PACK_MAX_SIDE, "px atlas");
+        return false;
+    }
+
+    godot::PackedByteArray bytes = img->get_data();
+    spritecutter::PixelView view = spritecutter::PixelView::packed(bytes.ptr(), img->get_width(), img->get_height(), spritecutter::FORMAT_RGBA8);
+    if (size_t(bytes.size()) < view.row_pitch * size_t(view.height)) {
+        godot::UtilityFunctions::printerr("SpriteCutterAutoSlicer: pixel buffer smaller than expected");
+        return false;
+    }
+
+    std::vector<uint8_t> rgba;
+    spritecutter::blit_packed(view, rects, result, rgba);
+    godot::PackedByteArray data;
+    data.resize(rgba.size());
+    memcpy(data.ptrw(), rgba.data(), rgba.size());
+    packed = godot::Image::create_from_data(result.width, result.height, false, godot::Image::FORMAT_RGBA8, data);
+
+    placed.resize(regions.size());
+    for (uint32_t i = 0; i < regions.size(); ++i) {
+        const spritecutter::PackedSprite& s = result.sprites[i];
+        placed[i] = { s.x, s.y, regions[i].w, regions[i].h, regions[i].count };
+    }
+    return packed.is_valid();
+}
+
+size_t SpriteCutterAutoSlicer::get_memory_budget() {
+    int mb = godot::ProjectSettings::get_singleton()->get_setting(MEMORY_BUDGET_SETTING, DEFAULT_MEMORY_BUDGET_MB);
+    return size_t(godot::MAX(1, mb)) << 20;
+}
+
+int SpriteCutterAutoSlicer::get_min_pixels() {
+    int min_pixels = godot::ProjectSettings::get_singleton()->get_setting(MIN_PIXELS_SETTING, MIN_PIXELS);
+    return godot::MAX(1, min_pixels);
+}
+
+float SpriteCutterAutoSlicer::get_merge_margin() {
+    float margin = godot::ProjectSettings::get_singleton()->get_setting(MERGE_MARGIN_SETTING, MERGE_MARGIN);
+    return godot::MAX(0.0f, margin);
+}
+
+void SpriteCutterAutoSlicer::merge_regions(godot::LocalVector<Region>& regions, spritecutter::SliceStats* stats) {
+    spritecutter::StageTimer timer(stats, spritecutter::STAGE_MERGE);
+    size_t found = regions.size();
+    size_t count = spritecutter::merge_regions(regions.ptr(), regions.size(), get_merge_margin());
+    regions.resize(count);
+    if (!stats) return;
+    stats->components += int(found);
+    stats->merges += int(found - count);
 }
 
 godot::Array SpriteCutterAutoSlicer::build_atlas_textures(const godot::Ref<godot::Texture2D>& texture, const godot::LocalVector<Region>& regions) {
@@ -136,7 +736,8 @@ godot::Array SpriteCutterAutoSlicer::build_atlas_textures(const godot::Ref<godot
         at.instantiate();
 
         at->set_atlas(texture);
-        at->set_region(regions[i].rect);
+        const Region& r = regions[i];
+        at->set_region(godot::Rect2((float)r.x, (float)r.y, (float)r.w, (float)r.h));
         at->set_filter_clip(true);
 
         subs.append(godot::Variant(at));
@@ -1,8 +1,26 @@
 #pragma once
 
+#include <cstdint>
+#include <vector>
+
+#include <godot_cpp/classes/array_mesh.hpp>
 #include <godot_cpp/classes/atlas_texture.hpp>
 #include <godot_cpp/classes/image.hpp>
+#include <godot_cpp/classes/multi_mesh.hpp>
 #include <godot_cpp/templates/local_vector.hpp>
+#include <godot_cpp/variant/packed_int32_array.hpp>
+#include <godot_cpp/variant/packed_vector2_array.hpp>
+#include <godot_cpp/variant/packed_vector3_array.hpp>
+
+#include "Core/AlphaMask.h"
+#include "Core/AtlasPacker.h"
+#include "Core/FrameIndex.h"
+#include "Core/MappedFile.h"
+#include "Core/Outline.h"
+#include "Core/RegionLabeller.h"
+#include "Core/SliceProgress.h"
+#include "Core/SliceStats.h"
+#include "Core/SliceTypes.h"
 
 /**
  * @class SpriteCutterAutoSlicer
@@ -17,67 +35,457 @@
  * The algorithm scans pixels, groups connected opaque areas into regions,
  * 
  * merges nearby ones, and returns a list of sliced textures.
+ *
+ * The pixel stages live in the Godot-independent core (src/Core), this class
+ * 
+ * adapts Image and the WorkerThreadPool to it.
  */
 class SpriteCutterAutoSlicer {
     public:
+        /**
+         * @brief Represents a detected region with a rectangle and pixel count.
+         */
+        using Region = spritecutter::Region;
+
         /**
          * @brief Automatically slices the given texture and returns a list of AtlasTextures.
          *
          * The algorithm extracts visible (non-transparent) areas from the image.
+         * 
+         * Runs every stage on the calling thread, see SpriteCutterSliceJob for the async path.
+         * 
+         * The cost of each stage is published through SpriteCutterMonitors.
          *
          * @param texture The input texture to slice.
+         * @param alpha_threshold Pixels with alpha (0-255) strictly above this value are opaque.
          * @return An array of AtlasTexture objects representing the detected regions.
          */
-        static godot::Array slice(const godot::Ref<godot::Texture2D>& texture);
+        static godot::Array slice(const godot::Ref<godot::Texture2D>& texture, uint8_t alpha_threshold = ALPHA_THRESHOLD);
 
-    private:
         /**
-         * @brief Represents a detected region with a rectangle and pixel count.
+         * @brief Reads the texture back into an Image. Call from the main thread.
+         *
+         * @param texture The texture to read.
+         * @return A copy of the texture data, or an invalid reference.
          */
-        struct Region
-        { 
-            godot::Rect2 rect;
-            int count;
-        };
+        static godot::Ref<godot::Image> fetch_image(const godot::Ref<godot::Texture2D>& texture);
 
         /**
-         * @brief A helper point struct used during region exploration.
+         * @brief Maps the PNG file a texture was imported from, to slice it without readback.
+         *
+         * Only when the file holds the texture's pixels: a `.png` of its own, imported as
+         * 
+         * a texture with no size limit nor alpha remap, at the texture's size, in a layout
+         * 
+         * spritecutter::PngReader decodes. Call from the main thread.
+         *
+         * @param texture The texture to slice.
+         * @param file Output mapping of the source file, closed on failure.
+         * @return false if the texture has to be read back with fetch_image().
          */
-        struct Pt
-        {
-            int x, y;
-        };
+        static bool open_source_file(const godot::Ref<godot::Texture2D>& texture, spritecutter::MappedFile& file);
 
         /**
-         * @brief Detects opaque pixel regions in the given image.
+         * @brief Runs the pixel stages of the pipeline: decompress, mask, label, merge.
          *
-         * Uses a non-recursive flood-fill to group connected opaque pixels.
-         * @param img The image to scan.
-         * @param regions Output list of detected regions.
+         * compute_components() with get_min_pixels(), then merge_regions().
+         *
+         * Creates no resources and may run on a worker thread.
+         * 
+         * Compressed images skip the decompression when build_compressed_mask() reads them.
+         * 
+         * Uncompressed images that, with their full mask, would not fit in get_memory_budget()
+         * 
+         * are labelled strip by strip instead, see detect_regions_in_strips(). The labeller
+         * 
+         * is then unused. See get_memory_budget() for the layouts that stay within it.
+         *
+         * @param img The image to slice. Decompressed in place, then released once the mask is built.
+         * @param alpha_threshold Pixels with alpha (0-255) strictly above this value are opaque.
+         * @param regions Output list of merged regions.
+         * @param progress Optional progress and cancellation state.
+         * @param parallel false to label on the calling thread only, e.g. from inside another pool task.
+         * @param labeller Optional state of the previous slice of the same sheet, see detect_regions().
+         * @param stats Optional output: decompress, label and merge times and counters, added to.
+         * @return false on error or cancellation.
          */
-        static void detect_regions(godot::Image* img, godot::LocalVector<Region>& regions);
-        
+        static bool compute_regions(godot::Ref<godot::Image>& img, uint8_t alpha_threshold, godot::LocalVector<Region>& regions, spritecutter::SliceProgress* progress = nullptr, bool parallel = true, spritecutter::IncrementalLabeller* labeller = nullptr, spritecutter::SliceStats* stats = nullptr);
+
         /**
-         * @brief Merges regions that are close to each other spatially.
+         * @brief compute_regions() without the merge: the labelled components, for spritecutter::RegionStages.
          *
-         * Prevents fragmented small regions and overlaps by combining overlapping or nearby areas.
+         * Progress stops at 0.9, the merge is left to the caller.
          *
-         * @param regions List of regions to process. Modified in-place.
+         * @param min_pixels Pixel floor of a component, 1 to keep them all.
+         * @param components Output list of unmerged components, in labelling order.
+         * @param mask_out Optional output: the full mask once labelled, untouched when labelled strip by strip.
+         * @return false on error or cancellation.
          */
-        static void merge_regions(godot::LocalVector<Region>& regions);
-        
+        static bool compute_components(godot::Ref<godot::Image>& img, uint8_t alpha_threshold, int min_pixels, godot::LocalVector<Region>& components, spritecutter::SliceProgress* progress = nullptr, bool parallel = true, spritecutter::IncrementalLabeller* labeller = nullptr, spritecutter::SliceStats* stats = nullptr, spritecutter::AlphaMask* mask_out = nullptr);
+
+        /**
+         * @brief Runs the pixel stages on an encoded PNG, decoded a strip of rows at a time.
+         *
+         * The decoded pixels are never held whole: strips are packed into the mask as they
+         * 
+         * come, or labelled one by one when even the mask would not fit get_memory_budget().
+         * 
+         * Gives the same regions as compute_regions() on the decoded image.
+         *
+         * @param data The encoded file, typically mapped with open_source_file().
+         * @param size Size of the file in bytes.
+         * @param alpha_threshold Pixels with alpha (0-255) strictly above this value are opaque.
+         * @param regions Output list of merged regions.
+         * @param progress Optional progress and cancellation state.
+         * @param parallel false to label on the calling thread only.
+         * @param labeller Optional state of the previous slice of the same sheet, see detect_regions().
+         * @param stats Optional output: label (decoding included) and merge times and counters, added to.
+         * @return false on an unsupported or corrupted file, or on cancellation.
+         */
+        static bool compute_regions_from_png(const uint8_t* data, size_t size, uint8_t alpha_threshold, godot::LocalVector<Region>& regions, spritecutter::SliceProgress* progress = nullptr, bool parallel = true, spritecutter::IncrementalLabeller* labeller = nullptr, spritecutter::SliceStats* stats = nullptr);
+
+        /**
+         * @brief compute_regions_from_png() without the merge, see compute_components().
+         */
+        static bool compute_components_from_png(const uint8_t* data, size_t size, uint8_t alpha_threshold, int min_pixels, godot::LocalVector<Region>& components, spritecutter::SliceProgress* progress = nullptr, bool parallel = true, spritecutter::IncrementalLabeller* labeller = nullptr, spritecutter::SliceStats* stats = nullptr, spritecutter::AlphaMask* mask_out = nullptr);
+
         /**
          * @brief Converts the regions into AtlasTextures using the original texture as atlas source.
          *
+         * Creates resources, call from the main thread.
+         *
          * @param texture The original texture to use as the atlas base.
          * @param regions The detected regions to convert.
          * @return An array of AtlasTextures.
          */
         static godot::Array build_atlas_textures(const godot::Ref<godot::Texture2D>& texture, const godot::LocalVector<Region>& regions);
 
-        // Minimum pixels to consider a region valid
+        /**
+         * @brief Traces a short polygon around the opaque pixels of each region.
+         *
+         * Runs spritecutter::trace_outlines() on the WorkerThreadPool with OUTLINE_EPSILON and
+         * 
+         * OUTLINE_MAX_VERTICES. Each outline covers every opaque pixel of its region and is
+         * 
+         * relative to the region's top-left, ready for a Polygon2D or build_trimmed_mesh().
+         *
+         * @param mask The mask the regions were detected in, see build_texture_mask().
+         * @param regions The regions to trace.
+         * @param outlines Output polygons, one per region.
+         * @param progress Optional cancellation state.
+         * @param parallel false to trace on the calling thread only.
+         * @return false on cancellation.
+         */
+        static bool compute_outlines(const spritecutter::AlphaMask& mask, const godot::LocalVector<Region>& regions, godot::LocalVector<godot::PackedVector2Array>& outlines, spritecutter::SliceProgress* progress = nullptr, bool parallel = true);
+
+        /**
+         * @brief Builds the full mask of a texture, for outlines of regions sliced earlier.
+         *
+         * Decodes the source PNG row by row when open_source_file() accepts it, reads the
+         * 
+         * texture back and runs build_image_mask() otherwise. Call from the main thread,
+         * 
+         * SpriteCutterOutlineJob does the same work on a worker.
+         *
+         * @param texture The sliced texture.
+         * @param alpha_threshold Pixels with alpha (0-255) strictly above this value are set.
+         * @param mask Output mask.
+         * @return false if the texture can't be read or its mask, with the read-back image, exceeds get_memory_budget().
+         */
+        static bool build_texture_mask(const godot::Ref<godot::Texture2D>& texture, uint8_t alpha_threshold, spritecutter::AlphaMask& mask);
+
+        /**
+         * @brief Builds the full mask of a read-back image, for outlines of regions sliced earlier.
+         *
+         * Compressed images are read by build_compressed_mask() when it can, decompressed
+         * 
+         * in place otherwise. Creates no resources and may run on a worker thread.
+         *
+         * @param img The image to read.
+         * @param alpha_threshold Pixels with alpha (0-255) strictly above this value are set.
+         * @param mask Output mask.
+         * @return false if the image can't be read or it and its mask exceed get_memory_budget().
+         */
+        static bool build_image_mask(godot::Ref<godot::Image>& img, uint8_t alpha_threshold, spritecutter::AlphaMask& mask);
+
+        /**
+         * @brief Fingerprints each region for duplicate detection, see spritecutter::FrameIndex.
+         *
+         * Runs spritecutter::hash_frames() on the WorkerThreadPool. The image is decompressed
+         * 
+         * and converted to RGBA8 in place first.
+         *
+         * @param img The image the regions were detected in.
+         * @param regions The regions to hash.
+         * @param hashes Output fingerprints, one per region.
+         * @param progress Optional cancellation state.
+         * @param parallel false to hash on the calling thread only.
+         * @return false if the image can't be read, an RGBA8 copy exceeds get_memory_budget(), or on cancellation.
+         */
+        static bool compute_frame_hashes(godot::Ref<godot::Image>& img, const godot::LocalVector<Region>& regions, std::vector<spritecutter::FrameHash>& hashes, spritecutter::SliceProgress* progress = nullptr, bool parallel = true);
+
+        /**
+         * @brief Returns the DEDUPE_SETTING project setting, one of DedupeMode.
+         */
+        static int get_dedupe_mode();
+
+        /**
+         * @brief Builds a flat mesh covering only the outline of a sprite.
+         *
+         * Sized and placed like a centered Sprite3D, textured with the atlas and alpha
+         * 
+         * scissor, so the transparent pixels outside the outline are never shaded.
+         * 
+         * Creates resources, call from the main thread.
+         *
+         * @param atlas The sprite.
+         * @param outline Its outline from compute_outlines().
+         * @param pixel_size Size of a pixel in meters, as Sprite3D::pixel_size.
+         * @return The mesh, or an invalid reference if the outline can't be triangulated.
+         */
+        static godot::Ref<godot::ArrayMesh> build_trimmed_mesh(const godot::Ref<godot::AtlasTexture>& atlas, const godot::PackedVector2Array& outline, float pixel_size = 0.01f);
+
+        /**
+         * @brief Places sprites spawned together on a grid in the XY plane, centered on the origin.
+         *
+         * Every cell fits the largest sprite plus SPAWN_GAP pixels, so none overlap.
+         *
+         * @param rects 4 ints per sprite, as SpriteCutterRegionSet::get_rects(). Only the sizes are read.
+         * @param pixel_size Size of a pixel in meters, as Sprite3D::pixel_size.
+         * @return The center of each sprite.
+         */
+        static godot::PackedVector3Array layout_sprites(const godot::PackedInt32Array& rects, float pixel_size = 0.01f);
+
+        /**
+         * @brief Builds a MultiMesh drawing every sprite from one atlas in a single draw call.
+         *
+         * Each instance scales a unit quad to its region; its custom data holds the region's
+         * 
+         * UV offset and size in the atlas, which SPRITE_MULTIMESH_SHADER applies. Quads
+         * 
+         * shade their transparent border, unlike build_trimmed_mesh(), but share one material.
+         * 
+         * Creates resources, call from the main thread.
+         *
+         * @param atlas The texture every region lies in.
+         * @param rects 4 ints per sprite, as SpriteCutterRegionSet::get_rects().
+         * @param positions Center of each sprite, see layout_sprites().
+         * @param pixel_size Size of a pixel in meters, as Sprite3D::pixel_size.
+         * @return The multimesh, or an invalid reference if there is nothing to draw.
+         */
+        static godot::Ref<godot::MultiMesh> build_sprite_multimesh(const godot::Ref<godot::Texture2D>& atlas, const godot::PackedInt32Array& rects, const godot::PackedVector3Array& positions, float pixel_size = 0.01f);
+
+        /**
+         * @brief Repacks the regions of an image into a new atlas without the empty space.
+         *
+         * Tries every spritecutter::pack_regions() heuristic on the WorkerThreadPool and keeps
+         * 
+         * the smallest atlas. Sprites are never rotated: an AtlasTexture can't turn its region back.
+         * 
+         * Pass `packed` and `placed` to build_atlas_textures() for the remapped sprites.
+         *
+         * @param img The image the regions were detected in. Decompressed and converted to RGBA8 in place.
+         * @param regions The regions to repack.
+         * @param padding Empty pixels between two sprites.
+         * @param packed Output atlas image.
+         * @param placed Output regions in the new atlas, in the order of `regions`.
+         * @param parallel false to try the heuristics on the calling thread.
+         * @return false if the image can't be read or the sprites don't fit in PACK_MAX_SIDE.
+         */
+        static bool pack_atlas(godot::Ref<godot::Image>& img, const godot::LocalVector<Region>& regions, int padding, godot::Ref<godot::Image>& packed, godot::LocalVector<Region>& placed, bool parallel = true);
+
+        /**
+         * @brief Packs the alpha channel of an uncompressed image into an occupancy mask.
+         *
+         * Wraps the image data in a spritecutter::PixelView without copying it.
+         * 
+         * Layouts the core can't read are converted to RGBA8 on a copy first.
+         *
+         * @param img The image to read. It is never modified.
+         * @param alpha_threshold Pixels with alpha (0-255) strictly above this value are set.
+         * @param mask Output mask.
+         * @return false if the image can't be read.
+         */
+        static bool build_mask(const godot::Image* img, uint8_t alpha_threshold, spritecutter::AlphaMask& mask);
+
+        /**
+         * @brief Packs the alpha of a compressed image into a mask without decompressing it.
+         *
+         * BC1/2/3/7 and ETC2 RGBA8/RGB8A1 blocks are read by spritecutter::build_block_mask():
+         * 
+         * blocks whose alpha endpoints settle them are written whole, only the others are
+         * 
+         * decoded, and only their alpha. Compressed layouts without alpha give a full mask.
+         *
+         * @param img The compressed image to read. It is never modified.
+         * @param alpha_threshold Pixels with alpha (0-255) strictly above this value are set.
+         * @param mask Output mask.
+         * @param parallel false to read every block on the calling thread.
+         * @return false for other layouts, which must be decompressed first.
+         */
+        static bool build_compressed_mask(const godot::Image* img, uint8_t alpha_threshold, spritecutter::AlphaMask& mask, bool parallel = true);
+
+        /**
+         * @brief Packs an encoded PNG into a full mask, decoding a strip of rows at a time.
+         *
+         * @param data The encoded file.
+         * @param size Size of the file in bytes.
+         * @param alpha_threshold Pixels with alpha (0-255) strictly above this value are set.
+         * @param mask Output mask.
+         * @param progress Optional progress and cancellation state, reported per strip.
+         * @param stats Optional output: peak scratch, added to.
+         * @return false on an unsupported or corrupted file, a mask past get_memory_budget(), or cancellation.
+         */
+        static bool build_png_mask(const uint8_t* data, size_t size, uint8_t alpha_threshold, spritecutter::AlphaMask& mask, spritecutter::SliceProgress* progress = nullptr, spritecutter::SliceStats* stats = nullptr);
+
+        /**
+         * @brief Detects opaque pixel regions in the given occupancy mask.
+         *
+         * Runs spritecutter::label_regions() with its tiles on the WorkerThreadPool.
+         * 
+         * Regions come out in the order a raster scan first reaches them.
+         * 
+         * With a labeller, only the bands that changed since its last call are labelled again.
+         *
+         * @param mask The occupancy mask to scan.
+         * @param min_pixels Pixel floor of a region, see get_min_pixels().
+         * @param regions Output list of detected regions.
+         * @param progress Optional progress and cancellation state.
+         * @param parallel false to label the whole mask as a single tile on the calling thread.
+         * @param labeller Optional state of the previous slice of the same sheet, updated in place.
+         */
+        static void detect_regions(const spritecutter::AlphaMask& mask, int min_pixels, godot::LocalVector<Region>& regions, spritecutter::SliceProgress* progress = nullptr, bool parallel = true, spritecutter::IncrementalLabeller* labeller = nullptr);
+
+        /**
+         * @brief Detects the regions of an uncompressed image read strip by strip.
+         *
+         * Runs spritecutter::label_strips() on the calling thread. Known layouts are read
+         * 
+         * in place, others are converted to RGBA8 one strip at a time, so neither a full
+         * 
+         * mask nor a full converted copy is ever made.
+         *
+         * @param img The image to read. It is never modified.
+         * @param alpha_threshold Pixels with alpha (0-255) strictly above this value are opaque.
+         * @param min_pixels Pixel floor of a region, see get_min_pixels().
+         * @param budget Bytes a strip and its mask may take.
+         * @param regions Output list of detected regions, before merging.
+         * @param progress Optional progress and cancellation state.
+         * @return false if the image can't be read, or on cancellation.
+         */
+        static bool detect_regions_in_strips(const godot::Image* img, uint8_t alpha_threshold, int min_pixels, size_t budget, godot::LocalVector<Region>& regions, spritecutter::SliceProgress* progress = nullptr);
+
+        /**
+         * @brief Returns the memory a slice may hold at once, image included, in bytes.
+         *
+         * Read from the `spritecutter/slicing/memory_budget_mb` project setting.
+         *
+         * PNG sources stay within it at any size, they are never held whole. So do
+         * 
+         * uncompressed images the core reads in place, as long as the image alone fits:
+         * 
+         * past that only one strip at a time is added to it. Other uncompressed layouts
+         * 
+         * add a converted strip. Compressed layouts build_compressed_mask() reads (BC1/2/3/7,
+         * 
+         * ETC2 RGBA8 and RGB8A1, and those without alpha) add only their mask, which may go
+         * 
+         * past the budget on sheets whose blocks nearly fill it. The others, ASTC and the
+         * 
+         * RA-as-RG layouts, are decompressed whole first, so the compressed and decompressed
+         * 
+         * copies are both resident for a moment, whatever the budget.
+         */
+        static size_t get_memory_budget();
+
+        /**
+         * @brief Returns the pixel floor of a region, from the `spritecutter/slicing/min_pixels` project setting.
+         */
+        static int get_min_pixels();
+
+        /**
+         * @brief Returns the margin nearby regions merge within, from the `spritecutter/slicing/merge_margin` project setting.
+         */
+        static float get_merge_margin();
+
+        /**
+         * @brief Merges regions that are close to each other spatially.
+         *
+         * Delegates to spritecutter::merge_regions() with get_merge_margin().
+         *
+         * @param regions List of regions to process. Modified in-place.
+         * @param stats Optional output: merge time, components in and merges performed, added to.
+         */
+        static void merge_regions(godot::LocalVector<Region>& regions, spritecutter::SliceStats* stats = nullptr);
+
+        // Default alpha threshold: any non-zero alpha counts as opaque
+        static constexpr uint8_t ALPHA_THRESHOLD = 0;
+
+        // Default minimum pixels to consider a region valid
         static constexpr int MIN_PIXELS = 100;
 
-        // Margin used when merging nearby regions
+        // Default margin used when merging nearby regions
         static constexpr float MERGE_MARGIN = 5.0f;
+
+        // Project settings overriding MIN_PIXELS and MERGE_MARGIN, tuned live from the dock
+        static constexpr const char* MIN_PIXELS_SETTING = "spritecutter/slicing/min_pixels";
+        static constexpr const char* MERGE_MARGIN_SETTING = "spritecutter/slicing/merge_margin";
+
+        // Pixels an outline may stray from the traced boundary, and its vertex budget
+        static constexpr float OUTLINE_EPSILON = 2.0f;
+        static constexpr int OUTLINE_MAX_VERTICES = 16;
+
+        // Largest side of an atlas built by pack_atlas(), what Godot's renderer accepts
+        static constexpr int PACK_MAX_SIDE = 16384;
+
+        // Pixels left between sprites placed by layout_sprites()
+        static constexpr int SPAWN_GAP = 16;
+
+        // Reads each instance's atlas rectangle from INSTANCE_CUSTOM, looks like build_trimmed_mesh().
+        // Transparent texels are discarded rather than blended: instances of one MultiMesh aren't
+        // depth sorted. No mipmaps and no repeat, so neighbouring regions don't bleed in.
+        static constexpr const char* SPRITE_MULTIMESH_SHADER = R"(shader_type spatial;
+render_mode unshaded, cull_disabled;
+
+uniform sampler2D atlas : source_color, filter_linear, repeat_disable;
+
+void vertex() {
+	UV = INSTANCE_CUSTOM.xy + UV * INSTANCE_CUSTOM.zw;
+}
+
+void fragment() {
+	vec4 color = texture(atlas, UV);
+	if (color.a < 0.5) {
+		discard;
+	}
+	ALBEDO = color.rgb;
+}
+)";
+
+        // Project setting holding the memory budget, and its default
+        static constexpr const char* MEMORY_BUDGET_SETTING = "spritecutter/slicing/memory_budget_mb";
+        static constexpr int DEFAULT_MEMORY_BUDGET_MB = 512;
+
+        // Duplicate frames folded into one: none, identical pixels, or frames that look alike
+        enum DedupeMode {
+            DEDUPE_OFF,
+            DEDUPE_EXACT,
+            DEDUPE_NEAR,
+        };
+
+        // Project setting holding the DedupeMode of the dock, off by default
+        static constexpr const char* DEDUPE_SETTING = "spritecutter/slicing/dedupe";
+
+        // Perceptual hash bits a near duplicate may differ by
+        static constexpr int NEAR_DUPLICATE_DISTANCE = 3;
+
+    private:
+        // Smallest tile height handed to a labelling task
+        static constexpr int MIN_TILE_ROWS = 64;
+
+        // Decoded pixels held at once while a PNG is packed into a full mask
+        static constexpr size_t DECODE_STRIP_BYTES = size_t(4) << 20;
+
+        // Value of the texture importer's `process/channel_remap/alpha` that keeps alpha as is
+        static constexpr int IMPORT_ALPHA_CHANNEL = 3;
 };
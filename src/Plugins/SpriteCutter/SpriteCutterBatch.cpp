@@ -0,0 +1,455 @@
+#include "SpriteCutterBatch.h"
+
+#include <algorithm>
+#include <memory>
+
+#include <godot_cpp/classes/dir_access.hpp>
+#include <godot_cpp/classes/file_access.hpp>
+#include <godot_cpp/classes/json.hpp>
+#include <godot_cpp/classes/os.hpp>
+#include <godot_cpp/classes/project_settings.hpp>
+#include <godot_cpp/classes/resource_loader.hpp>
+#include <godot_cpp/classes/resource_saver.hpp>
+#include <godot_cpp/classes/time.hpp>
+#include <godot_cpp/variant/utility_functions.hpp>
+
+#include "Core/PngReader.h"
+#include "SpriteCutterFrameIndex.h"
+#include "SpriteCutterTaskGroup.h"
+
+namespace {
+    bool is_image_file(const godot::String& path) {
+        godot::String ext = path.get_extension().to_lower();
+        return ext == "png" || ext == "webp" || ext == "jpg" || ext == "jpeg" || ext == "tga" || ext == "bmp";
+    }
+
+    bool has_wildcard(const godot::String& s) {
+        return s.contains("*") || s.contains("?");
+    }
+}
+
+void SpriteCutterBatch::_bind_methods() {
+    godot::ClassDB::bind_method(godot::D_METHOD("set_jobs", "jobs"), &SpriteCutterBatch::set_jobs);
+    godot::ClassDB::bind_method(godot::D_METHOD("get_jobs"), &SpriteCutterBatch::get_jobs);
+    godot::ClassDB::bind_method(godot::D_METHOD("set_output_format", "format"), &SpriteCutterBatch::set_output_format);
+    godot::ClassDB::bind_method(godot::D_METHOD("get_output_format"), &SpriteCutterBatch::get_output_format);
+    godot::ClassDB::bind_method(godot::D_METHOD("set_output_dir", "dir"), &SpriteCutterBatch::set_output_dir);
+    godot::ClassDB::bind_method(godot::D_METHOD("get_output_dir"), &SpriteCutterBatch::get_output_dir);
+    godot::ClassDB::bind_method(godot::D_METHOD("set_recursive", "recursive"), &SpriteCutterBatch::set_recursive);
+    godot::ClassDB::bind_method(godot::D_METHOD("is_recursive"), &SpriteCutterBatch::is_recursive);
+    godot::ClassDB::bind_method(godot::D_METHOD("set_pack", "pack"), &SpriteCutterBatch::set_pack);
+    godot::ClassDB::bind_method(godot::D_METHOD("is_pack"), &SpriteCutterBatch::is_pack);
+    godot::ClassDB::bind_method(godot::D_METHOD("set_pack_padding", "padding"), &SpriteCutterBatch::set_pack_padding);
+    godot::ClassDB::bind_method(godot::D_METHOD("get_pack_padding"), &SpriteCutterBatch::get_pack_padding);
+    godot::ClassDB::bind_method(godot::D_METHOD("set_dedupe", "dedupe"), &SpriteCutterBatch::set_dedupe);
+    godot::ClassDB::bind_method(godot::D_METHOD("get_dedupe"), &SpriteCutterBatch::get_dedupe);
+    godot::ClassDB::bind_method(godot::D_METHOD("set_alpha_threshold", "threshold"), &SpriteCutterBatch::set_alpha_threshold);
+    godot::ClassDB::bind_method(godot::D_METHOD("get_alpha_threshold"), &SpriteCutterBatch::get_alpha_threshold);
+    godot::ClassDB::bind_method(godot::D_METHOD("collect_inputs", "patterns"), &SpriteCutterBatch::collect_inputs);
+    godot::ClassDB::bind_method(godot::D_METHOD("run", "patterns"), &SpriteCutterBatch::run);
+
+    ADD_PROPERTY(godot::PropertyInfo(godot::Variant::INT, "jobs"), "set_jobs", "get_jobs");
+    ADD_PROPERTY(godot::PropertyInfo(godot::Variant::STRING, "output_format", godot::PROPERTY_HINT_ENUM, "json,tres,res"), "set_output_format", "get_output_format");
+    ADD_PROPERTY(godot::PropertyInfo(godot::Variant::STRING, "output_dir", godot::PROPERTY_HINT_DIR), "set_output_dir", "get_output_dir");
+    ADD_PROPERTY(godot::PropertyInfo(godot::Variant::BOOL, "recursive"), "set_recursive", "is_recursive");
+    ADD_PROPERTY(godot::PropertyInfo(godot::Variant::BOOL, "pack"), "set_pack", "is_pack");
+    ADD_PROPERTY(godot::PropertyInfo(godot::Variant::INT, "pack_padding", godot::PROPERTY_HINT_RANGE, "0,64"), "set_pack_padding", "get_pack_padding");
+    ADD_PROPERTY(godot::PropertyInfo(godot::Variant::INT, "dedupe", godot::PROPERTY_HINT_ENUM, "Off,Exact,Near"), "set_dedupe", "get_dedupe");
+    ADD_PROPERTY(godot::PropertyInfo(godot::Variant::INT, "alpha_threshold", godot::PROPERTY_HINT_RANGE, "0,255"), "set_alpha_threshold", "get_alpha_threshold");
+}
+
+void SpriteCutterBatch::collect_dir(const godot::String& dir, const godot::String& root, const godot::String& pattern, std::vector<Input>& out) const {
+    godot::Ref<godot::DirAccess> da = godot::DirAccess::open(dir);
+    if (!da.is_valid()) {
+        godot::UtilityFunctions::printerr("SpriteCutterBatch: can't open ", dir);
+        return;
+    }
+
+    godot::PackedStringArray files = da->get_files();
+    for (int i = 0; i < files.size(); ++i) {
+        const godot::String& f = files[i];
+        if (!is_image_file(f)) continue;
+        if (!pattern.is_empty() && !f.match(pattern)) continue;
+        out.push_back({ dir.path_join(f), root });
+    }
+
+    if (!recursive) return;
+
+    godot::PackedStringArray dirs = da->get_directories();
+    for (int i = 0; i < dirs.size(); ++i) {
+        collect_dir(dir.path_join(dirs[i]), root, pattern, out);
+    }
+}
+
+std::vector<SpriteCutterBatch::Input> SpriteCutterBatch::collect(const godot::PackedStringArray& patterns) const {
+    std::vector<Input> out;
+
+    for (int i = 0; i < patterns.size(); ++i) {
+        const godot::String& p = patterns[i];
+
+        if (godot::DirAccess::dir_exists_absolute(p)) {
+            collect_dir(p, p, godot::String(), out);
+        } else if (has_wildcard(p)) {
+            // Only the file name part may hold wildcards
+            godot::String base = p.get_base_dir();
+            if (base.is_empty()) base = ".";
+            if (has_wildcard(base)) {
+                godot::UtilityFunctions::printerr("SpriteCutterBatch: wildcards are only supported in the file name: ", p);
+                continue;
+            }
+            collect_dir(base, base, p.get_file(), out);
+        } else if (godot::FileAccess::file_exists(p)) {
+            out.push_back({ p, p.get_base_dir() });
+        } else {
+            godot::UtilityFunctions::printerr("SpriteCutterBatch: no such file or directory: ", p);
+        }
+    }
+
+    // A file matched by two patterns is sliced once, under the first pattern's root
+    std::stable_sort(out.begin(), out.end(), [](const Input& a, const Input& b) { return a.path < b.path; });
+    out.erase(std::unique(out.begin(), out.end(), [](const Input& a, const Input& b) { return a.path == b.path; }), out.end());
+    return out;
+}
+
+godot::PackedStringArray SpriteCutterBatch::collect_inputs(const godot::PackedStringArray& patterns) const {
+    godot::PackedStringArray out;
+    for (const Input& input : collect(patterns)) out.push_back(input.path);
+    return out;
+}
+
+void SpriteCutterBatch::slice_item(Item& item) const {
+    // PNGs are decoded row by row from the mapped file, others fully by Godot
+    if (item.path.get_extension().to_lower() == "png") {
+        spritecutter::MappedFile file;
+        spritecutter::PngReader png;
+        godot::String absolute = godot::ProjectSettings::get_singleton()->globalize_path(item.path);
+        if (file.open(absolute.utf8().get_data()) && png.open(file.get_data(), file.get_size())) {
+            item.width = png.get_width();
+            item.height = png.get_height();
+            item.ok = SpriteCutterAutoSlicer::compute_regions_from_png(file.get_data(), file.get_size(), uint8_t(alpha_threshold), item.regions, nullptr, false);
+            if (item.ok) {
+                // The row decoder keeps no pixels, packing and hashing share one reload
+                godot::Ref<godot::Image> pixels;
+                if (pack && dedupe != SpriteCutterAutoSlicer::DEDUPE_OFF) pixels = godot::Image::load_from_file(item.path);
+                if (pack) item.ok = pack_item(item, pixels);
+                if (item.ok && dedupe != SpriteCutterAutoSlicer::DEDUPE_OFF) item.ok = hash_item(item, pixels);
+                return;
+            }
+        }
+    }
+
+    godot::Ref<godot::Image> img = godot::Image::load_from_file(item.path);
+    if (!img.is_valid()) return;
+
+    item.width = img->get_width();
+    item.height = img->get_height();
+
+    // compute_regions() drops its reference once the mask is built, packing and hashing need the pixels
+    bool keep = pack || dedupe != SpriteCutterAutoSlicer::DEDUPE_OFF;
+    godot::Ref<godot::Image> pixels = keep ? img : godot::Ref<godot::Image>();
+
+    // Images already run in parallel: label each one on its own worker
+    item.ok = SpriteCutterAutoSlicer::compute_regions(img, uint8_t(alpha_threshold), item.regions, nullptr, false);
+    if (item.ok && pack) item.ok = pack_item(item, pixels);
+    if (item.ok && dedupe != SpriteCutterAutoSlicer::DEDUPE_OFF) item.ok = hash_item(item, pixels);
+}
+
+bool SpriteCutterBatch::pack_item(Item& item, godot::Ref<godot::Image> img) const {
+    if (!img.is_valid()) img = godot::Image::load_from_file(item.path);
+
+    godot::Ref<godot::Image> atlas;
+    if (!SpriteCutterAutoSlicer::pack_atlas(img, item.regions, pack_padding, atlas, item.packed, false)) {
+        godot::UtilityFunctions::printerr("SpriteCutterBatch: can't pack ", item.path);
+        return false;
+    }
+
+    item.packed_width = atlas->get_width();
+    item.packed_height = atlas->get_height();
+    item.packed_path = get_output_path(item, ".packed.png");
+    if (atlas->save_png(item.packed_path) != godot::OK) {
+        godot::UtilityFunctions::printerr("SpriteCutterBatch: can't write ", item.packed_path);
+        return false;
+    }
+    return true;
+}
+
+bool SpriteCutterBatch::hash_item(Item& item, godot::Ref<godot::Image> img) const {
+    if (!img.is_valid()) img = godot::Image::load_from_file(item.path);
+
+    if (!SpriteCutterAutoSlicer::compute_frame_hashes(img, item.regions, item.hashes, nullptr, false)) {
+        godot::UtilityFunctions::printerr("SpriteCutterBatch: can't hash the frames of ", item.path);
+        return false;
+    }
+    return true;
+}
+
+void SpriteCutterBatch::plan_outputs(godot::LocalVector<Item>& items) const {
+    // Lowercase keys: hero.png and Hero.webp collide on case-insensitive file systems too
+    godot::HashMap<godot::String, godot::String> owners;
+    for (Item& item : items) {
+        godot::String dir = item.path.get_base_dir();
+        if (!output_dir.is_empty()) {
+            // The image's folders below its root, so a/hero.png and b/hero.png stay apart
+            godot::String relative = dir.trim_prefix(item.root).trim_prefix("/");
+            dir = relative.is_empty() || relative == dir ? output_dir : output_dir.path_join(relative);
+            if (!godot::DirAccess::dir_exists_absolute(dir)) godot::DirAccess::make_dir_recursive_absolute(dir);
+        }
+        item.output_base = dir.path_join(item.path.get_file().get_basename());
+
+        godot::String key = item.output_base.to_lower();
+        if (owners.has(key)) {
+            item.collides_with = owners[key];
+        } else {
+            owners[key] = item.path;
+        }
+    }
+}
+
+bool SpriteCutterBatch::write_item(const Item& item, const godot::Ref<SpriteCutterRegionSet>& set) const {
+    godot::String dest = get_output_path(item, ".regions." + output_format);
+
+    if (output_format == "tres" || output_format == "res") {
+        godot::Ref<godot::Resource> res;
+        if (output_format == "res") {
+            res = set;
+        } else {
+            // Rects packed as x, y, w, h, pixel count
+            godot::PackedInt32Array packed;
+            packed.resize(item.regions.size() * 5);
+            for (uint32_t i = 0; i < item.regions.size(); ++i) {
+                const SpriteCutterAutoSlicer::Region& r = item.regions[i];
+                packed.set(i * 5 + 0, r.x);
+                packed.set(i * 5 + 1, r.y);
+                packed.set(i * 5 + 2, r.w);
+                packed.set(i * 5 + 3, r.h);
+                packed.set(i * 5 + 4, r.count);
+            }
+            res.instantiate();
+            res->set_meta("regions", packed);
+        }
+        res->set_meta("source", item.path);
+        res->set_meta("size", godot::Vector2i(item.width, item.height));
+
+        // Same layout without the pixel count. A packed .res set already holds the places
+        // in the new atlas, the rectangles in the source sheet are kept next to them instead.
+        if (pack) {
+            bool set_is_packed = output_format == "res";
+            const godot::LocalVector<SpriteCutterAutoSlicer::Region>& rects = set_is_packed ? item.regions : item.packed;
+            godot::PackedInt32Array places;
+            places.resize(rects.size() * 4);
+            for (uint32_t i = 0; i < rects.size(); ++i) {
+                const SpriteCutterAutoSlicer::Region& r = rects[i];
+                places.set(i * 4 + 0, r.x);
+                places.set(i * 4 + 1, r.y);
+                places.set(i * 4 + 2, r.w);
+                places.set(i * 4 + 3, r.h);
+            }
+            res->set_meta("packed_source", item.packed_path);
+            res->set_meta("packed_size", godot::Vector2i(item.packed_width, item.packed_height));
+            res->set_meta(set_is_packed ? "source_regions" : "packed_regions", places);
+        }
+
+        if (!item.duplicates.is_empty()) {
+            res->set_meta("duplicate_sources", item.duplicate_sources);
+            res->set_meta("duplicates", item.duplicates);
+        }
+
+        // Later sets linking to this one then reference the file instead of embedding it
+        return godot::ResourceSaver::get_singleton()->save(res, dest, godot::ResourceSaver::FLAG_CHANGE_PATH) == godot::OK;
+    }
+
+    godot::Array regions;
+    for (uint32_t i = 0; i < item.regions.size(); ++i) {
+        const SpriteCutterAutoSlicer::Region& r = item.regions[i];
+        godot::Dictionary d;
+        d["x"] = r.x;
+        d["y"] = r.y;
+        d["w"] = r.w;
+        d["h"] = r.h;
+        d["pixels"] = r.count;
+
+        int source = item.duplicates.is_empty() ? -1 : item.duplicates[i * 2];
+        if (source >= 0) {
+            godot::Dictionary original;
+            original["source"] = item.duplicate_sources[source];
+            original["index"] = item.duplicates[i * 2 + 1];
+            d["duplicate_of"] = original;
+        }
+        regions.push_back(d);
+    }
+
+    godot::Dictionary doc;
+    doc["source"] = item.path;
+    doc["width"] = item.width;
+    doc["height"] = item.height;
+    doc["regions"] = regions;
+
+    if (pack) {
+        godot::Array places;
+        for (const SpriteCutterAutoSlicer::Region& r : item.packed) {
+            godot::Dictionary d;
+            d["x"] = r.x;
+            d["y"] = r.y;
+            d["w"] = r.w;
+            d["h"] = r.h;
+            places.push_back(d);
+        }
+
+        godot::Dictionary packed;
+        packed["source"] = item.packed_path;
+        packed["width"] = item.packed_width;
+        packed["height"] = item.packed_height;
+        packed["regions"] = places;
+        doc["packed"] = packed;
+    }
+
+    godot::Ref<godot::FileAccess> f = godot::FileAccess::open(dest, godot::FileAccess::WRITE);
+    if (!f.is_valid()) return false;
+    f->store_string(godot::JSON::stringify(doc, "\t", false));
+    return true;
+}
+
+godot::Dictionary SpriteCutterBatch::run(const godot::PackedStringArray& patterns) {
+    godot::Dictionary stats;
+    if (output_format != "json" && output_format != "tres" && output_format != "res") {
+        godot::UtilityFunctions::printerr("SpriteCutterBatch: unknown output format ", output_format, " (json, tres or res)");
+        return stats;
+    }
+
+    std::vector<Input> inputs = collect(patterns);
+    int count = (int)inputs.size();
+
+    if (!output_dir.is_empty() && !godot::DirAccess::dir_exists_absolute(output_dir))
+        godot::DirAccess::make_dir_recursive_absolute(output_dir);
+
+    godot::LocalVector<Item> items;
+    items.resize(count);
+    for (int i = 0; i < count; ++i) {
+        items[i].path = inputs[i].path;
+        items[i].root = inputs[i].root;
+    }
+    plan_outputs(items);
+
+    int threads = jobs > 0 ? jobs : godot::OS::get_singleton()->get_processor_count();
+    uint64_t t0 = godot::Time::get_singleton()->get_ticks_usec();
+
+    // Load and slice every image on the pool, at most `threads` at a time
+    SpriteCutterTaskGroup::run(count, [&](int i) {
+        if (items[i].collides_with.is_empty()) slice_item(items[i]);
+    }, "SpriteCutter: batch", threads);
+
+    // One index for the run, so frames repeated across sheets are found too
+    std::unique_ptr<SpriteCutterFrameIndex> frame_index;
+    if (dedupe != SpriteCutterAutoSlicer::DEDUPE_OFF) frame_index = std::make_unique<SpriteCutterFrameIndex>(dedupe);
+
+    // Resource saving is not thread-safe, write the tables from here
+    int failed = 0, regions = 0, packed_sheets = 0;
+    double megapixels = 0.0, fill_sum = 0.0;
+    int64_t bytes_saved = 0;
+    SpriteCutterFrameIndex::Report folded;
+    for (Item& item : items) {
+        if (!item.collides_with.is_empty()) {
+            godot::UtilityFunctions::printerr("SpriteCutterBatch: ", item.path, " would overwrite the files of ", item.collides_with,
+                " (", item.output_base, ".*), skipped");
+            ++failed;
+            continue;
+        }
+        if (!item.ok) {
+            godot::UtilityFunctions::printerr("SpriteCutterBatch: failed to slice ", item.path);
+            ++failed;
+            continue;
+        }
+
+        // A binary SpriteCutterRegionSet, bound to the texture when the sheet is imported.
+        // Packed, it covers the new atlas: its AtlasTextures are the remapped sprites.
+        godot::Ref<SpriteCutterRegionSet> set;
+        if (output_format == "res") {
+            const godot::String& sheet = pack ? item.packed_path : item.path;
+            godot::Ref<godot::Texture2D> texture;
+            if (godot::ResourceLoader::get_singleton()->exists(sheet, "Texture2D"))
+                texture = godot::ResourceLoader::get_singleton()->load(sheet, "Texture2D");
+            set = SpriteCutterRegionSet::create(texture, pack ? item.packed : item.regions);
+        }
+
+        // Sheets are folded in file order, so the tables don't depend on the job count
+        if (frame_index) {
+            std::vector<spritecutter::FrameRef> originals;
+            SpriteCutterFrameIndex::Report report = frame_index->add_sheet(item.path, item.regions, item.hashes, set, &originals);
+            folded.exact += report.exact;
+            folded.near += report.near;
+            folded.bytes_saved += report.bytes_saved;
+
+            if (report.exact + report.near > 0) {
+                godot::HashMap<int, int> slots;
+                item.duplicates.resize(int64_t(originals.size()) * 2);
+                item.duplicates.fill(-1);
+                for (uint32_t i = 0; i < originals.size(); ++i) {
+                    const spritecutter::FrameRef& o = originals[i];
+                    if (!o.is_valid()) continue;
+                    if (!slots.has(o.sheet)) {
+                        slots[o.sheet] = (int)item.duplicate_sources.size();
+                        item.duplicate_sources.push_back(frame_index->get_sheet_name(o.sheet));
+                    }
+                    item.duplicates.set(int64_t(i) * 2, slots[o.sheet]);
+                    item.duplicates.set(int64_t(i) * 2 + 1, o.index);
+                }
+            }
+        }
+
+        if (!write_item(item, set)) {
+            godot::UtilityFunctions::printerr("SpriteCutterBatch: can't write the regions of ", item.path);
+            ++failed;
+            continue;
+        }
+        regions += (int)item.regions.size();
+        megapixels += double(item.width) * double(item.height) / 1e6;
+
+        if (pack) {
+            // As uncompressed RGBA8 in VRAM
+            int64_t packed_area = int64_t(item.packed_width) * item.packed_height;
+            int64_t saved = (int64_t(item.width) * item.height - packed_area) * 4;
+            int64_t used = 0;
+            for (const SpriteCutterAutoSlicer::Region& r : item.packed) used += int64_t(r.w) * r.h;
+            double fill = packed_area > 0 ? double(used) / double(packed_area) : 0.0;
+
+            godot::UtilityFunctions::print("SpriteCutterBatch: ", item.path, " packed ", item.width, "x", item.height, " -> ",
+                item.packed_width, "x", item.packed_height, ", fill ", godot::String::num(fill * 100.0, 1), "%, ",
+                godot::String::num(double(saved) / double(1 << 20), 1), " MiB saved");
+
+            bytes_saved += saved;
+            fill_sum += fill;
+            ++packed_sheets;
+        }
+    }
+
+    double seconds = double(godot::Time::get_singleton()->get_ticks_usec() - t0) / 1e6;
+    int done = count - failed;
+    double ips = seconds > 0.0 ? done / seconds : 0.0;
+    double mps = seconds > 0.0 ? megapixels / seconds : 0.0;
+
+    godot::UtilityFunctions::print("SpriteCutterBatch: ", done, "/", count, " images, ", regions, " regions in ",
+        godot::String::num(seconds, 3), " s (", godot::String::num(ips, 1), " images/s, ",
+        godot::String::num(mps, 1), " MP/s, ", threads, " jobs)");
+    if (frame_index) {
+        godot::UtilityFunctions::print("SpriteCutterBatch: ", folded.exact + folded.near, " duplicate frames (", folded.exact, " exact, ",
+            folded.near, " near), ", godot::String::num(double(folded.bytes_saved) / double(1 << 20), 1), " MiB saved");
+    }
+
+    stats["images"] = done;
+    stats["failed"] = failed;
+    stats["regions"] = regions;
+    stats["megapixels"] = megapixels;
+    stats["seconds"] = seconds;
+    stats["images_per_second"] = ips;
+    stats["megapixels_per_second"] = mps;
+    if (pack) {
+        stats["bytes_saved"] = bytes_saved;
+        stats["fill_ratio"] = packed_sheets > 0 ? fill_sum / packed_sheets : 0.0;
+    }
+    if (frame_index) {
+        stats["duplicates"] = folded.exact + folded.near;
+        stats["near_duplicates"] = folded.near;
+        stats["dedupe_bytes_saved"] = folded.bytes_saved;
+    }
+    return stats;
+}
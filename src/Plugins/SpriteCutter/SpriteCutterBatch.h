@@ -0,0 +1,216 @@
+#pragma once
+
+#include <vector>
+
+#include <godot_cpp/classes/ref_counted.hpp>
+#include <godot_cpp/variant/dictionary.hpp>
+#include <godot_cpp/variant/packed_string_array.hpp>
+
+#include "SpriteCutterAutoSlicer.h"
+#include "SpriteCutterRegionSet.h"
+
+/**
+ * @class SpriteCutterBatch
+ * @brief Slices whole folders of sprite sheets without the editor UI.
+ *
+ * Inputs are directories, glob patterns (`assets/*.png`) or single files.
+ *
+ * Images are loaded and sliced in parallel on the WorkerThreadPool, one task per image,
+ *
+ * and each region table is written as JSON, as a `.tres` resource, or as a binary
+ *
+ * SpriteCutterRegionSet `.res`.
+ *
+ * With `pack` on, the sprites of each sheet are also repacked into `<name>.packed.png`
+ *
+ * without the empty space, and their places there are added to the table. A `.res`
+ *
+ * table then covers the packed atlas, so its AtlasTextures are the remapped sprites.
+ *
+ * With `dedupe` on, frames repeating one seen earlier in the run, in the same sheet or
+ *
+ * another, point to it in the table instead of standing alone.
+ *
+ * With `output_dir` set, each image's files go to its path relative to the directory
+ *
+ * or glob it was collected from. Two images that would still write the same files, such
+ *
+ * as `hero.png` and `hero.webp`, fail rather than overwrite each other.
+ *
+ * Used by `addons/SpriteCutter/batch.gd` for `godot --headless` runs, and registered
+ *
+ * at scene level so it also works from exported builds.
+ */
+class SpriteCutterBatch : public godot::RefCounted {
+    GDCLASS(SpriteCutterBatch, godot::RefCounted);
+
+    public:
+        SpriteCutterBatch() = default;
+        ~SpriteCutterBatch() override = default;
+
+        void set_jobs(int p_jobs) { jobs = p_jobs; }
+        int get_jobs() const { return jobs; }
+
+        void set_output_format(const godot::String& p_format) { output_format = p_format; }
+        godot::String get_output_format() const { return output_format; }
+
+        void set_output_dir(const godot::String& p_dir) { output_dir = p_dir; }
+        godot::String get_output_dir() const { return output_dir; }
+
+        void set_recursive(bool p_recursive) { recursive = p_recursive; }
+        bool is_recursive() const { return recursive; }
+
+        void set_pack(bool p_pack) { pack = p_pack; }
+        bool is_pack() const { return pack; }
+
+        void set_pack_padding(int p_padding) { pack_padding = godot::MAX(0, p_padding); }
+        int get_pack_padding() const { return pack_padding; }
+
+        void set_dedupe(int p_dedupe) { dedupe = godot::CLAMP(p_dedupe, int(SpriteCutterAutoSlicer::DEDUPE_OFF), int(SpriteCutterAutoSlicer::DEDUPE_NEAR)); }
+        int get_dedupe() const { return dedupe; }
+
+        void set_alpha_threshold(int p_threshold) { alpha_threshold = godot::CLAMP(p_threshold, 0, 255); }
+        int get_alpha_threshold() const { return alpha_threshold; }
+
+        /**
+         * @brief Expands directories and glob patterns into a sorted list of image files.
+         *
+         * @param patterns Directories, glob patterns or files.
+         * @return The image files found.
+         */
+        godot::PackedStringArray collect_inputs(const godot::PackedStringArray& patterns) const;
+
+        /**
+         * @brief Slices every image matched by the patterns and writes their region tables.
+         *
+         * @param patterns Directories, glob patterns or files.
+         * @return Statistics: `images`, `failed`, `regions`, `megapixels`, `seconds`,
+         *         `images_per_second` and `megapixels_per_second`. With `pack` on, also
+         *         `bytes_saved` over every sheet and their mean `fill_ratio`. With `dedupe` on,
+         *         also `duplicates`, of which `near_duplicates`, and `dedupe_bytes_saved`.
+         */
+        godot::Dictionary run(const godot::PackedStringArray& patterns);
+
+    protected:
+        static void _bind_methods();
+
+    private:
+        /**
+         * @brief Result of one image, filled by a worker.
+         */
+        struct Item {
+            godot::String path;
+
+            // Directory the image was collected from, mirrored under output_dir
+            godot::String root;
+
+            // Output files are this plus a suffix, see get_output_path()
+            godot::String output_base;
+
+            // Earlier image writing the same files, this one is then skipped
+            godot::String collides_with;
+
+            int width = 0;
+            int height = 0;
+            bool ok = false;
+            godot::LocalVector<SpriteCutterAutoSlicer::Region> regions;
+
+            // Repacked atlas, when `pack` is on
+            godot::String packed_path;
+            int packed_width = 0;
+            int packed_height = 0;
+            godot::LocalVector<SpriteCutterAutoSlicer::Region> packed;
+
+            // Fingerprint of each region, when `dedupe` is on
+            std::vector<spritecutter::FrameHash> hashes;
+
+            // Sheets holding originals, then 2 ints per region: the sheet in
+            // duplicate_sources and the original's index, -1 for unique frames
+            godot::PackedStringArray duplicate_sources;
+            godot::PackedInt32Array duplicates;
+        };
+
+        /**
+         * @brief Loads and slices one image. Runs on a worker thread.
+         */
+        void slice_item(Item& item) const;
+
+        /**
+         * @brief Repacks the sprites of one image and saves the atlas. Runs on a worker thread.
+         *
+         * @param img The image if it is still loaded, reloaded from the file otherwise.
+         * @return false if the atlas can't be built or saved.
+         */
+        bool pack_item(Item& item, godot::Ref<godot::Image> img) const;
+
+        /**
+         * @brief Fingerprints the regions of one image for dedupe. Runs on a worker thread.
+         *
+         * @param img The image if it is still loaded, reloaded from the file otherwise.
+         * @return false if the image can't be read.
+         */
+        bool hash_item(Item& item, godot::Ref<godot::Image> img) const;
+
+        /**
+         * @brief Sets `output_base` of every item, creates its directory and flags collisions.
+         *
+         * Runs before slicing, on the calling thread.
+         */
+        void plan_outputs(godot::LocalVector<Item>& items) const;
+
+        /**
+         * @brief Returns where a file derived from an image goes: next to it or into output_dir.
+         */
+        godot::String get_output_path(const Item& item, const godot::String& suffix) const { return item.output_base + suffix; }
+
+        /**
+         * @brief Writes the region table of one image next to it or into output_dir.
+         *
+         * @param set The regions as a SpriteCutterRegionSet, written when the format is "res".
+         * @return false if the file can't be written.
+         */
+        bool write_item(const Item& item, const godot::Ref<SpriteCutterRegionSet>& set) const;
+
+        /**
+         * @brief An image file and the directory or glob base it was found under.
+         */
+        struct Input {
+            godot::String path;
+            godot::String root;
+        };
+
+        /**
+         * @brief collect_inputs() keeping the root of each file, sorted by path.
+         */
+        std::vector<Input> collect(const godot::PackedStringArray& patterns) const;
+
+        /**
+         * @brief Adds the image files of a directory, optionally recursing.
+         *
+         * @param root The directory the scan started from.
+         */
+        void collect_dir(const godot::String& dir, const godot::String& root, const godot::String& pattern, std::vector<Input>& out) const;
+
+        // Number of images sliced at once, <= 0 for one per core
+        int jobs = 0;
+
+        // "json", "tres" or "res"
+        godot::String output_format = "json";
+
+        // Destination folder, empty to write next to each image
+        godot::String output_dir;
+
+        // Scan directories recursively
+        bool recursive = false;
+
+        // Repack the sprites of each sheet into a tight atlas
+        bool pack = false;
+
+        // Empty pixels between two repacked sprites
+        int pack_padding = 2;
+
+        int alpha_threshold = SpriteCutterAutoSlicer::ALPHA_THRESHOLD;
+
+        // SpriteCutterAutoSlicer::DedupeMode applied across every sheet of a run
+        int dedupe = SpriteCutterAutoSlicer::DEDUPE_OFF;
+};
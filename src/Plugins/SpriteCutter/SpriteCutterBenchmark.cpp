@@ -0,0 +1,294 @@
+#include "SpriteCutterBenchmark.h"
+
+#include <algorithm>
+#include <vector>
+
+#include <godot_cpp/classes/class_db_singleton.hpp>
+#include <godot_cpp/classes/file_access.hpp>
+#include <godot_cpp/classes/image_texture.hpp>
+#include <godot_cpp/classes/json.hpp>
+#include <godot_cpp/classes/os.hpp>
+#include <godot_cpp/classes/resource_loader.hpp>
+#include <godot_cpp/classes/time.hpp>
+#include <godot_cpp/variant/utility_functions.hpp>
+
+#include "Core/SheetGenerator.h"
+#include "SpriteCutterRegionSet.h"
+#include "SpriteCutterRightPanel.h"
+
+namespace {
+    // Stages in report order, `total` is their sum
+    const char* const STAGES[] = { "fetch", "detect", "merge", "atlas", "populate", "total" };
+    constexpr int STAGE_COUNT = 6;
+    constexpr int STAGE_POPULATE = 4;
+
+    double median(std::vector<double> v) {
+        std::sort(v.begin(), v.end());
+        return v[v.size() / 2];
+    }
+
+    double elapsed_ms(uint64_t from, uint64_t to) {
+        return double(to - from) / 1000.0;
+    }
+
+    spritecutter::SheetSpec spec_from_dictionary(const godot::Dictionary& d) {
+        spritecutter::SheetSpec spec;
+        spec.width = int(d.get("width", spec.width));
+        spec.height = int(d.get("height", spec.height));
+        spec.sprites = int(d.get("sprites", spec.sprites));
+        spec.specks = int(d.get("specks", spec.specks));
+        spec.gap = int(d.get("gap", spec.gap));
+        spec.cell = int(d.get("cell", spec.cell));
+        spec.seed = uint32_t(int64_t(d.get("seed", int64_t(spec.seed))));
+
+        godot::String shape = d.get("shape", spritecutter::sprite_shape_name(spec.shape));
+        if (!spritecutter::parse_sprite_shape(shape.utf8().get_data(), spec.shape))
+            godot::UtilityFunctions::printerr("SpriteCutterBenchmark: unknown shape ", shape, ", using ", spritecutter::sprite_shape_name(spec.shape));
+        return spec;
+    }
+
+    godot::Dictionary spec_to_dictionary(const godot::String& name, const spritecutter::SheetSpec& spec) {
+        godot::Dictionary d;
+        d["name"] = name;
+        d["width"] = spec.width;
+        d["height"] = spec.height;
+        d["sprites"] = spec.sprites;
+        d["shape"] = spritecutter::sprite_shape_name(spec.shape);
+        d["specks"] = spec.specks;
+        d["gap"] = spec.gap;
+        d["cell"] = spec.cell;
+        d["seed"] = int64_t(spec.seed);
+        return d;
+    }
+}
+
+void SpriteCutterBenchmark::_bind_methods() {
+    godot::ClassDB::bind_method(godot::D_METHOD("set_iterations", "iterations"), &SpriteCutterBenchmark::set_iterations);
+    godot::ClassDB::bind_method(godot::D_METHOD("get_iterations"), &SpriteCutterBenchmark::get_iterations);
+    godot::ClassDB::bind_method(godot::D_METHOD("set_alpha_threshold", "threshold"), &SpriteCutterBenchmark::set_alpha_threshold);
+    godot::ClassDB::bind_method(godot::D_METHOD("get_alpha_threshold"), &SpriteCutterBenchmark::get_alpha_threshold);
+    godot::ClassDB::bind_method(godot::D_METHOD("run_file", "path"), &SpriteCutterBenchmark::run_file);
+    godot::ClassDB::bind_method(godot::D_METHOD("run_synthetic", "spec"), &SpriteCutterBenchmark::run_synthetic);
+    godot::ClassDB::bind_method(godot::D_METHOD("get_standard_sheets", "full"), &SpriteCutterBenchmark::get_standard_sheets);
+    godot::ClassDB::bind_method(godot::D_METHOD("run", "files", "sheets"), &SpriteCutterBenchmark::run);
+    godot::ClassDB::bind_static_method("SpriteCutterBenchmark", godot::D_METHOD("save_results", "results", "path"), &SpriteCutterBenchmark::save_results);
+    godot::ClassDB::bind_static_method("SpriteCutterBenchmark", godot::D_METHOD("compare", "results", "baseline_path", "tolerance"), &SpriteCutterBenchmark::compare, DEFVAL(0.1));
+
+    ADD_PROPERTY(godot::PropertyInfo(godot::Variant::INT, "iterations", godot::PROPERTY_HINT_RANGE, "1,1000"), "set_iterations", "get_iterations");
+    ADD_PROPERTY(godot::PropertyInfo(godot::Variant::INT, "alpha_threshold", godot::PROPERTY_HINT_RANGE, "0,255"), "set_alpha_threshold", "get_alpha_threshold");
+}
+
+godot::Dictionary SpriteCutterBenchmark::run_file(const godot::String& path) {
+    // The imported texture is what the dock slices, the source file is the fallback
+    godot::Ref<godot::Texture2D> texture;
+    if (godot::ResourceLoader::get_singleton()->exists(path))
+        texture = godot::ResourceLoader::get_singleton()->load(path);
+
+    godot::Ref<godot::Image> source = godot::Image::load_from_file(path);
+    if (!texture.is_valid() && source.is_valid())
+        texture = godot::ImageTexture::create_from_image(source);
+
+    if (!texture.is_valid()) {
+        godot::UtilityFunctions::printerr("SpriteCutterBenchmark: can't load ", path);
+        return godot::Dictionary();
+    }
+
+    godot::Dictionary params;
+    params["source"] = path;
+    return measure(path.get_file(), texture, source, params);
+}
+
+godot::Dictionary SpriteCutterBenchmark::run_synthetic(const godot::Dictionary& spec_dict) {
+    spritecutter::SheetSpec spec = spec_from_dictionary(spec_dict);
+    if (spec.width <= 0 || spec.height <= 0 || spec.width > 16384 || spec.height > 16384) {
+        godot::UtilityFunctions::printerr("SpriteCutterBenchmark: sheet size must be within 1..16384");
+        return godot::Dictionary();
+    }
+
+    // Draw straight into the byte array the Image will share
+    godot::PackedByteArray pixels;
+    pixels.resize(int64_t(spritecutter::sheet_size(spec)));
+    int placed = spritecutter::generate_sheet(spec, pixels.ptrw());
+    if (placed < 0) {
+        godot::UtilityFunctions::printerr("SpriteCutterBenchmark: invalid sheet spec");
+        return godot::Dictionary();
+    }
+
+    godot::Ref<godot::Image> source = godot::Image::create_from_data(spec.width, spec.height, false, godot::Image::FORMAT_RGBA8, pixels);
+    pixels = godot::PackedByteArray();
+    godot::Ref<godot::ImageTexture> texture = godot::ImageTexture::create_from_image(source);
+
+    godot::String name = spec_dict.get("name", godot::String::num_int64(spec.width) + "x" + godot::String::num_int64(spec.height)
+        + "-" + spritecutter::sprite_shape_name(spec.shape));
+    godot::Dictionary params = spec_to_dictionary(name, spec);
+    params["placed"] = placed;
+    return measure(name, texture, source, params);
+}
+
+godot::Array SpriteCutterBenchmark::get_standard_sheets(bool full) const {
+    godot::Array sheets;
+    for (const spritecutter::SheetCase& c : spritecutter::standard_sheets(full))
+        sheets.push_back(spec_to_dictionary(c.name.c_str(), c.spec));
+    return sheets;
+}
+
+godot::Dictionary SpriteCutterBenchmark::measure(const godot::String& name, const godot::Ref<godot::Texture2D>& texture,
+    const godot::Ref<godot::Image>& source, const godot::Dictionary& params) {
+    godot::Time* time = godot::Time::get_singleton();
+
+    // The panel is an editor class, only there when running inside the editor
+    bool has_panel = godot::ClassDBSingleton::get_singleton()->class_exists("SpriteCutterRightPanel");
+    SpriteCutterRightPanel* panel = has_panel ? memnew(SpriteCutterRightPanel) : nullptr;
+
+    std::vector<double> samples[STAGE_COUNT];
+    int width = 0, height = 0, regions_found = 0;
+    bool readback = true;
+
+    for (int it = 0; it < iterations; ++it) {
+        uint64_t t0 = time->get_ticks_usec();
+        godot::Ref<godot::Image> img = SpriteCutterAutoSlicer::fetch_image(texture);
+        if (!img.is_valid() && source.is_valid()) {
+            // The dummy renderer of --headless can't read textures back
+            img = source->duplicate();
+            readback = false;
+        }
+        if (!img.is_valid() || (img->is_compressed() && img->decompress() != godot::OK)) {
+            godot::UtilityFunctions::printerr("SpriteCutterBenchmark: can't read the pixels of ", name);
+            if (panel) memdelete(panel);
+            return godot::Dictionary();
+        }
+        width = img->get_width();
+        height = img->get_height();
+
+        uint64_t t1 = time->get_ticks_usec();
+        spritecutter::AlphaMask mask;
+        SpriteCutterAutoSlicer::build_mask(img.ptr(), uint8_t(alpha_threshold), mask);
+        img.unref();
+        godot::LocalVector<SpriteCutterAutoSlicer::Region> regions;
+        SpriteCutterAutoSlicer::detect_regions(mask, SpriteCutterAutoSlicer::get_min_pixels(), regions);
+
+        uint64_t t2 = time->get_ticks_usec();
+        SpriteCutterAutoSlicer::merge_regions(regions);
+        regions_found = (int)regions.size();
+
+        uint64_t t3 = time->get_ticks_usec();
+        godot::Ref<SpriteCutterRegionSet> set = SpriteCutterRegionSet::create(texture, regions);
+
+        uint64_t t4 = time->get_ticks_usec();
+        if (panel) panel->populate(set);
+        uint64_t t5 = time->get_ticks_usec();
+
+        samples[0].push_back(elapsed_ms(t0, t1));
+        samples[1].push_back(elapsed_ms(t1, t2));
+        samples[2].push_back(elapsed_ms(t2, t3));
+        samples[3].push_back(elapsed_ms(t3, t4));
+        samples[4].push_back(elapsed_ms(t4, t5));
+        samples[5].push_back(elapsed_ms(t0, t5));
+    }
+    if (panel) memdelete(panel);
+
+    godot::Dictionary stages, stages_min;
+    for (int s = 0; s < STAGE_COUNT; ++s) {
+        if (s == STAGE_POPULATE && !has_panel) continue;
+        stages[STAGES[s]] = median(samples[s]);
+        stages_min[STAGES[s]] = *std::min_element(samples[s].begin(), samples[s].end());
+    }
+
+    godot::Dictionary result = params.duplicate();
+    result["name"] = name;
+    result["width"] = width;
+    result["height"] = height;
+    result["regions"] = regions_found;
+    result["texture_readback"] = readback;
+    result["stages"] = stages;
+    result["stages_min"] = stages_min;
+    return result;
+}
+
+godot::Dictionary SpriteCutterBenchmark::run(const godot::PackedStringArray& files, const godot::Array& sheets) {
+    godot::Array cases;
+
+    auto report = [&cases](const godot::Dictionary& r) {
+        if (r.is_empty()) return;
+        cases.push_back(r);
+
+        godot::Dictionary stages = r["stages"];
+        godot::String line = godot::String(r["name"]).rpad(24) + godot::String::num_int64(r["width"]) + "x"
+            + godot::String::num_int64(r["height"]) + " " + godot::String::num_int64(r["regions"]) + " regions |";
+        for (int s = 0; s < STAGE_COUNT; ++s) {
+            if (stages.has(STAGES[s]))
+                line += godot::String(" ") + STAGES[s] + " " + godot::String::num(stages[STAGES[s]], 3);
+        }
+        godot::UtilityFunctions::print(line, " ms");
+    };
+
+    for (int i = 0; i < files.size(); ++i) report(run_file(files[i]));
+    for (int i = 0; i < sheets.size(); ++i) report(run_synthetic(sheets[i]));
+
+    godot::Dictionary results;
+    results["tool"] = "SpriteCutterBenchmark";
+    results["threads"] = godot::OS::get_singleton()->get_processor_count();
+    results["iterations"] = iterations;
+    results["cases"] = cases;
+    return results;
+}
+
+bool SpriteCutterBenchmark::save_results(const godot::Dictionary& results, const godot::String& path) {
+    godot::Ref<godot::FileAccess> f = godot::FileAccess::open(path, godot::FileAccess::WRITE);
+    if (!f.is_valid()) {
+        godot::UtilityFunctions::printerr("SpriteCutterBenchmark: can't write ", path);
+        return false;
+    }
+    f->store_string(godot::JSON::stringify(results, "\t", false));
+    return true;
+}
+
+int SpriteCutterBenchmark::compare(const godot::Dictionary& results, const godot::String& baseline_path, double tolerance) {
+    godot::Variant parsed = godot::JSON::parse_string(godot::FileAccess::get_file_as_string(baseline_path));
+    if (parsed.get_type() != godot::Variant::DICTIONARY || !godot::Dictionary(parsed).has("cases")) {
+        godot::UtilityFunctions::printerr("SpriteCutterBenchmark: can't read baseline ", baseline_path);
+        return -1;
+    }
+
+    // Index the baseline cases by name
+    godot::Dictionary baseline;
+    godot::Array old_cases = godot::Dictionary(parsed)["cases"];
+    for (int i = 0; i < old_cases.size(); ++i) {
+        godot::Dictionary c = old_cases[i];
+        baseline[c.get("name", "")] = c;
+    }
+
+    godot::UtilityFunctions::print("compared with ", baseline_path, " (tolerance ", godot::String::num(tolerance * 100.0, 0), "%)");
+    int regressions = 0;
+    godot::Array cases = results.get("cases", godot::Array());
+    for (int i = 0; i < cases.size(); ++i) {
+        godot::Dictionary now = cases[i];
+        godot::String name = now.get("name", "");
+        if (!baseline.has(name)) {
+            godot::UtilityFunctions::print(name.rpad(24), "not in baseline");
+            continue;
+        }
+        godot::Dictionary before = baseline[name];
+
+        // Not a timing regression, but a behaviour change worth a look
+        if (int(before.get("regions", -1)) != int(now.get("regions", -1)))
+            godot::UtilityFunctions::print(name.rpad(24), "region count changed: ", before.get("regions", -1), " -> ", now.get("regions", -1));
+
+        godot::Dictionary old_stages = before.get("stages", godot::Dictionary());
+        godot::Dictionary new_stages = now.get("stages", godot::Dictionary());
+        for (int s = 0; s < STAGE_COUNT; ++s) {
+            if (!old_stages.has(STAGES[s]) || !new_stages.has(STAGES[s])) continue;
+
+            double a = old_stages[STAGES[s]], b = new_stages[STAGES[s]];
+            double change = a > 0.0 ? b / a - 1.0 : 0.0;
+            bool slower = change > tolerance && b - a > NOISE_FLOOR_MS;
+            regressions += slower ? 1 : 0;
+
+            godot::UtilityFunctions::print(name.rpad(24), godot::String(STAGES[s]).rpad(9),
+                godot::String::num(a, 3), " -> ", godot::String::num(b, 3), " ms  ",
+                change >= 0.0 ? "+" : "", godot::String::num(change * 100.0, 1), "%", slower ? "  REGRESSION" : "");
+        }
+    }
+    godot::UtilityFunctions::print(regressions, " regression(s)");
+    return regressions;
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <godot_cpp/classes/image.hpp>
+#include <godot_cpp/classes/ref_counted.hpp>
+#include <godot_cpp/classes/texture2d.hpp>
+#include <godot_cpp/variant/array.hpp>
+#include <godot_cpp/variant/dictionary.hpp>
+#include <godot_cpp/variant/packed_string_array.hpp>
+
+#include "SpriteCutterAutoSlicer.h"
+
+/**
+ * @class SpriteCutterBenchmark
+ * @brief Times each stage of the editor pipeline on real and synthetic sprite sheets.
+ *
+ * Stages: `fetch` (texture readback and decompression), `detect` (mask and labelling),
+ *
+ * `merge`, `atlas` (SpriteCutterRegionSet creation) and `populate` (SpriteCutterRightPanel),
+ *
+ * plus their `total`. `populate` is only measured when the editor classes are registered.
+ *
+ * Synthetic sheets come from spritecutter::generate_sheet(), the same seeded generator
+ *
+ * the native `spritecutter_bench` uses, so both report on identical pixels.
+ *
+ * Results are plain dictionaries saved as JSON, and compare() flags stages that got
+ *
+ * slower than a saved baseline. Driven by `addons/SpriteCutter/bench.gd`.
+ */
+class SpriteCutterBenchmark : public godot::RefCounted {
+    GDCLASS(SpriteCutterBenchmark, godot::RefCounted);
+
+    public:
+        SpriteCutterBenchmark() = default;
+        ~SpriteCutterBenchmark() override = default;
+
+        void set_iterations(int p_iterations) { iterations = godot::MAX(1, p_iterations); }
+        int get_iterations() const { return iterations; }
+
+        void set_alpha_threshold(int p_threshold) { alpha_threshold = godot::CLAMP(p_threshold, 0, 255); }
+        int get_alpha_threshold() const { return alpha_threshold; }
+
+        /**
+         * @brief Benchmarks an image file, through its imported texture when there is one.
+         *
+         * @param path Path of the image, e.g. `res://assets/sheet.png`.
+         * @return The case result, empty on error.
+         */
+        godot::Dictionary run_file(const godot::String& path);
+
+        /**
+         * @brief Benchmarks a generated sheet.
+         *
+         * @param spec `name`, `width`, `height`, `sprites`, `shape` (rect, disc, blob, mixed),
+         *        `specks`, `gap`, `cell` and `seed`. Missing keys take the generator defaults.
+         * @return The case result, empty on error.
+         */
+        godot::Dictionary run_synthetic(const godot::Dictionary& spec);
+
+        /**
+         * @brief Returns the specs of the standard synthetic suite.
+         *
+         * @param full Adds the 8k and 16k sheets.
+         */
+        godot::Array get_standard_sheets(bool full) const;
+
+        /**
+         * @brief Benchmarks every file and sheet and gathers the results.
+         *
+         * @param files Image files.
+         * @param sheets Synthetic sheet specs, see run_synthetic().
+         * @return `tool`, `threads`, `iterations` and the `cases` array.
+         */
+        godot::Dictionary run(const godot::PackedStringArray& files, const godot::Array& sheets);
+
+        /**
+         * @brief Writes results as JSON.
+         *
+         * @return false if the file can't be written.
+         */
+        static bool save_results(const godot::Dictionary& results, const godot::String& path);
+
+        /**
+         * @brief Prints each stage next to a saved baseline and flags the ones that got slower.
+         *
+         * A stage regresses when its median grows by more than `tolerance` and by more than
+         *
+         * NOISE_FLOOR_MS. Cases are matched by name.
+         *
+         * @param results Results of run().
+         * @param baseline_path JSON file written by save_results().
+         * @param tolerance Allowed slowdown, 0.1 for 10%.
+         * @return The number of regressions, -1 if the baseline can't be read.
+         */
+        static int compare(const godot::Dictionary& results, const godot::String& baseline_path, double tolerance = 0.1);
+
+    protected:
+        static void _bind_methods();
+
+    private:
+        /**
+         * @brief Times every stage on one texture and returns the case result.
+         *
+         * @param name Case name.
+         * @param texture Texture to slice, used as the texture of the SpriteCutterRegionSet.
+         * @param source Pixels to use when the texture can't be read back, e.g. under the dummy renderer.
+         * @param params Extra keys copied into the result.
+         */
+        godot::Dictionary measure(const godot::String& name, const godot::Ref<godot::Texture2D>& texture,
+            const godot::Ref<godot::Image>& source, const godot::Dictionary& params);
+
+        // Runs per case, the median is reported
+        int iterations = 5;
+
+        int alpha_threshold = SpriteCutterAutoSlicer::ALPHA_THRESHOLD;
+
+        // Slowdowns smaller than this are noise whatever the ratio
+        static constexpr double NOISE_FLOOR_MS = 0.1;
+};
@@ -1,5 +1,11 @@
 #include "SpriteCutterDock.h"
 
+#include <godot_cpp/classes/project_settings.hpp>
+#include <godot_cpp/classes/time.hpp>
+
+#include "SpriteCutterMonitors.h"
+#include "SpriteCutterSliceCache.h"
+
 using namespace godot;
 
 // Register exposed methods and the custom signal
@@ -7,9 +13,17 @@ void SpriteCutterDock::_bind_methods() {
     ClassDB::bind_method(D_METHOD("adjust_split_offset"), &SpriteCutterDock::adjust_split_offset);
     ClassDB::bind_method(D_METHOD("_on_texture_changed", "tex"), &SpriteCutterDock::_on_texture_changed);
     ClassDB::bind_method(D_METHOD("_on_cut_requested"), &SpriteCutterDock::_on_cut_requested);
+    ClassDB::bind_method(D_METHOD("_on_cancel_requested"), &SpriteCutterDock::_on_cancel_requested);
+    ClassDB::bind_method(D_METHOD("_on_slice_finished"), &SpriteCutterDock::_on_slice_finished);
+    ClassDB::bind_method(D_METHOD("_on_outlines_finished"), &SpriteCutterDock::_on_outlines_finished);
     ClassDB::bind_method(D_METHOD("_on_item_activated", "index"), &SpriteCutterDock::_on_item_activated);
+    ClassDB::bind_method(D_METHOD("_on_selection_changed"), &SpriteCutterDock::_on_selection_changed);
+    ClassDB::bind_method(D_METHOD("_on_spawn_requested", "as_multimesh"), &SpriteCutterDock::_on_spawn_requested);
+    ClassDB::bind_method(D_METHOD("_on_region_settings_changed", "min_pixels", "merge_margin"), &SpriteCutterDock::_on_region_settings_changed);
+    ClassDB::bind_method(D_METHOD("_on_region_settings_timeout"), &SpriteCutterDock::_on_region_settings_timeout);
 
-    ADD_SIGNAL(MethodInfo("sprite_double_clicked", PropertyInfo(Variant::OBJECT, "atlas", PROPERTY_HINT_RESOURCE_TYPE, "AtlasTexture")));
+    ADD_SIGNAL(MethodInfo("sprite_double_clicked", PropertyInfo(Variant::OBJECT, "atlas", PROPERTY_HINT_RESOURCE_TYPE, "AtlasTexture"), PropertyInfo(Variant::PACKED_VECTOR2_ARRAY, "outline")));
+    ADD_SIGNAL(MethodInfo("sprites_spawn_requested", PropertyInfo(Variant::OBJECT, "set", PROPERTY_HINT_RESOURCE_TYPE, "SpriteCutterRegionSet"), PropertyInfo(Variant::PACKED_INT32_ARRAY, "indices"), PropertyInfo(Variant::ARRAY, "outlines"), PropertyInfo(Variant::BOOL, "as_multimesh")));
 }
 
 // Constructor: sets up the dock UI
@@ -25,6 +39,28 @@ void SpriteCutterDock::_notification(int what) {
         connect_signals();
         adjust_split_offset();
     }
+
+    // Mirror the job progress while it runs
+    if (what == NOTIFICATION_PROCESS && job.is_valid()) {
+        left_panel->set_progress(job->get_progress());
+    }
+
+    // Slider values reach project.godot once, when the editor or plugin closes
+    if (what == NOTIFICATION_EXIT_TREE) {
+        save_region_settings();
+    }
+
+    // The workers must not outlive the dock
+    if (what == NOTIFICATION_PREDELETE && job.is_valid()) {
+        job->cancel();
+        job->wait();
+        job.unref();
+    }
+    if (what == NOTIFICATION_PREDELETE && outline_job.is_valid()) {
+        outline_job->cancel();
+        outline_job->wait();
+        outline_job.unref();
+    }
 }
 
 void SpriteCutterDock::setup_ui() {
@@ -65,12 +101,23 @@ void SpriteCutterDock::setup_ui() {
         m->add_child(right_panel);
         split->add_child(m);
     }
+
+    // Fires once the region sliders rest
+    params_timer = memnew(Timer);
+    params_timer->set_one_shot(true);
+    params_timer->set_wait_time(PARAMS_DEBOUNCE);
+    add_child(params_timer);
 }
 
 void SpriteCutterDock::connect_signals() {
     left_panel->connect("texture_changed", Callable(this, "_on_texture_changed"));
     left_panel->connect("cut_requested", Callable(this, "_on_cut_requested"));
-    right_panel->get_list()->connect("item_activated", Callable(this, "_on_item_activated"));
+    left_panel->connect("cancel_requested", Callable(this, "_on_cancel_requested"));
+    left_panel->connect("region_settings_changed", Callable(this, "_on_region_settings_changed"));
+    params_timer->connect("timeout", Callable(this, "_on_region_settings_timeout"));
+    right_panel->get_grid()->connect("item_activated", Callable(this, "_on_item_activated"));
+    right_panel->get_grid()->connect("selection_changed", Callable(this, "_on_selection_changed"));
+    left_panel->connect("spawn_requested", Callable(this, "_on_spawn_requested"));
 }
 
 void SpriteCutterDock::adjust_split_offset() {
@@ -81,7 +128,15 @@ void SpriteCutterDock::adjust_split_offset() {
 
 void SpriteCutterDock::_on_texture_changed(const Ref<Texture2D>&) {
     UtilityFunctions::print("SpriteCutter: texture chargée → on clear");
+
+    // Results of the previous texture are no longer wanted
+    stop_job();
     right_panel->clear();
+    drop_outline_requests();
+    outlines.clear();
+    outline_mask.reset();
+    stages.clear();
+    staged_texture.unref();
 }
 
 void SpriteCutterDock::_on_cut_requested() {
@@ -95,25 +150,281 @@ void SpriteCutterDock::_on_cut_requested() {
 
     UtilityFunctions::print("SpriteCutter: texture valide → ", tex->get_width(), "×", tex->get_height());
 
-    // Slice the texture into subregions
-    Array arr = SpriteCutterAutoSlicer::slice(tex);
-    
-    // Convert to typed array of AtlasTexture references
-    Vector<Ref<AtlasTexture>> subs;
-    subs.resize(arr.size());
-    for (uint32_t i = 0; i < arr.size(); ++i) {
-        subs.set(i, arr[i]);
+    // Only one slice at a time
+    stop_job();
+    right_panel->clear();
+    drop_outline_requests();
+    outlines.clear();
+    outline_mask.reset();
+    stages.clear();
+    staged_texture.unref();
+
+    // Same file, same import: show the regions now, no pixel is read
+    LocalVector<SpriteCutterAutoSlicer::Region> cached;
+    bool dedupe = SpriteCutterAutoSlicer::get_dedupe_mode() != SpriteCutterAutoSlicer::DEDUPE_OFF;
+    hashing_only = SpriteCutterSliceCache::find_texture(tex, SpriteCutterAutoSlicer::ALPHA_THRESHOLD, cached);
+    if (hashing_only) {
+        UtilityFunctions::print("SpriteCutter: régions en cache");
+        stages.set_components(std::vector<SpriteCutterAutoSlicer::Region>(cached.ptr(), cached.ptr() + cached.size()));
+        stages.set_min_pixels(SpriteCutterAutoSlicer::get_min_pixels());
+        stages.set_merge_margin(SpriteCutterAutoSlicer::get_merge_margin());
+        staged_texture = tex;
+        spritecutter::SliceStats stats;
+        show_stages(tex, &stats);
+        SpriteCutterMonitors::record(tex->get_path(), stats);
+
+        // Outlines are traced when used, only duplicate detection needs the job
+        if (!dedupe) return;
+    }
+
+    // Slice the texture into subregions in the background
+    job_start_usec = Time::get_singleton()->get_ticks_usec();
+    job.instantiate();
+    job->set_hash_frames(dedupe);
+    job->connect("finished", Callable(this, "_on_slice_finished"));
+    if (!job->start(tex, SpriteCutterAutoSlicer::ALPHA_THRESHOLD)) {
+        UtilityFunctions::printerr("SpriteCutter: impossible de lire la texture");
+        job.unref();
+        return;
     }
 
-    UtilityFunctions::print("SpriteCutter: nombre de régions détectées = ", subs.size());
+    left_panel->set_busy(true);
+    set_process(true);
+}
+
+void SpriteCutterDock::_on_cancel_requested() {
+    if (!job.is_valid()) return;
+    UtilityFunctions::print("SpriteCutter: découpe annulée");
+    stop_job();
+}
+
+void SpriteCutterDock::_on_slice_finished() {
+    if (!job.is_valid() || !job->is_done()) return;
+
+    // Release the task and keep the results
+    Ref<SpriteCutterSliceJob> finished = job;
+    finished->wait();
+    stop_job();
+
+    if (finished->is_cancelled()) return;
+    if (!finished->has_succeeded()) {
+        UtilityFunctions::printerr("SpriteCutter: la découpe a échoué");
+        return;
+    }
+
+    uint64_t t1 = Time::get_singleton()->get_ticks_usec();
+    UtilityFunctions::print("SpriteCutter: découpe en ", double(t1 - job_start_usec) / 1000.0, " ms", finished->is_cached() ? " (cache)" : "");
+
+    // Sliders moved while it ran: its components are merged again with the new values
+    stages = finished->get_stages();
+    staged_texture = finished->get_texture();
+    stages.set_min_pixels(SpriteCutterAutoSlicer::get_min_pixels());
+    stages.set_merge_margin(SpriteCutterAutoSlicer::get_merge_margin());
+    bool retuned = stages.is_stale();
+    if (!hashing_only || retuned) {
+        spritecutter::SliceStats stats = finished->get_stats();
+        show_stages(finished->get_texture(), &stats);
+        SpriteCutterMonitors::record(finished->get_texture()->get_path(), stats);
+    }
+
+    // Outlines of any regions of this texture are traced from it
+    if (finished->get_mask()) outline_mask = finished->get_mask();
+
+    // The hashes follow the job's regions, drop them if the shown ones differ
+    if (retuned) return;
+    Ref<SpriteCutterRegionSet> shown = right_panel->get_region_set();
+    if (!shown.is_valid() || (int)finished->get_regions().size() != shown->get_count()) return;
+
+    // Duplicates of frames seen this session share their AtlasTexture
+    int mode = SpriteCutterAutoSlicer::get_dedupe_mode();
+    if (mode == SpriteCutterAutoSlicer::DEDUPE_OFF || finished->get_frame_hashes().empty()) return;
+    if (!frame_index || frame_index->get_mode() != mode) frame_index = std::make_unique<SpriteCutterFrameIndex>(mode);
+
+    Ref<Texture2D> tex = finished->get_texture();
+    String name = tex->get_path().is_empty() ? "texture:" + String::num_uint64(tex->get_instance_id()) : tex->get_path();
+    SpriteCutterFrameIndex::Report report = frame_index->add_sheet(name, finished->get_regions(), finished->get_frame_hashes(), shown);
+    UtilityFunctions::print("SpriteCutter: doublons = ", report.exact + report.near, " (", report.exact, " exacts, ", report.near, " proches), ",
+        String::num(double(report.bytes_saved) / double(1 << 20), 1), " Mio économisés");
+}
+
+void SpriteCutterDock::_on_region_settings_changed(int min_pixels, float merge_margin) {
+    ProjectSettings* settings = ProjectSettings::get_singleton();
+    settings->set_setting(SpriteCutterAutoSlicer::MIN_PIXELS_SETTING, min_pixels);
+    settings->set_setting(SpriteCutterAutoSlicer::MERGE_MARGIN_SETTING, merge_margin);
+    region_settings_dirty = true;
+    params_timer->start();
+}
+
+void SpriteCutterDock::save_region_settings() {
+    if (!region_settings_dirty) return;
+    region_settings_dirty = false;
+    if (ProjectSettings::get_singleton()->save() != OK) {
+        UtilityFunctions::printerr("SpriteCutter: impossible d'enregistrer les réglages des régions");
+    }
+}
+
+void SpriteCutterDock::_on_region_settings_timeout() {
+    if (!staged_texture.is_valid()) return;
+    stages.set_min_pixels(SpriteCutterAutoSlicer::get_min_pixels());
+    stages.set_merge_margin(SpriteCutterAutoSlicer::get_merge_margin());
+    if (!stages.is_stale()) return;
+
+    uint64_t t0 = Time::get_singleton()->get_ticks_usec();
+    spritecutter::SliceStats stats;
+    show_stages(staged_texture, &stats);
+    SpriteCutterMonitors::record(staged_texture->get_path(), stats);
+
+    uint64_t t1 = Time::get_singleton()->get_ticks_usec();
+    UtilityFunctions::print("SpriteCutter: régions recalculées en ", double(t1 - t0) / 1000.0, " ms");
+}
+
+void SpriteCutterDock::show_stages(const Ref<Texture2D>& tex, spritecutter::SliceStats* stats) {
+    const std::vector<SpriteCutterAutoSlicer::Region>& merged = stages.get_regions(stats);
+    LocalVector<SpriteCutterAutoSlicer::Region> regions;
+    regions.resize(merged.size());
+    for (size_t i = 0; i < merged.size(); ++i) regions[i] = merged[i];
+    show_regions(tex, regions, stats);
+}
+
+void SpriteCutterDock::show_regions(const Ref<Texture2D>& tex, const LocalVector<SpriteCutterAutoSlicer::Region>& regions, spritecutter::SliceStats* stats) {
+    // AtlasTextures are only created for the sprites actually used
+    spritecutter::StageTimer atlas(stats, spritecutter::STAGE_ATLAS);
+    Ref<SpriteCutterRegionSet> set = SpriteCutterRegionSet::create(tex, regions);
+    atlas.stop();
+
+    UtilityFunctions::print("SpriteCutter: nombre de régions détectées = ", set->get_count());
+
+    // Outlines follow the shown regions, they are traced again when used
+    drop_outline_requests();
+    outlines.clear();
 
     // Populate the right panel with the results
-    right_panel->populate(subs);
+    spritecutter::StageTimer populate(stats, spritecutter::STAGE_POPULATE);
+    right_panel->populate(set);
+    populate.stop();
     UtilityFunctions::print("SpriteCutter: populate() terminée");
 }
 
+void SpriteCutterDock::stop_job() {
+    if (job.is_valid()) {
+        job->disconnect("finished", Callable(this, "_on_slice_finished"));
+        job->cancel();
+        job->wait();
+        job.unref();
+    }
+
+    set_process(false);
+    left_panel->set_busy(false);
+}
+
+void SpriteCutterDock::trace_outlines() {
+    if (pending_outlines == PENDING_NONE || outline_job.is_valid()) return;
+    Ref<SpriteCutterRegionSet> set = right_panel->get_region_set();
+    if (!set.is_valid()) {
+        pending_outlines = PENDING_NONE;
+        return;
+    }
+    if ((int)outlines.size() != set->get_count()) {
+        outlines.clear();
+        outlines.resize(set->get_count());
+    }
+
+    // Only the sprites used are traced, the first time they are
+    PackedInt32Array missing;
+    for (int i = 0; i < pending_indices.size(); ++i) {
+        int index = pending_indices[i];
+        if (index >= 0 && index < set->get_count() && outlines[index].is_empty()) missing.push_back(index);
+    }
+    if (missing.is_empty()) {
+        emit_pending_outlines();
+        return;
+    }
+
+    outline_job.instantiate();
+    outline_job->connect("finished", Callable(this, "_on_outlines_finished"));
+    if (!outline_job->start(set, missing, outline_mask)) {
+        outline_job.unref();
+        emit_pending_outlines();
+    }
+}
+
+void SpriteCutterDock::_on_outlines_finished() {
+    if (!outline_job.is_valid() || !outline_job->is_done()) return;
+
+    // Release the task and keep the results
+    Ref<SpriteCutterOutlineJob> finished = outline_job;
+    finished->wait();
+    outline_job.unref();
+
+    // A job for regions no longer shown is dropped, its mask still serves the same texture
+    Ref<SpriteCutterRegionSet> set = right_panel->get_region_set();
+    if (!set.is_valid()) return;
+    if (!outline_mask && finished->get_mask() && finished->get_region_set()->get_texture() == set->get_texture())
+        outline_mask = finished->get_mask();
+    if (finished->get_region_set() != set || (int)outlines.size() != set->get_count()) {
+        trace_outlines();
+        return;
+    }
+
+    if (!finished->has_succeeded()) {
+        // Spawned without the outlines rather than not at all
+        UtilityFunctions::printerr("SpriteCutter: impossible de tracer les contours");
+        emit_pending_outlines();
+        return;
+    }
+    const LocalVector<int>& targets = finished->get_targets();
+    const LocalVector<PackedVector2Array>& traced = finished->get_outlines();
+    for (uint32_t i = 0; i < traced.size(); ++i) outlines[targets[i]] = traced[i];
+    trace_outlines();
+}
+
+void SpriteCutterDock::drop_outline_requests() {
+    pending_outlines = PENDING_NONE;
+    pending_indices.clear();
+    if (outline_job.is_valid()) outline_job->cancel();
+}
+
+void SpriteCutterDock::emit_pending_outlines() {
+    Ref<SpriteCutterRegionSet> set = right_panel->get_region_set();
+    PendingOutlines pending = pending_outlines;
+    PackedInt32Array indices = pending_indices;
+    pending_outlines = PENDING_NONE;
+    pending_indices.clear();
+    if (!set.is_valid()) return;
+
+    if (pending == PENDING_ITEM) {
+        int index = indices[0];
+        PackedVector2Array outline = index < (int)outlines.size() ? outlines[index] : PackedVector2Array();
+        emit_signal("sprite_double_clicked", set->get_atlas_texture(index), outline);
+    } else if (pending == PENDING_SPAWN) {
+        Array selected_outlines;
+        for (int i = 0; i < indices.size(); ++i) {
+            int index = indices[i];
+            selected_outlines.push_back(index < (int)outlines.size() ? outlines[index] : PackedVector2Array());
+        }
+        emit_signal("sprites_spawn_requested", set, indices, selected_outlines, pending_multimesh);
+    }
+}
+
 void SpriteCutterDock::_on_item_activated(int index) {
-    const Vector<Ref<AtlasTexture>>& subs = right_panel->get_subs();
-    if (index < 0 || index >= subs.size()) return;
-    emit_signal("sprite_double_clicked", subs[index]);
+    Ref<SpriteCutterRegionSet> set = right_panel->get_region_set();
+    if (!set.is_valid() || index < 0 || index >= set->get_count()) return;
+    pending_outlines = PENDING_ITEM;
+    pending_indices.clear();
+    pending_indices.push_back(index);
+    trace_outlines();
+}
+
+void SpriteCutterDock::_on_selection_changed() {
+    left_panel->set_spawn_count(right_panel->get_grid()->get_selected_items().size());
+}
+
+void SpriteCutterDock::_on_spawn_requested(bool as_multimesh) {
+    Ref<SpriteCutterRegionSet> set = right_panel->get_region_set();
+    PackedInt32Array indices = right_panel->get_grid()->get_selected_items();
+    if (!set.is_valid() || indices.is_empty()) return;
+    pending_outlines = PENDING_SPAWN;
+    pending_indices = indices;
+    pending_multimesh = as_multimesh;
+    trace_outlines();
 }
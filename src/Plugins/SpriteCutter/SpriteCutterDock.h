@@ -1,13 +1,20 @@
 #pragma once
 
+#include <memory>
+
 #include <godot_cpp/classes/margin_container.hpp>
 #include <godot_cpp/classes/panel_container.hpp>
 #include <godot_cpp/classes/split_container.hpp>
 #include <godot_cpp/classes/style_box_flat.hpp>
+#include <godot_cpp/classes/timer.hpp>
 
+#include "Core/RegionStages.h"
 #include "SpriteCutterLeftPanel.h"
 #include "SpriteCutterRightPanel.h"
 #include "SpriteCutterAutoSlicer.h"
+#include "SpriteCutterFrameIndex.h"
+#include "SpriteCutterOutlineJob.h"
+#include "SpriteCutterSliceJob.h"
 
 /**
  * @class SpriteCutterDock
@@ -15,11 +22,19 @@
  * 
  * This dock provides a split layout with:
  * 
- * - a left panel to load a texture and trigger the slicing process;
+ * - a left panel to load a texture and trigger the slicing process, which runs
+ * 
+ *   in the background and can be cancelled;
  * 
- * - a right panel to preview the generated AtlasTexture regions.
+ * - a right panel to preview the sliced regions.
  *
- * Emits a signal when the user double-clicks on one of the generated regions.
+ * The components of the shown texture are kept, so moving the pixel floor or merge
+ * 
+ * margin sliders only filters and merges them again, once the sliders settle.
+ *
+ * Emits a signal when the user double-clicks on one of the generated regions, and
+ * 
+ * another when the selected ones are spawned together.
  */
 class SpriteCutterDock : public godot::PanelContainer {
     GDCLASS(SpriteCutterDock, godot::PanelContainer);
@@ -77,27 +92,192 @@ class SpriteCutterDock : public godot::PanelContainer {
         /**
          * @brief Called when the user requests to cut the texture.
          * 
-         * Slices it using SpriteCutterAutoSlicer and populates the right panel.
+         * Shows the cached regions of an unchanged texture file right away,
+         * 
+         * otherwise starts a SpriteCutterSliceJob, replacing any job already running.
+         * 
+         * Cached regions only start a job to fingerprint their frames, when
+         * 
+         * duplicate detection is on. Outlines are traced when used, see trace_outlines().
+         * 
+         * The cache holds components: the cached ones are filtered and merged here.
          */
         void _on_cut_requested();
 
+        /**
+         * @brief Called when the user presses "Cancel" while a slice runs.
+         */
+        void _on_cancel_requested();
+
+        /**
+         * @brief Called on the main thread when the running job is done.
+         * 
+         * Populates the right panel with the regions, unless the cached regions
+         * 
+         * are already shown, and keeps the job's mask for trace_outlines(). If the
+         * 
+         * region settings moved while it ran, its components are merged again instead.
+         * 
+         * With SpriteCutterAutoSlicer::DEDUPE_SETTING on, also folds the frames
+         * 
+         * that duplicate ones sliced earlier this session.
+         */
+        void _on_slice_finished();
+
+        /**
+         * @brief Called when a region slider moves, (re)starts the debounce timer.
+         *
+         * Also stores the values in the in-memory project settings, which the next cut reads.
+         * They are written to project.godot by save_region_settings().
+         *
+         * @param min_pixels Pixel floor of a region.
+         * @param merge_margin Margin nearby regions merge within.
+         */
+        void _on_region_settings_changed(int min_pixels, float merge_margin);
+
+        /**
+         * @brief Called once the sliders settle: filters and merges the shown components again.
+         *
+         * Only the stages after the changed setting run, no pixel is read. Outlines
+         * are traced again when used, duplicate links are dropped until the next cut.
+         */
+        void _on_region_settings_timeout();
+
+        /**
+         * @brief Writes project.godot if a region slider moved since the last save.
+         *
+         * Called when the dock leaves the tree rather than after every drag, so the
+         * project file only changes once per session and headless batch runs then
+         * follow the dock.
+         */
+        void save_region_settings();
+
+        /**
+         * @brief Shows the regions of `stages`, running its stale stages first.
+         *
+         * @param tex The texture the components were sliced from.
+         * @param stats Optional output: merge, atlas and populate times, added to.
+         */
+        void show_stages(const godot::Ref<godot::Texture2D>& tex, spritecutter::SliceStats* stats = nullptr);
+
+        /**
+         * @brief Wraps the regions in a SpriteCutterRegionSet and populates the right panel.
+         * 
+         * @param tex The sliced texture.
+         * @param regions Its merged regions.
+         * @param stats Optional output: atlas and populate times, added to.
+         */
+        void show_regions(const godot::Ref<godot::Texture2D>& tex, const godot::LocalVector<SpriteCutterAutoSlicer::Region>& regions, spritecutter::SliceStats* stats = nullptr);
+
+        /**
+         * @brief Cancels the running job, if any, waits for it and restores the idle UI.
+         */
+        void stop_job();
+
+        /**
+         * @brief Traces the pending sprites that don't have an outline yet, then emits their signal.
+         *
+         * Starts a SpriteCutterOutlineJob from the mask of the last slice, or with none
+         * when the regions came from the cache, for the job to build it on its worker.
+         * The signal is emitted right away when every outline is known. Does nothing
+         * while a job runs, _on_outlines_finished() calls it again.
+         */
+        void trace_outlines();
+
+        /**
+         * @brief Called on the main thread when the outline job is done.
+         *
+         * Stores its outlines and keeps its mask until the texture changes. Outlines of
+         * regions no longer shown are dropped. Then serves the pending request.
+         */
+        void _on_outlines_finished();
+
+        /**
+         * @brief Forgets the pending request and cancels the outline job, without waiting for it.
+         */
+        void drop_outline_requests();
+
+        /**
+         * @brief Emits the signal of the pending request with the outlines known so far.
+         */
+        void emit_pending_outlines();
+
         /**
          * @brief Called when a region is activated (double-clicked).
          * 
-         * Emits the sprite_double_clicked signal.
+         * Emits the sprite_double_clicked signal with the sprite's outline once
+         * traced, empty if it can't be. See trace_outlines().
          * @param index Index of the clicked item.
          */
         void _on_item_activated(int index);
 
+        /**
+         * @brief Called when the grid selection changes, updates the "Spawn" button.
+         */
+        void _on_selection_changed();
+
+        /**
+         * @brief Called when the user presses "Spawn".
+         * 
+         * Emits sprites_spawn_requested with the selected regions and their outlines
+         * once traced, empty where they can't be. See trace_outlines().
+         * @param as_multimesh true to spawn them as one MultiMeshInstance3D.
+         */
+        void _on_spawn_requested(bool as_multimesh);
+
         // Container that holds left and right panels
         godot::SplitContainer* split{ nullptr };
 
         // Panel containing the texture loader and cut button
         SpriteCutterLeftPanel* left_panel{ nullptr };
 
-        // Panel displaying the generated AtlasTexture regions
+        // Panel displaying the sliced regions
         SpriteCutterRightPanel* right_panel{ nullptr };
 
+        // Slice running in the background, null when idle
+        godot::Ref<SpriteCutterSliceJob> job;
+
+        // Time the running job was started, for the log
+        uint64_t job_start_usec = 0;
+
+        // The running job only fingerprints frames, its regions came from the cache
+        bool hashing_only = false;
+
+        // Components of the shown texture and their filter and merge
+        spritecutter::RegionStages stages;
+        godot::Ref<godot::Texture2D> staged_texture;
+
+        // Coalesces slider moves, see PARAMS_DEBOUNCE
+        godot::Timer* params_timer{ nullptr };
+
+        // A slider moved since project.godot was last written
+        bool region_settings_dirty = false;
+
+        // Outline of each sprite shown, relative to its region, empty until traced
+        godot::LocalVector<godot::PackedVector2Array> outlines;
+
+        // Mask of the shown texture the outlines are traced from, null until needed
+        std::shared_ptr<const spritecutter::AlphaMask> outline_mask;
+
+        // Outlines being traced in the background, null when idle
+        godot::Ref<SpriteCutterOutlineJob> outline_job;
+
+        // Signal waiting for its outlines, a later request replaces it
+        enum PendingOutlines {
+            PENDING_NONE,
+            PENDING_ITEM,
+            PENDING_SPAWN,
+        };
+        PendingOutlines pending_outlines = PENDING_NONE;
+        godot::PackedInt32Array pending_indices;
+        bool pending_multimesh = false;
+
+        // Frames of every sheet sliced this session, created when dedupe is first on
+        std::unique_ptr<SpriteCutterFrameIndex> frame_index;
+
         // Default ratio between left and right panels (used on initial split offset)
         static constexpr float SPLIT_RATIO = 0.18f;
+
+        // Seconds the sliders must rest before the regions are merged again
+        static constexpr double PARAMS_DEBOUNCE = 0.15;
 };
@@ -0,0 +1,57 @@
+#include "SpriteCutterFrameIndex.h"
+
+SpriteCutterFrameIndex::SpriteCutterFrameIndex(int p_mode)
+    : mode(p_mode), index(p_mode == SpriteCutterAutoSlicer::DEDUPE_NEAR ? SpriteCutterAutoSlicer::NEAR_DUPLICATE_DISTANCE : 0) {
+}
+
+SpriteCutterFrameIndex::Report SpriteCutterFrameIndex::add_sheet(const godot::String& name, const godot::LocalVector<Region>& regions,
+    const std::vector<spritecutter::FrameHash>& hashes, const godot::Ref<SpriteCutterRegionSet>& set, std::vector<spritecutter::FrameRef>* originals) {
+    Report report;
+    if (originals) originals->assign(regions.size(), spritecutter::FrameRef());
+    if (hashes.size() != regions.size()) return report;
+
+    // A sheet sliced again must not match its own previous frames
+    if (!name.is_empty()) {
+        const int* previous = sheet_ids.getptr(name);
+        if (previous) {
+            int old = *previous;
+            index.remove_sheet(old);
+            sheet_names.erase(old);
+            sheet_sets.erase(old);
+        }
+    }
+
+    int sheet = index.add_sheet();
+    if (!name.is_empty()) sheet_ids[name] = sheet;
+    sheet_names[sheet] = name;
+    if (set.is_valid()) sheet_sets[sheet] = set;
+
+    for (uint32_t i = 0; i < regions.size(); ++i) {
+        spritecutter::FrameMatch match;
+        spritecutter::FrameRef original = index.find_or_add(sheet, int(i), regions[i], hashes[i], match);
+        if (match == spritecutter::FRAME_UNIQUE) continue;
+
+        if (match == spritecutter::FRAME_EXACT) ++report.exact;
+        else ++report.near;
+        report.bytes_saved += int64_t(regions[i].w) * regions[i].h * 4;
+        if (originals) (*originals)[i] = original;
+
+        // Sheets added without a set have nothing to link to
+        if (!set.is_valid()) continue;
+        const godot::Ref<SpriteCutterRegionSet>* owner = sheet_sets.getptr(original.sheet);
+        if (owner) set->set_duplicate(int(i), *owner, original.index);
+    }
+    return report;
+}
+
+godot::String SpriteCutterFrameIndex::get_sheet_name(int sheet) const {
+    const godot::String* name = sheet_names.getptr(sheet);
+    return name ? *name : godot::String();
+}
+
+void SpriteCutterFrameIndex::clear() {
+    index.clear();
+    sheet_ids.clear();
+    sheet_names.clear();
+    sheet_sets.clear();
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <godot_cpp/templates/hash_map.hpp>
+#include <godot_cpp/templates/local_vector.hpp>
+#include <godot_cpp/variant/string.hpp>
+
+#include "Core/FrameIndex.h"
+#include "SpriteCutterAutoSlicer.h"
+#include "SpriteCutterRegionSet.h"
+
+/**
+ * @class SpriteCutterFrameIndex
+ * @brief Finds the frames of a sheet that duplicate frames seen before, in it or in earlier sheets.
+ *
+ * Wraps a spritecutter::FrameIndex with the sheets' names and SpriteCutterRegionSets,
+ *
+ * so each duplicate can be linked to its original's AtlasTexture. The dock keeps one for
+ *
+ * the editor session, SpriteCutterBatch one per run.
+ *
+ * Not thread-safe: hash the frames on workers, add the sheets from one thread.
+ */
+class SpriteCutterFrameIndex {
+    public:
+        using Region = SpriteCutterAutoSlicer::Region;
+
+        /**
+         * @brief What adding a sheet folded.
+         */
+        struct Report {
+            int exact = 0;
+            int near = 0;
+
+            // Pixels of every duplicate as RGBA8, no longer stored twice
+            int64_t bytes_saved = 0;
+        };
+
+        /**
+         * @param mode SpriteCutterAutoSlicer::DEDUPE_EXACT or DEDUPE_NEAR.
+         */
+        explicit SpriteCutterFrameIndex(int mode);
+
+        int get_mode() const { return mode; }
+
+        /**
+         * @brief Adds the frames of a sheet, replacing those of its previous slice.
+         *
+         * @param name Names the sheet, usually its path. Empty for sheets never sliced again.
+         * @param regions The sheet's regions.
+         * @param hashes Their fingerprints, from SpriteCutterAutoSlicer::compute_frame_hashes().
+         * @param set The sheet's regions as shown, its duplicates get linked. May be null.
+         * @param originals Optional output: per region, the frame it duplicates, or an invalid ref.
+         * @return What was folded.
+         */
+        Report add_sheet(const godot::String& name, const godot::LocalVector<Region>& regions, const std::vector<spritecutter::FrameHash>& hashes,
+            const godot::Ref<SpriteCutterRegionSet>& set, std::vector<spritecutter::FrameRef>* originals = nullptr);
+
+        /**
+         * @brief Returns the name a sheet was added with.
+         */
+        godot::String get_sheet_name(int sheet) const;
+
+        void clear();
+
+    private:
+        int mode;
+        spritecutter::FrameIndex index;
+
+        // Current sheet id of each name, and what each id was added with
+        godot::HashMap<godot::String, int> sheet_ids;
+        godot::HashMap<int, godot::String> sheet_names;
+        godot::HashMap<int, godot::Ref<SpriteCutterRegionSet>> sheet_sets;
+};
@@ -1,12 +1,20 @@
 #include "SpriteCutterLeftPanel.h"
 
+#include "SpriteCutterAutoSlicer.h"
+
 // Register methods and signals to Godot's scripting system
 void SpriteCutterLeftPanel::_bind_methods() {
     godot::ClassDB::bind_method(godot::D_METHOD("_on_texture_picked", "res"), &SpriteCutterLeftPanel::_on_texture_picked);
     godot::ClassDB::bind_method(godot::D_METHOD("_on_cut_pressed"), &SpriteCutterLeftPanel::_on_cut_pressed);
+    godot::ClassDB::bind_method(godot::D_METHOD("_on_cancel_pressed"), &SpriteCutterLeftPanel::_on_cancel_pressed);
+    godot::ClassDB::bind_method(godot::D_METHOD("_on_region_setting_changed", "value"), &SpriteCutterLeftPanel::_on_region_setting_changed);
+    godot::ClassDB::bind_method(godot::D_METHOD("_on_spawn_pressed"), &SpriteCutterLeftPanel::_on_spawn_pressed);
 
     ADD_SIGNAL(godot::MethodInfo("texture_changed", godot::PropertyInfo(godot::Variant::OBJECT, "tex", godot::PROPERTY_HINT_RESOURCE_TYPE, "Texture2D")));
     ADD_SIGNAL(godot::MethodInfo("cut_requested"));
+    ADD_SIGNAL(godot::MethodInfo("cancel_requested"));
+    ADD_SIGNAL(godot::MethodInfo("region_settings_changed", godot::PropertyInfo(godot::Variant::INT, "min_pixels"), godot::PropertyInfo(godot::Variant::FLOAT, "merge_margin")));
+    ADD_SIGNAL(godot::MethodInfo("spawn_requested", godot::PropertyInfo(godot::Variant::BOOL, "as_multimesh")));
 }
 
 SpriteCutterLeftPanel::SpriteCutterLeftPanel() {
@@ -25,11 +33,89 @@ SpriteCutterLeftPanel::SpriteCutterLeftPanel() {
     texture_rect->set_v_size_flags(Control::SIZE_EXPAND_FILL);
     add_child(texture_rect);
 
+    // Region sliders, starting from the project settings
+    min_pixels_label = memnew(godot::Label);
+    add_child(min_pixels_label);
+    min_pixels_slider = memnew(godot::HSlider);
+    min_pixels_slider->set_min(1.0);
+    min_pixels_slider->set_max(MAX_MIN_PIXELS);
+    min_pixels_slider->set_step(1.0);
+    min_pixels_slider->set_exp_ratio(true);
+    min_pixels_slider->set_value(SpriteCutterAutoSlicer::get_min_pixels());
+    min_pixels_slider->connect("value_changed", godot::Callable(this, "_on_region_setting_changed"));
+    add_child(min_pixels_slider);
+
+    merge_margin_label = memnew(godot::Label);
+    add_child(merge_margin_label);
+    merge_margin_slider = memnew(godot::HSlider);
+    merge_margin_slider->set_min(0.0);
+    merge_margin_slider->set_max(MAX_MERGE_MARGIN);
+    merge_margin_slider->set_step(0.5);
+    merge_margin_slider->set_value(SpriteCutterAutoSlicer::get_merge_margin());
+    merge_margin_slider->connect("value_changed", godot::Callable(this, "_on_region_setting_changed"));
+    add_child(merge_margin_slider);
+    update_setting_labels();
+
     // "Cut" button
     cut_button = memnew(godot::Button);
     cut_button->set_text("Cut Sprite");
     cut_button->connect("pressed", godot::Callable(this, "_on_cut_pressed"));
     add_child(cut_button);
+
+    // Progress bar, hidden until a slice starts
+    progress_bar = memnew(godot::ProgressBar);
+    progress_bar->set_min(0.0);
+    progress_bar->set_max(100.0);
+    progress_bar->set_h_size_flags(Control::SIZE_EXPAND_FILL);
+    progress_bar->set_visible(false);
+    add_child(progress_bar);
+
+    // "Cancel" button, hidden until a slice starts
+    cancel_button = memnew(godot::Button);
+    cancel_button->set_text("Cancel");
+    cancel_button->connect("pressed", godot::Callable(this, "_on_cancel_pressed"));
+    cancel_button->set_visible(false);
+    add_child(cancel_button);
+
+    // "Spawn" button, enabled once sprites are selected in the results
+    spawn_button = memnew(godot::Button);
+    spawn_button->connect("pressed", godot::Callable(this, "_on_spawn_pressed"));
+    add_child(spawn_button);
+    set_spawn_count(0);
+
+    multimesh_check = memnew(godot::CheckBox);
+    multimesh_check->set_text("As MultiMesh");
+    multimesh_check->set_tooltip_text("One MultiMeshInstance3D drawing every sprite in a single draw call");
+    add_child(multimesh_check);
+}
+
+void SpriteCutterLeftPanel::set_spawn_count(int count) {
+    spawn_button->set_text(count > 1 ? "Spawn " + godot::String::num_int64(count) + " Sprites" : godot::String("Spawn Sprite"));
+    spawn_button->set_disabled(count <= 0);
+}
+
+void SpriteCutterLeftPanel::set_busy(bool busy) {
+    cut_button->set_visible(!busy);
+    progress_bar->set_visible(busy);
+    cancel_button->set_visible(busy);
+    progress_bar->set_value(0.0);
+}
+
+void SpriteCutterLeftPanel::set_progress(float ratio) {
+    progress_bar->set_value(ratio * 100.0);
+}
+
+int SpriteCutterLeftPanel::get_min_pixels() const {
+    return int(min_pixels_slider->get_value());
+}
+
+float SpriteCutterLeftPanel::get_merge_margin() const {
+    return float(merge_margin_slider->get_value());
+}
+
+void SpriteCutterLeftPanel::update_setting_labels() {
+    min_pixels_label->set_text("Min pixels: " + godot::String::num_int64(get_min_pixels()));
+    merge_margin_label->set_text("Merge margin: " + godot::String::num(get_merge_margin(), 1));
 }
 
 void SpriteCutterLeftPanel::_on_texture_picked(const godot::Ref<godot::Resource>& res) {
@@ -42,3 +128,16 @@ void SpriteCutterLeftPanel::_on_texture_picked(const godot::Ref<godot::Resource>
 void SpriteCutterLeftPanel::_on_cut_pressed() {
     emit_signal("cut_requested");
 }
+
+void SpriteCutterLeftPanel::_on_cancel_pressed() {
+    emit_signal("cancel_requested");
+}
+
+void SpriteCutterLeftPanel::_on_region_setting_changed(double) {
+    update_setting_labels();
+    emit_signal("region_settings_changed", get_min_pixels(), get_merge_margin());
+}
+
+void SpriteCutterLeftPanel::_on_spawn_pressed() {
+    emit_signal("spawn_requested", multimesh_check->is_pressed());
+}
@@ -1,7 +1,11 @@
 #pragma once
 
 #include <godot_cpp/classes/button.hpp>
+#include <godot_cpp/classes/check_box.hpp>
 #include <godot_cpp/classes/editor_resource_picker.hpp>
+#include <godot_cpp/classes/h_slider.hpp>
+#include <godot_cpp/classes/label.hpp>
+#include <godot_cpp/classes/progress_bar.hpp>
 #include <godot_cpp/classes/texture_rect.hpp>
 #include <godot_cpp/classes/v_box_container.hpp>
 
@@ -15,11 +19,29 @@
 * 
 * the slicing process.
 *
-* It emits two signals:
+* While a slice runs in the background, a progress bar and a "Cancel" button
+* 
+* replace the "Cut Sprite" button.
+*
+* Two sliders tune the pixel floor and merge margin of the regions, which only
+* 
+* filter and merge the components again, so they are followed while dragged.
+*
+* Below, "Spawn" adds every sprite selected in the results to the scene, as separate
+* 
+* nodes or, with "As MultiMesh" checked, as one MultiMeshInstance3D.
+*
+* It emits five signals:
 * 
 * - `texture_changed` when a new texture is selected.
 * 
 * - `cut_requested` when the "Cut Sprite" button is pressed.
+* 
+* - `cancel_requested` when the "Cancel" button is pressed.
+* 
+* - `region_settings_changed` when either slider moves.
+* 
+* - `spawn_requested` when the "Spawn" button is pressed.
 */
 class SpriteCutterLeftPanel : public godot::VBoxContainer
 {
@@ -39,6 +61,28 @@ class SpriteCutterLeftPanel : public godot::VBoxContainer
          */
         godot::Ref<godot::Texture2D> get_texture() const { return texture; }
 
+        /**
+         * @brief Switches between the idle layout and the slicing-in-progress layout.
+         *
+         * @param busy true while a slice is running.
+         */
+        void set_busy(bool busy);
+
+        /**
+         * @brief Updates the progress bar.
+         *
+         * @param ratio Progress in [0, 1].
+         */
+        void set_progress(float ratio);
+
+        /**
+         * @brief Updates the "Spawn" button for the number of selected sprites. Disabled at 0.
+         */
+        void set_spawn_count(int count);
+
+        int get_min_pixels() const;
+        float get_merge_margin() const;
+
     protected:
         static void _bind_methods();
 
@@ -59,6 +103,34 @@ class SpriteCutterLeftPanel : public godot::VBoxContainer
          */
         void _on_cut_pressed();
 
+        /**
+         * @brief Called when the user presses the "Cancel" button.
+         *
+         * Emits the `cancel_requested` signal.
+         */
+        void _on_cancel_pressed();
+
+        /**
+         * @brief Called when the user presses the "Spawn" button.
+         *
+         * Emits `spawn_requested` with the "As MultiMesh" choice.
+         */
+        void _on_spawn_pressed();
+
+        /**
+         * @brief Called when either slider moves.
+         *
+         * Updates the slider captions and emits `region_settings_changed`.
+         *
+         * @param value Unused, both values are read back from the sliders.
+         */
+        void _on_region_setting_changed(double value);
+
+        /**
+         * @brief Writes the slider values into their captions.
+         */
+        void update_setting_labels();
+
         // Picker for selecting a Texture2D resource
         godot::EditorResourcePicker* picker = nullptr;
 
@@ -68,6 +140,28 @@ class SpriteCutterLeftPanel : public godot::VBoxContainer
         // Button that triggers the cut action
         godot::Button* cut_button = nullptr;
 
+        // Shows the progress of a running slice
+        godot::ProgressBar* progress_bar = nullptr;
+
+        // Button that cancels a running slice
+        godot::Button* cancel_button = nullptr;
+
+        // Pixel floor of a region, with its caption
+        godot::Label* min_pixels_label = nullptr;
+        godot::HSlider* min_pixels_slider = nullptr;
+
+        // Margin nearby regions merge within, with its caption
+        godot::Label* merge_margin_label = nullptr;
+        godot::HSlider* merge_margin_slider = nullptr;
+
+        // Adds the selected sprites to the scene, and how
+        godot::Button* spawn_button = nullptr;
+        godot::CheckBox* multimesh_check = nullptr;
+
         // The currently selected texture
         godot::Ref<godot::Texture2D> texture;
+
+        // Slider ranges, the project settings accept anything past them
+        static constexpr double MAX_MIN_PIXELS = 4096.0;
+        static constexpr double MAX_MERGE_MARGIN = 64.0;
 };
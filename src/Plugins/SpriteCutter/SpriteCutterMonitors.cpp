@@ -0,0 +1,159 @@
+#include "SpriteCutterMonitors.h"
+
+#include <deque>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include <godot_cpp/classes/file_access.hpp>
+#include <godot_cpp/classes/json.hpp>
+#include <godot_cpp/classes/performance.hpp>
+#include <godot_cpp/classes/time.hpp>
+#include <godot_cpp/variant/array.hpp>
+#include <godot_cpp/variant/callable_method_pointer.hpp>
+#include <godot_cpp/variant/dictionary.hpp>
+#include <godot_cpp/variant/utility_functions.hpp>
+
+namespace {
+    // Stage monitors come first, indexed by spritecutter::SliceStage
+    enum Monitor {
+        MONITOR_TOTAL = spritecutter::STAGE_COUNT,
+        MONITOR_PIXELS,
+        MONITOR_COMPONENTS,
+        MONITOR_MERGES,
+        MONITOR_SCRATCH,
+        MONITOR_COUNT,
+    };
+
+    godot::String monitor_id(int id) {
+        godot::String name;
+        switch (id) {
+            case MONITOR_TOTAL: name = "total_ms"; break;
+            case MONITOR_PIXELS: name = "pixels_scanned"; break;
+            case MONITOR_COMPONENTS: name = "components"; break;
+            case MONITOR_MERGES: name = "merges"; break;
+            case MONITOR_SCRATCH: name = "peak_scratch_mb"; break;
+            default: name = godot::String(spritecutter::stage_name(spritecutter::SliceStage(id))) + "_ms"; break;
+        }
+        return "SpriteCutter/" + name;
+    }
+
+    // Standard containers: these statics outlive the godot-cpp bindings.
+    // record() runs on any thread, `guard` covers everything below it.
+    std::mutex guard;
+    spritecutter::SliceStats last;
+
+    // Compact JSON of each logged run, oldest first
+    std::deque<std::string> log_entries;
+
+    // Runs recorded since the log file was last written
+    bool log_dirty = false;
+
+    void write_log(const std::deque<std::string>& entries) {
+        godot::Ref<godot::FileAccess> f = godot::FileAccess::open(SpriteCutterMonitors::LOG_PATH, godot::FileAccess::WRITE);
+        if (!f.is_valid()) {
+            godot::UtilityFunctions::printerr("SpriteCutterMonitors: can't write ", SpriteCutterMonitors::LOG_PATH);
+            return;
+        }
+
+        // One run per line, so the log diffs and greps well
+        std::string text = "[\n";
+        for (size_t i = 0; i < entries.size(); ++i) {
+            text += "\t" + entries[i] + (i + 1 < entries.size() ? ",\n" : "\n");
+        }
+        text += "]\n";
+        f->store_string(godot::String::utf8(text.c_str()));
+    }
+}
+
+void SpriteCutterMonitors::add_monitors() {
+    godot::Performance* performance = godot::Performance::get_singleton();
+    for (int id = 0; id < MONITOR_COUNT; ++id) {
+        godot::String name = monitor_id(id);
+        if (performance->has_custom_monitor(name)) continue;
+
+        godot::Array args;
+        args.push_back(id);
+        performance->add_custom_monitor(name, callable_mp_static(&SpriteCutterMonitors::get_monitor), args);
+    }
+
+    // Runs of earlier sessions, the log keeps rolling from them
+    std::deque<std::string> earlier;
+    if (godot::FileAccess::file_exists(LOG_PATH)) {
+        godot::Variant parsed = godot::JSON::parse_string(godot::FileAccess::get_file_as_string(LOG_PATH));
+        if (parsed.get_type() == godot::Variant::ARRAY) {
+            godot::Array runs = parsed;
+            for (int i = godot::MAX(0, (int)runs.size() - LOG_MAX_RUNS); i < runs.size(); ++i) {
+                earlier.push_back(godot::JSON::stringify(runs[i], "", false).utf8().get_data());
+            }
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(guard);
+    log_entries.swap(earlier);
+    log_dirty = false;
+}
+
+void SpriteCutterMonitors::remove_monitors() {
+    godot::Performance* performance = godot::Performance::get_singleton();
+    for (int id = 0; id < MONITOR_COUNT; ++id) {
+        godot::String name = monitor_id(id);
+        if (performance->has_custom_monitor(name)) performance->remove_custom_monitor(name);
+    }
+    flush_log();
+}
+
+void SpriteCutterMonitors::flush_log() {
+    std::deque<std::string> entries;
+    {
+        std::lock_guard<std::mutex> lock(guard);
+        if (!log_dirty) return;
+        log_dirty = false;
+        entries = log_entries;
+    }
+    write_log(entries);
+}
+
+void SpriteCutterMonitors::record(const godot::String& source, const spritecutter::SliceStats& stats) {
+    godot::Dictionary stages;
+    for (int s = 0; s < spritecutter::STAGE_COUNT; ++s) {
+        stages[spritecutter::stage_name(spritecutter::SliceStage(s))] = double(stats.stage_usec[s]) / 1000.0;
+    }
+
+    godot::Dictionary run;
+    run["time"] = godot::Time::get_singleton()->get_datetime_string_from_system();
+    run["source"] = source;
+    run["stages_ms"] = stages;
+    run["total_ms"] = double(stats.total_usec()) / 1000.0;
+    run["pixels_scanned"] = int64_t(stats.pixels_scanned);
+    run["components"] = stats.components;
+    run["merges"] = stats.merges;
+    run["peak_scratch_bytes"] = int64_t(stats.peak_scratch_bytes);
+
+    std::string entry = godot::JSON::stringify(run, "", false).utf8().get_data();
+
+    // Kept in memory, the file is written once by flush_log()
+    std::lock_guard<std::mutex> lock(guard);
+    last = stats;
+    log_entries.push_back(std::move(entry));
+    while ((int)log_entries.size() > LOG_MAX_RUNS) log_entries.pop_front();
+    log_dirty = true;
+}
+
+spritecutter::SliceStats SpriteCutterMonitors::get_last() {
+    std::lock_guard<std::mutex> lock(guard);
+    return last;
+}
+
+double SpriteCutterMonitors::get_monitor(int id) {
+    spritecutter::SliceStats run = get_last();
+    if (id >= 0 && id < spritecutter::STAGE_COUNT) return double(run.stage_usec[id]) / 1000.0;
+    switch (id) {
+        case MONITOR_TOTAL: return double(run.total_usec()) / 1000.0;
+        case MONITOR_PIXELS: return double(run.pixels_scanned);
+        case MONITOR_COMPONENTS: return double(run.components);
+        case MONITOR_MERGES: return double(run.merges);
+        case MONITOR_SCRATCH: return double(run.peak_scratch_bytes) / double(1 << 20);
+        default: return 0.0;
+    }
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <godot_cpp/variant/string.hpp>
+
+#include "Core/SliceStats.h"
+
+/**
+ * @class SpriteCutterMonitors
+ * @brief Shows what the last slice cost in the editor's Monitors tab, and logs every run.
+ *
+ * Each stage of spritecutter::SliceStats (fetch, decompress, label, merge, atlas, populate)
+ *
+ * gets a `SpriteCutter/` custom monitor in milliseconds, next to the pixels scanned,
+ *
+ * the components found, the merges performed and the peak scratch memory.
+ *
+ * Every recorded run is also added to a rolling JSON log under `res://.godot/`,
+ *
+ * keeping the last LOG_MAX_RUNS runs across editor sessions. The log is written
+ * once, when the plugin exits, never per run.
+ *
+ * Static and thread-safe: workers fill a SliceStats, the owner records it once the run is over.
+ */
+class SpriteCutterMonitors {
+    public:
+        /**
+         * @brief Registers the custom monitors and reloads the log. Called by SpriteCutterPlugin.
+         */
+        static void add_monitors();
+
+        /**
+         * @brief Unregisters the custom monitors and flushes the log.
+         */
+        static void remove_monitors();
+
+        /**
+         * @brief Publishes a finished run to the monitors and appends it to the log in memory.
+         *
+         * Cheap enough for every slider move: nothing is written to disk. Callable from any thread.
+         *
+         * @param source Path of the sliced texture, or any label for the run.
+         * @param stats What the run cost.
+         */
+        static void record(const godot::String& source, const spritecutter::SliceStats& stats);
+
+        /**
+         * @brief Writes the log file if a run was recorded since the last write.
+         */
+        static void flush_log();
+
+        /**
+         * @brief Returns a copy of the last recorded run, empty before the first one.
+         */
+        static spritecutter::SliceStats get_last();
+
+        // Rolling log of the recorded runs, oldest first
+        static constexpr const char* LOG_PATH = "res://.godot/spritecutter_slices.json";
+        static constexpr int LOG_MAX_RUNS = 100;
+
+    private:
+        /**
+         * @brief Value of one monitor for the last run, called by Performance.
+         */
+        static double get_monitor(int id);
+};
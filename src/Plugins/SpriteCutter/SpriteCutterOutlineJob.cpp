@@ -0,0 +1,71 @@
+#include "SpriteCutterOutlineJob.h"
+
+#include <godot_cpp/classes/worker_thread_pool.hpp>
+#include <godot_cpp/variant/callable_method_pointer.hpp>
+
+void SpriteCutterOutlineJob::_bind_methods() {
+    ADD_SIGNAL(godot::MethodInfo("finished"));
+}
+
+SpriteCutterOutlineJob::~SpriteCutterOutlineJob() {
+    // Never free the state a running task still points to
+    cancel();
+    wait();
+}
+
+bool SpriteCutterOutlineJob::start(const godot::Ref<SpriteCutterRegionSet>& p_set, const godot::PackedInt32Array& indices, const std::shared_ptr<const spritecutter::AlphaMask>& p_mask) {
+    if (task_id >= 0 || !p_set.is_valid()) return false;
+
+    set = p_set;
+    texture = p_set->get_texture();
+    mask = p_mask;
+    for (int i = 0; i < indices.size(); ++i) {
+        int index = indices[i];
+        if (index < 0 || index >= set->get_count()) continue;
+        godot::Rect2i rect = set->get_region(index);
+        regions.push_back({ rect.position.x, rect.position.y, rect.size.x, rect.size.y, 0 });
+        targets.push_back(index);
+    }
+    if (regions.is_empty()) return false;
+
+    // Only the chunk headers are read here, the worker decodes the rest
+    if (!mask) SpriteCutterAutoSlicer::open_source_file(texture, source_file);
+
+    task_id = godot::WorkerThreadPool::get_singleton()->add_task(
+        callable_mp(this, &SpriteCutterOutlineJob::_run), false, "SpriteCutter: outlines");
+    return true;
+}
+
+void SpriteCutterOutlineJob::wait() {
+    if (task_id < 0) return;
+    godot::WorkerThreadPool::get_singleton()->wait_for_task_completion(task_id);
+    task_id = -1;
+}
+
+void SpriteCutterOutlineJob::_run() {
+    // Cached regions read no pixel: the mask is built here, once per texture
+    if (!mask) {
+        std::shared_ptr<spritecutter::AlphaMask> built = std::make_shared<spritecutter::AlphaMask>();
+        bool ok;
+        if (source_file.get_data()) {
+            ok = SpriteCutterAutoSlicer::build_png_mask(source_file.get_data(), source_file.get_size(), SpriteCutterAutoSlicer::ALPHA_THRESHOLD, *built, &progress);
+            source_file.close();
+        } else {
+            godot::Ref<godot::Image> image = SpriteCutterAutoSlicer::fetch_image(texture);
+            ok = SpriteCutterAutoSlicer::build_image_mask(image, SpriteCutterAutoSlicer::ALPHA_THRESHOLD, *built);
+        }
+        if (ok) mask = built;
+    }
+
+    if (mask && !progress.is_cancelled()) {
+        succeeded = SpriteCutterAutoSlicer::compute_outlines(*mask, regions, outlines, &progress);
+    }
+    done.store(true);
+
+    // Hand the result back to the main thread. Skipped if the job is freed first.
+    callable_mp(this, &SpriteCutterOutlineJob::_notify_finished).call_deferred();
+}
+
+void SpriteCutterOutlineJob::_notify_finished() {
+    emit_signal("finished");
+}
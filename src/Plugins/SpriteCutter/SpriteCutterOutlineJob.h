@@ -0,0 +1,118 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+#include <godot_cpp/classes/ref_counted.hpp>
+#include <godot_cpp/templates/local_vector.hpp>
+#include <godot_cpp/variant/packed_int32_array.hpp>
+#include <godot_cpp/variant/packed_vector2_array.hpp>
+
+#include "SpriteCutterAutoSlicer.h"
+#include "SpriteCutterRegionSet.h"
+
+/**
+ * @class SpriteCutterOutlineJob
+ * @brief Runs SpriteCutterAutoSlicer::compute_outlines on a WorkerThreadPool task.
+ *
+ * Traces the sprites of a region set from the mask of its texture. Without one, as
+ * when the regions came from the cache, the mask is built on the worker first: the
+ * source PNG is mapped in start() and decoded there, other textures are read back
+ * there, like the grid preview does. The `finished` signal is emitted on the main
+ * thread through a deferred call, where the owner stores get_outlines().
+ *
+ * The owner must keep a reference to the job and call wait() before dropping it.
+ */
+class SpriteCutterOutlineJob : public godot::RefCounted {
+    GDCLASS(SpriteCutterOutlineJob, godot::RefCounted);
+
+    public:
+        SpriteCutterOutlineJob() = default;
+        ~SpriteCutterOutlineJob() override;
+
+        /**
+         * @brief Reads the regions to trace and queues the tracing task.
+         *
+         * Main thread only.
+         *
+         * @param p_set The region set the sprites belong to.
+         * @param indices Indices of the sprites to trace, out of range ones are skipped.
+         * @param p_mask Mask of the set's texture, or null to build it on the worker.
+         * @return false if a task is already queued or there is nothing to trace.
+         */
+        bool start(const godot::Ref<SpriteCutterRegionSet>& p_set, const godot::PackedInt32Array& indices, const std::shared_ptr<const spritecutter::AlphaMask>& p_mask);
+
+        /**
+         * @brief Asks the task to stop at its next check. Returns immediately.
+         */
+        void cancel() { progress.cancel(); }
+
+        /**
+         * @brief Blocks until the task has returned and releases it from the pool.
+         */
+        void wait();
+
+        bool is_cancelled() const { return progress.is_cancelled(); }
+        bool is_done() const { return done.load(); }
+        bool has_succeeded() const { return succeeded; }
+
+        /**
+         * @brief Returns the region set being traced.
+         */
+        godot::Ref<SpriteCutterRegionSet> get_region_set() const { return set; }
+
+        /**
+         * @brief Returns the index in the set of each outline. Set by start().
+         */
+        const godot::LocalVector<int>& get_targets() const { return targets; }
+
+        /**
+         * @brief Returns one outline per target, relative to its region. Only valid once is_done() is true.
+         */
+        const godot::LocalVector<godot::PackedVector2Array>& get_outlines() const { return outlines; }
+
+        /**
+         * @brief Returns the mask the outlines were traced from. Only valid once is_done() is true.
+         *
+         * The one given to start(), or the one built by the task, null if that failed.
+         */
+        std::shared_ptr<const spritecutter::AlphaMask> get_mask() const { return mask; }
+
+    protected:
+        static void _bind_methods();
+
+    private:
+        /**
+         * @brief Task body, runs on a worker thread.
+         */
+        void _run();
+
+        /**
+         * @brief Emits `finished`. Deferred to the main thread by _run().
+         */
+        void _notify_finished();
+
+        // Set and texture being traced, only released on the main thread
+        godot::Ref<SpriteCutterRegionSet> set;
+        godot::Ref<godot::Texture2D> texture;
+
+        // Mapped source file, when the mask has to be built from it
+        spritecutter::MappedFile source_file;
+
+        // Regions to trace and their index in the set
+        godot::LocalVector<SpriteCutterAutoSlicer::Region> regions;
+        godot::LocalVector<int> targets;
+
+        // Only its cancellation is used, the outlines show no progress
+        spritecutter::SliceProgress progress;
+
+        std::shared_ptr<const spritecutter::AlphaMask> mask;
+        godot::LocalVector<godot::PackedVector2Array> outlines;
+
+        // Set by the worker once outlines are final
+        std::atomic<bool> done{ false };
+        bool succeeded = false;
+
+        // WorkerThreadPool task id, -1 when no task is pending
+        int64_t task_id = -1;
+};
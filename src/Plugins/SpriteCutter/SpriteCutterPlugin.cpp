@@ -1,10 +1,20 @@
 #include "SpriteCutterPlugin.h"
 
+#include <godot_cpp/classes/editor_selection.hpp>
+#include <godot_cpp/classes/mesh_instance3d.hpp>
+#include <godot_cpp/classes/multi_mesh_instance3d.hpp>
+#include <godot_cpp/classes/project_settings.hpp>
+
+#include "SpriteCutterMonitors.h"
+#include "SpriteCutterSliceCache.h"
+
 // Register methods to Godot's scripting system (so they can be called or connected via the editor)
 void SpriteCutterPlugin::_bind_methods() {
     godot::ClassDB::bind_method(godot::D_METHOD("initialized_plugin"), &SpriteCutterPlugin::initialized_plugin);
     godot::ClassDB::bind_method(godot::D_METHOD("uninitialized_plugin"), &SpriteCutterPlugin::uninitialized_plugin);
-    godot::ClassDB::bind_method(godot::D_METHOD("_on_sprite_double_clicked", "atlas"), &SpriteCutterPlugin::_on_sprite_double_clicked);
+    godot::ClassDB::bind_method(godot::D_METHOD("_on_sprite_double_clicked", "atlas", "outline"), &SpriteCutterPlugin::_on_sprite_double_clicked);
+    godot::ClassDB::bind_method(godot::D_METHOD("_on_sprites_spawn_requested", "set", "indices", "outlines", "as_multimesh"), &SpriteCutterPlugin::_on_sprites_spawn_requested);
+    godot::ClassDB::bind_method(godot::D_METHOD("_on_resources_reimported", "paths"), &SpriteCutterPlugin::_on_resources_reimported);
 }
 
 void SpriteCutterPlugin::initialized_plugin() {
@@ -17,6 +27,58 @@ void SpriteCutterPlugin::initialized_plugin() {
 
     // Connect the dock signal to the handler method in this plugin
     dock->connect("sprite_double_clicked", godot::Callable(this, "_on_sprite_double_clicked"));
+    dock->connect("sprites_spawn_requested", godot::Callable(this, "_on_sprites_spawn_requested"));
+
+    // Memory a slice may hold, image included, editable under Project Settings > SpriteCutter
+    godot::ProjectSettings* settings = godot::ProjectSettings::get_singleton();
+    if (!settings->has_setting(SpriteCutterAutoSlicer::MEMORY_BUDGET_SETTING))
+        settings->set_setting(SpriteCutterAutoSlicer::MEMORY_BUDGET_SETTING, SpriteCutterAutoSlicer::DEFAULT_MEMORY_BUDGET_MB);
+    settings->set_initial_value(SpriteCutterAutoSlicer::MEMORY_BUDGET_SETTING, SpriteCutterAutoSlicer::DEFAULT_MEMORY_BUDGET_MB);
+    godot::Dictionary budget_info;
+    budget_info["name"] = SpriteCutterAutoSlicer::MEMORY_BUDGET_SETTING;
+    budget_info["type"] = godot::Variant::INT;
+    budget_info["hint"] = godot::PROPERTY_HINT_RANGE;
+    budget_info["hint_string"] = "16,65536,1,or_greater,suffix:MB";
+    settings->add_property_info(budget_info);
+
+    // Region floor and merge margin, also tuned live from the dock sliders
+    if (!settings->has_setting(SpriteCutterAutoSlicer::MIN_PIXELS_SETTING))
+        settings->set_setting(SpriteCutterAutoSlicer::MIN_PIXELS_SETTING, SpriteCutterAutoSlicer::MIN_PIXELS);
+    settings->set_initial_value(SpriteCutterAutoSlicer::MIN_PIXELS_SETTING, SpriteCutterAutoSlicer::MIN_PIXELS);
+    godot::Dictionary min_pixels_info;
+    min_pixels_info["name"] = SpriteCutterAutoSlicer::MIN_PIXELS_SETTING;
+    min_pixels_info["type"] = godot::Variant::INT;
+    min_pixels_info["hint"] = godot::PROPERTY_HINT_RANGE;
+    min_pixels_info["hint_string"] = "1,4096,1,or_greater,suffix:px";
+    settings->add_property_info(min_pixels_info);
+
+    if (!settings->has_setting(SpriteCutterAutoSlicer::MERGE_MARGIN_SETTING))
+        settings->set_setting(SpriteCutterAutoSlicer::MERGE_MARGIN_SETTING, SpriteCutterAutoSlicer::MERGE_MARGIN);
+    settings->set_initial_value(SpriteCutterAutoSlicer::MERGE_MARGIN_SETTING, SpriteCutterAutoSlicer::MERGE_MARGIN);
+    godot::Dictionary margin_info;
+    margin_info["name"] = SpriteCutterAutoSlicer::MERGE_MARGIN_SETTING;
+    margin_info["type"] = godot::Variant::FLOAT;
+    margin_info["hint"] = godot::PROPERTY_HINT_RANGE;
+    margin_info["hint_string"] = "0,64,0.5,or_greater,suffix:px";
+    settings->add_property_info(margin_info);
+
+    // Duplicate frame folding across the sheets sliced this session
+    if (!settings->has_setting(SpriteCutterAutoSlicer::DEDUPE_SETTING))
+        settings->set_setting(SpriteCutterAutoSlicer::DEDUPE_SETTING, SpriteCutterAutoSlicer::DEDUPE_OFF);
+    settings->set_initial_value(SpriteCutterAutoSlicer::DEDUPE_SETTING, SpriteCutterAutoSlicer::DEDUPE_OFF);
+    godot::Dictionary dedupe_info;
+    dedupe_info["name"] = SpriteCutterAutoSlicer::DEDUPE_SETTING;
+    dedupe_info["type"] = godot::Variant::INT;
+    dedupe_info["hint"] = godot::PROPERTY_HINT_ENUM;
+    dedupe_info["hint_string"] = "Off,Exact,Near";
+    settings->add_property_info(dedupe_info);
+
+    // Region tables persist under .godot/, stale ones are dropped on reimport
+    SpriteCutterSliceCache::open();
+    get_editor_interface()->get_resource_filesystem()->connect("resources_reimported", godot::Callable(this, "_on_resources_reimported"));
+
+    // Stage costs of the last slice, under SpriteCutter in the Monitors tab
+    SpriteCutterMonitors::add_monitors();
 
     godot::UtilityFunctions::print("SpriteCutterPlugin initialized");
 }
@@ -26,6 +88,10 @@ void SpriteCutterPlugin::uninitialized_plugin() {
 
     // Disconnect the signal (safety before removal)
     dock->disconnect("sprite_double_clicked", godot::Callable(this, "_on_sprite_double_clicked"));
+    dock->disconnect("sprites_spawn_requested", godot::Callable(this, "_on_sprites_spawn_requested"));
+    get_editor_interface()->get_resource_filesystem()->disconnect("resources_reimported", godot::Callable(this, "_on_resources_reimported"));
+    SpriteCutterSliceCache::close();
+    SpriteCutterMonitors::remove_monitors();
     
     // Remove the dock from the UI if it's still active
     if (dock->is_inside_tree())
@@ -37,35 +103,121 @@ void SpriteCutterPlugin::uninitialized_plugin() {
     godot::UtilityFunctions::print("SpriteCutterPlugin uninitialized");
 }
 
-void SpriteCutterPlugin::_on_sprite_double_clicked(const godot::Ref<godot::AtlasTexture>& atlas) {
+void SpriteCutterPlugin::_on_sprite_double_clicked(const godot::Ref<godot::AtlasTexture>& atlas, const godot::PackedVector2Array& outline) {
     // Ignore invalid input
     if (!atlas.is_valid()) {
         return;
     }
 
-    // Get the root node of the currently edited scene
-    godot::Node* edited = get_editor_interface()->get_edited_scene_root();
-    godot::Node3D* root3d = godot::Object::cast_to<godot::Node3D>(edited);
-    if (!root3d) {
+    godot::Node3D* parent = get_spawn_parent();
+    if (!parent) {
         return;
     }
 
-    // Create a new Sprite3D node and assign the texture
-    godot::Sprite3D* sprite = memnew(godot::Sprite3D);
-    sprite->set_texture(atlas);
+    // A mesh cut to the outline draws far fewer transparent pixels than the full quad
+    godot::Node3D* sprite = create_sprite_node(atlas, outline);
 
     // Set up the undo/redo action for adding the sprite
     godot::EditorUndoRedoManager* ur = get_undo_redo();
-    ur->create_action("Add Sprite3D");
+    ur->create_action(godot::Object::cast_to<godot::MeshInstance3D>(sprite) ? "Add Trimmed Sprite" : "Add Sprite3D");
+    add_spawn_steps(ur, parent, sprite);
 
+    // Apply the action to the editor
+    ur->commit_action();
+}
+
+void SpriteCutterPlugin::_on_sprites_spawn_requested(const godot::Ref<SpriteCutterRegionSet>& set, const godot::PackedInt32Array& indices, const godot::Array& outlines, bool as_multimesh) {
+    if (!set.is_valid() || indices.is_empty()) {
+        return;
+    }
+
+    godot::Node3D* parent = get_spawn_parent();
+    if (!parent) {
+        return;
+    }
+
+    // Rectangles of the selected regions, in selection order
+    godot::PackedInt32Array rects;
+    for (int i = 0; i < indices.size(); ++i) {
+        godot::Rect2i r = set->get_region(indices[i]);
+        rects.push_back(r.position.x);
+        rects.push_back(r.position.y);
+        rects.push_back(r.size.x);
+        rects.push_back(r.size.y);
+    }
+    godot::PackedVector3Array positions = SpriteCutterAutoSlicer::layout_sprites(rects);
+
+    // Everything in one action, undone in one step
+    godot::EditorUndoRedoManager* ur = get_undo_redo();
+    if (as_multimesh) {
+        godot::Ref<godot::MultiMesh> multimesh = SpriteCutterAutoSlicer::build_sprite_multimesh(set->get_texture(), rects, positions);
+        if (!multimesh.is_valid()) {
+            return;
+        }
+
+        godot::MultiMeshInstance3D* instance = memnew(godot::MultiMeshInstance3D);
+        instance->set_name("Sprites");
+        instance->set_multimesh(multimesh);
+        ur->create_action("Add Sprite MultiMesh");
+        add_spawn_steps(ur, parent, instance);
+    } else {
+        ur->create_action("Add " + godot::String::num_int64(indices.size()) + " Sprites");
+        for (int i = 0; i < indices.size(); ++i) {
+            godot::PackedVector2Array outline = i < outlines.size() ? godot::PackedVector2Array(outlines[i]) : godot::PackedVector2Array();
+            godot::Node3D* sprite = create_sprite_node(set->get_atlas_texture(indices[i]), outline);
+            sprite->set_position(positions[i]);
+            add_spawn_steps(ur, parent, sprite);
+        }
+    }
+    ur->commit_action();
+}
+
+godot::Node3D* SpriteCutterPlugin::get_spawn_parent() {
+    // The first selected Node3D of the edited scene, then its root
+    godot::Node* edited = get_editor_interface()->get_edited_scene_root();
+    if (!edited) {
+        return nullptr;
+    }
+
+    godot::TypedArray<godot::Node> selected = get_editor_interface()->get_selection()->get_selected_nodes();
+    for (int i = 0; i < selected.size(); ++i) {
+        godot::Node3D* node = godot::Object::cast_to<godot::Node3D>(selected[i]);
+        if (node && (node == edited || edited->is_ancestor_of(node))) {
+            return node;
+        }
+    }
+
+    godot::Node3D* root3d = godot::Object::cast_to<godot::Node3D>(edited);
+    if (!root3d) {
+        godot::UtilityFunctions::printerr("SpriteCutterPlugin: select a Node3D to add the sprites under");
+    }
+    return root3d;
+}
+
+godot::Node3D* SpriteCutterPlugin::create_sprite_node(const godot::Ref<godot::AtlasTexture>& atlas, const godot::PackedVector2Array& outline) const {
+    godot::Ref<godot::ArrayMesh> mesh = SpriteCutterAutoSlicer::build_trimmed_mesh(atlas, outline);
+    if (mesh.is_valid()) {
+        godot::MeshInstance3D* instance = memnew(godot::MeshInstance3D);
+        instance->set_mesh(mesh);
+        return instance;
+    }
+
+    // Create a new Sprite3D node and assign the texture
+    godot::Sprite3D* sprite3d = memnew(godot::Sprite3D);
+    sprite3d->set_texture(atlas);
+    return sprite3d;
+}
+
+void SpriteCutterPlugin::add_spawn_steps(godot::EditorUndoRedoManager* ur, godot::Node3D* parent, godot::Node3D* node) {
     // Define what happens when the action is done
-    ur->add_do_method(root3d, "add_child", sprite);
-    ur->add_do_method(sprite, "set_owner", root3d);
+    ur->add_do_method(parent, "add_child", node, true);
+    ur->add_do_method(node, "set_owner", get_editor_interface()->get_edited_scene_root());
+    ur->add_do_reference(node);
 
     // Define what happens when the action is undone
-    ur->add_undo_method(root3d, "remove_child", sprite);
-    ur->add_undo_method(sprite, "set_owner", nullptr);
+    ur->add_undo_method(parent, "remove_child", node);
+}
 
-    // Apply the action to the editor
-    ur->commit_action();
+void SpriteCutterPlugin::_on_resources_reimported(const godot::PackedStringArray& paths) {
+    SpriteCutterSliceCache::invalidate(paths);
 }
@@ -2,8 +2,10 @@
 
 #include <godot_cpp/classes/atlas_texture.hpp>
 #include <godot_cpp/classes/editor_plugin.hpp>
+#include <godot_cpp/classes/editor_file_system.hpp>
 #include <godot_cpp/classes/editor_interface.hpp>
 #include <godot_cpp/classes/editor_undo_redo_manager.hpp>
+#include <godot_cpp/classes/node3d.hpp>
 #include <godot_cpp/classes/sprite3d.hpp>
 
 #include "SpriteCutterDock.h"
@@ -14,9 +16,27 @@
  *
  * This plugin creates a custom bottom dock ("Sprite Cutter") which allows the user to inspect atlas textures.
  * 
- * When a texture is double-clicked, a Sprite3D node is instantiated and added to the edited 3D scene.
+ * When a texture is double-clicked, a mesh trimmed to the sprite's outline (or a Sprite3D when it has
+ * 
+ * none) is instantiated and added to the edited 3D scene.
+ *
+ * The sprites selected in the dock can also be spawned together, laid out on a grid,
+ * 
+ * in one undo action: as one node each, or as a single MultiMeshInstance3D drawing
+ * 
+ * them all in one draw call.
+ *
+ * New sprites go under the first Node3D selected in the scene tree, or under the
+ * 
+ * scene root when it is a Node3D.
  *
  * This plugin uses the Godot undo/redo system to properly register node creation in the editor.
+ *
+ * It also opens the SpriteCutterSliceCache, keeps it in sync with reimports, registers
+ *
+ * the `spritecutter/slicing/memory_budget_mb` and `spritecutter/slicing/dedupe` project
+ *
+ * settings, and adds the SpriteCutterMonitors to the Monitors tab.
  */
 class SpriteCutterPlugin : public godot::EditorPlugin
 {
@@ -45,11 +65,51 @@ class SpriteCutterPlugin : public godot::EditorPlugin
         /**
          * Handles the double-click signal from the SpriteCutterDock.
          * 
-         * Creates and adds a Sprite3D node with the selected texture.
+         * Adds a MeshInstance3D trimmed to the sprite's outline, so the transparent
+         * 
+         * pixels around it aren't drawn, or a Sprite3D when there is no outline.
          *
-         * @param atlas A reference to the AtlasTexture used for the new Sprite3D.
+         * @param atlas A reference to the AtlasTexture of the sprite.
+         * @param outline Its outline relative to the region, may be empty.
+         */
+        void _on_sprite_double_clicked(const godot::Ref<godot::AtlasTexture>& atlas, const godot::PackedVector2Array& outline);
+
+        /**
+         * Handles the "Spawn" request from the SpriteCutterDock.
+         *
+         * Adds every sprite in one undo action, each as _on_sprite_double_clicked() would,
+         * 
+         * or as one MultiMeshInstance3D built by SpriteCutterAutoSlicer::build_sprite_multimesh().
+         *
+         * @param set The regions shown in the dock.
+         * @param indices The selected regions.
+         * @param outlines One outline per selected region, may be empty.
+         * @param as_multimesh true for a single MultiMeshInstance3D.
+         */
+        void _on_sprites_spawn_requested(const godot::Ref<SpriteCutterRegionSet>& set, const godot::PackedInt32Array& indices, const godot::Array& outlines, bool as_multimesh);
+
+        /**
+         * Drops the cached regions of reimported textures.
+         *
+         * @param paths Resource paths reported by EditorFileSystem.
+         */
+        void _on_resources_reimported(const godot::PackedStringArray& paths);
+
+    private:
+        /**
+         * Returns the node new sprites are added under, null if there is none.
+         */
+        godot::Node3D* get_spawn_parent();
+
+        /**
+         * Creates the node of one sprite: a trimmed MeshInstance3D, or a Sprite3D without outline.
+         */
+        godot::Node3D* create_sprite_node(const godot::Ref<godot::AtlasTexture>& atlas, const godot::PackedVector2Array& outline) const;
+
+        /**
+         * Registers the do and undo steps adding `node` under `parent` in the current action.
          */
-        void _on_sprite_double_clicked(const godot::Ref<godot::AtlasTexture>& atlas);
+        void add_spawn_steps(godot::EditorUndoRedoManager* ur, godot::Node3D* parent, godot::Node3D* node);
 
         // Pointer to the plugin's custom dock UI.
         SpriteCutterDock* dock{ nullptr };
@@ -0,0 +1,134 @@
+#include "SpriteCutterRegionSet.h"
+
+void SpriteCutterRegionSet::_bind_methods() {
+    godot::ClassDB::bind_method(godot::D_METHOD("set_texture", "texture"), &SpriteCutterRegionSet::set_texture);
+    godot::ClassDB::bind_method(godot::D_METHOD("get_texture"), &SpriteCutterRegionSet::get_texture);
+    godot::ClassDB::bind_method(godot::D_METHOD("set_rects", "rects"), &SpriteCutterRegionSet::set_rects);
+    godot::ClassDB::bind_method(godot::D_METHOD("get_rects"), &SpriteCutterRegionSet::get_rects);
+    godot::ClassDB::bind_method(godot::D_METHOD("get_count"), &SpriteCutterRegionSet::get_count);
+    godot::ClassDB::bind_method(godot::D_METHOD("get_region", "index"), &SpriteCutterRegionSet::get_region);
+    godot::ClassDB::bind_method(godot::D_METHOD("get_atlas_texture", "index"), &SpriteCutterRegionSet::get_atlas_texture);
+    godot::ClassDB::bind_method(godot::D_METHOD("is_duplicate", "index"), &SpriteCutterRegionSet::is_duplicate);
+    godot::ClassDB::bind_method(godot::D_METHOD("set_duplicate_sets", "sets"), &SpriteCutterRegionSet::set_duplicate_sets);
+    godot::ClassDB::bind_method(godot::D_METHOD("get_duplicate_sets"), &SpriteCutterRegionSet::get_duplicate_sets);
+    godot::ClassDB::bind_method(godot::D_METHOD("set_duplicates", "duplicates"), &SpriteCutterRegionSet::set_duplicates);
+    godot::ClassDB::bind_method(godot::D_METHOD("get_duplicates"), &SpriteCutterRegionSet::get_duplicates);
+
+    ADD_PROPERTY(godot::PropertyInfo(godot::Variant::OBJECT, "texture", godot::PROPERTY_HINT_RESOURCE_TYPE, "Texture2D"), "set_texture", "get_texture");
+    ADD_PROPERTY(godot::PropertyInfo(godot::Variant::PACKED_INT32_ARRAY, "rects"), "set_rects", "get_rects");
+    ADD_PROPERTY(godot::PropertyInfo(godot::Variant::ARRAY, "duplicate_sets", godot::PROPERTY_HINT_ARRAY_TYPE, "SpriteCutterRegionSet"), "set_duplicate_sets", "get_duplicate_sets");
+    ADD_PROPERTY(godot::PropertyInfo(godot::Variant::PACKED_INT32_ARRAY, "duplicates"), "set_duplicates", "get_duplicates");
+}
+
+godot::Ref<SpriteCutterRegionSet> SpriteCutterRegionSet::create(const godot::Ref<godot::Texture2D>& texture, const godot::LocalVector<spritecutter::Region>& regions) {
+    godot::PackedInt32Array packed;
+    packed.resize(regions.size() * 4);
+    int32_t* out = packed.ptrw();
+    for (uint32_t i = 0; i < regions.size(); ++i) {
+        const spritecutter::Region& r = regions[i];
+        out[i * 4 + 0] = r.x;
+        out[i * 4 + 1] = r.y;
+        out[i * 4 + 2] = r.w;
+        out[i * 4 + 3] = r.h;
+    }
+
+    godot::Ref<SpriteCutterRegionSet> set;
+    set.instantiate();
+    set->texture = texture;
+    set->rects = packed;
+    return set;
+}
+
+void SpriteCutterRegionSet::set_texture(const godot::Ref<godot::Texture2D>& p_texture) {
+    texture = p_texture;
+    atlas_textures.clear();
+    emit_changed();
+}
+
+void SpriteCutterRegionSet::set_rects(const godot::PackedInt32Array& p_rects) {
+    rects = p_rects;
+    atlas_textures.clear();
+    emit_changed();
+}
+
+void SpriteCutterRegionSet::set_duplicate_sets(const godot::Array& p_sets) {
+    duplicate_sets = p_sets;
+    atlas_textures.clear();
+    emit_changed();
+}
+
+void SpriteCutterRegionSet::set_duplicates(const godot::PackedInt32Array& p_duplicates) {
+    duplicates = p_duplicates;
+    atlas_textures.clear();
+    emit_changed();
+}
+
+void SpriteCutterRegionSet::set_duplicate(int index, const godot::Ref<SpriteCutterRegionSet>& owner, int owner_index) {
+    if (index < 0 || index >= get_count() || !owner.is_valid()) return;
+
+    if (duplicates.size() != int64_t(get_count()) * 2) {
+        duplicates.resize(int64_t(get_count()) * 2);
+        duplicates.fill(-1);
+    }
+
+    // Slot 0 is this set, so it never holds a reference to itself
+    int slot = 0;
+    if (owner.ptr() != this) {
+        slot = -1;
+        for (int i = 0; i < duplicate_sets.size() && slot < 0; ++i) {
+            if (godot::Ref<SpriteCutterRegionSet>(duplicate_sets[i]) == owner) slot = i + 1;
+        }
+        if (slot < 0) {
+            duplicate_sets.push_back(owner);
+            slot = (int)duplicate_sets.size();
+        }
+    }
+
+    duplicates.set(int64_t(index) * 2, slot);
+    duplicates.set(int64_t(index) * 2 + 1, owner_index);
+    atlas_textures.erase(index);
+}
+
+bool SpriteCutterRegionSet::is_duplicate(int index) const {
+    if (index < 0 || int64_t(index) * 2 + 1 >= duplicates.size()) return false;
+    return duplicates[int64_t(index) * 2] >= 0;
+}
+
+godot::Rect2i SpriteCutterRegionSet::get_region(int index) const {
+    if (index < 0 || index >= get_count()) return godot::Rect2i();
+    const int32_t* r = rects.ptr() + size_t(index) * 4;
+    return godot::Rect2i(r[0], r[1], r[2], r[3]);
+}
+
+godot::Ref<godot::AtlasTexture> SpriteCutterRegionSet::get_atlas_texture(int index) const {
+    if (index < 0 || index >= get_count()) return godot::Ref<godot::AtlasTexture>();
+
+    godot::Ref<godot::AtlasTexture>* cached = atlas_textures.getptr(index);
+    if (cached) return *cached;
+
+    // Duplicates hand out their original's texture, never a copy
+    if (is_duplicate(index)) {
+        int slot = duplicates[int64_t(index) * 2], original = duplicates[int64_t(index) * 2 + 1];
+        godot::Ref<godot::AtlasTexture> at;
+        if (slot == 0) {
+            // An original is never a duplicate itself, following one could loop
+            if (original != index && !is_duplicate(original)) at = get_atlas_texture(original);
+        } else if (slot <= duplicate_sets.size()) {
+            godot::Ref<SpriteCutterRegionSet> owner = duplicate_sets[slot - 1];
+            if (owner.is_valid()) at = owner->get_atlas_texture(original);
+        }
+        if (at.is_valid()) {
+            atlas_textures.insert(index, at);
+            return at;
+        }
+    }
+
+    // Same settings as SpriteCutterAutoSlicer::build_atlas_textures()
+    godot::Ref<godot::AtlasTexture> at;
+    at.instantiate();
+    at->set_atlas(texture);
+    at->set_region(godot::Rect2(get_region(index)));
+    at->set_filter_clip(true);
+    atlas_textures.insert(index, at);
+    return at;
+}
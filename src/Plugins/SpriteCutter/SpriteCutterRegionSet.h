@@ -0,0 +1,100 @@
+#pragma once
+
+#include <godot_cpp/classes/atlas_texture.hpp>
+#include <godot_cpp/classes/resource.hpp>
+#include <godot_cpp/classes/texture2d.hpp>
+#include <godot_cpp/templates/hash_map.hpp>
+#include <godot_cpp/templates/local_vector.hpp>
+#include <godot_cpp/variant/array.hpp>
+#include <godot_cpp/variant/packed_int32_array.hpp>
+
+#include "Core/SliceTypes.h"
+
+/**
+ * @class SpriteCutterRegionSet
+ * @brief The sprites of one sheet: its texture and the rectangle of every region.
+ *
+ * The rectangles live in a single PackedInt32Array, 4 ints per region (x, y, w, h),
+ *
+ * so a sheet of 10,000 frames saves to a `.res` as one blob instead of 10,000 sub-resources.
+ *
+ * AtlasTextures are only created when get_atlas_texture() asks for one, then reused
+ *
+ * until the texture or the rectangles change.
+ *
+ * Duplicate frames, found by SpriteCutterFrameIndex, are linked to the frame they copy,
+ *
+ * in this set or in the set of an earlier sheet, and share its AtlasTexture.
+ */
+class SpriteCutterRegionSet : public godot::Resource {
+    GDCLASS(SpriteCutterRegionSet, godot::Resource);
+
+    public:
+        SpriteCutterRegionSet() = default;
+        ~SpriteCutterRegionSet() override = default;
+
+        /**
+         * @brief Creates a set from detected regions, their pixel counts are not kept.
+         *
+         * @param texture The sheet the regions were detected in.
+         * @param regions The merged regions.
+         */
+        static godot::Ref<SpriteCutterRegionSet> create(const godot::Ref<godot::Texture2D>& texture, const godot::LocalVector<spritecutter::Region>& regions);
+
+        void set_texture(const godot::Ref<godot::Texture2D>& p_texture);
+        godot::Ref<godot::Texture2D> get_texture() const { return texture; }
+
+        /**
+         * @brief Replaces the rectangles, 4 ints per region. A trailing partial one is ignored.
+         */
+        void set_rects(const godot::PackedInt32Array& p_rects);
+        godot::PackedInt32Array get_rects() const { return rects; }
+
+        int get_count() const { return int(rects.size() / 4); }
+
+        /**
+         * @brief Returns the rectangle of a region, empty if the index is out of range.
+         */
+        godot::Rect2i get_region(int index) const;
+
+        /**
+         * @brief Returns the AtlasTexture of a region, created on first use. Main thread only.
+         *
+         * A duplicate returns the AtlasTexture of the frame it copies.
+         *
+         * @return The texture, or an invalid reference if the index is out of range.
+         */
+        godot::Ref<godot::AtlasTexture> get_atlas_texture(int index) const;
+
+        /**
+         * @brief Links a region to the frame it duplicates.
+         *
+         * @param index The duplicate.
+         * @param owner Set holding the original, this one or an earlier sheet's.
+         * @param owner_index Index of the original in `owner`, itself never a duplicate.
+         */
+        void set_duplicate(int index, const godot::Ref<SpriteCutterRegionSet>& owner, int owner_index);
+
+        bool is_duplicate(int index) const;
+
+        // Storage of the links: other sets holding originals, then 2 ints per region,
+        // the set (-1 none, 0 this one, k the k-th other set) and the original's index
+        void set_duplicate_sets(const godot::Array& p_sets);
+        godot::Array get_duplicate_sets() const { return duplicate_sets; }
+        void set_duplicates(const godot::PackedInt32Array& p_duplicates);
+        godot::PackedInt32Array get_duplicates() const { return duplicates; }
+
+    protected:
+        static void _bind_methods();
+
+    private:
+        godot::Ref<godot::Texture2D> texture;
+        godot::PackedInt32Array rects;
+
+        // Empty until a duplicate is linked
+        godot::Array duplicate_sets;
+        godot::PackedInt32Array duplicates;
+
+        // AtlasTextures handed out so far, by region index
+        mutable godot::HashMap<int, godot::Ref<godot::AtlasTexture>> atlas_textures;
+};
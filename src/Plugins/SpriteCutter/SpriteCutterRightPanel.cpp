@@ -6,24 +6,11 @@ void SpriteCutterRightPanel::_bind_methods() {
 }
 
 SpriteCutterRightPanel::SpriteCutterRightPanel() {
-    // Create the scroll container
-    scroll = memnew(godot::ScrollContainer);
-    scroll->set_h_size_flags(Control::SIZE_EXPAND_FILL);
-    scroll->set_v_size_flags(Control::SIZE_EXPAND_FILL);
-    scroll->set_clip_contents(true);
-    scroll->set_horizontal_scroll_mode(godot::ScrollContainer::ScrollMode::SCROLL_MODE_AUTO);
-    scroll->set_vertical_scroll_mode(godot::ScrollContainer::ScrollMode::SCROLL_MODE_DISABLED);
-    add_child(scroll);
-
-    // Create the ItemList that will hold the AtlasTextures
-    list = memnew(godot::ItemList);
-    list->set_h_size_flags(Control::SIZE_EXPAND_FILL);
-    list->set_v_size_flags(Control::SIZE_EXPAND_FILL);
-    list->set_clip_contents(true);
-    list->set_icon_mode(godot::ItemList::IconMode::ICON_MODE_TOP);
-    list->set_select_mode(godot::ItemList::SelectMode::SELECT_SINGLE);
-    list->set_wraparound_items(false);
-    scroll->add_child(list);
+    // Create the grid that will show the sprites, it scrolls on its own
+    grid = memnew(SpriteCutterSpriteGrid);
+    grid->set_h_size_flags(Control::SIZE_EXPAND_FILL);
+    grid->set_v_size_flags(Control::SIZE_EXPAND_FILL);
+    add_child(grid);
 
     // Compute and apply icon size
     adjust_icon_size();
@@ -36,39 +23,34 @@ void SpriteCutterRightPanel::_notification(int p_what) {
 }
 
 void SpriteCutterRightPanel::adjust_icon_size() {
-    int avail_h = scroll->get_size().y;
+    int avail_h = get_size().y;
     int icon_h = avail_h - TEXT_HEIGHT - PADDING - BORDER_EXTRA;
 
-    // Enforce a minimum icon size
+    // Enforce a minimum and a maximum icon size
     if (icon_h < 16)
         icon_h = 16;
-    
-    list->set_fixed_icon_size(godot::Vector2(icon_h, icon_h));
+    if (icon_h > MAX_ICON_SIZE)
+        icon_h = MAX_ICON_SIZE;
+
+    grid->set_thumbnail_size(icon_h);
 }
 
 void SpriteCutterRightPanel::clear() {
-    list->clear();
-    subs_storage.clear();
+    grid->clear();
+    region_set.unref();
 }
 
-void SpriteCutterRightPanel::populate(const godot::Vector<godot::Ref<godot::AtlasTexture>>& subs) {
+void SpriteCutterRightPanel::populate(const godot::Ref<SpriteCutterRegionSet>& set) {
     // Always start from an empty state
     clear();
 
-    subs_storage = subs;
-    
-    if (subs_storage.is_empty())
+    if (!set.is_valid() || set->get_count() == 0)
         return;
-    
-    // Show all textures in a single row (no wrapping)
-    list->set_max_columns(subs_storage.size());
+    region_set = set;
 
     // Adjust icon size before adding
     adjust_icon_size();
 
-    // Add each AtlasTexture to the list with its index as label
-    for (int i = 0; i < subs_storage.size(); ++i) {
-        godot::String txt = godot::String::num_int64(i + 1);
-        list->add_item(txt, subs_storage[i]);
-    }
+    // Cells are drawn on demand, nothing is created per region
+    grid->set_items(region_set);
 }
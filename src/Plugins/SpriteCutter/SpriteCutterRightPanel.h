@@ -1,19 +1,21 @@
 #pragma once
 
-#include <godot_cpp/classes/atlas_texture.hpp>
-#include <godot_cpp/classes/item_list.hpp>
 #include <godot_cpp/classes/panel_container.hpp>
-#include <godot_cpp/classes/scroll_container.hpp>
+
+#include "SpriteCutterRegionSet.h"
+#include "SpriteCutterSpriteGrid.h"
 
 /**
  * @class SpriteCutterRightPanel
- * @brief Displays a scrollable list of AtlasTexture previews.
+ * @brief Displays a scrollable grid of sprite previews.
  *
  * This panel is used to show the result of slicing a Texture2D.
  * 
- * Each AtlasTexture is represented as an icon in a grid.
+ * Each region of a SpriteCutterRegionSet is represented as a thumbnail in a SpriteCutterSpriteGrid,
+ * 
+ * which only draws the cells in view.
  * 
- * The panel handles resizing and icon scaling automatically.
+ * The panel handles resizing and thumbnail scaling automatically.
  */
 class SpriteCutterRightPanel : public godot::PanelContainer
 {
@@ -27,34 +29,34 @@ class SpriteCutterRightPanel : public godot::PanelContainer
         ~SpriteCutterRightPanel() override = default;
 
         /**
-         * @brief Clears the UI list and internal storage of sliced regions.
+         * @brief Clears the UI grid and internal storage of sliced regions.
          */
         void clear();
 
         /**
-         * @brief Populates the list with the given sliced textures.
-         * @param subs A vector of AtlasTexture references to display.
+         * @brief Populates the grid with the given sliced regions.
+         * @param set The texture and regions to display.
          */
-        void populate(const godot::Vector<godot::Ref<godot::AtlasTexture>>& subs);
+        void populate(const godot::Ref<SpriteCutterRegionSet>& set);
 
         /**
-         * @brief Returns the stored list of sliced AtlasTextures.
-         * @return A constant reference to the vector of textures.
+         * @brief Returns the regions shown, invalid when the panel is empty.
+         * @return A reference to the region set.
          */
-        const godot::Vector<godot::Ref<godot::AtlasTexture>>& get_subs() const { return subs_storage; }
+        godot::Ref<SpriteCutterRegionSet> get_region_set() const { return region_set; }
 
         /**
-         * @brief Returns the ItemList UI node.
-         * @return A pointer to the ItemList instance.
+         * @brief Returns the grid UI node, which emits `item_activated`.
+         * @return A pointer to the SpriteCutterSpriteGrid instance.
          */
-        godot::ItemList* get_list() const { return list; }
+        SpriteCutterSpriteGrid* get_grid() const { return grid; }
 
     protected:
         static void _bind_methods();
 
     private:
         /**
-         * @brief Recalculates and sets the icon size in the list based on panel height.
+         * @brief Recalculates and sets the thumbnail size of the grid based on panel height.
          */
         void adjust_icon_size();
 
@@ -64,14 +66,11 @@ class SpriteCutterRightPanel : public godot::PanelContainer
          */
         void _notification(int p_what);
 
-        // Scrollable container that holds the ItemList
-        godot::ScrollContainer* scroll = nullptr;
+        // Displays the sliced textures as thumbnails
+        SpriteCutterSpriteGrid* grid = nullptr;
 
-        // Displays the sliced textures as icons
-        godot::ItemList* list = nullptr;
-
-        // Internal storage of current textures
-        godot::Vector<godot::Ref<godot::AtlasTexture>> subs_storage;
+        // Regions currently shown, AtlasTextures are created from it on demand
+        godot::Ref<SpriteCutterRegionSet> region_set;
 
         // Height reserved for the text below each icon
         static constexpr int TEXT_HEIGHT = 20;
@@ -81,4 +80,7 @@ class SpriteCutterRightPanel : public godot::PanelContainer
 
         // Extra space reserved for scroll bars and borders
         static constexpr int BORDER_EXTRA = 30;
+
+        // Thumbnails never get bigger than this, more rows fit instead
+        static constexpr int MAX_ICON_SIZE = 128;
 };
@@ -0,0 +1,149 @@
+#include "SpriteCutterRuntimeSlicer.h"
+
+#include <optional>
+
+#include <godot_cpp/classes/os.hpp>
+#include <godot_cpp/classes/worker_thread_pool.hpp>
+#include <godot_cpp/variant/callable_method_pointer.hpp>
+#include <godot_cpp/variant/utility_functions.hpp>
+
+#include "SpriteCutterTaskGroup.h"
+
+void SpriteCutterRuntimeSlicer::_bind_methods() {
+    godot::ClassDB::bind_method(godot::D_METHOD("set_alpha_threshold", "threshold"), &SpriteCutterRuntimeSlicer::set_alpha_threshold);
+    godot::ClassDB::bind_method(godot::D_METHOD("get_alpha_threshold"), &SpriteCutterRuntimeSlicer::get_alpha_threshold);
+    godot::ClassDB::bind_method(godot::D_METHOD("set_min_pixels", "min_pixels"), &SpriteCutterRuntimeSlicer::set_min_pixels);
+    godot::ClassDB::bind_method(godot::D_METHOD("get_min_pixels"), &SpriteCutterRuntimeSlicer::get_min_pixels);
+    godot::ClassDB::bind_method(godot::D_METHOD("set_merge_margin", "margin"), &SpriteCutterRuntimeSlicer::set_merge_margin);
+    godot::ClassDB::bind_method(godot::D_METHOD("get_merge_margin"), &SpriteCutterRuntimeSlicer::get_merge_margin);
+    godot::ClassDB::bind_method(godot::D_METHOD("set_parallel", "parallel"), &SpriteCutterRuntimeSlicer::set_parallel);
+    godot::ClassDB::bind_method(godot::D_METHOD("is_parallel"), &SpriteCutterRuntimeSlicer::is_parallel);
+    godot::ClassDB::bind_method(godot::D_METHOD("slice_image", "image"), &SpriteCutterRuntimeSlicer::slice_image);
+    godot::ClassDB::bind_method(godot::D_METHOD("slice_bytes", "data", "width", "height"), &SpriteCutterRuntimeSlicer::slice_bytes);
+    godot::ClassDB::bind_method(godot::D_METHOD("slice_async", "image", "callback"), &SpriteCutterRuntimeSlicer::slice_async);
+    godot::ClassDB::bind_method(godot::D_METHOD("wait_async"), &SpriteCutterRuntimeSlicer::wait_async);
+
+    ADD_PROPERTY(godot::PropertyInfo(godot::Variant::INT, "alpha_threshold", godot::PROPERTY_HINT_RANGE, "0,255"), "set_alpha_threshold", "get_alpha_threshold");
+    ADD_PROPERTY(godot::PropertyInfo(godot::Variant::INT, "min_pixels", godot::PROPERTY_HINT_RANGE, "1,4096,1,or_greater"), "set_min_pixels", "get_min_pixels");
+    ADD_PROPERTY(godot::PropertyInfo(godot::Variant::FLOAT, "merge_margin", godot::PROPERTY_HINT_RANGE, "0,64,0.5,or_greater"), "set_merge_margin", "get_merge_margin");
+    ADD_PROPERTY(godot::PropertyInfo(godot::Variant::BOOL, "parallel"), "set_parallel", "is_parallel");
+
+    BIND_CONSTANT(REGION_STRIDE);
+}
+
+SpriteCutterRuntimeSlicer::~SpriteCutterRuntimeSlicer() {
+    // Tasks point to this object
+    wait_async();
+}
+
+godot::PackedInt32Array SpriteCutterRuntimeSlicer::slice_image(const godot::Ref<godot::Image>& image) {
+    return slice_with(image, parallel);
+}
+
+godot::PackedInt32Array SpriteCutterRuntimeSlicer::slice_bytes(const godot::PackedByteArray& data, int width, int height) {
+    spritecutter::PixelView view = spritecutter::PixelView::packed(data.ptr(), width, height, spritecutter::FORMAT_RGBA8);
+    if (width <= 0 || height <= 0 || size_t(data.size()) < view.row_pitch * size_t(height)) {
+        godot::UtilityFunctions::printerr("SpriteCutterRuntimeSlicer: expected ", width, "×", height, " RGBA8 pixels, got ", data.size(), " bytes");
+        return godot::PackedInt32Array();
+    }
+
+    std::unique_lock<std::mutex> lock(scratch_mutex, std::try_to_lock);
+    std::optional<Scratch> local;
+    Scratch& s = lock.owns_lock() ? scratch : local.emplace();
+    if (!s.mask.build(view, uint8_t(int(alpha_threshold)))) return godot::PackedInt32Array();
+    return label_and_pack(parallel, s);
+}
+
+int64_t SpriteCutterRuntimeSlicer::slice_async(const godot::Ref<godot::Image>& image, const godot::Callable& callback) {
+    godot::WorkerThreadPool* pool = godot::WorkerThreadPool::get_singleton();
+    if (!pool) return -1;
+    _release_finished_tasks();
+
+    std::lock_guard<std::mutex> lock(tasks_mutex);
+    int64_t id = pool->add_task(callable_mp(this, &SpriteCutterRuntimeSlicer::_run_async).bind(image, callback), false, "SpriteCutter: runtime slice");
+    tasks.push_back(id);
+    return id;
+}
+
+void SpriteCutterRuntimeSlicer::wait_async() {
+    std::vector<int64_t> pending;
+    {
+        std::lock_guard<std::mutex> lock(tasks_mutex);
+        pending.swap(tasks);
+    }
+    godot::WorkerThreadPool* pool = godot::WorkerThreadPool::get_singleton();
+    for (int64_t id : pending) pool->wait_for_task_completion(id);
+}
+
+bool SpriteCutterRuntimeSlicer::build_image_mask(const godot::Image* image, uint8_t threshold, bool use_pool, Scratch& s) const {
+    if (!image->is_compressed()) return SpriteCutterAutoSlicer::build_mask(image, threshold, s.mask);
+
+    // Blocks with a known alpha layout are read as they are, others are decoded on a copy
+    if (SpriteCutterAutoSlicer::build_compressed_mask(image, threshold, s.mask, use_pool)) return true;
+    godot::Ref<godot::Image> copy = image->duplicate();
+    if (!copy.is_valid() || copy->decompress() != godot::OK) {
+        godot::UtilityFunctions::printerr("SpriteCutterRuntimeSlicer: can't decompress image");
+        return false;
+    }
+    return SpriteCutterAutoSlicer::build_mask(copy.ptr(), threshold, s.mask);
+}
+
+godot::PackedInt32Array SpriteCutterRuntimeSlicer::label_and_pack(bool use_pool, Scratch& s) const {
+    spritecutter::LabelOptions options;
+    options.min_pixels = min_pixels;
+    options.threads = use_pool ? godot::MAX(1, (int)godot::OS::get_singleton()->get_processor_count()) : 1;
+
+    spritecutter::ParallelFor pool = [](int count, const spritecutter::TaskFn& task) {
+        SpriteCutterTaskGroup::run(count, task, "SpriteCutter: label tiles");
+    };
+    s.regions.clear();
+    spritecutter::label_regions(s.mask, options, s.regions, s.labelling, use_pool ? pool : spritecutter::ParallelFor(spritecutter::serial_for));
+    s.regions.resize(spritecutter::merge_regions(s.regions.data(), s.regions.size(), merge_margin, s.merging));
+
+    // The only allocation of a serial call once the buffers have grown to the sheet size
+    godot::PackedInt32Array packed;
+    packed.resize(int64_t(s.regions.size()) * REGION_STRIDE);
+    int32_t* out = packed.ptrw();
+    for (const Region& r : s.regions) {
+        *out++ = r.x;
+        *out++ = r.y;
+        *out++ = r.w;
+        *out++ = r.h;
+        *out++ = r.count;
+    }
+    return packed;
+}
+
+godot::PackedInt32Array SpriteCutterRuntimeSlicer::slice_with(const godot::Ref<godot::Image>& image, bool use_pool) {
+    if (!image.is_valid() || image->is_empty()) return godot::PackedInt32Array();
+
+    // A concurrent call gets buffers of its own rather than waiting, built only then
+    std::unique_lock<std::mutex> lock(scratch_mutex, std::try_to_lock);
+    std::optional<Scratch> local;
+    Scratch& s = lock.owns_lock() ? scratch : local.emplace();
+    if (!build_image_mask(image.ptr(), uint8_t(int(alpha_threshold)), use_pool, s)) return godot::PackedInt32Array();
+    return label_and_pack(use_pool, s);
+}
+
+void SpriteCutterRuntimeSlicer::_run_async(const godot::Ref<godot::Image>& image, const godot::Callable& callback) {
+    // Already on a pool thread: label here rather than nest a group task
+    godot::PackedInt32Array packed = slice_with(image, false);
+    callback.call_deferred(packed);
+    callable_mp(this, &SpriteCutterRuntimeSlicer::_release_finished_tasks).call_deferred();
+}
+
+void SpriteCutterRuntimeSlicer::_release_finished_tasks() {
+    godot::WorkerThreadPool* pool = godot::WorkerThreadPool::get_singleton();
+    std::lock_guard<std::mutex> lock(tasks_mutex);
+
+    // A task still returning is released by a later call or by wait_async()
+    for (size_t i = 0; i < tasks.size();) {
+        if (pool->is_task_completed(tasks[i])) {
+            pool->wait_for_task_completion(tasks[i]);
+            tasks[i] = tasks.back();
+            tasks.pop_back();
+        } else {
+            ++i;
+        }
+    }
+}
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#include <godot_cpp/classes/image.hpp>
+#include <godot_cpp/classes/ref_counted.hpp>
+#include <godot_cpp/variant/callable.hpp>
+#include <godot_cpp/variant/packed_byte_array.hpp>
+#include <godot_cpp/variant/packed_int32_array.hpp>
+
+#include "Core/AlphaMask.h"
+#include "Core/RegionLabeller.h"
+#include "Core/RegionMerger.h"
+#include "SpriteCutterAutoSlicer.h"
+
+/**
+ * @class SpriteCutterRuntimeSlicer
+ * @brief Slices images at runtime, in exported games as well as in the editor.
+ *
+ * Takes an Image or raw RGBA8 bytes and returns the merged regions packed in a
+ *
+ * PackedInt32Array, REGION_STRIDE ints per region: `x, y, w, h, pixel_count`. No
+ *
+ * AtlasTexture or Variant array is created, the game builds what it needs from the rects.
+ *
+ * The mask, region, labelling and merge buffers are kept between calls, so slicing
+ *
+ * sheets of similar size again, with `parallel` off and a layout read in place,
+ *
+ * allocates nothing but the returned array. Parallel calls also pay for their pool
+ *
+ * tasks. Calls are thread-safe: a call made while another one holds the buffers uses
+ *
+ * buffers of its own.
+ *
+ * The settings are its own, the project settings read by the editor don't apply.
+ *
+ * Registered at scene level, with no editor dependency.
+ */
+class SpriteCutterRuntimeSlicer : public godot::RefCounted {
+    GDCLASS(SpriteCutterRuntimeSlicer, godot::RefCounted);
+
+    public:
+        using Region = SpriteCutterAutoSlicer::Region;
+
+        SpriteCutterRuntimeSlicer() = default;
+        ~SpriteCutterRuntimeSlicer() override;
+
+        void set_alpha_threshold(int p_threshold) { alpha_threshold = godot::CLAMP(p_threshold, 0, 255); }
+        int get_alpha_threshold() const { return alpha_threshold; }
+
+        void set_min_pixels(int p_min_pixels) { min_pixels = godot::MAX(1, p_min_pixels); }
+        int get_min_pixels() const { return min_pixels; }
+
+        void set_merge_margin(float p_margin) { merge_margin = godot::MAX(0.0f, p_margin); }
+        float get_merge_margin() const { return merge_margin; }
+
+        /**
+         * @brief Labels on the WorkerThreadPool when true. Turn off when calling from inside your own pool tasks.
+         */
+        void set_parallel(bool p_parallel) { parallel = p_parallel; }
+        bool is_parallel() const { return parallel; }
+
+        /**
+         * @brief Slices an image of any format, compressed ones included.
+         *
+         * Known layouts are read in place, others are converted on a copy.
+         *
+         * @param image The image to slice. It is never modified.
+         * @return REGION_STRIDE ints per region, empty on error or if nothing is opaque.
+         */
+        godot::PackedInt32Array slice_image(const godot::Ref<godot::Image>& image);
+
+        /**
+         * @brief Slices raw RGBA8 pixels, rows packed top to bottom.
+         *
+         * @param data At least `width * height * 4` bytes.
+         * @return REGION_STRIDE ints per region, empty on error or if nothing is opaque.
+         */
+        godot::PackedInt32Array slice_bytes(const godot::PackedByteArray& data, int width, int height);
+
+        /**
+         * @brief Slices an image on a WorkerThreadPool task and calls back on the main thread.
+         *
+         * Safe to call from any thread. The task labels on its own thread only.
+         *
+         * @param image The image to slice. It is never modified.
+         * @param callback Called deferred with the packed regions, as slice_image() returns them.
+         * @return The WorkerThreadPool task id, -1 if the task can't be queued.
+         */
+        int64_t slice_async(const godot::Ref<godot::Image>& image, const godot::Callable& callback);
+
+        /**
+         * @brief Blocks until every task queued by slice_async() has returned.
+         *
+         * Their callbacks still run deferred.
+         */
+        void wait_async();
+
+        // Ints per region in the packed output: x, y, w, h, pixel_count
+        static constexpr int REGION_STRIDE = 5;
+
+    protected:
+        static void _bind_methods();
+
+    private:
+        // Kept between calls, see slice_with()
+        struct Scratch {
+            spritecutter::AlphaMask mask;
+            std::vector<Region> regions;
+            spritecutter::LabelWorkspace labelling;
+            spritecutter::MergeWorkspace merging;
+        };
+
+        /**
+         * @brief Builds the mask of `image` into `scratch`, reading compressed blocks when possible.
+         */
+        bool build_image_mask(const godot::Image* image, uint8_t threshold, bool use_pool, Scratch& scratch) const;
+
+        /**
+         * @brief Labels and merges `scratch.mask` and packs the regions.
+         */
+        godot::PackedInt32Array label_and_pack(bool use_pool, Scratch& scratch) const;
+
+        /**
+         * @brief Slices with the shared scratch if free, else with a temporary one.
+         */
+        godot::PackedInt32Array slice_with(const godot::Ref<godot::Image>& image, bool use_pool);
+
+        /**
+         * @brief Body of a slice_async() task, runs on a worker thread.
+         */
+        void _run_async(const godot::Ref<godot::Image>& image, const godot::Callable& callback);
+
+        /**
+         * @brief Releases the slice_async() tasks that have returned, deferred by each task.
+         */
+        void _release_finished_tasks();
+
+        std::atomic<int> alpha_threshold{ SpriteCutterAutoSlicer::ALPHA_THRESHOLD };
+        std::atomic<int> min_pixels{ SpriteCutterAutoSlicer::MIN_PIXELS };
+        std::atomic<float> merge_margin{ SpriteCutterAutoSlicer::MERGE_MARGIN };
+        std::atomic<bool> parallel{ true };
+
+        std::mutex scratch_mutex;
+        Scratch scratch;
+
+        // slice_async() tasks not yet released from the pool
+        std::mutex tasks_mutex;
+        std::vector<int64_t> tasks;
+};
@@ -0,0 +1,151 @@
+#include "SpriteCutterSliceCache.h"
+
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <godot_cpp/classes/project_settings.hpp>
+#include <godot_cpp/variant/utility_functions.hpp>
+
+#include "Core/Hash.h"
+
+namespace {
+    spritecutter::RegionCache& region_cache() {
+        static spritecutter::RegionCache cache;
+        return cache;
+    }
+
+    // Texture path (UTF-8) → hash of its pixels when it was last sliced.
+    // Standard containers: these statics outlive the godot-cpp bindings.
+    std::mutex paths_mutex;
+    std::unordered_map<std::string, uint64_t> path_contents;
+    uint64_t generation = 0;
+
+    // Labelling state of the last sliced files, most recent first
+    std::list<std::pair<std::string, std::shared_ptr<spritecutter::IncrementalLabeller>>> labellers;
+
+    spritecutter::CacheKey key_for(uint64_t content, uint8_t alpha_threshold) {
+        spritecutter::CacheKey key;
+        key.content = content;
+        key.alpha_threshold = alpha_threshold;
+        // Tables hold every component unmerged, the floor and margin are applied on top
+        key.min_pixels = 1;
+        key.merge_margin = 0.0f;
+        return key;
+    }
+}
+
+bool SpriteCutterSliceCache::open(const godot::String& directory) {
+    godot::String path = godot::ProjectSettings::get_singleton()->globalize_path(directory);
+    if (!region_cache().open(path.utf8().get_data())) {
+        godot::UtilityFunctions::printerr("SpriteCutterSliceCache: can't create ", path, ", caching in memory only");
+        return false;
+    }
+    return true;
+}
+
+void SpriteCutterSliceCache::close() {
+    region_cache().close();
+}
+
+spritecutter::CacheKey SpriteCutterSliceCache::make_key(const godot::Image* img, uint8_t alpha_threshold) {
+    godot::PackedByteArray data = img->get_data();
+    uint64_t h = spritecutter::hash_bytes(data.ptr(), size_t(data.size()));
+    h = spritecutter::hash_combine(h, uint64_t(img->get_width()));
+    h = spritecutter::hash_combine(h, uint64_t(img->get_height()));
+    h = spritecutter::hash_combine(h, uint64_t(img->get_format()));
+    h = spritecutter::hash_combine(h, uint64_t(img->has_mipmaps()));
+    return key_for(h, alpha_threshold);
+}
+
+spritecutter::CacheKey SpriteCutterSliceCache::make_key(const uint8_t* data, size_t size, uint8_t alpha_threshold) {
+    return key_for(spritecutter::hash_bytes(data, size), alpha_threshold);
+}
+
+bool SpriteCutterSliceCache::find(const spritecutter::CacheKey& key, godot::LocalVector<Region>& regions) {
+    std::vector<Region> found;
+    if (!region_cache().find(key, found)) return false;
+
+    regions.resize(found.size());
+    for (size_t i = 0; i < found.size(); ++i) regions[i] = found[i];
+    return true;
+}
+
+void SpriteCutterSliceCache::insert(const spritecutter::CacheKey& key, const godot::LocalVector<Region>& regions) {
+    std::vector<Region> table(regions.ptr(), regions.ptr() + regions.size());
+    region_cache().insert(key, table);
+}
+
+bool SpriteCutterSliceCache::find_texture(const godot::Ref<godot::Texture2D>& texture, uint8_t alpha_threshold, godot::LocalVector<Region>& regions) {
+    if (!texture.is_valid()) return false;
+    std::string path = texture->get_path().utf8().get_data();
+
+    uint64_t content;
+    {
+        std::lock_guard<std::mutex> lock(paths_mutex);
+        auto found = path_contents.find(path);
+        if (found == path_contents.end()) return false;
+        content = found->second;
+    }
+    return find(key_for(content, alpha_threshold), regions);
+}
+
+void SpriteCutterSliceCache::remember(const godot::String& path, uint64_t p_generation, const spritecutter::CacheKey& key) {
+    // Subresources have no file of their own to watch
+    if (path.is_empty() || path.contains("::")) return;
+
+    std::lock_guard<std::mutex> lock(paths_mutex);
+    if (p_generation != generation) return;
+    path_contents[path.utf8().get_data()] = key.content;
+}
+
+uint64_t SpriteCutterSliceCache::get_generation() {
+    std::lock_guard<std::mutex> lock(paths_mutex);
+    return generation;
+}
+
+void SpriteCutterSliceCache::invalidate(const godot::PackedStringArray& paths) {
+    std::vector<uint64_t> stale;
+    {
+        std::lock_guard<std::mutex> lock(paths_mutex);
+        ++generation;
+        for (int64_t i = 0; i < paths.size(); ++i) {
+            auto found = path_contents.find(paths[i].utf8().get_data());
+            if (found == path_contents.end()) continue;
+            stale.push_back(found->second);
+            path_contents.erase(found);
+        }
+    }
+
+    // Tables sliced with other thresholds age out on their own
+    for (uint64_t content : stale) region_cache().erase(key_for(content, SpriteCutterAutoSlicer::ALPHA_THRESHOLD));
+}
+
+std::shared_ptr<spritecutter::IncrementalLabeller> SpriteCutterSliceCache::get_labeller(const godot::String& path) {
+    if (path.is_empty() || path.contains("::")) return nullptr;
+    std::string key = path.utf8().get_data();
+
+    std::lock_guard<std::mutex> lock(paths_mutex);
+    for (auto it = labellers.begin(); it != labellers.end(); ++it) {
+        if (it->first == key) {
+            labellers.splice(labellers.begin(), labellers, it);
+            return labellers.front().second;
+        }
+    }
+
+    labellers.emplace_front(key, std::make_shared<spritecutter::IncrementalLabeller>());
+    if ((int)labellers.size() > MAX_LABELLERS) labellers.pop_back();
+    return labellers.front().second;
+}
+
+void SpriteCutterSliceCache::clear() {
+    {
+        std::lock_guard<std::mutex> lock(paths_mutex);
+        ++generation;
+        path_contents.clear();
+        labellers.clear();
+    }
+    region_cache().clear();
+}
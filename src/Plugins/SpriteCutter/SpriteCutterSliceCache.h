@@ -0,0 +1,145 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include <godot_cpp/classes/image.hpp>
+#include <godot_cpp/classes/texture2d.hpp>
+#include <godot_cpp/templates/local_vector.hpp>
+#include <godot_cpp/variant/packed_string_array.hpp>
+
+#include "Core/RegionCache.h"
+#include "SpriteCutterAutoSlicer.h"
+
+/**
+ * @class SpriteCutterSliceCache
+ * @brief Remembers the regions of already sliced textures across cuts and editor sessions.
+ *
+ * Tables hold the components of a sheet, labelled with a pixel floor of 1 and unmerged,
+ *
+ * so changing the floor or the merge margin never misses: see spritecutter::RegionStages.
+ *
+ * They are keyed by an XXH64 of the read-back pixels, or of the source file when it
+ *
+ * is decoded directly, plus the alpha threshold, and kept by a spritecutter::RegionCache in memory and under `res://.godot/spritecutter_cache/`,
+ *
+ * both capped and least recently used first.
+ *
+ * Hashing still needs the pixels, so each texture file is also mapped to the hash of
+ *
+ * its last slice: cutting it again then skips the readback too. That mapping is dropped
+ *
+ * when the file is reimported, see invalidate().
+ *
+ * After a reimport the pixels must be sliced again, but the labelling state of the
+ *
+ * previous slice is kept per file so only the bands the edit touched are relabelled.
+ *
+ * Static and thread-safe, like SpriteCutterAutoSlicer.
+ */
+class SpriteCutterSliceCache {
+    public:
+        using Region = SpriteCutterAutoSlicer::Region;
+
+        /**
+         * @brief Stores entries on disk under `directory`, in addition to memory.
+         *
+         * @param directory A `res://` or absolute path. Created if missing.
+         * @return false if the directory can't be created, the cache then stays in memory.
+         */
+        static bool open(const godot::String& directory = DIRECTORY);
+
+        /**
+         * @brief Stops writing to disk. Memory entries are kept.
+         */
+        static void close();
+
+        /**
+         * @brief Builds the key of an image read back by SpriteCutterAutoSlicer::fetch_image().
+         *
+         * Hashes the raw data as is, compressed or not, with its size and format.
+         *
+         * Call before compute_regions(), which decompresses the image in place.
+         */
+        static spritecutter::CacheKey make_key(const godot::Image* img, uint8_t alpha_threshold);
+
+        /**
+         * @brief Builds the key of an encoded file sliced by SpriteCutterAutoSlicer::compute_regions_from_png().
+         *
+         * Hashes the file bytes, so the same pixels read back from the texture get another key.
+         */
+        static spritecutter::CacheKey make_key(const uint8_t* data, size_t size, uint8_t alpha_threshold);
+
+        /**
+         * @brief Looks up the components sliced for `key`, unfiltered and unmerged.
+         *
+         * @return false on a miss.
+         */
+        static bool find(const spritecutter::CacheKey& key, godot::LocalVector<Region>& regions);
+
+        /**
+         * @brief Stores the components sliced for `key`, see SpriteCutterAutoSlicer::compute_components().
+         */
+        static void insert(const spritecutter::CacheKey& key, const godot::LocalVector<Region>& regions);
+
+        /**
+         * @brief Looks up a texture by its file, without reading its pixels back.
+         *
+         * Only hits for textures sliced since their last reimport, during this session.
+         *
+         * @param texture A texture loaded from a file. Embedded and generated ones always miss.
+         * @param alpha_threshold Threshold of the slice.
+         * @param regions Output regions.
+         * @return false on a miss.
+         */
+        static bool find_texture(const godot::Ref<godot::Texture2D>& texture, uint8_t alpha_threshold, godot::LocalVector<Region>& regions);
+
+        /**
+         * @brief Maps a texture file to the key of its pixels, for find_texture().
+         *
+         * @param path Resource path of the texture.
+         * @param generation get_generation() when the pixels were read back. The mapping is
+         *        ignored if a reimport happened since, as the pixels may be outdated.
+         * @param key Key of the pixels.
+         */
+        static void remember(const godot::String& path, uint64_t generation, const spritecutter::CacheKey& key);
+
+        /**
+         * @brief Returns a counter bumped by every invalidate().
+         */
+        static uint64_t get_generation();
+
+        /**
+         * @brief Forgets the pixels of reimported files.
+         *
+         * Connected to EditorFileSystem's `resources_reimported` by the plugin.
+         *
+         * The table of the old pixels is erased, the next cut slices the new ones.
+         *
+         * @param paths Resource paths of the reimported files.
+         */
+        static void invalidate(const godot::PackedStringArray& paths);
+
+        /**
+         * @brief Returns the labelling state of the last slice of a texture file.
+         *
+         * Survives invalidate(): diffing against the previous pixels is the point.
+         *
+         * Only the MAX_LABELLERS most recently sliced files keep one.
+         *
+         * @param path Resource path of the texture.
+         * @return null for textures without a file of their own.
+         */
+        static std::shared_ptr<spritecutter::IncrementalLabeller> get_labeller(const godot::String& path);
+
+        /**
+         * @brief Drops every entry, in memory and on disk, and every labelling state.
+         */
+        static void clear();
+
+        // Default location, inside the project data folder that Godot never imports
+        static constexpr const char* DIRECTORY = "res://.godot/spritecutter_cache";
+
+        // Texture files whose labelling state is kept between slices
+        static constexpr int MAX_LABELLERS = 4;
+};
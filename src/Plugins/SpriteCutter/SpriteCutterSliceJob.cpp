@@ -0,0 +1,114 @@
+#include "SpriteCutterSliceJob.h"
+
+#include "SpriteCutterSliceCache.h"
+
+#include <godot_cpp/classes/worker_thread_pool.hpp>
+#include <godot_cpp/variant/callable_method_pointer.hpp>
+
+void SpriteCutterSliceJob::_bind_methods() {
+    ADD_SIGNAL(godot::MethodInfo("finished"));
+}
+
+SpriteCutterSliceJob::~SpriteCutterSliceJob() {
+    // Never free the state a running task still points to
+    cancel();
+    wait();
+}
+
+bool SpriteCutterSliceJob::start(const godot::Ref<godot::Texture2D>& tex, uint8_t alpha_threshold) {
+    if (task_id >= 0) return false;
+
+    texture = tex;
+    threshold = alpha_threshold;
+    stages.set_min_pixels(SpriteCutterAutoSlicer::get_min_pixels());
+    stages.set_merge_margin(SpriteCutterAutoSlicer::get_merge_margin());
+    source_path = tex.is_valid() ? tex->get_path() : godot::String();
+    cache_generation = SpriteCutterSliceCache::get_generation();
+
+    // Straight from the imported PNG when it holds the texture's pixels
+    stats = spritecutter::SliceStats();
+    spritecutter::StageTimer fetch(&stats, spritecutter::STAGE_FETCH);
+    if (!SpriteCutterAutoSlicer::open_source_file(tex, source_file)) {
+        image = SpriteCutterAutoSlicer::fetch_image(tex);
+        if (!image.is_valid()) return false;
+    }
+    fetch.stop();
+
+    task_id = godot::WorkerThreadPool::get_singleton()->add_task(
+        callable_mp(this, &SpriteCutterSliceJob::_run), false, "SpriteCutter: slice");
+    return true;
+}
+
+void SpriteCutterSliceJob::wait() {
+    if (task_id < 0) return;
+    godot::WorkerThreadPool::get_singleton()->wait_for_task_completion(task_id);
+    task_id = -1;
+}
+
+void SpriteCutterSliceJob::_run() {
+    spritecutter::CacheKey key;
+
+    // Every component, the floor and margin are applied by the stages below
+    godot::LocalVector<SpriteCutterAutoSlicer::Region> components;
+
+    // compute_components() drops its image, the hashes still need the pixels
+    godot::Ref<godot::Image> pixels;
+    spritecutter::AlphaMask built;
+    if (source_file.get_data()) {
+        key = SpriteCutterSliceCache::make_key(source_file.get_data(), source_file.get_size(), threshold);
+        cached = SpriteCutterSliceCache::find(key, components);
+        if (!cached) {
+            // Reuses the bands of the previous slice of this file, if any
+            std::shared_ptr<spritecutter::IncrementalLabeller> labeller = SpriteCutterSliceCache::get_labeller(source_path);
+            succeeded = SpriteCutterAutoSlicer::compute_components_from_png(source_file.get_data(), source_file.get_size(), threshold, 1, components, &progress, true, labeller.get(), &stats, &built);
+
+            // Let Godot's decoder have a go at files ours rejects
+            if (!succeeded && !progress.is_cancelled()) image = godot::Image::load_from_file(source_path);
+        }
+        source_file.close();
+    }
+
+    if (image.is_valid()) {
+        // Hash before compute_components() decompresses the image in place
+        key = SpriteCutterSliceCache::make_key(image.ptr(), threshold);
+        cached = SpriteCutterSliceCache::find(key, components);
+        if (hash_frames) pixels = image;
+        if (!cached) {
+            std::shared_ptr<spritecutter::IncrementalLabeller> labeller = SpriteCutterSliceCache::get_labeller(source_path);
+            succeeded = SpriteCutterAutoSlicer::compute_components(image, threshold, 1, components, &progress, true, labeller.get(), &stats, &built);
+        }
+    }
+
+    if (cached) {
+        succeeded = true;
+    } else if (succeeded) {
+        SpriteCutterSliceCache::insert(key, components);
+    }
+    if (succeeded) SpriteCutterSliceCache::remember(source_path, cache_generation, key);
+    if (succeeded && built.get_width() > 0) mask = std::make_shared<const spritecutter::AlphaMask>(std::move(built));
+    image.unref();
+
+    if (succeeded) {
+        progress.begin_stage(0.9f, 1.0f);
+        stages.set_components(std::vector<SpriteCutterAutoSlicer::Region>(components.ptr(), components.ptr() + components.size()));
+        const std::vector<SpriteCutterAutoSlicer::Region>& merged = stages.get_regions(&stats);
+        regions.resize(merged.size());
+        for (size_t i = 0; i < merged.size(); ++i) regions[i] = merged[i];
+        progress.finish();
+    }
+
+    // Hashes read the colors, which neither the cache nor the mask hold
+    if (succeeded && hash_frames && !regions.is_empty() && !progress.is_cancelled()) {
+        if (!pixels.is_valid()) pixels = godot::Image::load_from_file(source_path);
+        if (pixels.is_valid() && !SpriteCutterAutoSlicer::compute_frame_hashes(pixels, regions, hashes, &progress)) hashes.clear();
+        pixels.unref();
+    }
+    done.store(true);
+
+    // Hand the result back to the main thread. Skipped if the job is freed first.
+    callable_mp(this, &SpriteCutterSliceJob::_notify_finished).call_deferred();
+}
+
+void SpriteCutterSliceJob::_notify_finished() {
+    emit_signal("finished");
+}
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <godot_cpp/classes/ref_counted.hpp>
+#include <godot_cpp/classes/texture2d.hpp>
+
+#include "Core/RegionStages.h"
+#include "SpriteCutterAutoSlicer.h"
+
+/**
+ * @class SpriteCutterSliceJob
+ * @brief Runs SpriteCutterAutoSlicer::compute_components on a WorkerThreadPool task.
+ *
+ * The texture is read back on the main thread in start(), every pixel stage then
+ * 
+ * runs on the worker. Textures imported from a PNG skip the readback: the file is
+ * 
+ * mapped in start() and decoded row by row on the worker instead. The `finished` signal is emitted on the main thread through
+ * 
+ * a deferred call, where the owner shows the regions from get_regions().
+ *
+ * The components are then filtered and merged by a spritecutter::RegionStages with
+ * 
+ * the pixel floor and merge margin read in start(), so the owner can tune both later
+ * 
+ * without slicing again, see get_stages().
+ *
+ * Pixels sliced before are answered by SpriteCutterSliceCache instead. With
+ * 
+ * set_hash_frames(), the task then fingerprints the pixels of every region.
+ *
+ * The full mask the labelling built is kept, see get_mask(), so the owner can trace
+ * 
+ * the outlines of the sprites it uses without reading the pixels again.
+ *
+ * The owner must keep a reference to the job and call wait() before dropping it.
+ */
+class SpriteCutterSliceJob : public godot::RefCounted {
+    GDCLASS(SpriteCutterSliceJob, godot::RefCounted);
+
+    public:
+        SpriteCutterSliceJob() = default;
+        ~SpriteCutterSliceJob() override;
+
+        /**
+         * @brief Maps the source file or reads the texture back, and queues the slicing task.
+         *
+         * Main thread only.
+         *
+         * @param tex The texture to slice.
+         * @param alpha_threshold Pixels with alpha (0-255) strictly above this value are opaque.
+         * @return false if the texture can't be read.
+         */
+        bool start(const godot::Ref<godot::Texture2D>& tex, uint8_t alpha_threshold);
+
+        /**
+         * @brief Also fingerprints the regions for duplicate detection. Call before start().
+         *
+         * PNG sources are decoded by Godot for it, costing a full image on the worker.
+         */
+        void set_hash_frames(bool p_hash) { hash_frames = p_hash; }
+
+        /**
+         * @brief Asks the task to stop at its next check. Returns immediately.
+         */
+        void cancel() { progress.cancel(); }
+
+        /**
+         * @brief Blocks until the task has returned and releases it from the pool.
+         */
+        void wait();
+
+        bool is_cancelled() const { return progress.is_cancelled(); }
+        bool is_done() const { return done.load(); }
+        bool has_succeeded() const { return succeeded; }
+
+        /**
+         * @brief Returns true if the regions came from SpriteCutterSliceCache.
+         */
+        bool is_cached() const { return cached; }
+
+        /**
+         * @brief Overall progress in [0, 1], safe to poll while the task runs.
+         */
+        float get_progress() const { return progress.get(); }
+
+        /**
+         * @brief Returns the texture being sliced.
+         */
+        godot::Ref<godot::Texture2D> get_texture() const { return texture; }
+
+        /**
+         * @brief Returns the merged regions. Only valid once is_done() is true.
+         */
+        const godot::LocalVector<SpriteCutterAutoSlicer::Region>& get_regions() const { return regions; }
+
+        /**
+         * @brief Returns the components and the stages that made get_regions(). Only valid once is_done() is true.
+         *
+         * Copy it to filter and merge the components again with other parameters.
+         */
+        const spritecutter::RegionStages& get_stages() const { return stages; }
+
+        /**
+         * @brief Returns the mask the regions were labelled from. Only valid once is_done() is true.
+         *
+         * Null when the regions came from the cache or the image was labelled strip by strip.
+         */
+        std::shared_ptr<const spritecutter::AlphaMask> get_mask() const { return mask; }
+
+        /**
+         * @brief Returns one fingerprint per region, or none if they weren't computed. Only valid once is_done() is true.
+         */
+        const std::vector<spritecutter::FrameHash>& get_frame_hashes() const { return hashes; }
+
+        /**
+         * @brief Returns the fetch, decompress, label and merge costs. Only valid once is_done() is true.
+         *
+         * Cached regions only cost the fetch.
+         */
+        const spritecutter::SliceStats& get_stats() const { return stats; }
+
+    protected:
+        static void _bind_methods();
+
+    private:
+        /**
+         * @brief Task body, runs on a worker thread.
+         */
+        void _run();
+
+        /**
+         * @brief Emits `finished`. Deferred to the main thread by _run().
+         */
+        void _notify_finished();
+
+        // Source texture, only touched on the main thread
+        godot::Ref<godot::Texture2D> texture;
+
+        // Read-back image, or the mapped source file, handed over to the worker
+        godot::Ref<godot::Image> image;
+        spritecutter::MappedFile source_file;
+
+        // Resource path of the texture and the cache generation at readback
+        godot::String source_path;
+        uint64_t cache_generation = 0;
+
+        uint8_t threshold = SpriteCutterAutoSlicer::ALPHA_THRESHOLD;
+
+        spritecutter::SliceProgress progress;
+
+        // Components as labelled or cached, then filtered and merged into regions
+        spritecutter::RegionStages stages;
+        godot::LocalVector<SpriteCutterAutoSlicer::Region> regions;
+
+        // Full mask of the labelling, handed to the owner for its outlines
+        std::shared_ptr<const spritecutter::AlphaMask> mask;
+
+        // Filled after the regions when hash_frames is set
+        bool hash_frames = false;
+        std::vector<spritecutter::FrameHash> hashes;
+
+        // Fetch timed in start(), the pixel stages by the worker
+        spritecutter::SliceStats stats;
+
+        // Set by the worker once regions are final
+        std::atomic<bool> done{ false };
+        bool succeeded = false;
+        bool cached = false;
+
+        // WorkerThreadPool task id, -1 when no task is pending
+        int64_t task_id = -1;
+};
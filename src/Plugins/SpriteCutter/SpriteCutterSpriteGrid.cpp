@@ -0,0 +1,347 @@
+#include "SpriteCutterSpriteGrid.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <godot_cpp/classes/font.hpp>
+#include <godot_cpp/classes/input_event_key.hpp>
+#include <godot_cpp/classes/input_event_mouse_button.hpp>
+#include <godot_cpp/classes/os.hpp>
+#include <godot_cpp/classes/worker_thread_pool.hpp>
+#include <godot_cpp/variant/callable_method_pointer.hpp>
+
+#include "SpriteCutterAutoSlicer.h"
+#include "SpriteCutterTaskGroup.h"
+
+namespace {
+    // Background of the selected cell
+    const godot::Color SELECTED_COLOR(0.35f, 0.55f, 0.9f, 0.35f);
+
+    // Largest rectangle of `size`'s aspect centered in `box`
+    godot::Rect2 fit(const godot::Rect2& box, const godot::Vector2& size) {
+        if (size.x <= 0.0f || size.y <= 0.0f) return box;
+        float scale = godot::MIN(box.size.x / size.x, box.size.y / size.y);
+        godot::Vector2 fitted = size * scale;
+        return godot::Rect2(box.position + (box.size - fitted) * 0.5f, fitted);
+    }
+}
+
+void SpriteCutterSpriteGrid::_bind_methods() {
+    godot::ClassDB::bind_method(godot::D_METHOD("_on_scrolled", "value"), &SpriteCutterSpriteGrid::_on_scrolled);
+    godot::ClassDB::bind_method(godot::D_METHOD("get_selected_items"), &SpriteCutterSpriteGrid::get_selected_items);
+    godot::ClassDB::bind_method(godot::D_METHOD("select_all"), &SpriteCutterSpriteGrid::select_all);
+
+    ADD_SIGNAL(godot::MethodInfo("item_activated", godot::PropertyInfo(godot::Variant::INT, "index")));
+    ADD_SIGNAL(godot::MethodInfo("selection_changed"));
+}
+
+SpriteCutterSpriteGrid::SpriteCutterSpriteGrid() {
+    set_clip_contents(true);
+    set_focus_mode(FOCUS_CLICK);
+
+    scroll_bar = memnew(godot::VScrollBar);
+    scroll_bar->set_visible(false);
+    scroll_bar->connect("value_changed", godot::Callable(this, "_on_scrolled"));
+    add_child(scroll_bar);
+}
+
+SpriteCutterSpriteGrid::~SpriteCutterSpriteGrid() {
+    // Never free the state a running task still points to
+    stop_preview();
+}
+
+void SpriteCutterSpriteGrid::_notification(int p_what) {
+    switch (p_what) {
+        case NOTIFICATION_RESIZED:
+            update_layout();
+            break;
+
+        case NOTIFICATION_DRAW:
+            draw_cells();
+            break;
+
+        case NOTIFICATION_PROCESS:
+            if (task_id < 0) set_process(false);
+            else if (built_done.load()) finish_preview();
+            break;
+
+        case NOTIFICATION_PREDELETE:
+            stop_preview();
+            break;
+    }
+}
+
+void SpriteCutterSpriteGrid::set_items(const godot::Ref<SpriteCutterRegionSet>& p_items) {
+    clear();
+    if (p_items.is_valid()) {
+        atlas = p_items->get_texture();
+        regions.resize(p_items->get_count());
+        for (int i = 0; i < p_items->get_count(); ++i) {
+            godot::Rect2i r = p_items->get_region(i);
+            regions[i] = { r.position.x, r.position.y, r.size.x, r.size.y, 0 };
+        }
+        selection.assign(regions.size(), 0);
+    }
+    update_layout();
+    start_preview();
+}
+
+void SpriteCutterSpriteGrid::clear() {
+    stop_preview();
+    regions.clear();
+    atlas.unref();
+    preview.unref();
+    preview_rects.clear();
+    source.unref();
+    readback_failed = false;
+    selected = -1;
+    selection.clear();
+    scroll_bar->set_value(0.0);
+    update_layout();
+    emit_signal("selection_changed");
+}
+
+godot::PackedInt32Array SpriteCutterSpriteGrid::get_selected_items() const {
+    godot::PackedInt32Array items;
+    for (size_t i = 0; i < selection.size(); ++i) {
+        if (selection[i]) items.push_back(int32_t(i));
+    }
+    return items;
+}
+
+void SpriteCutterSpriteGrid::select_all() {
+    if (selection.empty()) return;
+    std::fill(selection.begin(), selection.end(), uint8_t(1));
+    queue_redraw();
+    emit_signal("selection_changed");
+}
+
+void SpriteCutterSpriteGrid::click_item(int index, bool toggle, bool extend) {
+    if (extend && selected >= 0 && index >= 0) {
+        // The range is added to what toggling already picked
+        if (!toggle) std::fill(selection.begin(), selection.end(), uint8_t(0));
+        for (int i = godot::MIN(selected, index); i <= godot::MAX(selected, index); ++i) selection[i] = 1;
+    } else if (toggle && index >= 0) {
+        selection[index] = !selection[index];
+        selected = index;
+    } else {
+        std::fill(selection.begin(), selection.end(), uint8_t(0));
+        if (index >= 0) selection[index] = 1;
+        selected = index;
+    }
+    queue_redraw();
+    emit_signal("selection_changed");
+}
+
+void SpriteCutterSpriteGrid::set_thumbnail_size(int size) {
+    size = godot::MAX(16, size);
+    if (size == thumbnail_size) return;
+
+    // The current preview is stretched until the new one is ready
+    thumbnail_size = size;
+    update_layout();
+    start_preview();
+}
+
+int SpriteCutterSpriteGrid::get_columns() const {
+    float avail = get_size().x - scroll_bar->get_combined_minimum_size().x;
+    return godot::MAX(1, int(avail) / get_cell_width());
+}
+
+int SpriteCutterSpriteGrid::get_item_at(const godot::Vector2& pos) const {
+    if (pos.x < 0.0f || pos.y < 0.0f) return -1;
+    int column = int(pos.x) / get_cell_width();
+    int row = int(pos.y + scroll_bar->get_value()) / get_cell_height();
+    if (column >= get_columns()) return -1;
+
+    int index = row * get_columns() + column;
+    return index < (int)regions.size() ? index : -1;
+}
+
+void SpriteCutterSpriteGrid::get_visible_range(int& first, int& last) const {
+    int columns = get_columns(), cell_h = get_cell_height();
+    double top = scroll_bar->get_value();
+    int first_row = int(top) / cell_h;
+    int last_row = int(top + get_size().y + cell_h - 1) / cell_h;
+    first = godot::MIN(int(regions.size()), first_row * columns);
+    last = godot::MIN(int(regions.size()), last_row * columns);
+}
+
+void SpriteCutterSpriteGrid::update_layout() {
+    godot::Vector2 size = get_size();
+    float bar_w = scroll_bar->get_combined_minimum_size().x;
+    scroll_bar->set_position(godot::Vector2(size.x - bar_w, 0.0f));
+    scroll_bar->set_size(godot::Vector2(bar_w, size.y));
+
+    int columns = get_columns();
+    int rows = (int(regions.size()) + columns - 1) / columns;
+    double content_h = double(rows) * get_cell_height();
+    scroll_bar->set_max(content_h);
+    scroll_bar->set_page(size.y);
+    scroll_bar->set_step(1.0);
+    scroll_bar->set_visible(content_h > size.y);
+
+    queue_redraw();
+}
+
+void SpriteCutterSpriteGrid::_on_scrolled(double) {
+    queue_redraw();
+}
+
+void SpriteCutterSpriteGrid::start_preview() {
+    stop_preview();
+    if (!atlas.is_valid() || readback_failed || regions.empty()) return;
+
+    progress = std::make_unique<spritecutter::SliceProgress>();
+    build_size = thumbnail_size;
+    build_ok = false;
+    built_done.store(false);
+    task_id = godot::WorkerThreadPool::get_singleton()->add_task(
+        callable_mp(this, &SpriteCutterSpriteGrid::_run_preview), false, "SpriteCutter: preview");
+    set_process(true);
+}
+
+void SpriteCutterSpriteGrid::_run_preview() {
+    // One readback per sheet, every thumbnail is cut from it. Read here: a 16k sheet
+    // would stall the editor on the main thread
+    if (!source.is_valid()) {
+        source = SpriteCutterAutoSlicer::fetch_image(atlas);
+        if (!source.is_valid()) {
+            built_done.store(true);
+            return;
+        }
+    }
+
+    // Compressed and exotic layouts are converted once, on the worker
+    if (source->is_compressed() && source->decompress() != godot::OK) {
+        built_done.store(true);
+        return;
+    }
+    if (source->get_format() != godot::Image::FORMAT_RGBA8) source->convert(godot::Image::FORMAT_RGBA8);
+
+    godot::PackedByteArray bytes = source->get_data();
+    int w = source->get_width(), h = source->get_height();
+    spritecutter::PixelView view = spritecutter::PixelView::packed(bytes.ptr(), w, h, spritecutter::FORMAT_RGBA8);
+    if (size_t(bytes.size()) >= view.row_pitch * size_t(h)) {
+        int tasks = 4 * godot::MAX(1, (int)godot::OS::get_singleton()->get_processor_count());
+        spritecutter::ParallelFor pool = [](int count, const spritecutter::TaskFn& task) {
+            SpriteCutterTaskGroup::run(count, task, "SpriteCutter: preview regions");
+        };
+        build_ok = spritecutter::build_preview_atlas(view, regions, build_size, MAX_PREVIEW_BYTES, built, pool, tasks, progress.get());
+    }
+    built_done.store(true);
+}
+
+void SpriteCutterSpriteGrid::finish_preview() {
+    godot::WorkerThreadPool::get_singleton()->wait_for_task_completion(task_id);
+    task_id = -1;
+    set_process(false);
+
+    if (!source.is_valid()) {
+        godot::UtilityFunctions::printerr("SpriteCutterSpriteGrid: can't read the atlas back, no thumbnails");
+        readback_failed = true;
+        return;
+    }
+
+    // The RGBA8 copy is worth keeping for the next size change if the budget allows it
+    size_t source_bytes = size_t(source->get_width()) * size_t(source->get_height()) * 4;
+    if (source_bytes > SpriteCutterAutoSlicer::get_memory_budget()) source.unref();
+
+    if (!build_ok) {
+        godot::UtilityFunctions::printerr("SpriteCutterSpriteGrid: can't build the preview");
+        built = spritecutter::PreviewAtlas();
+        return;
+    }
+
+    // A single upload for every thumbnail
+    godot::PackedByteArray data;
+    data.resize(built.rgba.size());
+    memcpy(data.ptrw(), built.rgba.data(), built.rgba.size());
+    godot::Ref<godot::Image> image = godot::Image::create_from_data(built.width, built.height, false, godot::Image::FORMAT_RGBA8, data);
+    preview = godot::ImageTexture::create_from_image(image);
+    preview_rects = std::move(built.rects);
+    built = spritecutter::PreviewAtlas();
+    queue_redraw();
+}
+
+void SpriteCutterSpriteGrid::stop_preview() {
+    if (task_id >= 0) {
+        progress->cancel();
+        godot::WorkerThreadPool::get_singleton()->wait_for_task_completion(task_id);
+        task_id = -1;
+    }
+    built = spritecutter::PreviewAtlas();
+    built_done.store(false);
+}
+
+void SpriteCutterSpriteGrid::draw_cells() {
+    int first, last;
+    get_visible_range(first, last);
+    if (first >= last) return;
+
+    int columns = get_columns();
+    int cell_w = get_cell_width(), cell_h = get_cell_height();
+    float top = float(scroll_bar->get_value());
+
+    godot::Ref<godot::Font> font = get_theme_default_font();
+    int font_size = get_theme_default_font_size();
+
+    for (int i = first; i < last; ++i) {
+        godot::Vector2 pos(float((i % columns) * cell_w), float((i / columns) * cell_h) - top);
+        if (is_item_selected(i)) draw_rect(godot::Rect2(pos, godot::Vector2(cell_w, cell_h)), SELECTED_COLOR);
+
+        godot::Rect2 box(pos.x + PADDING, pos.y + PADDING, thumbnail_size, thumbnail_size);
+        if (atlas.is_valid()) {
+            // Fitted from the region so a preview of another size lands on the same rectangle
+            godot::Rect2 region(regions[i].x, regions[i].y, regions[i].w, regions[i].h);
+            bool in_preview = preview.is_valid() && size_t(i) < preview_rects.size() && preview_rects[i].w > 0;
+            if (in_preview) {
+                const spritecutter::PreviewRect& r = preview_rects[i];
+                draw_texture_rect_region(preview, fit(box, region.size), godot::Rect2(r.x, r.y, r.w, r.h));
+            } else {
+                // Until the preview is ready, the region is drawn straight from the atlas
+                draw_texture_rect_region(atlas, fit(box, region.size), region);
+            }
+        }
+
+        if (font.is_valid()) {
+            godot::Vector2 baseline(pos.x + PADDING, pos.y + PADDING + thumbnail_size + TEXT_HEIGHT - 4);
+            draw_string(font, baseline, godot::String::num_int64(i + 1), godot::HORIZONTAL_ALIGNMENT_CENTER, thumbnail_size, font_size);
+        }
+    }
+}
+
+void SpriteCutterSpriteGrid::_gui_input(const godot::Ref<godot::InputEvent>& event) {
+    godot::Ref<godot::InputEventKey> key = event;
+    if (key.is_valid() && key->is_pressed() && key->is_command_or_control_pressed() && key->get_keycode() == godot::KEY_A) {
+        select_all();
+        accept_event();
+        return;
+    }
+
+    godot::Ref<godot::InputEventMouseButton> mb = event;
+    if (mb.is_null() || !mb->is_pressed()) return;
+
+    switch (mb->get_button_index()) {
+        case godot::MOUSE_BUTTON_WHEEL_UP:
+            scroll_bar->set_value(scroll_bar->get_value() - get_cell_height() * 0.5);
+            accept_event();
+            break;
+
+        case godot::MOUSE_BUTTON_WHEEL_DOWN:
+            scroll_bar->set_value(scroll_bar->get_value() + get_cell_height() * 0.5);
+            accept_event();
+            break;
+
+        case godot::MOUSE_BUTTON_LEFT: {
+            int index = get_item_at(mb->get_position());
+            if (!mb->is_double_click()) click_item(index, mb->is_command_or_control_pressed(), mb->is_shift_pressed());
+            if (index >= 0 && mb->is_double_click()) emit_signal("item_activated", index);
+            accept_event();
+            break;
+        }
+
+        default:
+            break;
+    }
+}
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <godot_cpp/classes/control.hpp>
+#include <godot_cpp/classes/image.hpp>
+#include <godot_cpp/classes/image_texture.hpp>
+#include <godot_cpp/classes/input_event.hpp>
+#include <godot_cpp/classes/v_scroll_bar.hpp>
+#include <godot_cpp/variant/packed_int32_array.hpp>
+
+#include "Core/PreviewAtlas.h"
+#include "Core/SliceProgress.h"
+#include "SpriteCutterRegionSet.h"
+
+/**
+ * @class SpriteCutterSpriteGrid
+ * @brief Virtualized grid of sprite previews, sized for sheets with thousands of regions.
+ *
+ * Nothing is created per item: the control draws the cells in view and nothing else,
+ *
+ * so scrolling costs the same with 30 or 30,000 sprites.
+ *
+ * Cells first draw their region straight from the atlas. A WorkerThreadPool task then
+ *
+ * shrinks every region from one readback of the atlas and packs the thumbnails in a
+ *
+ * single preview texture, uploaded once: a 16k sheet is no longer sampled per icon.
+ *
+ * Changing the thumbnail size rebuilds the preview, the old one stays on screen meanwhile.
+ *
+ * Emits `item_activated` on double click, like ItemList. Ctrl+click toggles an item,
+ *
+ * Shift+click extends the selection from the last clicked one and Ctrl+A selects all,
+ *
+ * each emitting `selection_changed`.
+ */
+class SpriteCutterSpriteGrid : public godot::Control {
+    GDCLASS(SpriteCutterSpriteGrid, godot::Control);
+
+    public:
+        SpriteCutterSpriteGrid();
+        ~SpriteCutterSpriteGrid() override;
+
+        /**
+         * @brief Replaces the items and starts building their preview.
+         *
+         * @param items The sprites to show, in order.
+         */
+        void set_items(const godot::Ref<SpriteCutterRegionSet>& items);
+
+        /**
+         * @brief Removes every item and stops the preview task.
+         */
+        void clear();
+
+        int get_item_count() const { return (int)regions.size(); }
+
+        /**
+         * @brief Sets the side of the square a thumbnail fits in. Rebuilds the preview.
+         */
+        void set_thumbnail_size(int size);
+        int get_thumbnail_size() const { return thumbnail_size; }
+
+        /**
+         * @brief Returns the last clicked item, -1 if none.
+         */
+        int get_selected() const { return selected; }
+
+        /**
+         * @brief Returns every selected item, in grid order.
+         */
+        godot::PackedInt32Array get_selected_items() const;
+
+        bool is_item_selected(int index) const { return index >= 0 && size_t(index) < selection.size() && selection[index]; }
+
+        void select_all();
+
+        void _gui_input(const godot::Ref<godot::InputEvent>& event) override;
+
+        // Largest preview texture in bytes, thumbnails shrink below the asked size past it
+        static constexpr size_t MAX_PREVIEW_BYTES = size_t(64) << 20;
+
+        // Height reserved for the index below each thumbnail
+        static constexpr int TEXT_HEIGHT = 20;
+
+        // Space around each thumbnail
+        static constexpr int PADDING = 4;
+
+    protected:
+        static void _bind_methods();
+        void _notification(int p_what);
+
+    private:
+        int get_cell_width() const { return thumbnail_size + PADDING * 2; }
+        int get_cell_height() const { return thumbnail_size + TEXT_HEIGHT + PADDING * 2; }
+        int get_columns() const;
+
+        /**
+         * @brief Returns the item under a point of the control, -1 if none.
+         */
+        int get_item_at(const godot::Vector2& pos) const;
+
+        /**
+         * @brief Range [first, last) of the items in view.
+         */
+        void get_visible_range(int& first, int& last) const;
+
+        /**
+         * @brief Updates the scroll bar from the item count and control size.
+         */
+        void update_layout();
+
+        void draw_cells();
+
+        /**
+         * @brief Queues a preview build at the current size, reading the atlas back first if needed.
+         */
+        void start_preview();
+
+        /**
+         * @brief Turns a finished build into the preview texture and releases its task.
+         */
+        void finish_preview();
+
+        /**
+         * @brief Cancels the preview task and waits for it. The current preview is kept.
+         */
+        void stop_preview();
+
+        /**
+         * @brief Preview task body, runs on a worker thread.
+         */
+        void _run_preview();
+
+        void _on_scrolled(double value);
+
+        /**
+         * @brief Applies a click on `index` with the modifiers held, and emits `selection_changed`.
+         */
+        void click_item(int index, bool toggle, bool extend);
+
+        godot::VScrollBar* scroll_bar = nullptr;
+
+        // Atlas of the items and their regions in it, read by the worker
+        godot::Ref<godot::Texture2D> atlas;
+        std::vector<spritecutter::Region> regions;
+
+        int thumbnail_size = 64;
+
+        // Last clicked item, the anchor of Shift+click, and one flag per item
+        int selected = -1;
+        std::vector<uint8_t> selection;
+
+        // Preview on screen and where each item lies in it, main thread only
+        godot::Ref<godot::ImageTexture> preview;
+        std::vector<spritecutter::PreviewRect> preview_rects;
+
+        // Atlas pixels, read back and converted to RGBA8 by the worker, then only touched by
+        // the main thread. Kept between builds when it fits the memory budget, read back again otherwise
+        godot::Ref<godot::Image> source;
+        bool readback_failed = false;
+
+        // Written by the worker, read on the main thread once `built_done` is set
+        spritecutter::PreviewAtlas built;
+        int build_size = 0;
+        bool build_ok = false;
+        std::atomic<bool> built_done{ false };
+
+        // One per build, so a cancelled build never leaks into the next
+        std::unique_ptr<spritecutter::SliceProgress> progress;
+
+        // WorkerThreadPool task id, -1 when no task is pending
+        int64_t task_id = -1;
+};
@@ -0,0 +1,27 @@
+#include "SpriteCutterTaskGroup.h"
+
+#include <godot_cpp/classes/worker_thread_pool.hpp>
+#include <godot_cpp/variant/callable_method_pointer.hpp>
+
+void SpriteCutterTaskGroup::run(int count, const std::function<void(int)>& task, const godot::String& description, int max_threads) {
+    if (count <= 0) return;
+
+    // Not worth a round trip through the pool
+    godot::WorkerThreadPool* pool = godot::WorkerThreadPool::get_singleton();
+    if (count == 1 || max_threads == 1 || !pool) {
+        for (int i = 0; i < count; ++i) task(i);
+        return;
+    }
+
+    SpriteCutterTaskGroup* group = memnew(SpriteCutterTaskGroup);
+    group->task = &task;
+
+    int64_t id = pool->add_group_task(callable_mp(group, &SpriteCutterTaskGroup::_run_task), count, max_threads, true, description);
+    pool->wait_for_group_task_completion(id);
+
+    memdelete(group);
+}
+
+void SpriteCutterTaskGroup::_run_task(int index) {
+    (*task)(index);
+}
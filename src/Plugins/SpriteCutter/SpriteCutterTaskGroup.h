@@ -0,0 +1,43 @@
+#pragma once
+
+#include <functional>
+
+#include <godot_cpp/classes/object.hpp>
+#include <godot_cpp/variant/string.hpp>
+
+/**
+ * @class SpriteCutterTaskGroup
+ * @brief Runs an indexed job on the WorkerThreadPool and waits for it.
+ *
+ * WorkerThreadPool only accepts a Callable, so this small internal Object
+ * 
+ * wraps a C++ function and forwards each group index to it.
+ */
+class SpriteCutterTaskGroup : public godot::Object {
+    GDCLASS(SpriteCutterTaskGroup, godot::Object);
+
+    public:
+        /**
+         * @brief Calls `task(i)` for every `i` in [0, count) and blocks until all calls return.
+         *
+         * Runs inline when there is a single element.
+         *
+         * @param count Number of elements.
+         * @param task Function called once per element, possibly from several threads at once.
+         * @param description Label shown in the debugger for the group task.
+         * @param max_threads Upper bound on threads working on the group, -1 for no limit.
+         */
+        static void run(int count, const std::function<void(int)>& task, const godot::String& description = godot::String(), int max_threads = -1);
+
+    protected:
+        static void _bind_methods() {}
+
+    private:
+        /**
+         * @brief Entry point called by the pool for each element.
+         */
+        void _run_task(int index);
+
+        // Function being dispatched, owned by the caller of run()
+        const std::function<void(int)>* task = nullptr;
+};
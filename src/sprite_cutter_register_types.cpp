@@ -1,10 +1,21 @@
 #include "spritecutter_register_types.h"
 
 void initialize_spritecutter_types(godot::ModuleInitializationLevel p_level) {
+    if (p_level == godot::MODULE_INITIALIZATION_LEVEL_SCENE) {
+        godot::ClassDB::register_internal_class<SpriteCutterTaskGroup>();
+        godot::ClassDB::register_internal_class<SpriteCutterSliceJob>();
+        godot::ClassDB::register_internal_class<SpriteCutterOutlineJob>();
+        godot::ClassDB::register_class<SpriteCutterRegionSet>();
+        godot::ClassDB::register_class<SpriteCutterBatch>();
+        godot::ClassDB::register_class<SpriteCutterBenchmark>();
+        godot::ClassDB::register_class<SpriteCutterRuntimeSlicer>();
+    }
+
     if (p_level == godot::MODULE_INITIALIZATION_LEVEL_EDITOR) {
         godot::ClassDB::register_class<SpriteCutterPlugin>();
         godot::ClassDB::register_class<SpriteCutterDock>();
         godot::ClassDB::register_class<SpriteCutterLeftPanel>();
+        godot::ClassDB::register_class<SpriteCutterSpriteGrid>();
         godot::ClassDB::register_class<SpriteCutterRightPanel>();
     }
 }
@@ -4,9 +4,17 @@
 
 // Plugins
 #include "Plugins/SpriteCutter/SpriteCutterPlugin.h"
+#include "Plugins/SpriteCutter/SpriteCutterBatch.h"
+#include "Plugins/SpriteCutter/SpriteCutterBenchmark.h"
 #include "Plugins/SpriteCutter/SpriteCutterDock.h"
 #include "Plugins/SpriteCutter/SpriteCutterLeftPanel.h"
+#include "Plugins/SpriteCutter/SpriteCutterOutlineJob.h"
+#include "Plugins/SpriteCutter/SpriteCutterRegionSet.h"
 #include "Plugins/SpriteCutter/SpriteCutterRightPanel.h"
+#include "Plugins/SpriteCutter/SpriteCutterRuntimeSlicer.h"
+#include "Plugins/SpriteCutter/SpriteCutterSliceJob.h"
+#include "Plugins/SpriteCutter/SpriteCutterSpriteGrid.h"
+#include "Plugins/SpriteCutter/SpriteCutterTaskGroup.h"
 
 void initialize_spritecutter_types(godot::ModuleInitializationLevel p_level);
 void uninitialize_spritecutter_types(godot::ModuleInitializationLevel p_level);
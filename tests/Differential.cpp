@@ -0,0 +1,295 @@
+#include "Differential.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "AlphaMask.h"
+#include "RegionLabeller.h"
+#include "RegionMerger.h"
+#include "Slicer.h"
+#include "TestRegions.h"
+
+using spritecutter::AlphaMask;
+using spritecutter::PixelView;
+using spritecutter::Region;
+
+namespace difftest {
+
+    namespace {
+        std::string describe(const Region& r) {
+            return "{" + std::to_string(r.x) + ", " + std::to_string(r.y) + ", " + std::to_string(r.w) + ", "
+                + std::to_string(r.h) + ", " + std::to_string(r.count) + "}";
+        }
+
+        // Empty if `got` is `expected`, else the engine and the first region that differs
+        std::string diff(const std::string& engine, const std::vector<Region>& got, const std::vector<Region>& expected) {
+            size_t n = std::min(got.size(), expected.size());
+            for (size_t i = 0; i < n; ++i) {
+                const Region& a = got[i];
+                const Region& b = expected[i];
+                if (!sctest::same_region(a, b))
+                    return engine + ": region " + std::to_string(i) + " is " + describe(a) + ", expected " + describe(b);
+            }
+            if (got.size() != expected.size())
+                return engine + ": " + std::to_string(got.size()) + " regions, expected " + std::to_string(expected.size());
+            return std::string();
+        }
+
+        // Words the mask must hold for row y, tail bits past the width cleared
+        void expected_row(const Sheet& sheet, int y, uint8_t threshold, std::vector<uint64_t>& words) {
+            words.assign((sheet.width + 63) / 64, 0);
+            for (int x = 0; x < sheet.width; ++x) {
+                if (sheet.rgba[(size_t(y) * sheet.width + x) * 4 + 3] > threshold)
+                    words[x >> 6] |= uint64_t(1) << (x & 63);
+            }
+        }
+
+        const char* isa_name(int isa) {
+            return isa == AlphaMask::ISA_AVX2 ? "avx2" : isa == AlphaMask::ISA_SSE2 ? "sse2" : "scalar";
+        }
+
+        // Random int in [lo, hi]
+        int pick(std::mt19937& rng, int lo, int hi) {
+            return lo + int(rng() % uint32_t(hi - lo + 1));
+        }
+    }
+
+    Sheet checkerboard(int w, int h, int cell) {
+        Sheet sheet(w, h);
+        for (int y = 0; y < h; ++y)
+            for (int x = 0; x < w; ++x)
+                if ((x / cell + y / cell) % 2 == 0) sheet.set(x, y);
+        return sheet;
+    }
+
+    Sheet diagonals(int w, int h, int spacing, bool anti) {
+        Sheet sheet(w, h);
+        for (int y = 0; y < h; ++y)
+            for (int x = 0; x < w; ++x)
+                if ((anti ? x + y : x - y + h * spacing) % spacing == 0) sheet.set(x, y);
+        return sheet;
+    }
+
+    Sheet spiral(int w, int h) {
+        // Square spiral with one empty pixel between its turns: a single component
+        // that crosses every tile, band and strip seam several times
+        Sheet sheet(w, h);
+        int l = 0, t = 0, r = w - 1, b = h - 1;
+        int start = 0;
+        while (l <= r && t <= b) {
+            for (int x = start; x <= r; ++x) sheet.set(x, t);
+            for (int y = t; y <= b; ++y) sheet.set(r, y);
+            if (t + 2 > b) break;
+            for (int x = l; x <= r; ++x) sheet.set(x, b);
+            if (l + 2 > r) break;
+            for (int y = t + 2; y <= b; ++y) sheet.set(l, y);
+            start = l + 1;
+            l += 2;
+            t += 2;
+            r -= 2;
+            b -= 2;
+        }
+        return sheet;
+    }
+
+    Sheet seam_sprites(std::mt19937& rng, int w, int h, int seam_rows) {
+        Sheet sheet(w, h);
+        int shapes = 1 + w * h / 300;
+        for (int s = 0; s < shapes; ++s) {
+            // Anchor on or next to a row seam and a word boundary
+            int ay = (h > seam_rows ? pick(rng, 1, h / seam_rows) * seam_rows : pick(rng, 0, h - 1)) + pick(rng, -1, 1);
+            int ax = rng() % 2 ? pick(rng, 0, w / 64) * 64 + pick(rng, -1, 1) : pick(rng, 0, w - 1);
+            switch (rng() % 4) {
+                case 0: {
+                    // Block starting or ending on the anchor
+                    int bw = pick(rng, 1, 5), bh = pick(rng, 1, 5);
+                    int x0 = rng() % 2 ? ax : ax - bw + 1;
+                    int y0 = rng() % 2 ? ay : ay - bh + 1;
+                    for (int y = y0; y < y0 + bh; ++y)
+                        for (int x = x0; x < x0 + bw; ++x) sheet.set(x, y);
+                    break;
+                }
+                case 1:
+                    // Two pixels touching by a corner across the seam
+                    sheet.set(ax - 1, ay - 1);
+                    sheet.set(ax, ay);
+                    break;
+                case 2:
+                    // The other diagonal
+                    sheet.set(ax, ay - 1);
+                    sheet.set(ax - 1, ay);
+                    break;
+                default:
+                    // Vertical stroke through the seam, with a horizontal one through the word boundary
+                    for (int y = ay - 3; y <= ay + 3; ++y) sheet.set(ax, y);
+                    for (int x = ax - 3; x <= ax + 3; ++x) sheet.set(x, ay + 3);
+                    break;
+            }
+        }
+        return sheet;
+    }
+
+    Sheet noise(std::mt19937& rng, int w, int h, float density) {
+        Sheet sheet(w, h);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        for (int y = 0; y < h; ++y)
+            for (int x = 0; x < w; ++x)
+                sheet.set(x, y, uint8_t(unit(rng) < density ? 128 + rng() % 128 : rng() % 128));
+        return sheet;
+    }
+
+    Sheet random_sheet(std::mt19937& rng, EngineParams& params) {
+        static const int edges[] = { 1, 2, 3, 63, 64, 65, 127, 128, 129 };
+        int w = rng() % 2 ? edges[rng() % 9] : pick(rng, 1, 200);
+        int h = rng() % 2 ? edges[rng() % 9] : pick(rng, 1, 150);
+
+        static const uint8_t thresholds[] = { 0, 127, 200 };
+        static const float margins[] = { 0.0f, 0.5f, 1.0f, 2.5f, 5.0f };
+        params.alpha_threshold = thresholds[rng() % 3];
+        params.min_pixels = pick(rng, 0, 6);
+        params.merge_margin = margins[rng() % 5];
+        params.tile_rows = pick(rng, 1, 9);
+        params.threads = pick(rng, 2, 8);
+        params.band_rows = pick(rng, 1, 9);
+        params.strip_rows = pick(rng, 1, 9);
+
+        switch (rng() % 6) {
+            case 0: return checkerboard(w, h, pick(rng, 1, 3));
+            case 1: return diagonals(w, h, pick(rng, 2, 5), rng() % 2);
+            case 2: return spiral(w, h);
+            case 3: return seam_sprites(rng, w, h, params.tile_rows);
+            // The reference merge is cubic, keep the speckled sheets small
+            case 4: return noise(rng, std::min(w, 64), std::min(h, 64), float(rng() % 100) / 100.0f);
+            default: return Sheet(w, h);
+        }
+    }
+
+    bool sheet_from_bytes(const uint8_t* data, size_t size, Sheet& sheet, EngineParams& params) {
+        const size_t header = 8;
+        if (size <= header) return false;
+
+        params.alpha_threshold = data[0];
+        params.min_pixels = data[1] % 8;
+        params.merge_margin = float(data[2] % 17) * 0.5f;
+        params.tile_rows = 1 + data[3] % 16;
+        params.band_rows = 1 + data[4] % 16;
+        params.strip_rows = 1 + data[5] % 16;
+        int w = 1 + data[6];
+        bool bits = data[7] & 1;
+        params.threads = 2 + (data[7] >> 1) % 7;
+
+        // One bit per pixel, set ones are opaque and clear ones sit right at the threshold,
+        // or one alpha byte per pixel
+        const uint8_t* body = data + header;
+        size_t pixels = std::min((size - header) * (bits ? 8 : 1), size_t(1) << 14);
+        int h = int((pixels + w - 1) / w);
+        sheet = Sheet(w, h);
+        for (size_t i = 0; i < pixels; ++i) {
+            uint8_t alpha = bits ? ((body[i >> 3] >> (i & 7)) & 1 ? 255 : params.alpha_threshold) : body[i];
+            sheet.set(int(i % w), int(i / w), alpha);
+        }
+        return true;
+    }
+
+    std::string compare_engines(const Sheet& sheet, const EngineParams& params, const spritecutter::ParallelFor& parallel_for) {
+        const int w = sheet.width, h = sheet.height;
+        const uint8_t threshold = params.alpha_threshold;
+        PixelView view = PixelView::packed(sheet.rgba.data(), w, h, spritecutter::FORMAT_RGBA8);
+
+        // LA8 copy, the other layout with vector kernels
+        std::vector<uint8_t> la(size_t(w) * h * 2);
+        for (size_t i = 0; i < size_t(w) * h; ++i) {
+            la[i * 2] = sheet.rgba[i * 4];
+            la[i * 2 + 1] = sheet.rgba[i * 4 + 3];
+        }
+        PixelView la_view = PixelView::packed(la.data(), w, h, spritecutter::FORMAT_LA8);
+
+        // Every mask kernel against a per-pixel test of the threshold
+        std::string why;
+        AlphaMask mask;
+        AlphaMask::Isa saved = AlphaMask::get_isa();
+        std::vector<uint64_t> words;
+        for (int isa = AlphaMask::ISA_SCALAR; isa <= AlphaMask::detect_isa() && why.empty(); ++isa) {
+            AlphaMask::set_isa(AlphaMask::Isa(isa));
+            for (const PixelView* v : { &view, &la_view }) {
+                std::string engine = std::string("AlphaMask ") + isa_name(isa) + (v == &view ? " RGBA8" : " LA8");
+                AlphaMask built;
+                if (!built.build(*v, threshold)) {
+                    why = engine + ": build failed";
+                    break;
+                }
+                for (int y = 0; y < h && why.empty(); ++y) {
+                    expected_row(sheet, y, threshold, words);
+                    if (std::memcmp(built.get_row(y), words.data(), words.size() * sizeof(uint64_t)) != 0)
+                        why = engine + ": row " + std::to_string(y) + " differs";
+                }
+                if (!why.empty()) break;
+                if (isa == AlphaMask::ISA_SCALAR && v == &view) mask = built;
+            }
+        }
+        AlphaMask::set_isa(saved);
+        if (!why.empty()) return why;
+
+        std::vector<Region> reference;
+        spritecutter::label_regions_reference(mask, params.min_pixels, reference);
+        std::vector<Region> merged = reference;
+        merged.resize(spritecutter::merge_regions_reference(merged.data(), merged.size(), params.merge_margin));
+
+        // Labelling as one tile, then tiled
+        spritecutter::LabelOptions options;
+        options.min_pixels = params.min_pixels;
+        std::vector<Region> got;
+        spritecutter::label_regions(mask, options, got);
+        if (!(why = diff("label_regions", got, reference)).empty()) return why;
+
+        options.threads = params.threads;
+        options.min_tile_rows = params.tile_rows;
+        got.clear();
+        spritecutter::label_regions(mask, options, got, parallel_for);
+        if (!(why = diff("label_regions tiled", got, reference)).empty()) return why;
+
+        // Incremental: from a blank mask only the occupied bands are relabelled, then none
+        spritecutter::IncrementalLabeller labeller(params.band_rows);
+        AlphaMask blank;
+        blank.reset(w, h);
+        got.clear();
+        labeller.label(blank, options, got, parallel_for);
+        if (!(why = diff("IncrementalLabeller blank", got, std::vector<Region>())).empty()) return why;
+        for (const char* engine : { "IncrementalLabeller edited", "IncrementalLabeller reused" }) {
+            got.clear();
+            labeller.label(mask, options, got, parallel_for);
+            if (!(why = diff(engine, got, reference)).empty()) return why;
+        }
+
+        // Strips, each copied out so nothing past it can be read
+        std::vector<uint8_t> strip;
+        spritecutter::StripReader read = [&](int y0, int rows, PixelView& out) {
+            strip.assign(sheet.rgba.begin() + size_t(y0) * w * 4, sheet.rgba.begin() + size_t(y0 + rows) * w * 4);
+            out = PixelView::packed(strip.data(), w, rows, spritecutter::FORMAT_RGBA8);
+            return true;
+        };
+        got.clear();
+        if (!spritecutter::label_strips(w, h, params.strip_rows, read, threshold, options, got))
+            return "label_strips: failed";
+        if (!(why = diff("label_strips", got, reference)).empty()) return why;
+
+        // Fast merge on the reference components
+        got = reference;
+        got.resize(spritecutter::merge_regions(got.data(), got.size(), params.merge_margin));
+        if (!(why = diff("merge_regions", got, merged)).empty()) return why;
+
+        // Whole pipelines, in memory and in strips
+        spritecutter::SliceOptions slice;
+        slice.alpha_threshold = threshold;
+        slice.min_pixels = params.min_pixels;
+        slice.merge_margin = params.merge_margin;
+        slice.min_tile_rows = params.tile_rows;
+        slice.threads = params.threads;
+        if (!spritecutter::slice_pixels(view, slice, got, parallel_for)) return "slice_pixels: failed";
+        if (!(why = diff("slice_pixels", got, merged)).empty()) return why;
+
+        slice.memory_budget = size_t(params.strip_rows) * (size_t(w) * 4 + size_t(w + 63) / 64 * 8);
+        if (!spritecutter::slice_strips(w, h, spritecutter::FORMAT_RGBA8, read, slice, got)) return "slice_strips: failed";
+        return diff("slice_strips", got, merged);
+    }
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "ParallelFor.h"
+
+/**
+ * Differential harness for the slicing engines, shared by the tests and the fuzz target.
+ *
+ * Every engine that turns pixels into regions (mask kernels, tiled and incremental
+ *
+ * labelling, strips, fast merge, whole pipelines) runs on the same sheet and must give
+ *
+ * exactly the regions of label_regions_reference() and merge_regions_reference().
+ */
+namespace difftest {
+
+    /**
+     * @brief RGBA8 pixels, rows packed top to bottom.
+     */
+    struct Sheet {
+        int width = 0;
+        int height = 0;
+        std::vector<uint8_t> rgba;
+
+        Sheet() = default;
+        Sheet(int w, int h) : width(w), height(h), rgba(size_t(w) * h * 4, 0) {}
+
+        void set(int x, int y, uint8_t alpha = 255) {
+            if (x >= 0 && y >= 0 && x < width && y < height) rgba[(size_t(y) * width + x) * 4 + 3] = alpha;
+        }
+    };
+
+    /**
+     * @brief Knobs of the engines under test, set far below their defaults to put seams everywhere.
+     */
+    struct EngineParams {
+        uint8_t alpha_threshold = 0;
+        int min_pixels = 1;
+        float merge_margin = 0.0f;
+
+        // min_tile_rows of the tiled labelling, with `threads` tiles or more
+        int tile_rows = 1;
+        int threads = 8;
+
+        // Band height of the IncrementalLabeller
+        int band_rows = 7;
+
+        // Rows per strip of label_strips() and slice_strips()
+        int strip_rows = 3;
+    };
+
+    // Adversarial shapes
+    Sheet checkerboard(int w, int h, int cell);
+    Sheet diagonals(int w, int h, int spacing, bool anti);
+    Sheet spiral(int w, int h);
+
+    /**
+     * @brief Blocks, strokes and specks that start, end or touch at corners on rows multiple
+     * of `seam_rows` and on the 64-bit word boundaries of the mask.
+     */
+    Sheet seam_sprites(std::mt19937& rng, int w, int h, int seam_rows);
+
+    /**
+     * @brief Random alphas, `density` of them above 127.
+     */
+    Sheet noise(std::mt19937& rng, int w, int h, float density);
+
+    /**
+     * @brief One of the sheets above at a random size, 1-pixel wide and high ones included.
+     */
+    Sheet random_sheet(std::mt19937& rng, EngineParams& params);
+
+    /**
+     * @brief Decodes a fuzzer input into a sheet and engine parameters.
+     *
+     * @return false if the input is too short to describe a sheet.
+     */
+    bool sheet_from_bytes(const uint8_t* data, size_t size, Sheet& sheet, EngineParams& params);
+
+    /**
+     * @brief Runs every engine on `sheet` and compares each result with the references.
+     *
+     * Forces each AlphaMask instruction set the CPU has in turn, then restores the previous one.
+     *
+     * @param parallel_for Scheduler of the tiled engines.
+     * @return An empty string if all agree, else the first engine that doesn't and how.
+     */
+    std::string compare_engines(const Sheet& sheet, const EngineParams& params,
+        const spritecutter::ParallelFor& parallel_for = spritecutter::serial_for);
+}
@@ -0,0 +1,133 @@
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "AlphaMask.h"
+#include "TestFramework.h"
+
+using spritecutter::AlphaMask;
+using spritecutter::PixelView;
+
+namespace {
+    // Expected bit of pixel x given its 8-bit alpha
+    bool mask_matches(const AlphaMask& mask, const std::vector<uint8_t>& alpha, int w, int h, uint8_t threshold) {
+        if (mask.get_width() != w || mask.get_height() != h) return false;
+        for (int y = 0; y < h; ++y)
+            for (int x = 0; x < w; ++x)
+                if (mask.is_set(x, y) != (alpha[size_t(y) * w + x] > threshold)) return false;
+        return true;
+    }
+
+    // Padding bits past the width must stay clear, the labeller reads whole words
+    bool padding_clear(const AlphaMask& mask) {
+        int tail = mask.get_width() & 63;
+        if (tail == 0) return true;
+        for (int y = 0; y < mask.get_height(); ++y)
+            if (mask.get_row(y)[mask.get_words_per_row() - 1] >> tail) return false;
+        return true;
+    }
+}
+
+TEST_CASE("mask: 8-bit formats and threshold") {
+    const int w = 5, h = 2;
+    std::vector<uint8_t> alpha = { 0, 1, 127, 128, 255, 255, 0, 64, 200, 3 };
+
+    std::vector<uint8_t> rgba(size_t(w) * h * 4, 0x55), la(size_t(w) * h * 2, 0x55);
+    for (size_t i = 0; i < alpha.size(); ++i) {
+        rgba[i * 4 + 3] = alpha[i];
+        la[i * 2 + 1] = alpha[i];
+    }
+
+    for (uint8_t t : { 0, 1, 127, 254, 255 }) {
+        AlphaMask m;
+        REQUIRE(m.build(PixelView::packed(rgba.data(), w, h, spritecutter::FORMAT_RGBA8), t));
+        CHECK(mask_matches(m, alpha, w, h, t));
+
+        REQUIRE(m.build(PixelView::packed(la.data(), w, h, spritecutter::FORMAT_LA8), t));
+        CHECK(mask_matches(m, alpha, w, h, t));
+    }
+}
+
+TEST_CASE("mask: wide and float formats") {
+    // RGBA4444 keeps alpha in the low nibble, scaled by 17
+    uint8_t r4[4] = { 0x00, 0xFF, 0x08, 0x00 };
+    AlphaMask m;
+    REQUIRE(m.build(PixelView::packed(r4, 2, 1, spritecutter::FORMAT_RGBA4444), 135));
+    CHECK(!m.is_set(0, 0));
+    CHECK(m.is_set(1, 0));
+
+    // RGBAH: alpha 0.5 (0x3800) and 0 (0x0000)
+    uint16_t rh[8] = { 0, 0, 0, 0x3800, 0, 0, 0, 0 };
+    REQUIRE(m.build(PixelView::packed(reinterpret_cast<uint8_t*>(rh), 2, 1, spritecutter::FORMAT_RGBAH), 100));
+    CHECK(m.is_set(0, 0));
+    CHECK(!m.is_set(1, 0));
+
+    float rf[8] = { 0, 0, 0, 0.2f, 0, 0, 0, 0.9f };
+    REQUIRE(m.build(PixelView::packed(reinterpret_cast<uint8_t*>(rf), 2, 1, spritecutter::FORMAT_RGBAF), 127));
+    CHECK(!m.is_set(0, 0));
+    CHECK(m.is_set(1, 0));
+
+    // Layouts without alpha are fully opaque below 255
+    REQUIRE(m.build(PixelView::packed(nullptr, 70, 2, spritecutter::FORMAT_OPAQUE), 254));
+    CHECK(m.is_set(0, 0) && m.is_set(69, 1));
+    CHECK(padding_clear(m));
+    REQUIRE(m.build(PixelView::packed(nullptr, 70, 2, spritecutter::FORMAT_OPAQUE), 255));
+    CHECK(!m.is_set(0, 0));
+}
+
+TEST_CASE("mask: malformed views are rejected") {
+    uint8_t px[16] = {};
+    AlphaMask m;
+    CHECK(!m.build(PixelView::packed(px, -1, 1, spritecutter::FORMAT_RGBA8)));
+    CHECK(!m.build(PixelView::packed(nullptr, 4, 1, spritecutter::FORMAT_RGBA8)));
+
+    PixelView short_pitch = PixelView::packed(px, 4, 1, spritecutter::FORMAT_RGBA8);
+    short_pitch.row_pitch = 8;
+    CHECK(!m.build(short_pitch));
+
+    CHECK(m.build(PixelView::packed(px, 0, 0, spritecutter::FORMAT_RGBA8)));
+    CHECK(m.get_width() == 0 && m.get_height() == 0);
+}
+
+TEST_CASE("mask: SIMD kernels match scalar") {
+    std::mt19937 rng(7);
+    AlphaMask::Isa best = AlphaMask::detect_isa();
+
+    for (int w : { 1, 15, 16, 17, 31, 32, 33, 63, 64, 65, 100, 257 }) {
+        const int h = 3;
+        // Padded rows check that row_pitch is honoured
+        size_t pitch = size_t(w) * 4 + 12;
+        std::vector<uint8_t> rgba(pitch * h), la(size_t(w) * 2 * h);
+        std::vector<uint8_t> alpha(size_t(w) * h);
+        for (int y = 0; y < h; ++y) {
+            for (int x = 0; x < w; ++x) {
+                // Mostly 0 and 255 like real sprites, with some values around the thresholds
+                uint32_t r = rng();
+                uint8_t a = (r & 3) == 0 ? 0 : (r & 3) == 1 ? 255 : uint8_t(r >> 8);
+                alpha[size_t(y) * w + x] = a;
+                rgba[pitch * y + size_t(x) * 4 + 0] = uint8_t(r >> 16);
+                rgba[pitch * y + size_t(x) * 4 + 3] = a;
+                la[(size_t(y) * w + x) * 2 + 0] = uint8_t(r >> 24);
+                la[(size_t(y) * w + x) * 2 + 1] = a;
+            }
+        }
+        PixelView rgba_view = PixelView::packed(rgba.data(), w, h, spritecutter::FORMAT_RGBA8);
+        rgba_view.row_pitch = pitch;
+        PixelView la_view = PixelView::packed(la.data(), w, h, spritecutter::FORMAT_LA8);
+
+        for (int isa = AlphaMask::ISA_SCALAR; isa <= best; ++isa) {
+            AlphaMask::set_isa(AlphaMask::Isa(isa));
+            for (uint8_t t : { 0, 100, 128, 254 }) {
+                AlphaMask m;
+                REQUIRE(m.build(rgba_view, t));
+                CHECK(mask_matches(m, alpha, w, h, t));
+                CHECK(padding_clear(m));
+
+                REQUIRE(m.build(la_view, t));
+                CHECK(mask_matches(m, alpha, w, h, t));
+                CHECK(padding_clear(m));
+            }
+        }
+    }
+    AlphaMask::set_isa(best);
+}
@@ -0,0 +1,122 @@
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "AtlasPacker.h"
+#include "TestFramework.h"
+
+using spritecutter::PackOptions;
+using spritecutter::PackResult;
+using spritecutter::PixelView;
+using spritecutter::Region;
+
+namespace {
+    std::vector<Region> random_sizes(std::mt19937& rng, int count) {
+        std::vector<Region> regions;
+        for (int i = 0; i < count; ++i) {
+            int kind = rng() % 8;
+            int w = kind == 0 ? 60 + rng() % 200 : 4 + rng() % 60;
+            int h = kind == 0 ? 60 + rng() % 200 : 4 + rng() % 60;
+            regions.push_back({ 0, 0, w, h, w * h });
+        }
+        return regions;
+    }
+
+    // Every sprite, grown by the padding, is inside the atlas and alone
+    bool valid_packing(const std::vector<Region>& regions, const PackResult& result, int padding) {
+        struct Box {
+            int x0, y0, x1, y1;
+        };
+        std::vector<Box> boxes;
+        for (size_t i = 0; i < regions.size(); ++i) {
+            const spritecutter::PackedSprite& s = result.sprites[i];
+            int w = s.rotated ? regions[i].h : regions[i].w;
+            int h = s.rotated ? regions[i].w : regions[i].h;
+            if (s.x < 0 || s.y < 0 || s.x + w > result.width || s.y + h > result.height) return false;
+            boxes.push_back({ s.x, s.y, s.x + w + padding, s.y + h + padding });
+        }
+        for (size_t i = 0; i < boxes.size(); ++i)
+            for (size_t j = i + 1; j < boxes.size(); ++j) {
+                const Box& a = boxes[i];
+                const Box& b = boxes[j];
+                if (a.x0 < b.x1 && b.x0 < a.x1 && a.y0 < b.y1 && b.y0 < a.y1) return false;
+            }
+        return true;
+    }
+}
+
+TEST_CASE("packer: every heuristic gives a valid packing") {
+    std::mt19937 rng(21);
+    std::vector<Region> regions = random_sizes(rng, 300);
+
+    for (int rotate = 0; rotate < 2; ++rotate) {
+        PackOptions options;
+        options.padding = 2;
+        options.allow_rotation = rotate == 1;
+        for (int h = 0; h < spritecutter::PACK_HEURISTIC_COUNT; ++h) {
+            PackResult result;
+            REQUIRE(spritecutter::pack_regions_with(regions, spritecutter::PackHeuristic(h), 1024, options, result));
+            CHECK(result.width <= 1024);
+            CHECK(valid_packing(regions, result, options.padding));
+            if (!rotate)
+                for (const spritecutter::PackedSprite& s : result.sprites) CHECK(!s.rotated);
+        }
+    }
+}
+
+TEST_CASE("packer: best result is dense and the same on any scheduler") {
+    std::mt19937 rng(4);
+    std::vector<Region> regions = random_sizes(rng, 600);
+
+    PackOptions options;
+    PackResult serial, threaded;
+    REQUIRE(spritecutter::pack_regions(regions, options, serial));
+    REQUIRE(spritecutter::pack_regions(regions, options, threaded, spritecutter::thread_for(4)));
+    CHECK(valid_packing(regions, serial, options.padding));
+    CHECK(serial.width == threaded.width && serial.height == threaded.height && serial.heuristic == threaded.heuristic);
+    CHECK(serial.get_fill_ratio() > 0.75);
+}
+
+TEST_CASE("packer: too large for max_side fails") {
+    std::vector<Region> regions = { { 0, 0, 300, 20, 0 } };
+    PackOptions options;
+    options.max_side = 256;
+    PackResult result;
+    CHECK(!spritecutter::pack_regions(regions, options, result));
+
+    // Fits once the limit allows it
+    options.max_side = 310;
+    REQUIRE(spritecutter::pack_regions(regions, options, result));
+    CHECK(result.width == 300 && result.height == 20);
+}
+
+TEST_CASE("packer: blit copies and turns the pixels") {
+    // Two sprites with a distinct value per pixel
+    const int w = 16, h = 8;
+    std::vector<uint8_t> rgba(size_t(w) * h * 4);
+    for (size_t i = 0; i < rgba.size(); ++i) rgba[i] = uint8_t(i * 7 + 1);
+    PixelView view = PixelView::packed(rgba.data(), w, h, spritecutter::FORMAT_RGBA8);
+    std::vector<Region> regions = { { 1, 1, 5, 3, 15 }, { 8, 0, 3, 7, 21 } };
+
+    PackResult result;
+    result.width = 12;
+    result.height = 10;
+    result.sprites = { { 0, 0, false }, { 6, 2, true } };
+
+    std::vector<uint8_t> atlas;
+    REQUIRE(spritecutter::blit_packed(view, regions, result, atlas));
+    REQUIRE(atlas.size() == size_t(12) * 10 * 4);
+
+    auto at = [&](const std::vector<uint8_t>& px, int pitch, int x, int y) { return &px[(size_t(y) * pitch + x) * 4]; };
+    for (int y = 0; y < 3; ++y)
+        for (int x = 0; x < 5; ++x)
+            CHECK(memcmp(at(atlas, 12, x, y), at(rgba, w, 1 + x, 1 + y), 4) == 0);
+
+    // Clockwise: the source's top-left lands top-right
+    for (int y = 0; y < 7; ++y)
+        for (int x = 0; x < 3; ++x)
+            CHECK(memcmp(at(atlas, 12, 6 + 7 - 1 - y, 2 + x), at(rgba, w, 8 + x, y), 4) == 0);
+
+    // Outside the sprites stays transparent
+    CHECK(at(atlas, 12, 11, 9)[3] == 0);
+}
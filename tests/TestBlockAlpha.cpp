@@ -0,0 +1,202 @@
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "BlockAlpha.h"
+#include "TestFramework.h"
+
+using spritecutter::BlockFormat;
+
+namespace {
+    // Writes a block least significant bit first, the way BC7 reads it
+    struct BitWriter {
+        uint8_t bytes[16] = {};
+        int pos = 0;
+
+        BitWriter& put(uint32_t value, int n) {
+            for (int i = 0; i < n; ++i, ++pos)
+                if (i < 32 && ((value >> i) & 1)) bytes[pos >> 3] |= uint8_t(1 << (pos & 7));
+            return *this;
+        }
+    };
+
+    std::vector<uint8_t> decode(BlockFormat format, const uint8_t* block) {
+        std::vector<uint8_t> alpha(16);
+        spritecutter::decode_block_alpha(format, block, alpha.data());
+        return alpha;
+    }
+
+    // Expected coverage of decoded alphas
+    spritecutter::BlockCoverage coverage_of(const std::vector<uint8_t>& alpha, uint8_t threshold) {
+        int above = 0;
+        for (uint8_t a : alpha) above += a > threshold;
+        if (above == 16) return spritecutter::COVERAGE_FULL;
+        return above == 0 ? spritecutter::COVERAGE_NONE : spritecutter::COVERAGE_MIXED;
+    }
+
+    constexpr BlockFormat ALL_FORMATS[] = { spritecutter::BLOCK_BC1, spritecutter::BLOCK_BC2, spritecutter::BLOCK_BC3,
+        spritecutter::BLOCK_BC7, spritecutter::BLOCK_ETC2_RGBA8, spritecutter::BLOCK_ETC2_RGB8A1 };
+}
+
+TEST_CASE("blocks: punch-through formats are settled from the index bits") {
+    // BC1, 3-color mode: index 3 is transparent. Pixels 0 and 5 use it.
+    uint8_t bc1[8] = { 0x00, 0x10, 0x00, 0x20, 0x03, 0x0C, 0x00, 0x00 };
+    std::vector<uint8_t> alpha = decode(spritecutter::BLOCK_BC1, bc1);
+    CHECK(alpha[0] == 0 && alpha[5] == 0 && alpha[1] == 255 && alpha[15] == 255);
+    CHECK(spritecutter::classify_block(spritecutter::BLOCK_BC1, bc1, 0) == spritecutter::COVERAGE_MIXED);
+
+    // Same indices in 4-color mode: opaque
+    std::swap(bc1[1], bc1[3]);
+    CHECK(spritecutter::classify_block(spritecutter::BLOCK_BC1, bc1, 0) == spritecutter::COVERAGE_FULL);
+    CHECK(spritecutter::classify_block(spritecutter::BLOCK_BC1, bc1, 255) == spritecutter::COVERAGE_NONE);
+
+    // ETC2 punch-through, differential mode with the opaque bit clear: index 2 (msb 1, lsb 0)
+    // is transparent. Pixel 1 of the column-major order is x = 0, y = 1.
+    uint8_t etc[8] = { 0x80, 0x80, 0x80, 0x00, 0x00, 0x02, 0x00, 0x00 };
+    alpha = decode(spritecutter::BLOCK_ETC2_RGB8A1, etc);
+    CHECK(alpha[4] == 0);
+    CHECK(alpha[0] == 255 && alpha[1] == 255 && alpha[15] == 255);
+    CHECK(spritecutter::classify_block(spritecutter::BLOCK_ETC2_RGB8A1, etc, 0) == spritecutter::COVERAGE_MIXED);
+
+    // Opaque bit set, then a planar block (only blue overflows): no transparency either way
+    etc[3] = 0x02;
+    CHECK(spritecutter::classify_block(spritecutter::BLOCK_ETC2_RGB8A1, etc, 0) == spritecutter::COVERAGE_FULL);
+    uint8_t planar[8] = { 0x80, 0x80, 0xFB, 0x00, 0x00, 0x02, 0x00, 0x00 };
+    CHECK(spritecutter::classify_block(spritecutter::BLOCK_ETC2_RGB8A1, planar, 0) == spritecutter::COVERAGE_FULL);
+
+    // Every pixel transparent
+    uint8_t clear[8] = { 0x80, 0x80, 0x80, 0x00, 0xFF, 0xFF, 0x00, 0x00 };
+    CHECK(spritecutter::classify_block(spritecutter::BLOCK_ETC2_RGB8A1, clear, 0) == spritecutter::COVERAGE_NONE);
+}
+
+TEST_CASE("blocks: BC3 and EAC endpoints bound the whole block") {
+    // 8-value mode: every value lies in [100, 200]
+    uint8_t bc3[16] = { 200, 100, 0x88, 0x88, 0x88, 0x88, 0x88, 0x88 };
+    CHECK(spritecutter::classify_block(spritecutter::BLOCK_BC3, bc3, 50) == spritecutter::COVERAGE_FULL);
+    CHECK(spritecutter::classify_block(spritecutter::BLOCK_BC3, bc3, 200) == spritecutter::COVERAGE_NONE);
+    CHECK(spritecutter::classify_block(spritecutter::BLOCK_BC3, bc3, 150) == spritecutter::COVERAGE_MIXED);
+
+    // 0x88 bytes give indices 0, 1 and 2 to the first three pixels
+    std::vector<uint8_t> alpha = decode(spritecutter::BLOCK_BC3, bc3);
+    CHECK(alpha[0] == 200 && alpha[1] == 100 && alpha[2] == (6 * 200 + 100) / 7);
+
+    // 6-value mode can reach 0 and 255: never settled from the endpoints
+    uint8_t bc3_six[16] = { 100, 200 };
+    CHECK(spritecutter::classify_block(spritecutter::BLOCK_BC3, bc3_six, 0) == spritecutter::COVERAGE_MIXED);
+
+    // EAC: base 100, multiplier 2, table 13 = { -1, -2, -3, -10, 0, 1, 2, 9 }, values in [80, 118]
+    uint8_t eac[16] = { 100, 0x2D, 0xE0, 0x00, 0x00, 0x00, 0x00, 0x00 };
+    CHECK(spritecutter::classify_block(spritecutter::BLOCK_ETC2_RGBA8, eac, 79) == spritecutter::COVERAGE_FULL);
+    CHECK(spritecutter::classify_block(spritecutter::BLOCK_ETC2_RGBA8, eac, 118) == spritecutter::COVERAGE_NONE);
+    alpha = decode(spritecutter::BLOCK_ETC2_RGBA8, eac);
+    CHECK(alpha[0] == 118 && alpha[4] == 98 && alpha[1] == 98);
+
+    // Multiplier 0: a flat block at the base value
+    eac[1] = 0x0D;
+    CHECK(spritecutter::classify_block(spritecutter::BLOCK_ETC2_RGBA8, eac, 99) == spritecutter::COVERAGE_FULL);
+}
+
+TEST_CASE("blocks: BC7 modes and rotation") {
+    // Modes 0 to 3 carry no alpha
+    uint8_t mode1[16] = { 0x02 };
+    CHECK(spritecutter::classify_block(spritecutter::BLOCK_BC7, mode1, 254) == spritecutter::COVERAGE_FULL);
+
+    // Mode 6, alpha endpoints 0 and 255, index i on pixel i
+    BitWriter m6;
+    m6.put(1 << 6, 7).put(0, 42).put(0, 7).put(127, 7).put(0, 1).put(1, 1);
+    for (int i = 0; i < 16; ++i) m6.put(uint32_t(i), i == 0 ? 3 : 4);
+    std::vector<uint8_t> alpha = decode(spritecutter::BLOCK_BC7, m6.bytes);
+    CHECK(alpha[0] == 0 && alpha[15] == 255 && alpha[8] == (34 * 255 + 32) >> 6);
+    CHECK(spritecutter::classify_block(spritecutter::BLOCK_BC7, m6.bytes, 0) == spritecutter::COVERAGE_MIXED);
+
+    // Mode 5, alpha 240..250 without rotation: settled. Rotation 1 takes alpha from red (0..255).
+    auto mode5 = [](uint32_t rotation) {
+        BitWriter w;
+        w.put(1 << 5, 6).put(rotation, 2).put(0, 7).put(127, 7).put(0, 28).put(240, 8).put(250, 8);
+        for (int i = 0; i < 16; ++i) w.put(i & 3, i == 0 ? 1 : 2);
+        for (int i = 0; i < 16; ++i) w.put(3, i == 0 ? 1 : 2);
+        return w;
+    };
+    BitWriter plain = mode5(0), rotated = mode5(1);
+    CHECK(spritecutter::classify_block(spritecutter::BLOCK_BC7, plain.bytes, 200) == spritecutter::COVERAGE_FULL);
+    CHECK(decode(spritecutter::BLOCK_BC7, plain.bytes)[1] == 250);
+    CHECK(spritecutter::classify_block(spritecutter::BLOCK_BC7, rotated.bytes, 200) == spritecutter::COVERAGE_MIXED);
+    alpha = decode(spritecutter::BLOCK_BC7, rotated.bytes);
+    CHECK(alpha[0] == 0 && alpha[3] == 255 && alpha[1] == (21 * 255 + 32) >> 6);
+
+    // Mode 7, partition 13 (top half subset 0, bottom half subset 1): transparent top, opaque bottom
+    BitWriter m7;
+    m7.put(1 << 7, 8).put(13, 6).put(0, 60).put(0, 5).put(0, 5).put(31, 5).put(31, 5).put(0, 1).put(0, 1).put(1, 1).put(1, 1);
+    alpha = decode(spritecutter::BLOCK_BC7, m7.bytes);
+    CHECK(alpha[0] == 0 && alpha[7] == 0 && alpha[8] == 255 && alpha[15] == 255);
+
+    // Reserved mode: transparent black
+    uint8_t reserved[16] = {};
+    CHECK(spritecutter::classify_block(spritecutter::BLOCK_BC7, reserved, 0) == spritecutter::COVERAGE_NONE);
+}
+
+TEST_CASE("blocks: classification agrees with decoding") {
+    std::mt19937 rng(7);
+    for (BlockFormat format : ALL_FORMATS) {
+        for (int n = 0; n < 4000; ++n) {
+            uint8_t block[16];
+            for (uint8_t& b : block) b = uint8_t(rng());
+            // Skew towards flat alpha so settled blocks come up often
+            if (n & 1) {
+                block[0] = block[1] = uint8_t(n & 2 ? 0 : 255);
+                if (format == spritecutter::BLOCK_BC1) block[1] = 0x80;
+            }
+
+            std::vector<uint8_t> alpha = decode(format, block);
+            for (int threshold : { 0, 127, 254, 255 }) {
+                spritecutter::BlockCoverage c = spritecutter::classify_block(format, block, uint8_t(threshold));
+                if (c != spritecutter::COVERAGE_MIXED && c != coverage_of(alpha, uint8_t(threshold))) {
+                    CHECK(!"classification contradicts the decoded block");
+                    return;
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("blocks: mask matches per-pixel decoding, in parallel and clipped") {
+    const int w = 37, h = 22;
+    std::mt19937 rng(11);
+    for (BlockFormat format : ALL_FORMATS) {
+        spritecutter::BlockView view;
+        view.width = w;
+        view.height = h;
+        view.format = format;
+        std::vector<uint8_t> data(view.get_size());
+        for (uint8_t& b : data) b = uint8_t(rng());
+        view.data = data.data();
+
+        spritecutter::AlphaMask mask;
+        spritecutter::BlockMaskStats stats;
+        REQUIRE(spritecutter::build_block_mask(view, 100, mask, spritecutter::thread_for(4), 3, &stats));
+        CHECK(stats.empty + stats.full + stats.decoded == size_t(view.get_blocks_x() * view.get_blocks_y()));
+
+        bool same = true;
+        size_t bytes = spritecutter::block_size(format);
+        for (int by = 0; by < view.get_blocks_y(); ++by)
+            for (int bx = 0; bx < view.get_blocks_x(); ++bx) {
+                std::vector<uint8_t> alpha = decode(format, data.data() + (size_t(by) * view.get_blocks_x() + bx) * bytes);
+                for (int i = 0; i < 16; ++i) {
+                    int x = bx * 4 + (i & 3), y = by * 4 + (i >> 2);
+                    if (x < w && y < h) same = same && mask.is_set(x, y) == (alpha[i] > 100);
+                }
+            }
+        CHECK(same);
+
+        // Nothing past the width
+        bool padding = true;
+        for (int y = 0; y < h; ++y) padding = padding && (mask.get_row(y)[0] >> w) == 0;
+        CHECK(padding);
+    }
+
+    spritecutter::AlphaMask mask;
+    spritecutter::BlockView missing;
+    missing.width = 4;
+    missing.height = 4;
+    CHECK(!spritecutter::build_block_mask(missing, 0, mask));
+}
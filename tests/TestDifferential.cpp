@@ -0,0 +1,79 @@
+#include <cstdio>
+#include <random>
+#include <string>
+
+#include "Differential.h"
+#include "TestFramework.h"
+
+using difftest::EngineParams;
+using difftest::Sheet;
+
+namespace {
+    // Checks one sheet and prints what disagreed, with enough to replay it
+    bool agree(const Sheet& sheet, const EngineParams& params, const char* what,
+        const spritecutter::ParallelFor& parallel_for = spritecutter::serial_for) {
+        std::string why = difftest::compare_engines(sheet, params, parallel_for);
+        if (why.empty()) return true;
+        std::fprintf(stderr, "%s %dx%d, threshold %d, tile rows %d, band rows %d, strip rows %d: %s\n", what,
+            sheet.width, sheet.height, params.alpha_threshold, params.tile_rows, params.band_rows, params.strip_rows, why.c_str());
+        return false;
+    }
+}
+
+TEST_CASE("diff: adversarial shapes agree across engines") {
+    std::mt19937 rng(41);
+    const int sizes[][2] = { { 1, 1 }, { 1, 200 }, { 200, 1 }, { 2, 90 }, { 64, 64 }, { 65, 63 }, { 129, 97 } };
+    for (const auto& size : sizes) {
+        int w = size[0], h = size[1];
+        for (int rows : { 1, 7, 64 }) {
+            EngineParams params;
+            params.tile_rows = rows;
+            params.band_rows = rows;
+            params.strip_rows = rows;
+            CHECK(agree(difftest::checkerboard(w, h, 1), params, "checkerboard"));
+            CHECK(agree(difftest::checkerboard(w, h, 2), params, "checkerboard 2"));
+            CHECK(agree(difftest::diagonals(w, h, 3, false), params, "diagonals"));
+            CHECK(agree(difftest::diagonals(w, h, 2, true), params, "anti-diagonals"));
+            CHECK(agree(difftest::spiral(w, h), params, "spiral"));
+            CHECK(agree(difftest::seam_sprites(rng, w, h, rows), params, "seam sprites"));
+            CHECK(agree(Sheet(w, h), params, "empty"));
+
+            params.merge_margin = 2.0f;
+            params.min_pixels = 3;
+            CHECK(agree(difftest::seam_sprites(rng, w, h, rows), params, "seam sprites, merged"));
+        }
+    }
+
+    // Everything opaque, and alphas right at the threshold
+    Sheet full(130, 70);
+    for (int y = 0; y < 70; ++y)
+        for (int x = 0; x < 130; ++x) full.set(x, y, uint8_t(x % 2 ? 200 : 201));
+    EngineParams params;
+    params.alpha_threshold = 200;
+    CHECK(agree(full, params, "threshold stripes"));
+    params.alpha_threshold = 0;
+    CHECK(agree(full, params, "full"));
+}
+
+TEST_CASE("diff: random sheets agree across engines") {
+    std::mt19937 rng(43);
+    spritecutter::ParallelFor threads = spritecutter::thread_for(4);
+    for (int round = 0; round < 150; ++round) {
+        EngineParams params;
+        Sheet sheet = difftest::random_sheet(rng, params);
+        CHECK(agree(sheet, params, "random", round % 10 == 0 ? threads : spritecutter::ParallelFor(spritecutter::serial_for)));
+    }
+}
+
+TEST_CASE("diff: fuzzer inputs decode to bounded sheets") {
+    uint8_t input[64] = { 10, 2, 4, 3, 5, 6, 15, 1 };
+    for (int i = 8; i < 64; ++i) input[i] = uint8_t(i * 37);
+
+    Sheet sheet;
+    EngineParams params;
+    CHECK(!difftest::sheet_from_bytes(input, 8, sheet, params));
+    REQUIRE(difftest::sheet_from_bytes(input, sizeof(input), sheet, params));
+    CHECK(sheet.width == 16 && sheet.height == 28);
+    CHECK(params.alpha_threshold == 10 && params.merge_margin == 2.0f);
+    CHECK(agree(sheet, params, "fuzzer input"));
+}
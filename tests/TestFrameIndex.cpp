@@ -0,0 +1,152 @@
+#include <random>
+#include <vector>
+
+#include "FrameIndex.h"
+#include "TestFramework.h"
+
+using spritecutter::FrameHash;
+using spritecutter::FrameIndex;
+using spritecutter::FrameMatch;
+using spritecutter::FrameRef;
+using spritecutter::PixelView;
+using spritecutter::Region;
+
+namespace {
+    struct Sheet {
+        int width, height;
+        std::vector<uint8_t> rgba;
+
+        Sheet(int w, int h) : width(w), height(h), rgba(size_t(w) * h * 4, 0) {}
+
+        uint8_t* at(int x, int y) { return &rgba[(size_t(y) * width + x) * 4]; }
+        PixelView view() const { return PixelView::packed(rgba.data(), width, height, spritecutter::FORMAT_RGBA8); }
+    };
+
+    // Paints a seeded pattern of opaque pixels into a `w` x `h` frame at (x, y)
+    Region paint(Sheet& sheet, int x, int y, int w, int h, unsigned seed) {
+        std::mt19937 rng(seed);
+        int count = 0;
+        for (int j = 0; j < h; ++j) {
+            for (int i = 0; i < w; ++i) {
+                uint8_t* p = sheet.at(x + i, y + j);
+                bool opaque = (i * i + j * j + int(rng() % 40)) % 5 != 0;
+                p[0] = uint8_t(rng());
+                p[1] = uint8_t(i * 255 / w);
+                p[2] = uint8_t(j * 255 / h);
+                p[3] = opaque ? 255 : 0;
+                count += opaque;
+            }
+        }
+        return { x, y, w, h, count };
+    }
+
+    FrameRef add(FrameIndex& index, int sheet, int i, const Region& r, const FrameHash& h, FrameMatch& match) {
+        return index.find_or_add(sheet, i, r, h, match);
+    }
+}
+
+TEST_CASE("frames: identical frames share the exact hash, others don't") {
+    Sheet sheet(256, 64);
+    std::vector<Region> regions = {
+        paint(sheet, 0, 0, 40, 40, 1),
+        paint(sheet, 50, 0, 40, 40, 1),
+        paint(sheet, 100, 0, 40, 40, 2),
+        paint(sheet, 150, 0, 41, 40, 1),
+    };
+
+    std::vector<FrameHash> hashes;
+    REQUIRE(spritecutter::hash_frames(sheet.view(), regions, hashes, spritecutter::thread_for(3), 3));
+    REQUIRE(hashes.size() == 4);
+    CHECK(hashes[0].exact == hashes[1].exact);
+    CHECK(hashes[0].perceptual == hashes[1].perceptual);
+    CHECK(hashes[0].mean == hashes[1].mean);
+    CHECK(hashes[0].exact != hashes[2].exact);
+    CHECK(hashes[0].exact != hashes[3].exact);
+}
+
+TEST_CASE("frames: copies fold into the first frame across sheets") {
+    Sheet a(128, 64), b(128, 64);
+    std::vector<Region> ra = { paint(a, 0, 0, 30, 30, 7), paint(a, 40, 0, 30, 30, 8), paint(a, 80, 0, 30, 30, 7) };
+    std::vector<Region> rb = { paint(b, 10, 10, 30, 30, 8), paint(b, 60, 10, 30, 30, 9) };
+    std::vector<FrameHash> ha, hb;
+    REQUIRE(spritecutter::hash_frames(a.view(), ra, ha));
+    REQUIRE(spritecutter::hash_frames(b.view(), rb, hb));
+
+    FrameIndex index(0);
+    int sa = index.add_sheet(), sb = index.add_sheet();
+    FrameMatch match;
+    FrameRef r = add(index, sa, 0, ra[0], ha[0], match);
+    CHECK(match == spritecutter::FRAME_UNIQUE && r.sheet == sa && r.index == 0);
+    add(index, sa, 1, ra[1], ha[1], match);
+    CHECK(match == spritecutter::FRAME_UNIQUE);
+    r = add(index, sa, 2, ra[2], ha[2], match);
+    CHECK(match == spritecutter::FRAME_EXACT && r.sheet == sa && r.index == 0);
+    r = add(index, sb, 0, rb[0], hb[0], match);
+    CHECK(match == spritecutter::FRAME_EXACT && r.sheet == sa && r.index == 1);
+    r = add(index, sb, 1, rb[1], hb[1], match);
+    CHECK(match == spritecutter::FRAME_UNIQUE && r.sheet == sb && r.index == 1);
+    CHECK(index.size() == 3);
+
+    // Forgotten sheets no longer answer
+    index.remove_sheet(sa);
+    CHECK(index.size() == 1);
+    int sa2 = index.add_sheet();
+    r = add(index, sa2, 0, ra[1], ha[1], match);
+    CHECK(match == spritecutter::FRAME_UNIQUE && r.sheet == sa2);
+}
+
+TEST_CASE("frames: slightly altered frames are near duplicates") {
+    Sheet sheet(256, 64);
+    std::vector<Region> regions = { paint(sheet, 0, 0, 48, 48, 3), paint(sheet, 60, 0, 48, 48, 3), paint(sheet, 120, 0, 48, 48, 4) };
+
+    // A few recolored pixels: a re-export, not the same bytes
+    for (int i = 0; i < 6; ++i) {
+        uint8_t* p = sheet.at(60 + 5 + i * 7, 20 + i);
+        p[0] = uint8_t(p[0] ^ 0x10);
+    }
+
+    std::vector<FrameHash> hashes;
+    REQUIRE(spritecutter::hash_frames(sheet.view(), regions, hashes));
+    CHECK(hashes[0].exact != hashes[1].exact);
+    CHECK(spritecutter::hamming_distance(hashes[0].perceptual, hashes[1].perceptual) <= 3);
+
+    FrameIndex exact_only(0), near(3);
+    FrameMatch match;
+    for (FrameIndex* index : { &exact_only, &near }) {
+        int s = index->add_sheet();
+        add(*index, s, 0, regions[0], hashes[0], match);
+        FrameRef r = add(*index, s, 1, regions[1], hashes[1], match);
+        if (index == &near) CHECK(match == spritecutter::FRAME_NEAR && r.index == 0);
+        else CHECK(match == spritecutter::FRAME_UNIQUE);
+        add(*index, s, 2, regions[2], hashes[2], match);
+        CHECK(match == spritecutter::FRAME_UNIQUE);
+    }
+}
+
+TEST_CASE("frames: the banded lookup finds every pair within the distance") {
+    std::mt19937_64 rng(11);
+    FrameIndex index(3);
+    int s = index.add_sheet();
+    FrameMatch match;
+
+    // Same size and color, only the perceptual bits tell the frames apart
+    std::vector<FrameHash> seeds;
+    for (int i = 0; i < 200; ++i) {
+        FrameHash h;
+        h.exact = rng();
+        h.perceptual = rng();
+        h.mean = 0x80808080u;
+        seeds.push_back(h);
+        add(index, s, i, Region{ 0, 0, 16, 16, 256 }, h, match);
+        CHECK(match == spritecutter::FRAME_UNIQUE);
+    }
+
+    for (int i = 0; i < 200; ++i) {
+        FrameHash h = seeds[i];
+        h.exact = rng();
+        for (int flip = 0; flip < 3; ++flip) h.perceptual ^= uint64_t(1) << (rng() % 64);
+        FrameRef r = add(index, s, 1000 + i, Region{ 0, 0, 16, 16, 256 }, h, match);
+        CHECK(match == spritecutter::FRAME_NEAR);
+        CHECK(r.index == i);
+    }
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <vector>
+
+/**
+ * Minimal self-registering test runner for the Godot-independent core.
+ *
+ * TEST_CASE(name) defines and registers a test, CHECK(cond) records a failure
+ * without stopping it, REQUIRE(cond) records the failure and returns.
+ *
+ * TestMain.cpp replaces every global operator new and delete to count heap allocations, see allocations().
+ */
+namespace sctest {
+
+    struct TestCase {
+        const char* name;
+        void (*fn)();
+    };
+
+    inline std::vector<TestCase>& registry() {
+        static std::vector<TestCase> tests;
+        return tests;
+    }
+
+    inline int& failures() {
+        static int count = 0;
+        return count;
+    }
+
+    struct Registrar {
+        Registrar(const char* name, void (*fn)()) { registry().push_back({ name, fn }); }
+    };
+
+    /**
+     * @brief Number of global operator new calls so far, from every thread.
+     */
+    inline std::atomic<size_t>& allocations() {
+        static std::atomic<size_t> count{ 0 };
+        return count;
+    }
+
+    inline void report(const char* file, int line, const char* expr) {
+        std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expr);
+        ++failures();
+    }
+}
+
+#define SCTEST_CAT2(a, b) a##b
+#define SCTEST_CAT(a, b) SCTEST_CAT2(a, b)
+
+#define TEST_CASE(name)                                                                     \
+    static void SCTEST_CAT(sctest_fn_, __LINE__)();                                         \
+    static sctest::Registrar SCTEST_CAT(sctest_reg_, __LINE__)(name, &SCTEST_CAT(sctest_fn_, __LINE__)); \
+    static void SCTEST_CAT(sctest_fn_, __LINE__)()
+
+#define CHECK(cond) \
+    do { if (!(cond)) sctest::report(__FILE__, __LINE__, #cond); } while (0)
+
+#define REQUIRE(cond) \
+    do { if (!(cond)) { sctest::report(__FILE__, __LINE__, #cond); return; } } while (0)
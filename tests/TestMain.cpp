@@ -0,0 +1,88 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include "TestFramework.h"
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+// Every form of operator new is counted, so tests can check that warm buffers are
+// reused, see sctest::allocations(). Each delete frees with the function its new
+// allocated with, which sanitizers check.
+namespace {
+    void* allocate(std::size_t size) noexcept {
+        sctest::allocations().fetch_add(1, std::memory_order_relaxed);
+        return std::malloc(size ? size : 1);
+    }
+
+    void* allocate_aligned(std::size_t size, std::align_val_t align) noexcept {
+        sctest::allocations().fetch_add(1, std::memory_order_relaxed);
+        std::size_t a = std::max(static_cast<std::size_t>(align), sizeof(void*));
+#ifdef _WIN32
+        return _aligned_malloc(size ? size : 1, a);
+#else
+        void* p = nullptr;
+        return posix_memalign(&p, a, size ? size : 1) == 0 ? p : nullptr;
+#endif
+    }
+
+    void release_aligned(void* p) noexcept {
+#ifdef _WIN32
+        _aligned_free(p);
+#else
+        std::free(p);
+#endif
+    }
+
+    void* checked(void* p) {
+        if (!p) throw std::bad_alloc();
+        return p;
+    }
+}
+
+void* operator new(std::size_t size) { return checked(allocate(size)); }
+void* operator new[](std::size_t size) { return checked(allocate(size)); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+void* operator new(std::size_t size, std::align_val_t align) { return checked(allocate_aligned(size, align)); }
+void* operator new[](std::size_t size, std::align_val_t align) { return checked(allocate_aligned(size, align)); }
+void* operator new(std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept { return allocate_aligned(size, align); }
+void* operator new[](std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept { return allocate_aligned(size, align); }
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { release_aligned(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { release_aligned(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { release_aligned(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { release_aligned(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { release_aligned(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { release_aligned(p); }
+
+// Runs every registered test, or only those whose name contains argv[1]
+int main(int argc, char** argv) {
+    const char* filter = argc > 1 ? argv[1] : nullptr;
+    int ran = 0;
+
+    for (const sctest::TestCase& t : sctest::registry()) {
+        if (filter && !std::strstr(t.name, filter)) continue;
+
+        int before = sctest::failures();
+        auto start = std::chrono::steady_clock::now();
+        t.fn();
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        std::printf("[%s] %s (%.1f ms)\n", sctest::failures() == before ? " OK " : "FAIL", t.name, ms);
+        ++ran;
+    }
+
+    std::printf("%d test(s), %d failed check(s)\n", ran, sctest::failures());
+    return sctest::failures() == 0 ? 0 : 1;
+}
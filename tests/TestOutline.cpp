@@ -0,0 +1,121 @@
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "Outline.h"
+#include "TestFramework.h"
+
+using spritecutter::AlphaMask;
+using spritecutter::Outline;
+using spritecutter::OutlineOptions;
+using spritecutter::PixelView;
+using spritecutter::Region;
+
+namespace {
+    AlphaMask to_mask(const std::vector<uint8_t>& opaque, int w, int h) {
+        std::vector<uint8_t> la(opaque.size() * 2, 0);
+        for (size_t i = 0; i < opaque.size(); ++i) la[i * 2 + 1] = opaque[i] ? 255 : 0;
+
+        AlphaMask mask;
+        mask.build(PixelView::packed(la.data(), w, h, spritecutter::FORMAT_LA8));
+        return mask;
+    }
+
+    // Overlapping discs and a stray speck, like a hand-drawn sprite
+    std::vector<uint8_t> blob_sheet(std::mt19937& rng, int w, int h) {
+        std::vector<uint8_t> opaque(size_t(w) * h, 0);
+        for (int d = 0; d < 4; ++d) {
+            int cx = 10 + rng() % (w - 20), cy = 10 + rng() % (h - 20), radius = 3 + rng() % 12;
+            for (int y = 0; y < h; ++y)
+                for (int x = 0; x < w; ++x)
+                    if ((x - cx) * (x - cx) + (y - cy) * (y - cy) <= radius * radius) opaque[size_t(y) * w + x] = 1;
+        }
+        opaque[rng() % opaque.size()] = 1;
+        return opaque;
+    }
+
+    long long twice_area(const Outline& o) {
+        long long a = 0;
+        for (size_t i = 0; i < o.size(); ++i) {
+            const spritecutter::OutlinePoint& p = o[i];
+            const spritecutter::OutlinePoint& q = o[(i + 1) % o.size()];
+            a += (long long)p.x * q.y - (long long)q.x * p.y;
+        }
+        return a;
+    }
+}
+
+TEST_CASE("outline: a full rectangle gives its four corners") {
+    const int w = 20, h = 10;
+    std::vector<uint8_t> opaque(size_t(w) * h, 0);
+    for (int y = 2; y < 8; ++y)
+        for (int x = 3; x < 15; ++x) opaque[size_t(y) * w + x] = 1;
+    AlphaMask mask = to_mask(opaque, w, h);
+
+    OutlineOptions options;
+    options.epsilon = 0.0f;
+    Outline outline;
+    spritecutter::trace_outline(mask, { 3, 2, 12, 6, 72 }, options, outline);
+    REQUIRE(outline.size() == 4);
+    CHECK(outline[0].x == 0 && outline[0].y == 0);
+    CHECK(outline[2].x == 12 && outline[2].y == 6);
+
+    // Clockwise with y down
+    CHECK(twice_area(outline) > 0);
+}
+
+TEST_CASE("outline: an L shape is traced exactly without tolerance") {
+    const int w = 8, h = 8;
+    std::vector<uint8_t> opaque(size_t(w) * h, 0);
+    for (int y = 0; y < 8; ++y) opaque[size_t(y) * w] = opaque[size_t(y) * w + 1] = 1;
+    for (int x = 0; x < 8; ++x) opaque[size_t(7) * w + x] = 1;
+    AlphaMask mask = to_mask(opaque, w, h);
+
+    OutlineOptions options;
+    options.epsilon = 0.0f;
+    Outline outline;
+    Region r{ 0, 0, 8, 8, 22 };
+    spritecutter::trace_outline(mask, r, options, outline);
+    CHECK(outline.size() == 6);
+    CHECK(twice_area(outline) == 2 * 22);
+    CHECK(spritecutter::outline_covers(mask, r, outline));
+}
+
+TEST_CASE("outline: random blobs are covered within the vertex budget") {
+    std::mt19937 rng(17);
+    for (int round = 0; round < 40; ++round) {
+        const int w = 64, h = 48;
+        std::vector<uint8_t> opaque = blob_sheet(rng, w, h);
+        AlphaMask mask = to_mask(opaque, w, h);
+        Region r{ 0, 0, w, h, 0 };
+
+        OutlineOptions options;
+        options.epsilon = float(rng() % 4);
+        options.max_vertices = 6 + rng() % 20;
+        Outline outline;
+        spritecutter::trace_outline(mask, r, options, outline);
+        CHECK((int)outline.size() <= options.max_vertices);
+        CHECK(outline.size() >= 3);
+        CHECK(spritecutter::outline_covers(mask, r, outline));
+        for (const spritecutter::OutlinePoint& p : outline) CHECK(p.x >= 0 && p.y >= 0 && p.x <= w && p.y <= h);
+    }
+}
+
+TEST_CASE("outline: cuts the empty corners of a diamond") {
+    const int w = 41, h = 41;
+    std::vector<uint8_t> opaque(size_t(w) * h, 0);
+    for (int y = 0; y < h; ++y)
+        for (int x = 0; x < w; ++x)
+            if (std::abs(x - 20) + std::abs(y - 20) <= 20) opaque[size_t(y) * w + x] = 1;
+    AlphaMask mask = to_mask(opaque, w, h);
+
+    std::vector<Region> regions = { { 0, 0, w, h, 0 }, { 0, 0, 20, 20, 0 } };
+    std::vector<Outline> outlines;
+    REQUIRE(spritecutter::trace_outlines(mask, regions, OutlineOptions(), outlines, spritecutter::thread_for(2), 2));
+    REQUIRE(outlines.size() == 2);
+
+    // The diamond is half of its rectangle, the grown outline not much more
+    CHECK(twice_area(outlines[0]) < 2 * w * h * 2 / 3);
+    CHECK(spritecutter::outline_covers(mask, regions[0], outlines[0]));
+    CHECK(spritecutter::outline_covers(mask, regions[1], outlines[1]));
+}
@@ -0,0 +1,215 @@
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "AlphaMask.h"
+#include "Inflate.h"
+#include "PngReader.h"
+#include "TestFramework.h"
+
+using spritecutter::PngReader;
+
+namespace {
+    // Encoded with Python's zlib: the RGBA file has a dynamic Huffman block split over
+    // three IDAT chunks and cycles the five row filters, the others use fixed codes.
+    const uint8_t RGBA_PNG[] = {
+        0x89, 0x50, 0x4E, 0x47, 0x0D, 0x0A, 0x1A, 0x0A, 0x00, 0x00, 0x00, 0x0D, 0x49, 0x48, 0x44, 0x52, 0x00, 0x00, 0x00, 0x20,
+        0x00, 0x00, 0x00, 0x18, 0x08, 0x06, 0x00, 0x00, 0x00, 0x9B, 0x53, 0xFF, 0x34, 0x00, 0x00, 0x00, 0x80, 0x49, 0x44, 0x41,
+        0x54, 0x78, 0xDA, 0xDD, 0xD5, 0xB1, 0x4B, 0x02, 0x51, 0x1C, 0xC0, 0xF1, 0xE7, 0xDD, 0xD9, 0xD0, 0x22, 0x44, 0x4B, 0x4B,
+        0x04, 0x2D, 0x2D, 0x0D, 0x39, 0x19, 0x58, 0x58, 0x41, 0xF4, 0x27, 0x34, 0x3A, 0x04, 0x1A, 0x44, 0x10, 0x45, 0x08, 0x22,
+        0x48, 0x20, 0x42, 0xB4, 0xB4, 0xB4, 0xB4, 0xB4, 0x04, 0x51, 0x04, 0x51, 0x44, 0x8E, 0xED, 0xFE, 0x07, 0xCD, 0x81, 0x28,
+        0x12, 0x44, 0xE0, 0xDC, 0xF7, 0xC0, 0x2D, 0xFC, 0xFD, 0x0E, 0x7E, 0x27, 0x17, 0x3E, 0xF8, 0x1C, 0x07, 0x72, 0xEF, 0x1E,
+        0xCF, 0xAF, 0x4F, 0x57, 0xA8, 0xBF, 0x3B, 0xA4, 0x31, 0x8D, 0x0C, 0x66, 0x31, 0x87, 0x79, 0x2C, 0x0E, 0x3F, 0xB7, 0xA8,
+        0xA0, 0x86, 0x33, 0x34, 0x71, 0x81, 0x4B, 0x5C, 0xE1, 0x3A, 0xC5, 0xC5, 0x77, 0xCE, 0xA5, 0x05, 0x1F, 0xCE, 0x36, 0xAA,
+        0xD2, 0xFC, 0x1E, 0x17, 0x5F, 0x61, 0x1D, 0xE2, 0xFC, 0x36, 0xC2, 0x3E, 0x78, 0x00, 0x00, 0x00, 0x80, 0x49, 0x44, 0x41,
+        0x54, 0xFE, 0x42, 0xA1, 0x38, 0xC5, 0x4D, 0x20, 0xE8, 0x19, 0x17, 0xB0, 0x29, 0xCD, 0x1F, 0x24, 0xBD, 0x03, 0x6E, 0x44,
+        0x78, 0x4B, 0x58, 0x46, 0x36, 0x86, 0x08, 0xFF, 0x84, 0x87, 0x1B, 0xDC, 0xE2, 0x3E, 0x8C, 0x70, 0x46, 0x89, 0xB0, 0x6D,
+        0xDC, 0x81, 0xF3, 0x7F, 0x1F, 0xE1, 0x80, 0x9B, 0x1F, 0x7C, 0xE3, 0x0B, 0x7D, 0x74, 0xD1, 0xC1, 0x67, 0x84, 0x17, 0x94,
+        0xB1, 0x8A, 0x3C, 0xD6, 0xB1, 0x81, 0x2D, 0x6C, 0x63, 0x07, 0x27, 0x78, 0xC3, 0x2B, 0x9E, 0xF1, 0x84, 0x47, 0x3C, 0xE0,
+        0x2E, 0x18, 0x7B, 0x64, 0xDA, 0x88, 0x21, 0xB2, 0x43, 0x1C, 0x0B, 0x27, 0x9E, 0xF8, 0x7C, 0x18, 0xA1, 0x75, 0x07, 0x8E,
+        0x94, 0x88, 0x0F, 0xA4, 0x87, 0xBD, 0xA4, 0xBF, 0x82, 0x30, 0x42, 0xEB, 0x02, 0xD6, 0x94, 0x93, 0xF4, 0x45, 0x7A, 0x78,
+        0x22, 0x22, 0x1C, 0xF9, 0x57, 0x3B, 0x3C, 0xF1, 0xCC, 0x28, 0x67, 0x93, 0x92, 0x00, 0x00, 0x00, 0x35, 0x49, 0x44, 0x41,
+        0x54, 0x11, 0xEE, 0x2A, 0x91, 0x35, 0x2C, 0xDB, 0xE7, 0x8D, 0x7D, 0x8B, 0x63, 0x88, 0x70, 0x45, 0x89, 0xCC, 0xF4, 0x3B,
+        0x0E, 0x92, 0xDE, 0x81, 0x28, 0x91, 0xED, 0x61, 0x5F, 0x38, 0xF1, 0x4C, 0x11, 0x47, 0x89, 0xB0, 0xA4, 0x44, 0x78, 0x3A,
+        0xF1, 0x11, 0xE6, 0x94, 0x08, 0x5B, 0x96, 0x05, 0xFC, 0x02, 0xD2, 0x81, 0x2D, 0x0B, 0x4F, 0xA9, 0x30, 0x4D, 0x00, 0x00,
+        0x00, 0x00, 0x49, 0x45, 0x4E, 0x44, 0xAE, 0x42, 0x60, 0x82,
+    };
+
+    const uint8_t PALETTE_PNG[] = {
+        0x89, 0x50, 0x4E, 0x47, 0x0D, 0x0A, 0x1A, 0x0A, 0x00, 0x00, 0x00, 0x0D, 0x49, 0x48, 0x44, 0x52, 0x00, 0x00, 0x00, 0x0D,
+        0x00, 0x00, 0x00, 0x05, 0x04, 0x03, 0x00, 0x00, 0x00, 0x6C, 0x96, 0x7B, 0x22, 0x00, 0x00, 0x00, 0x15, 0x50, 0x4C, 0x54,
+        0x45, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x10, 0x11, 0x12,
+        0x13, 0x14, 0x4A, 0x5D, 0x44, 0xD1, 0x00, 0x00, 0x00, 0x03, 0x74, 0x52, 0x4E, 0x53, 0x00, 0x80, 0xFF, 0xEC, 0xF7, 0xB3,
+        0x18, 0x00, 0x00, 0x00, 0x2D, 0x49, 0x44, 0x41, 0x54, 0x78, 0xDA, 0x63, 0x60, 0x54, 0x76, 0x4D, 0x10, 0x32, 0x09, 0x60,
+        0x14, 0x52, 0x52, 0x5A, 0xAD, 0xA4, 0x24, 0xCD, 0x24, 0x28, 0xC8, 0x25, 0x28, 0x28, 0xB8, 0x80, 0x59, 0x59, 0x6A, 0x99,
+        0x94, 0x94, 0xF0, 0x03, 0x16, 0x30, 0x77, 0xA1, 0x3C, 0x00, 0x83, 0xA0, 0x06, 0xE1, 0xA8, 0xFB, 0xD3, 0x94, 0x00, 0x00,
+        0x00, 0x00, 0x49, 0x45, 0x4E, 0x44, 0xAE, 0x42, 0x60, 0x82,
+    };
+
+    const uint8_t GRAY16_PNG[] = {
+        0x89, 0x50, 0x4E, 0x47, 0x0D, 0x0A, 0x1A, 0x0A, 0x00, 0x00, 0x00, 0x0D, 0x49, 0x48, 0x44, 0x52, 0x00, 0x00, 0x00, 0x05,
+        0x00, 0x00, 0x00, 0x04, 0x10, 0x04, 0x00, 0x00, 0x00, 0xBC, 0xAA, 0xE1, 0x88, 0x00, 0x00, 0x00, 0x35, 0x49, 0x44, 0x41,
+        0x54, 0x78, 0xDA, 0x63, 0x60, 0x00, 0x02, 0xE6, 0x17, 0xC6, 0xC6, 0xEC, 0x17, 0xD2, 0xD2, 0xB8, 0x77, 0xCC, 0x9C, 0xC9,
+        0xBF, 0xE0, 0xCC, 0x19, 0x46, 0x06, 0x06, 0x01, 0x66, 0x90, 0x20, 0x0B, 0x12, 0x66, 0x02, 0x09, 0xA2, 0x63, 0x20, 0xA1,
+        0xC0, 0xC6, 0x54, 0xA2, 0x24, 0xCD, 0xF4, 0x05, 0x81, 0x01, 0x3A, 0x3C, 0x11, 0x62, 0xBA, 0x5C, 0xD7, 0x39, 0x00, 0x00,
+        0x00, 0x00, 0x49, 0x45, 0x4E, 0x44, 0xAE, 0x42, 0x60, 0x82,
+    };
+
+    const uint8_t FIXED_ZLIB[] = {
+        0x78, 0x01, 0x2B, 0x2E, 0x28, 0xCA, 0x2C, 0x49, 0x55, 0x28, 0x46, 0xA1, 0x92, 0x4B, 0x4B, 0x4A, 0x52, 0x8B, 0xD0, 0x04,
+        0x87, 0xA6, 0x1C, 0x00, 0x50, 0xB2, 0x56, 0xE1,
+    };
+
+    // Pixels of RGBA_PNG, 32x24, and of the other two files
+    uint8_t rgba_alpha(int x, int y) { return ((x >> 3) + (y >> 3)) % 3 == 0 ? uint8_t((x * 5 + y * 3) & 255) : 0; }
+    int palette_index(int x, int y) { return (x + y) % 7; }
+    uint16_t gray16_alpha(int x, int y) { return uint16_t(x * 13107 + y * 4099); }
+
+    std::vector<uint8_t> copy_of(const uint8_t* data, size_t size) { return std::vector<uint8_t>(data, data + size); }
+
+    // Decodes the whole file in strips of `rows`
+    bool read_all(const std::vector<uint8_t>& file, int rows, std::vector<uint8_t>& pixels, PngReader& png) {
+        if (!png.open(file.data(), file.size())) return false;
+        size_t pitch = size_t(png.get_width()) * spritecutter::pixel_size(png.get_format());
+        pixels.assign(pitch * png.get_height(), 0);
+        for (int y = 0; y < png.get_height(); y += rows) {
+            int n = rows < png.get_height() - y ? rows : png.get_height() - y;
+            if (!png.read_rows(n, pixels.data() + pitch * y, pitch)) return false;
+        }
+        return true;
+    }
+}
+
+TEST_CASE("png: inflate stored blocks and fixed codes") {
+    // Two stored blocks, the second one final, cut across spans at odd places
+    const uint8_t stored[] = { 0x00, 0x03, 0x00, 0xFC, 0xFF, 'a', 'b', 'c', 0x01, 0x05, 0x00, 0xFA, 0xFF, 'd', 'e', 'f', 'g', 'h' };
+    std::vector<spritecutter::ByteSpan> spans = { { stored, 4 }, { stored + 4, 0 }, { stored + 4, 9 }, { stored + 13, 5 } };
+    spritecutter::Inflater inflater;
+    REQUIRE(inflater.reset(&spans, false));
+    char out[16] = {};
+    CHECK(inflater.read(reinterpret_cast<uint8_t*>(out), 3) == 3);
+    CHECK(inflater.read(reinterpret_cast<uint8_t*>(out) + 3, 10) == 5);
+    CHECK(std::memcmp(out, "abcdefgh", 8) == 0);
+    CHECK(inflater.is_done());
+
+    // Matches reaching back into the window, read a few bytes at a time
+    std::vector<spritecutter::ByteSpan> fixed = { { FIXED_ZLIB, sizeof(FIXED_ZLIB) } };
+    REQUIRE(inflater.reset(&fixed, true));
+    std::string text;
+    uint8_t chunk[7];
+    long n;
+    while ((n = inflater.read(chunk, sizeof(chunk))) > 0) text.append(reinterpret_cast<char*>(chunk), size_t(n));
+    CHECK(n == 0);
+    std::string expected;
+    for (int i = 0; i < 8; ++i) expected += "sprite sprite sprite cutter ";
+    CHECK(text == expected);
+
+    // Bad zlib header, and a stream cut short
+    const uint8_t bad_header[] = { 0x78, 0x9D, 0x03, 0x00 };
+    std::vector<spritecutter::ByteSpan> bad = { { bad_header, sizeof(bad_header) } };
+    CHECK(!inflater.reset(&bad, true));
+    std::vector<spritecutter::ByteSpan> cut = { { FIXED_ZLIB, sizeof(FIXED_ZLIB) / 2 } };
+    REQUIRE(inflater.reset(&cut, true));
+    CHECK(inflater.read(chunk, sizeof(chunk)) >= 0);
+    while ((n = inflater.read(chunk, sizeof(chunk))) > 0) {}
+    CHECK(n == -1);
+}
+
+TEST_CASE("png: RGBA8 rows decode in any strip height") {
+    std::vector<uint8_t> file = copy_of(RGBA_PNG, sizeof(RGBA_PNG));
+    for (int rows : { 1, 5, 24 }) {
+        PngReader png;
+        std::vector<uint8_t> pixels;
+        REQUIRE(read_all(file, rows, pixels, png));
+        CHECK(png.get_width() == 32 && png.get_height() == 24);
+        CHECK(png.get_format() == spritecutter::FORMAT_RGBA8);
+
+        bool same = true;
+        for (int y = 0; y < 24; ++y)
+            for (int x = 0; x < 32; ++x) {
+                const uint8_t* p = pixels.data() + (size_t(y) * 32 + x) * 4;
+                same = same && p[0] == 0x40 && p[1] == 0x80 && p[2] == 0xC0 && p[3] == rgba_alpha(x, y);
+            }
+        CHECK(same);
+    }
+}
+
+TEST_CASE("png: palette and 16-bit alpha come out as LA8") {
+    PngReader png;
+    std::vector<uint8_t> pixels;
+    REQUIRE(read_all(copy_of(PALETTE_PNG, sizeof(PALETTE_PNG)), 2, pixels, png));
+    CHECK(png.get_format() == spritecutter::FORMAT_LA8);
+    const uint8_t trns[3] = { 0, 128, 255 };
+    bool same = true;
+    for (int y = 0; y < 5; ++y)
+        for (int x = 0; x < 13; ++x) {
+            int index = palette_index(x, y);
+            same = same && pixels[(size_t(y) * 13 + x) * 2 + 1] == (index < 3 ? trns[index] : 255);
+        }
+    CHECK(same);
+
+    REQUIRE(read_all(copy_of(GRAY16_PNG, sizeof(GRAY16_PNG)), 4, pixels, png));
+    CHECK(png.get_format() == spritecutter::FORMAT_LA8);
+    same = true;
+    for (int y = 0; y < 4; ++y)
+        for (int x = 0; x < 5; ++x)
+            same = same && pixels[(size_t(y) * 5 + x) * 2 + 1] == uint8_t((uint32_t(gray16_alpha(x, y)) * 255 + 32895) >> 16);
+    CHECK(same);
+}
+
+TEST_CASE("png: strips fill the mask like a whole buffer") {
+    PngReader png;
+    std::vector<uint8_t> file = copy_of(RGBA_PNG, sizeof(RGBA_PNG));
+    REQUIRE(png.open(file.data(), file.size()));
+
+    spritecutter::AlphaMask mask;
+    mask.reset(png.get_width(), png.get_height());
+    std::vector<uint8_t> strip(size_t(32) * 4 * 7);
+    for (int y = 0; y < 24; y += 7) {
+        int rows = y + 7 <= 24 ? 7 : 24 - y;
+        REQUIRE(png.read_rows(rows, strip.data(), size_t(32) * 4));
+        REQUIRE(mask.build_rows(spritecutter::PixelView::packed(strip.data(), 32, rows, png.get_format()), y, 16));
+    }
+    CHECK(!png.read_rows(1, strip.data(), size_t(32) * 4));
+
+    bool same = true;
+    for (int y = 0; y < 24; ++y)
+        for (int x = 0; x < 32; ++x) same = same && mask.is_set(x, y) == (rgba_alpha(x, y) > 16);
+    CHECK(same);
+
+    // Strips must fit the mask
+    spritecutter::PixelView view = spritecutter::PixelView::packed(strip.data(), 32, 7, spritecutter::FORMAT_RGBA8);
+    CHECK(!mask.build_rows(view, 20, 16));
+    CHECK(!mask.build_rows(spritecutter::PixelView::packed(strip.data(), 31, 1, spritecutter::FORMAT_RGBA8), 0, 16));
+}
+
+TEST_CASE("png: malformed and truncated files are rejected") {
+    PngReader png;
+    std::vector<uint8_t> pixels;
+    std::vector<uint8_t> file = copy_of(RGBA_PNG, sizeof(RGBA_PNG));
+    CHECK(!png.open(file.data(), 7));
+
+    std::vector<uint8_t> bad = file;
+    bad[1] = 'X';
+    CHECK(!png.open(bad.data(), bad.size()));
+
+    // Interlaced
+    bad = file;
+    bad[28] = 1;
+    CHECK(!png.open(bad.data(), bad.size()));
+
+    // Chunk length past the end of the file
+    CHECK(!png.open(file.data(), 100));
+
+    // Only the first of three IDAT chunks: the header parses, the rows run dry
+    std::vector<uint8_t> cut(file.begin(), file.begin() + 33 + 12 + 128);
+    CHECK(!read_all(cut, 4, pixels, png));
+
+    // Unknown row filter
+    std::vector<uint8_t> stored = { 0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A,
+        0, 0, 0, 13, 'I', 'H', 'D', 'R', 0, 0, 0, 1, 0, 0, 0, 1, 8, 4, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 14, 'I', 'D', 'A', 'T', 0x78, 0x01, 0x01, 0x03, 0x00, 0xFC, 0xFF, 7, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+    CHECK(!read_all(stored, 1, pixels, png));
+    stored[48] = 0;
+    CHECK(read_all(stored, 1, pixels, png));
+}
@@ -0,0 +1,107 @@
+#include <random>
+#include <vector>
+
+#include "PreviewAtlas.h"
+#include "TestFramework.h"
+
+using spritecutter::PixelView;
+using spritecutter::PreviewAtlas;
+using spritecutter::PreviewRect;
+using spritecutter::Region;
+
+namespace {
+    bool overlap(const PreviewRect& a, const PreviewRect& b) {
+        return a.x < b.x + b.w && b.x < a.x + a.w && a.y < b.y + b.h && b.y < a.y + a.h;
+    }
+
+    std::vector<Region> random_regions(std::mt19937& rng, int count, int w, int h) {
+        std::vector<Region> regions;
+        for (int i = 0; i < count; ++i) {
+            int rw = 1 + rng() % 300, rh = 1 + rng() % 300;
+            regions.push_back({ int(rng() % w), int(rng() % h), rw, rh, rw * rh });
+        }
+        return regions;
+    }
+}
+
+TEST_CASE("preview: fitted sizes keep the aspect and never enlarge") {
+    int w = 0, h = 0;
+    spritecutter::fit_thumbnail(200, 100, 64, w, h);
+    CHECK(w == 64 && h == 32);
+    spritecutter::fit_thumbnail(10, 300, 64, w, h);
+    CHECK(w == 2 && h == 64);
+    spritecutter::fit_thumbnail(20, 30, 64, w, h);
+    CHECK(w == 20 && h == 30);
+    spritecutter::fit_thumbnail(1000, 1, 64, w, h);
+    CHECK(w == 64 && h == 1);
+}
+
+TEST_CASE("preview: thumbnails are disjoint and inside the atlas") {
+    std::mt19937 rng(5);
+    const int w = 2048, h = 2048;
+    std::vector<uint8_t> rgba(size_t(w) * h * 4, 255);
+    PixelView view = PixelView::packed(rgba.data(), w, h, spritecutter::FORMAT_RGBA8);
+    std::vector<Region> regions = random_regions(rng, 500, w, h);
+
+    PreviewAtlas atlas;
+    REQUIRE(spritecutter::build_preview_atlas(view, regions, 48, size_t(64) << 20, atlas, spritecutter::thread_for(4), 4));
+    REQUIRE(atlas.rects.size() == regions.size());
+    CHECK(atlas.icon_size == 48);
+    CHECK(atlas.rgba.size() == size_t(atlas.width) * atlas.height * 4);
+
+    for (size_t i = 0; i < atlas.rects.size(); ++i) {
+        const PreviewRect& r = atlas.rects[i];
+        CHECK(r.w >= 1 && r.h >= 1 && r.w <= 48 && r.h <= 48);
+        CHECK(r.x >= 0 && r.y >= 0 && r.x + r.w <= atlas.width && r.y + r.h <= atlas.height);
+        for (size_t j = i + 1; j < atlas.rects.size(); ++j) CHECK(!overlap(r, atlas.rects[j]));
+    }
+}
+
+TEST_CASE("preview: the box filter averages covered pixels") {
+    // 4x2 checker of opaque white and transparent black, halved
+    const int w = 4, h = 2;
+    std::vector<uint8_t> rgba(size_t(w) * h * 4, 0);
+    for (int y = 0; y < h; ++y)
+        for (int x = 0; x < w; ++x) {
+            if ((x + y) & 1) continue;
+            uint8_t* p = &rgba[(size_t(y) * w + x) * 4];
+            p[0] = p[1] = p[2] = p[3] = 255;
+        }
+    PixelView view = PixelView::packed(rgba.data(), w, h, spritecutter::FORMAT_RGBA8);
+
+    uint8_t out[8] = {};
+    spritecutter::downscale_box(view, { 0, 0, 4, 2 }, out, 8, 2, 1);
+    for (int i = 0; i < 2; ++i) {
+        // Transparent pixels don't pull the color towards black
+        CHECK(out[i * 4] == 255 && out[i * 4 + 1] == 255 && out[i * 4 + 2] == 255);
+        CHECK(out[i * 4 + 3] == 128);
+    }
+
+    // Same size copies straight through
+    uint8_t copy[32] = {};
+    spritecutter::downscale_box(view, { 0, 0, 4, 2 }, copy, 16, 4, 2);
+    CHECK(std::vector<uint8_t>(copy, copy + 32) == rgba);
+}
+
+TEST_CASE("preview: the icon size drops to fit the budget") {
+    std::mt19937 rng(9);
+    const int w = 1024, h = 1024;
+    std::vector<uint8_t> rgba(size_t(w) * h * 4, 200);
+    PixelView view = PixelView::packed(rgba.data(), w, h, spritecutter::FORMAT_RGBA8);
+    std::vector<Region> regions = random_regions(rng, 300, w, h);
+    regions.push_back({ 5000, 5000, 10, 10, 100 });
+
+    PreviewAtlas full, small;
+    REQUIRE(spritecutter::build_preview_atlas(view, regions, 128, size_t(256) << 20, full));
+    REQUIRE(spritecutter::build_preview_atlas(view, regions, 128, 256 * 1024, small));
+    CHECK(full.icon_size == 128);
+    CHECK(small.icon_size < 128);
+    CHECK(small.rgba.size() <= 256 * 1024);
+
+    // Outside the image: no thumbnail, index kept
+    CHECK(small.rects.back().w == 0 && small.rects.back().h == 0);
+
+    spritecutter::SliceProgress progress;
+    progress.cancel();
+    CHECK(!spritecutter::build_preview_atlas(view, regions, 64, size_t(64) << 20, full, spritecutter::serial_for, 1, &progress));
+}
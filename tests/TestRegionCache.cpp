@@ -0,0 +1,148 @@
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "Hash.h"
+#include "RegionCache.h"
+#include "TestFramework.h"
+#include "TestRegions.h"
+
+using sctest::same_regions;
+
+namespace {
+    std::vector<spritecutter::Region> sample_regions(int n) {
+        std::vector<spritecutter::Region> regions;
+        for (int i = 0; i < n; ++i)
+            regions.push_back({ i * 37, i * 11, 10 + i, 20 + (i * 7) % 300, 100 + i * 1000 });
+        return regions;
+    }
+
+    spritecutter::CacheKey sample_key(uint64_t content) {
+        spritecutter::CacheKey key;
+        key.content = content;
+        key.min_pixels = 100;
+        key.merge_margin = 5.0f;
+        return key;
+    }
+
+    // Fresh directory under the system temp dir, removed on destruction
+    struct TempDir {
+        std::filesystem::path path;
+        explicit TempDir(const char* name) : path(std::filesystem::temp_directory_path() / name) {
+            std::filesystem::remove_all(path);
+        }
+        ~TempDir() { std::filesystem::remove_all(path); }
+    };
+}
+
+TEST_CASE("cache: XXH64 reference values") {
+    CHECK(spritecutter::hash_bytes(nullptr, 0) == 0xEF46DB3751D8E999ULL);
+    CHECK(spritecutter::hash_bytes("a", 1) == 0xD24EC4F1A98C6E5BULL);
+    CHECK(spritecutter::hash_bytes("abc", 3) == 0x44BC2CF5AD770999ULL);
+
+    // Long enough for the four-lane loop, and sensitive to a single bit
+    std::vector<uint8_t> bytes(1000, 7);
+    uint64_t h = spritecutter::hash_bytes(bytes.data(), bytes.size());
+    bytes[999] ^= 1;
+    CHECK(spritecutter::hash_bytes(bytes.data(), bytes.size()) != h);
+}
+
+TEST_CASE("cache: encoding round-trips and rejects damage") {
+    spritecutter::CacheKey key = sample_key(42);
+    key.alpha_threshold = 16;
+    std::vector<spritecutter::Region> regions = sample_regions(500);
+
+    std::vector<uint8_t> bytes;
+    spritecutter::encode_regions(key, regions, bytes);
+    CHECK(bytes.size() < regions.size() * sizeof(spritecutter::Region));
+
+    spritecutter::CacheKey read_key;
+    std::vector<spritecutter::Region> read;
+    REQUIRE(spritecutter::decode_regions(bytes.data(), bytes.size(), read_key, read));
+    CHECK(read_key == key);
+    CHECK(same_regions(read, regions));
+
+    std::vector<uint8_t> damaged = bytes;
+    damaged[damaged.size() / 2] ^= 0x10;
+    CHECK(!spritecutter::decode_regions(damaged.data(), damaged.size(), read_key, read));
+    CHECK(!spritecutter::decode_regions(bytes.data(), bytes.size() - 1, read_key, read));
+    CHECK(!spritecutter::decode_regions(bytes.data(), 3, read_key, read));
+}
+
+TEST_CASE("cache: parameters are part of the key") {
+    spritecutter::RegionCache cache;
+    spritecutter::CacheKey key = sample_key(1);
+    cache.insert(key, sample_regions(3));
+
+    std::vector<spritecutter::Region> out;
+    CHECK(cache.find(key, out) && out.size() == 3);
+
+    spritecutter::CacheKey other = key;
+    other.merge_margin = 6.0f;
+    CHECK(!cache.find(other, out));
+    other = key;
+    other.min_pixels = 50;
+    CHECK(!cache.find(other, out));
+    other = key;
+    other.alpha_threshold = 1;
+    CHECK(!cache.find(other, out));
+
+    cache.erase(key);
+    CHECK(!cache.find(key, out));
+}
+
+TEST_CASE("cache: memory budget evicts the least recently used") {
+    // Room for about two tables of 100 regions
+    spritecutter::RegionCache cache(2 * (100 * sizeof(spritecutter::Region) + 200), 0);
+    std::vector<spritecutter::Region> out;
+
+    cache.insert(sample_key(1), sample_regions(100));
+    cache.insert(sample_key(2), sample_regions(100));
+    CHECK(cache.find(sample_key(1), out));
+
+    // 2 is now the oldest and goes first
+    cache.insert(sample_key(3), sample_regions(100));
+    CHECK(cache.get_memory_entries() == 2);
+    CHECK(cache.find(sample_key(1), out));
+    CHECK(!cache.find(sample_key(2), out));
+    CHECK(cache.find(sample_key(3), out));
+}
+
+TEST_CASE("cache: disk entries survive a new cache and are capped") {
+    TempDir dir("spritecutter_test_cache");
+    std::vector<spritecutter::Region> regions = sample_regions(200);
+    std::vector<spritecutter::Region> out;
+    {
+        spritecutter::RegionCache cache;
+        REQUIRE(cache.open(dir.path.u8string()));
+        cache.insert(sample_key(1), regions);
+        cache.insert(sample_key(2), regions);
+        CHECK(cache.get_disk_entries() == 2);
+    }
+
+    // A new session finds both tables on disk
+    spritecutter::RegionCache cache;
+    REQUIRE(cache.open(dir.path.u8string()));
+    CHECK(cache.get_disk_entries() == 2);
+    CHECK(cache.find(sample_key(2), out) && same_regions(out, regions));
+    CHECK(cache.get_memory_entries() == 1);
+
+    // Shrinking the disk budget below two files keeps only the most recent one
+    size_t one_file = cache.get_disk_size() / 2;
+    cache.set_budgets(spritecutter::RegionCache::DEFAULT_MEMORY_BUDGET, one_file + one_file / 2);
+    CHECK(cache.get_disk_entries() == 1);
+
+    // A corrupted file is a miss, and is deleted
+    cache.clear();
+    cache.insert(sample_key(3), regions);
+    cache.set_budgets(0, spritecutter::RegionCache::DEFAULT_DISK_BUDGET);
+    for (const auto& entry : std::filesystem::directory_iterator(dir.path)) {
+        std::fstream file(entry.path(), std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(20);
+        file.put('\x7f');
+    }
+    CHECK(!cache.find(sample_key(3), out));
+    CHECK(cache.get_disk_entries() == 0);
+    CHECK(std::filesystem::is_empty(dir.path));
+}
@@ -0,0 +1,365 @@
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "RegionLabeller.h"
+#include "RegionMerger.h"
+#include "Slicer.h"
+#include "TestFramework.h"
+#include "TestRegions.h"
+
+using spritecutter::AlphaMask;
+using spritecutter::PixelView;
+using spritecutter::Region;
+using sctest::same_regions;
+
+namespace {
+    AlphaMask to_mask(const std::vector<uint8_t>& opaque, int w, int h) {
+        // LA8 with the luminance byte left at 0
+        std::vector<uint8_t> la(opaque.size() * 2, 0);
+        for (size_t i = 0; i < opaque.size(); ++i) la[i * 2 + 1] = opaque[i] ? 255 : 0;
+
+        AlphaMask mask;
+        mask.build(PixelView::packed(la.data(), w, h, spritecutter::FORMAT_LA8));
+        return mask;
+    }
+
+    // The labeller's oracle, see label_regions_reference()
+    std::vector<Region> flood_fill(const std::vector<uint8_t>& opaque, int w, int h, int min_pixels) {
+        std::vector<Region> out;
+        spritecutter::label_regions_reference(to_mask(opaque, w, h), min_pixels, out);
+        return out;
+    }
+
+    // Random blobs, rings and diagonal strokes, with specks in between
+    std::vector<uint8_t> random_sheet(std::mt19937& rng, int w, int h, int shapes) {
+        std::vector<uint8_t> opaque(size_t(w) * h, 0);
+        for (int s = 0; s < shapes; ++s) {
+            int cx = rng() % w, cy = rng() % h;
+            int r = 1 + rng() % 24;
+            int kind = rng() % 3;
+            for (int y = std::max(0, cy - r); y <= std::min(h - 1, cy + r); ++y) {
+                for (int x = std::max(0, cx - r); x <= std::min(w - 1, cx + r); ++x) {
+                    int d2 = (x - cx) * (x - cx) + (y - cy) * (y - cy);
+                    bool on = kind == 0 ? d2 <= r * r
+                        : kind == 1 ? (d2 <= r * r && d2 >= (r - 2) * (r - 2))
+                        : (x - cx) == (y - cy);
+                    if (on) opaque[size_t(y) * w + x] = 1;
+                }
+            }
+        }
+        for (int i = 0; i < w * h / 50; ++i) opaque[rng() % opaque.size()] = 1;
+        return opaque;
+    }
+}
+
+TEST_CASE("label: diagonal contact and pixel floor") {
+    const int w = 8, h = 4;
+    std::vector<uint8_t> opaque = {
+        1, 0, 0, 0, 0, 0, 1, 1,
+        0, 1, 0, 0, 0, 0, 1, 1,
+        0, 0, 1, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 1, 0, 0, 0,
+    };
+    AlphaMask mask = to_mask(opaque, w, h);
+
+    spritecutter::LabelOptions options;
+    options.min_pixels = 1;
+    std::vector<Region> regions;
+    spritecutter::label_regions(mask, options, regions);
+
+    std::vector<Region> expected = { { 0, 0, 3, 3, 3 }, { 6, 0, 2, 2, 4 }, { 4, 3, 1, 1, 1 } };
+    CHECK(same_regions(regions, expected));
+
+    options.min_pixels = 4;
+    regions.clear();
+    spritecutter::label_regions(mask, options, regions);
+    CHECK(regions.size() == 1 && regions[0].count == 4);
+}
+
+TEST_CASE("label: matches flood fill") {
+    std::mt19937 rng(11);
+    for (int round = 0; round < 20; ++round) {
+        int w = 1 + rng() % 300, h = 1 + rng() % 200;
+        std::vector<uint8_t> opaque = random_sheet(rng, w, h, 1 + rng() % 40);
+        AlphaMask mask = to_mask(opaque, w, h);
+
+        spritecutter::LabelOptions options;
+        options.min_pixels = int(rng() % 30);
+        std::vector<Region> regions;
+        spritecutter::label_regions(mask, options, regions);
+        CHECK(same_regions(regions, flood_fill(opaque, w, h, options.min_pixels)));
+    }
+}
+
+TEST_CASE("label: tiling does not change the result") {
+    std::mt19937 rng(5);
+    const int w = 640, h = 480;
+    std::vector<uint8_t> opaque = random_sheet(rng, w, h, 400);
+    AlphaMask mask = to_mask(opaque, w, h);
+
+    spritecutter::LabelOptions options;
+    options.min_pixels = 1;
+    std::vector<Region> serial;
+    spritecutter::label_regions(mask, options, serial);
+
+    // One-row tiles put a seam between every pair of rows
+    for (int rows : { 1, 7, 64 }) {
+        options.threads = 8;
+        options.min_tile_rows = rows;
+        std::vector<Region> tiled;
+        spritecutter::label_regions(mask, options, tiled, spritecutter::thread_for(4));
+        CHECK(same_regions(tiled, serial));
+    }
+}
+
+TEST_CASE("label: workspaces allocate nothing until used") {
+    // The runtime slicer builds a spare mask and workspaces when its own are busy
+    size_t before = sctest::allocations();
+    {
+        AlphaMask mask;
+        spritecutter::LabelWorkspace labelling;
+        spritecutter::MergeWorkspace merging;
+        std::vector<Region> regions;
+    }
+    CHECK(sctest::allocations() == before);
+}
+
+TEST_CASE("label: a warm workspace allocates nothing") {
+    std::mt19937 rng(37);
+    const int w = 300, h = 200;
+    AlphaMask mask = to_mask(random_sheet(rng, w, h, 80), w, h);
+
+    spritecutter::LabelOptions options;
+    options.min_pixels = 1;
+    std::vector<Region> expected;
+    spritecutter::label_regions(mask, options, expected);
+
+    // Tiled calls and a smaller mask leave the workspace reusable
+    spritecutter::LabelWorkspace workspace;
+    std::vector<Region> regions;
+    options.threads = 8;
+    options.min_tile_rows = 7;
+    spritecutter::label_regions(mask, options, regions, workspace, spritecutter::thread_for(4));
+    CHECK(same_regions(regions, expected));
+    std::vector<uint8_t> small = random_sheet(rng, 90, 40, 10);
+    regions.clear();
+    spritecutter::label_regions(to_mask(small, 90, 40), options, regions, workspace);
+    CHECK(same_regions(regions, flood_fill(small, 90, 40, 1)));
+
+    options.threads = 1;
+    regions.clear();
+    spritecutter::label_regions(mask, options, regions, workspace);
+    regions.clear();
+    size_t before = sctest::allocations();
+    spritecutter::label_regions(mask, options, regions, workspace);
+    CHECK(sctest::allocations() == before);
+    CHECK(same_regions(regions, expected));
+}
+
+TEST_CASE("label: incremental matches a full labelling after edits") {
+    std::mt19937 rng(17);
+    const int w = 400, h = 300;
+    std::vector<uint8_t> opaque = random_sheet(rng, w, h, 150);
+
+    spritecutter::LabelOptions options;
+    options.min_pixels = 5;
+    spritecutter::IncrementalLabeller labeller(16);
+
+    for (int edit = 0; edit < 30; ++edit) {
+        AlphaMask mask = to_mask(opaque, w, h);
+        std::vector<Region> full, incremental;
+        spritecutter::label_regions(mask, options, full);
+        labeller.label(mask, options, incremental);
+        CHECK(same_regions(incremental, full));
+
+        // Only the first call and the bands under the edit are relabelled
+        int span = 1 + int(rng() % 24);
+        int ex = int(rng() % (w - span)), ey = int(rng() % (h - span));
+        if (edit == 0) CHECK(labeller.get_relabelled_count() == labeller.get_band_count());
+        else CHECK(labeller.get_relabelled_count() <= 3);
+
+        // Paint or erase a square, often across a band seam, sometimes joining components
+        uint8_t value = rng() % 2;
+        for (int y = ey; y < ey + span; ++y)
+            for (int x = ex; x < ex + span; ++x) opaque[size_t(y) * w + x] = value;
+    }
+
+    // A threaded call on an unchanged mask relabels nothing and still agrees
+    AlphaMask mask = to_mask(opaque, w, h);
+    std::vector<Region> full, incremental;
+    spritecutter::label_regions(mask, options, full);
+    labeller.label(mask, options, incremental);
+    options.threads = 4;
+    incremental.clear();
+    labeller.label(mask, options, incremental, spritecutter::thread_for(4));
+    CHECK(labeller.get_relabelled_count() == 0);
+    CHECK(same_regions(incremental, full));
+}
+
+TEST_CASE("label: incremental survives size changes and cancellation") {
+    std::mt19937 rng(23);
+    spritecutter::LabelOptions options;
+    options.min_pixels = 1;
+    spritecutter::IncrementalLabeller labeller(7);
+
+    std::vector<uint8_t> small = random_sheet(rng, 90, 50, 20);
+    std::vector<Region> regions;
+    labeller.label(to_mask(small, 90, 50), options, regions);
+
+    // Another size starts over
+    std::vector<uint8_t> big = random_sheet(rng, 130, 75, 30);
+    AlphaMask mask = to_mask(big, 130, 75);
+    regions.clear();
+    labeller.label(mask, options, regions);
+    CHECK(labeller.get_relabelled_count() == labeller.get_band_count());
+    CHECK(same_regions(regions, flood_fill(big, 130, 75, 1)));
+
+    // A cancelled call keeps the stored bands of the previous mask
+    for (int x = 0; x < 130; ++x) big[size_t(40) * 130 + x] = 1;
+    AlphaMask edited = to_mask(big, 130, 75);
+    spritecutter::SliceProgress cancelled;
+    cancelled.cancel();
+    regions.clear();
+    labeller.label(edited, options, regions, spritecutter::serial_for, &cancelled);
+    CHECK(regions.empty());
+
+    labeller.label(edited, options, regions);
+    CHECK(labeller.get_relabelled_count() == 1);
+    CHECK(same_regions(regions, flood_fill(big, 130, 75, 1)));
+}
+
+TEST_CASE("label: strips match the whole mask") {
+    std::mt19937 rng(29);
+    for (int round = 0; round < 12; ++round) {
+        int w = 1 + rng() % 260, h = 1 + rng() % 180;
+        std::vector<uint8_t> opaque = random_sheet(rng, w, h, 1 + rng() % 40);
+        std::vector<uint8_t> la(opaque.size() * 2, 0);
+        for (size_t i = 0; i < opaque.size(); ++i) la[i * 2 + 1] = opaque[i] ? 255 : 0;
+
+        spritecutter::LabelOptions options;
+        options.min_pixels = int(rng() % 20);
+        std::vector<Region> whole;
+        spritecutter::label_regions(to_mask(opaque, w, h), options, whole);
+
+        // Each strip is copied out, so nothing outside it can be read
+        std::vector<uint8_t> strip;
+        spritecutter::StripReader read = [&](int y0, int rows, PixelView& view) {
+            strip.assign(la.begin() + size_t(y0) * w * 2, la.begin() + size_t(y0 + rows) * w * 2);
+            view = PixelView::packed(strip.data(), w, rows, spritecutter::FORMAT_LA8);
+            return true;
+        };
+        for (int rows : { 1, 2, 17, h }) {
+            std::vector<Region> strips;
+            REQUIRE(spritecutter::label_strips(w, h, rows, read, 0, options, strips));
+            CHECK(same_regions(strips, whole));
+        }
+    }
+}
+
+TEST_CASE("slice: strips within a budget match the in-memory pipeline") {
+    std::mt19937 rng(31);
+    const int w = 700, h = 500;
+    std::vector<uint8_t> opaque = random_sheet(rng, w, h, 200);
+    std::vector<uint8_t> rgba(opaque.size() * 4, 0);
+    for (size_t i = 0; i < opaque.size(); ++i) rgba[i * 4 + 3] = opaque[i] ? 200 : 0;
+
+    spritecutter::SliceOptions options;
+    std::vector<Region> whole;
+    REQUIRE(spritecutter::slice_pixels(PixelView::packed(rgba.data(), w, h, spritecutter::FORMAT_RGBA8), options, whole));
+
+    // About 10 rows per strip, and never more than that handed out at once
+    options.memory_budget = 10 * (w * 4 + (w + 63) / 64 * 8);
+    CHECK(spritecutter::strip_rows_for_budget(w, 4, options.memory_budget) == 10);
+    int largest = 0;
+    spritecutter::StripReader read = [&](int y0, int rows, PixelView& view) {
+        largest = std::max(largest, rows);
+        view = PixelView::packed(&rgba[size_t(y0) * w * 4], w, rows, spritecutter::FORMAT_RGBA8);
+        return true;
+    };
+    std::vector<Region> strips;
+    spritecutter::SliceProgress progress;
+    REQUIRE(spritecutter::slice_strips(w, h, spritecutter::FORMAT_RGBA8, read, options, strips, &progress));
+    CHECK(largest == 10);
+    CHECK(progress.get() == 1.0f);
+    CHECK(same_regions(strips, whole));
+
+    // Read errors and malformed strips stop the slice
+    spritecutter::StripReader failing = [&](int y0, int rows, PixelView& view) { return y0 < 100 && read(y0, rows, view); };
+    CHECK(!spritecutter::slice_strips(w, h, spritecutter::FORMAT_RGBA8, failing, options, strips));
+    spritecutter::StripReader short_rows = [&](int y0, int rows, PixelView& view) { return read(y0, rows - 1, view); };
+    CHECK(!spritecutter::slice_strips(w, h, spritecutter::FORMAT_RGBA8, short_rows, options, strips));
+}
+
+TEST_CASE("slice: pipeline matches its stages") {
+    std::mt19937 rng(3);
+    const int w = 512, h = 256;
+    std::vector<uint8_t> opaque = random_sheet(rng, w, h, 120);
+    std::vector<uint8_t> rgba(opaque.size() * 4, 0);
+    for (size_t i = 0; i < opaque.size(); ++i) rgba[i * 4 + 3] = opaque[i] ? 200 : 0;
+
+    spritecutter::SliceOptions options;
+    options.threads = 4;
+    std::vector<Region> sliced;
+    spritecutter::SliceProgress progress;
+    REQUIRE(spritecutter::slice_pixels(PixelView::packed(rgba.data(), w, h, spritecutter::FORMAT_RGBA8),
+        options, sliced, spritecutter::thread_for(4), &progress));
+    CHECK(progress.get() == 1.0f);
+
+    std::vector<Region> expected = flood_fill(opaque, w, h, options.min_pixels);
+    expected.resize(spritecutter::merge_regions_reference(expected.data(), expected.size(), options.merge_margin));
+    CHECK(same_regions(sliced, expected));
+
+    // A cancelled run reports failure
+    spritecutter::SliceProgress cancelled;
+    cancelled.cancel();
+    CHECK(!spritecutter::slice_pixels(PixelView::packed(rgba.data(), w, h, spritecutter::FORMAT_RGBA8),
+        options, sliced, spritecutter::serial_for, &cancelled));
+}
+
+TEST_CASE("slice: stats count pixels, components and merges") {
+    // Two blocks 2 px apart merge, the third stays alone
+    const int w = 64, h = 32;
+    std::vector<uint8_t> rgba(size_t(w) * h * 4, 0);
+    for (int bx : { 2, 16, 45 }) {
+        for (int y = 2; y < 14; ++y)
+            for (int x = bx; x < bx + 12; ++x) rgba[(size_t(y) * w + x) * 4 + 3] = 255;
+    }
+
+    spritecutter::SliceOptions options;
+    std::vector<Region> regions;
+    spritecutter::SliceStats stats;
+    REQUIRE(spritecutter::slice_pixels(PixelView::packed(rgba.data(), w, h, spritecutter::FORMAT_RGBA8),
+        options, regions, spritecutter::serial_for, nullptr, &stats));
+    CHECK(regions.size() == 2);
+    CHECK(stats.pixels_scanned == uint64_t(w) * h);
+    CHECK(stats.components == 3);
+    CHECK(stats.merges == 1);
+    CHECK(stats.peak_scratch_bytes >= size_t(h) * sizeof(uint64_t));
+    CHECK(stats.total_usec() == stats.stage_usec[spritecutter::STAGE_LABEL] + stats.stage_usec[spritecutter::STAGE_MERGE]);
+
+    // The strip path counts the same, its scratch is one strip
+    options.memory_budget = 4 * (w * 4 + 8);
+    spritecutter::StripReader read = [&](int y0, int rows, PixelView& view) {
+        view = PixelView::packed(&rgba[size_t(y0) * w * 4], w, rows, spritecutter::FORMAT_RGBA8);
+        return true;
+    };
+    spritecutter::SliceStats strip_stats;
+    REQUIRE(spritecutter::slice_strips(w, h, spritecutter::FORMAT_RGBA8, read, options, regions, nullptr, &strip_stats));
+    CHECK(regions.size() == 2);
+    CHECK(strip_stats.pixels_scanned == stats.pixels_scanned);
+    CHECK(strip_stats.components == 3);
+    CHECK(strip_stats.merges == 1);
+    CHECK(strip_stats.peak_scratch_bytes == options.memory_budget);
+
+    // A timer without stats measures nothing, a stopped one stops adding
+    { spritecutter::StageTimer idle(nullptr, spritecutter::STAGE_FETCH); }
+    spritecutter::SliceStats timed;
+    spritecutter::StageTimer timer(&timed, spritecutter::STAGE_FETCH);
+    timer.stop();
+    uint64_t once = timed.stage_usec[spritecutter::STAGE_FETCH];
+    timer.stop();
+    CHECK(timed.stage_usec[spritecutter::STAGE_FETCH] == once);
+    CHECK(std::string(spritecutter::stage_name(spritecutter::STAGE_POPULATE)) == "populate");
+}
@@ -0,0 +1,153 @@
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "RegionMerger.h"
+#include "TestFramework.h"
+#include "TestRegions.h"
+
+using spritecutter::Region;
+using sctest::same_regions;
+
+namespace {
+    constexpr float MARGIN = 5.0f;
+
+    std::vector<Region> merged(std::vector<Region> r, bool reference) {
+        size_t n = reference
+            ? spritecutter::merge_regions_reference(r.data(), r.size(), MARGIN)
+            : spritecutter::merge_regions(r.data(), r.size(), MARGIN);
+        r.resize(n);
+        return r;
+    }
+
+    // Sprites, particles and specks scattered over a w x h sheet
+    std::vector<Region> generate(std::mt19937& rng, size_t count, int w, int h, int x_offset) {
+        std::vector<Region> out;
+        out.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            int kind = rng() % 10;
+            int rw = kind == 0 ? 40 + rng() % 200 : (kind < 4 ? 8 + rng() % 30 : 1 + rng() % 6);
+            int rh = kind == 0 ? 40 + rng() % 200 : (kind < 4 ? 8 + rng() % 30 : 1 + rng() % 6);
+            rw = std::min(rw, w / 2);
+            rh = std::min(rh, h / 2);
+            int x = x_offset + rng() % (w - rw);
+            int y = rng() % (h - rh);
+            out.push_back({ x, y, rw, rh, 1 + int(rng() % (rw * rh)) });
+        }
+        return out;
+    }
+}
+
+TEST_CASE("merge: empty and single region") {
+    CHECK(merged({}, false).empty());
+
+    std::vector<Region> one = { { 3, 4, 5, 6, 7 } };
+    CHECK(same_regions(merged(one, false), one));
+}
+
+TEST_CASE("merge: margin boundary") {
+    // 5 px gap: grown box ends exactly on the neighbour, no merge
+    std::vector<Region> apart = { { 0, 0, 10, 10, 100 }, { 15, 0, 10, 10, 100 } };
+    CHECK(merged(apart, false).size() == 2);
+
+    // 4 px gap: merge
+    std::vector<Region> close = { { 0, 0, 10, 10, 100 }, { 14, 0, 10, 10, 100 } };
+    std::vector<Region> r = merged(close, false);
+    REQUIRE(r.size() == 1);
+    CHECK(r[0].x == 0 && r[0].w == 24 && r[0].count == 200);
+}
+
+TEST_CASE("merge: cascades through grown boxes") {
+    // The merged box of the first two reaches the third, which none of them touched alone
+    std::vector<Region> chain = {
+        { 0, 0, 10, 10, 1 }, { 12, 30, 10, 10, 1 }, { 8, 12, 2, 16, 1 }, { 30, 20, 4, 4, 1 },
+    };
+    CHECK(same_regions(merged(chain, false), merged(chain, true)));
+}
+
+TEST_CASE("merge: matches reference on random sheets") {
+    std::mt19937 rng(1234);
+    for (int it = 0; it < 200; ++it) {
+        size_t count = 1 + rng() % 400;
+        int size = 64 + rng() % 2000;
+        std::vector<Region> r = generate(rng, count, size, size, 0);
+        CHECK(same_regions(merged(r, false), merged(r, true)));
+    }
+}
+
+TEST_CASE("merge: a warm workspace allocates nothing") {
+    std::mt19937 rng(13);
+    spritecutter::MergeWorkspace workspace;
+    std::vector<Region> input = generate(rng, 2000, 2048, 2048, 0);
+    std::vector<Region> expected = merged(input, true);
+
+    // A larger call first, then the same input twice
+    std::vector<Region> big = generate(rng, 5000, 4096, 4096, 0);
+    big.resize(spritecutter::merge_regions(big.data(), big.size(), MARGIN, workspace));
+    std::vector<Region> r = input;
+    r.resize(spritecutter::merge_regions(r.data(), r.size(), MARGIN, workspace));
+    CHECK(same_regions(r, expected));
+
+    r = input;
+    size_t before = sctest::allocations();
+    r.resize(spritecutter::merge_regions(r.data(), r.size(), MARGIN, workspace));
+    CHECK(sctest::allocations() == before);
+    CHECK(same_regions(r, expected));
+}
+
+TEST_CASE("merge: 50k region stress against reference") {
+    // The reference restarts its O(n²) scan after every merge, which is out of reach
+    // at 50k regions. The sheet is therefore laid out as strips separated on X by far
+    // more than the margin: no merge crosses a strip, X-sorting keeps each strip
+    // contiguous, so the reference result is the concatenation of per-strip results.
+    constexpr int STRIPS = 100;
+    constexpr int PER_STRIP = 500;
+    constexpr int STRIP_W = 1200;
+    constexpr int STRIP_GAP = 100;
+
+    std::mt19937 rng(42);
+    std::vector<std::vector<Region>> strips;
+    std::vector<Region> expected;
+    for (int s = 0; s < STRIPS; ++s) {
+        strips.push_back(generate(rng, PER_STRIP, STRIP_W, 4096, s * (STRIP_W + STRIP_GAP)));
+
+        std::vector<Region> ref = merged(strips.back(), true);
+        expected.insert(expected.end(), ref.begin(), ref.end());
+    }
+
+    // Feed the strips in shuffled order so the fast path can't rely on input order.
+    // Within a strip the order is kept, since it breaks ties between equal X.
+    std::shuffle(strips.begin(), strips.end(), rng);
+    std::vector<Region> all;
+    for (const std::vector<Region>& strip : strips)
+        all.insert(all.end(), strip.begin(), strip.end());
+
+    REQUIRE(all.size() == size_t(STRIPS * PER_STRIP));
+    std::vector<Region> got = merged(all, false);
+    CHECK(got.size() == expected.size());
+    CHECK(same_regions(got, expected));
+}
+
+TEST_CASE("merge: long chains against reference") {
+    // Each box only reaches its neighbour, so the merged box grows one step at a
+    // time across the whole sheet: the case the X-separated strips above never hit.
+    constexpr int CHAIN = 5000;
+    std::vector<Region> row, column, stairs;
+    for (int i = 0; i < CHAIN; ++i) {
+        row.push_back({ i * 12, 0, 10, 10, 100 });
+        column.push_back({ 0, i * 12, 10, 10, 100 });
+        stairs.push_back({ i * 12, i * 12, 10, 10, 100 });
+    }
+
+    // Shuffled, so the chain isn't already in X order
+    std::mt19937 rng(7);
+    std::shuffle(row.begin(), row.end(), rng);
+    std::shuffle(stairs.begin(), stairs.end(), rng);
+
+    for (const std::vector<Region>* chain : { &row, &column, &stairs }) {
+        std::vector<Region> r = merged(*chain, false);
+        REQUIRE(r.size() == 1);
+        CHECK(r[0].count == CHAIN * 100);
+        CHECK(same_regions(r, merged(*chain, true)));
+    }
+}
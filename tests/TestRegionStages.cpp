@@ -0,0 +1,84 @@
+#include <vector>
+
+#include "AlphaMask.h"
+#include "RegionLabeller.h"
+#include "RegionStages.h"
+#include "SheetGenerator.h"
+#include "Slicer.h"
+#include "TestFramework.h"
+#include "TestRegions.h"
+
+using spritecutter::PixelView;
+using spritecutter::Region;
+using sctest::same_regions;
+
+TEST_CASE("stages: match the full pipeline for every floor and margin") {
+    // Tight gaps and specks, so both parameters change the result
+    spritecutter::SheetSpec spec;
+    spec.width = 600;
+    spec.height = 400;
+    spec.sprites = 60;
+    spec.specks = 300;
+    spec.gap = 3;
+    std::vector<uint8_t> px;
+    REQUIRE(spritecutter::generate_sheet(spec, px) > 0);
+    PixelView view = PixelView::packed(px.data(), spec.width, spec.height, spritecutter::FORMAT_RGBA8);
+
+    spritecutter::AlphaMask mask;
+    REQUIRE(mask.build(view, 0));
+    spritecutter::LabelOptions every;
+    every.min_pixels = 1;
+    std::vector<Region> components;
+    spritecutter::label_regions(mask, every, components);
+
+    spritecutter::RegionStages stages;
+    stages.set_components(components);
+    for (int min_pixels : { 1, 20, 100, 400 }) {
+        for (float margin : { 0.0f, 2.0f, 5.0f, 12.5f }) {
+            spritecutter::SliceOptions options;
+            options.min_pixels = min_pixels;
+            options.merge_margin = margin;
+            std::vector<Region> expected;
+            REQUIRE(spritecutter::slice_pixels(view, options, expected));
+
+            stages.set_min_pixels(min_pixels);
+            stages.set_merge_margin(margin);
+            CHECK(same_regions(stages.get_regions(), expected));
+        }
+    }
+}
+
+TEST_CASE("stages: only the stages after a change run again") {
+    std::vector<Region> components = { { 0, 0, 10, 10, 100 }, { 12, 0, 10, 10, 100 }, { 40, 0, 2, 2, 4 } };
+
+    spritecutter::RegionStages stages;
+    stages.set_components(components);
+    stages.set_min_pixels(50);
+    stages.set_merge_margin(5.0f);
+    CHECK(stages.is_stale());
+
+    spritecutter::SliceStats stats;
+    CHECK(stages.get_regions(&stats).size() == 1);
+    CHECK(stats.components == 2);
+    CHECK(stats.merges == 1);
+    CHECK(!stages.is_stale());
+
+    // Same values: nothing runs, the counters stay
+    stages.set_min_pixels(50);
+    stages.set_merge_margin(5.0f);
+    CHECK(!stages.is_stale());
+    stages.get_regions(&stats);
+    CHECK(stats.components == 2);
+
+    // A smaller margin keeps the two sprites apart, the speck stays filtered
+    stages.set_merge_margin(1.0f);
+    CHECK(stages.get_regions().size() == 2);
+
+    // A lower floor lets the speck through
+    stages.set_min_pixels(1);
+    CHECK(stages.get_regions().size() == 3);
+
+    stages.clear();
+    CHECK(stages.get_regions().empty());
+    CHECK(stages.get_components().empty());
+}
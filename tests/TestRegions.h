@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "SliceTypes.h"
+
+/**
+ * Region comparisons shared by the tests and the differential harness.
+ */
+namespace sctest {
+
+    /**
+     * @brief True if both regions have the same box and pixel count.
+     */
+    inline bool same_region(const spritecutter::Region& a, const spritecutter::Region& b) {
+        return a.x == b.x && a.y == b.y && a.w == b.w && a.h == b.h && a.count == b.count;
+    }
+
+    /**
+     * @brief True if both lists hold the same regions in the same order.
+     */
+    inline bool same_regions(const std::vector<spritecutter::Region>& a, const std::vector<spritecutter::Region>& b) {
+        if (a.size() != b.size()) return false;
+        for (size_t i = 0; i < a.size(); ++i) {
+            if (!same_region(a[i], b[i])) return false;
+        }
+        return true;
+    }
+}
@@ -0,0 +1,53 @@
+#include <vector>
+
+#include "SheetGenerator.h"
+#include "Slicer.h"
+#include "TestFramework.h"
+
+TEST_CASE("generator: same spec, same pixels") {
+    spritecutter::SheetSpec spec;
+    spec.width = 300;
+    spec.height = 200;
+    spec.sprites = 40;
+    spec.specks = 100;
+
+    std::vector<uint8_t> a, b;
+    CHECK(spritecutter::generate_sheet(spec, a) == 40);
+    CHECK(spritecutter::generate_sheet(spec, b) == 40);
+    CHECK(a == b);
+
+    spec.seed = 2;
+    spritecutter::generate_sheet(spec, b);
+    CHECK(a != b);
+}
+
+TEST_CASE("generator: gaps keep sprites apart") {
+    // Rectangles wider than the merge margin apart each come out as one region
+    spritecutter::SheetSpec spec;
+    spec.width = 1024;
+    spec.height = 512;
+    spec.sprites = 50;
+    spec.shape = spritecutter::SHAPE_RECT;
+    spec.gap = 8;
+
+    std::vector<uint8_t> px;
+    int placed = spritecutter::generate_sheet(spec, px);
+    REQUIRE(placed == 50);
+
+    spritecutter::SliceOptions options;
+    options.min_pixels = 1;
+    std::vector<spritecutter::Region> regions;
+    REQUIRE(spritecutter::slice_pixels(spritecutter::PixelView::packed(px.data(), spec.width, spec.height, spritecutter::FORMAT_RGBA8), options, regions));
+    CHECK(int(regions.size()) == placed);
+}
+
+TEST_CASE("generator: invalid specs and shape names") {
+    spritecutter::SheetSpec spec;
+    spec.width = 0;
+    std::vector<uint8_t> px;
+    CHECK(spritecutter::generate_sheet(spec, px) == -1);
+
+    spritecutter::SpriteShape shape;
+    CHECK(spritecutter::parse_sprite_shape("blob", shape) && shape == spritecutter::SHAPE_BLOB);
+    CHECK(!spritecutter::parse_sprite_shape("star", shape));
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cctype>
+#include <cstdlib>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Just enough JSON to read back the result files spritecutter_bench writes.
+ *
+ * Numbers, strings, bools, null, arrays and objects. No unicode escapes.
+ */
+namespace benchjson {
+
+    struct Value {
+        enum Type { NUL, BOOL, NUMBER, STRING, ARRAY, OBJECT };
+
+        Type type = NUL;
+        bool b = false;
+        double number = 0.0;
+        std::string str;
+        std::vector<Value> items;
+        std::vector<std::pair<std::string, Value>> members;
+
+        // Member lookup, nullptr if missing or not an object
+        const Value* get(const std::string& key) const {
+            if (type != OBJECT) return nullptr;
+            for (const auto& m : members)
+                if (m.first == key) return &m.second;
+            return nullptr;
+        }
+    };
+
+    class Parser {
+        public:
+            explicit Parser(const std::string& text) : s(text) {}
+
+            bool parse(Value& out) {
+                if (!value(out)) return false;
+                skip();
+                return pos == s.size();
+            }
+
+        private:
+            void skip() {
+                while (pos < s.size() && std::isspace((unsigned char)s[pos])) ++pos;
+            }
+
+            bool literal(const char* word) {
+                size_t n = std::char_traits<char>::length(word);
+                if (s.compare(pos, n, word) != 0) return false;
+                pos += n;
+                return true;
+            }
+
+            bool string(std::string& out) {
+                if (s[pos] != '"') return false;
+                ++pos;
+                while (pos < s.size() && s[pos] != '"') {
+                    char c = s[pos++];
+                    if (c == '\\' && pos < s.size()) {
+                        char e = s[pos++];
+                        c = e == 'n' ? '\n' : e == 't' ? '\t' : e;
+                    }
+                    out.push_back(c);
+                }
+                if (pos >= s.size()) return false;
+                ++pos;
+                return true;
+            }
+
+            bool value(Value& v) {
+                skip();
+                if (pos >= s.size()) return false;
+
+                char c = s[pos];
+                if (c == '{') {
+                    v.type = Value::OBJECT;
+                    ++pos;
+                    skip();
+                    if (pos < s.size() && s[pos] == '}') { ++pos; return true; }
+                    for (;;) {
+                        skip();
+                        std::pair<std::string, Value> m;
+                        if (pos >= s.size() || !string(m.first)) return false;
+                        skip();
+                        if (pos >= s.size() || s[pos++] != ':') return false;
+                        if (!value(m.second)) return false;
+                        v.members.push_back(std::move(m));
+                        skip();
+                        if (pos >= s.size()) return false;
+                        if (s[pos] == ',') { ++pos; continue; }
+                        if (s[pos] == '}') { ++pos; return true; }
+                        return false;
+                    }
+                }
+                if (c == '[') {
+                    v.type = Value::ARRAY;
+                    ++pos;
+                    skip();
+                    if (pos < s.size() && s[pos] == ']') { ++pos; return true; }
+                    for (;;) {
+                        Value item;
+                        if (!value(item)) return false;
+                        v.items.push_back(std::move(item));
+                        skip();
+                        if (pos >= s.size()) return false;
+                        if (s[pos] == ',') { ++pos; continue; }
+                        if (s[pos] == ']') { ++pos; return true; }
+                        return false;
+                    }
+                }
+                if (c == '"') {
+                    v.type = Value::STRING;
+                    return string(v.str);
+                }
+                if (literal("true")) { v.type = Value::BOOL; v.b = true; return true; }
+                if (literal("false")) { v.type = Value::BOOL; return true; }
+                if (literal("null")) return true;
+
+                const char* start = s.c_str() + pos;
+                char* end = nullptr;
+                v.number = std::strtod(start, &end);
+                if (end == start) return false;
+                v.type = Value::NUMBER;
+                pos += size_t(end - start);
+                return true;
+            }
+
+            const std::string& s;
+            size_t pos = 0;
+    };
+}
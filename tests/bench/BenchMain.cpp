@@ -0,0 +1,312 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "AlphaMask.h"
+#include "BenchJson.h"
+#include "RegionLabeller.h"
+#include "RegionMerger.h"
+#include "SheetGenerator.h"
+#include "Slicer.h"
+
+using spritecutter::AlphaMask;
+using spritecutter::PixelView;
+using spritecutter::Region;
+
+namespace {
+    // Pipeline stages timed by the native bench, in report order
+    const char* const STAGES[] = { "mask", "label", "merge", "total" };
+    constexpr int STAGE_COUNT = 4;
+
+    // Regressions smaller than this are noise whatever the ratio
+    constexpr double NOISE_FLOOR_MS = 0.1;
+
+    struct Args {
+        std::string suite;
+        spritecutter::SheetSpec spec;
+        bool custom = false;
+        int iterations = 10;
+        int threads = 0;
+        int isa = -1;
+        std::string json_path;
+        std::string compare_path;
+        double tolerance = 0.10;
+    };
+
+    struct CaseResult {
+        std::string name;
+        spritecutter::SheetSpec spec;
+        int placed = 0;
+        size_t regions = 0;
+        double median_ms[STAGE_COUNT] = {};
+        double min_ms[STAGE_COUNT] = {};
+    };
+
+    void usage() {
+        std::printf(
+            "usage: spritecutter_bench [--suite quick|full] [sheet options] [run options]\n"
+            "  Slices synthetic RGBA8 sheets and reports the median time of each stage.\n"
+            "sheet options (a single custom sheet instead of the suite):\n"
+            "  --size WxH      up to 16384x16384\n"
+            "  --sprites N     --shape rect|disc|blob|mixed   --specks N   --gap N   --cell N   --seed N\n"
+            "run options:\n"
+            "  --iterations N  --threads N  --isa scalar|sse2|avx2\n"
+            "  --json FILE     write the results as JSON\n"
+            "  --compare FILE  flag stages slower than a saved result file, exit 1 on regression\n"
+            "  --tolerance F   allowed slowdown before flagging, 0.10 = 10%% (default)\n");
+    }
+
+    bool parse(int argc, char** argv, Args& args) {
+        for (int i = 1; i < argc; ++i) {
+            const char* a = argv[i];
+            const char* v = i + 1 < argc ? argv[i + 1] : nullptr;
+            if (!v) return false;
+
+            if (!std::strcmp(a, "--suite")) {
+                args.suite = v;
+                if (args.suite != "quick" && args.suite != "full") return false;
+            } else if (!std::strcmp(a, "--size")) {
+                if (std::sscanf(v, "%dx%d", &args.spec.width, &args.spec.height) != 2) return false;
+                args.custom = true;
+            } else if (!std::strcmp(a, "--sprites")) {
+                args.spec.sprites = std::atoi(v);
+                args.custom = true;
+            } else if (!std::strcmp(a, "--shape")) {
+                if (!spritecutter::parse_sprite_shape(v, args.spec.shape)) return false;
+                args.custom = true;
+            } else if (!std::strcmp(a, "--specks")) {
+                args.spec.specks = std::atoi(v);
+                args.custom = true;
+            } else if (!std::strcmp(a, "--gap")) {
+                args.spec.gap = std::atoi(v);
+                args.custom = true;
+            } else if (!std::strcmp(a, "--cell")) {
+                args.spec.cell = std::atoi(v);
+                args.custom = true;
+            } else if (!std::strcmp(a, "--seed")) {
+                args.spec.seed = uint32_t(std::strtoul(v, nullptr, 10));
+                args.custom = true;
+            } else if (!std::strcmp(a, "--iterations")) {
+                args.iterations = std::max(1, std::atoi(v));
+            } else if (!std::strcmp(a, "--threads")) {
+                args.threads = std::atoi(v);
+            } else if (!std::strcmp(a, "--isa")) {
+                args.isa = !std::strcmp(v, "scalar") ? AlphaMask::ISA_SCALAR
+                    : !std::strcmp(v, "sse2") ? AlphaMask::ISA_SSE2
+                    : !std::strcmp(v, "avx2") ? AlphaMask::ISA_AVX2 : -2;
+                if (args.isa == -2) return false;
+            } else if (!std::strcmp(a, "--json")) {
+                args.json_path = v;
+            } else if (!std::strcmp(a, "--compare")) {
+                args.compare_path = v;
+            } else if (!std::strcmp(a, "--tolerance")) {
+                args.tolerance = std::atof(v);
+            } else {
+                return false;
+            }
+            ++i;
+        }
+
+        // A custom sheet replaces the suite
+        const spritecutter::SheetSpec& s = args.spec;
+        return s.width > 0 && s.height > 0 && s.width <= 16384 && s.height <= 16384 && !(args.custom && !args.suite.empty());
+    }
+
+    double now_ms() {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    const char* isa_name(AlphaMask::Isa isa) {
+        return isa == AlphaMask::ISA_AVX2 ? "avx2" : isa == AlphaMask::ISA_SSE2 ? "sse2" : "scalar";
+    }
+
+    // Times the mask, label and merge stages separately, then the whole pipeline
+    CaseResult run_case(const spritecutter::SheetCase& sheet, int iterations, int threads) {
+        CaseResult result;
+        result.name = sheet.name;
+        result.spec = sheet.spec;
+
+        std::vector<uint8_t> px;
+        result.placed = spritecutter::generate_sheet(sheet.spec, px);
+        PixelView view = PixelView::packed(px.data(), sheet.spec.width, sheet.spec.height, spritecutter::FORMAT_RGBA8);
+
+        spritecutter::SliceOptions options;
+        options.threads = threads;
+        spritecutter::ParallelFor parallel_for = spritecutter::thread_for(threads);
+
+        spritecutter::LabelOptions label;
+        label.min_pixels = options.min_pixels;
+        label.min_tile_rows = options.min_tile_rows;
+        label.threads = options.threads;
+
+        std::vector<double> samples[STAGE_COUNT];
+        for (int it = 0; it < iterations; ++it) {
+            double t0 = now_ms();
+            AlphaMask mask;
+            mask.build(view, options.alpha_threshold);
+            double t1 = now_ms();
+            std::vector<Region> regions;
+            spritecutter::label_regions(mask, label, regions, parallel_for);
+            double t2 = now_ms();
+            spritecutter::merge_regions(regions.data(), regions.size(), options.merge_margin);
+            double t3 = now_ms();
+
+            std::vector<Region> sliced;
+            spritecutter::slice_pixels(view, options, sliced, parallel_for);
+            double t4 = now_ms();
+            result.regions = sliced.size();
+
+            samples[0].push_back(t1 - t0);
+            samples[1].push_back(t2 - t1);
+            samples[2].push_back(t3 - t2);
+            samples[3].push_back(t4 - t3);
+        }
+
+        for (int s = 0; s < STAGE_COUNT; ++s) {
+            std::sort(samples[s].begin(), samples[s].end());
+            result.median_ms[s] = samples[s][samples[s].size() / 2];
+            result.min_ms[s] = samples[s].front();
+        }
+        return result;
+    }
+
+    void print_case(const CaseResult& r) {
+        double mp = double(r.spec.width) * r.spec.height / 1e6;
+        std::printf("%-18s %5dx%-5d %6d sprites %6zu regions |", r.name.c_str(), r.spec.width, r.spec.height, r.placed, r.regions);
+        for (int s = 0; s < STAGE_COUNT; ++s) std::printf(" %s %8.3f", STAGES[s], r.median_ms[s]);
+        std::printf(" ms | %7.1f MP/s\n", mp / (r.median_ms[STAGE_COUNT - 1] / 1000.0));
+    }
+
+    bool write_json(const std::string& path, const std::vector<CaseResult>& results, int threads, int iterations) {
+        std::ofstream out(path);
+        if (!out) return false;
+
+        out << "{\n";
+        out << "\t\"tool\": \"spritecutter_bench\",\n";
+        out << "\t\"isa\": \"" << isa_name(AlphaMask::get_isa()) << "\",\n";
+        out << "\t\"threads\": " << threads << ",\n";
+        out << "\t\"iterations\": " << iterations << ",\n";
+        out << "\t\"cases\": [\n";
+        for (size_t i = 0; i < results.size(); ++i) {
+            const CaseResult& r = results[i];
+            out << "\t\t{\n";
+            out << "\t\t\t\"name\": \"" << r.name << "\",\n";
+            out << "\t\t\t\"width\": " << r.spec.width << ", \"height\": " << r.spec.height
+                << ", \"sprites\": " << r.spec.sprites << ", \"shape\": \"" << spritecutter::sprite_shape_name(r.spec.shape)
+                << "\", \"specks\": " << r.spec.specks << ", \"gap\": " << r.spec.gap << ", \"cell\": " << r.spec.cell << ", \"seed\": " << r.spec.seed << ",\n";
+            out << "\t\t\t\"regions\": " << r.regions << ",\n";
+
+            // Medians are compared, minimums help spot noisy runs
+            const char* keys[] = { "stages", "stages_min" };
+            const double* values[] = { r.median_ms, r.min_ms };
+            for (int k = 0; k < 2; ++k) {
+                out << "\t\t\t\"" << keys[k] << "\": {";
+                for (int s = 0; s < STAGE_COUNT; ++s) {
+                    char num[32];
+                    std::snprintf(num, sizeof(num), "%.4f", values[k][s]);
+                    out << (s ? ", " : " ") << "\"" << STAGES[s] << "\": " << num;
+                }
+                out << " }" << (k == 0 ? "," : "") << "\n";
+            }
+            out << "\t\t}" << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        out << "\t]\n}\n";
+        return bool(out);
+    }
+
+    // Prints a line per stage present in both runs, returns the number of regressions
+    int compare(const std::string& path, const std::vector<CaseResult>& results, double tolerance) {
+        std::ifstream in(path);
+        if (!in) {
+            std::fprintf(stderr, "can't read baseline %s\n", path.c_str());
+            return -1;
+        }
+        std::stringstream text;
+        text << in.rdbuf();
+
+        benchjson::Value base;
+        if (!benchjson::Parser(text.str()).parse(base) || !base.get("cases")) {
+            std::fprintf(stderr, "malformed baseline %s\n", path.c_str());
+            return -1;
+        }
+
+        std::printf("\ncompared with %s (tolerance %.0f%%)\n", path.c_str(), tolerance * 100.0);
+        int regressions = 0;
+        for (const CaseResult& r : results) {
+            const benchjson::Value* old_case = nullptr;
+            for (const benchjson::Value& c : base.get("cases")->items) {
+                const benchjson::Value* name = c.get("name");
+                if (name && name->str == r.name) old_case = &c;
+            }
+            if (!old_case) {
+                std::printf("%-18s not in baseline\n", r.name.c_str());
+                continue;
+            }
+
+            // Not a timing regression, but a behaviour change worth a look
+            const benchjson::Value* regions = old_case->get("regions");
+            if (regions && size_t(regions->number) != r.regions)
+                std::printf("%-18s region count changed: %zu -> %zu\n", r.name.c_str(), size_t(regions->number), r.regions);
+
+            const benchjson::Value* stages = old_case->get("stages");
+            for (int s = 0; s < STAGE_COUNT && stages; ++s) {
+                const benchjson::Value* old_ms = stages->get(STAGES[s]);
+                if (!old_ms || old_ms->type != benchjson::Value::NUMBER) continue;
+
+                double before = old_ms->number, after = r.median_ms[s];
+                double change = before > 0.0 ? after / before - 1.0 : 0.0;
+                bool slower = change > tolerance && after - before > NOISE_FLOOR_MS;
+                regressions += slower ? 1 : 0;
+                std::printf("%-18s %-6s %9.3f -> %9.3f ms  %+6.1f%%%s\n", r.name.c_str(), STAGES[s], before, after,
+                    change * 100.0, slower ? "  REGRESSION" : "");
+            }
+        }
+        std::printf("%d regression(s)\n", regressions);
+        return regressions;
+    }
+}
+
+int main(int argc, char** argv) {
+    Args args;
+    if (!parse(argc, argv, args)) {
+        usage();
+        return 2;
+    }
+    if (args.isa >= 0) AlphaMask::set_isa(AlphaMask::Isa(args.isa));
+    int threads = args.threads > 0 ? args.threads : std::max(1, (int)std::thread::hardware_concurrency());
+
+    std::vector<spritecutter::SheetCase> cases;
+    if (args.custom) {
+        char name[64];
+        std::snprintf(name, sizeof(name), "%dx%d-%s", args.spec.width, args.spec.height, spritecutter::sprite_shape_name(args.spec.shape));
+        cases.push_back({ name, args.spec });
+    } else {
+        cases = spritecutter::standard_sheets(args.suite == "full");
+    }
+
+    std::printf("%d threads, %s, %d iterations\n", threads, isa_name(AlphaMask::get_isa()), args.iterations);
+    std::vector<CaseResult> results;
+    for (const spritecutter::SheetCase& c : cases) {
+        results.push_back(run_case(c, args.iterations, threads));
+        print_case(results.back());
+    }
+
+    if (!args.json_path.empty() && !write_json(args.json_path, results, threads, args.iterations)) {
+        std::fprintf(stderr, "can't write %s\n", args.json_path.c_str());
+        return 2;
+    }
+
+    if (!args.compare_path.empty()) {
+        int regressions = compare(args.compare_path, results, args.tolerance);
+        if (regressions < 0) return 2;
+        if (regressions > 0) return 1;
+    }
+    return 0;
+}
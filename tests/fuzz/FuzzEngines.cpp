@@ -0,0 +1,28 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "Differential.h"
+
+/**
+ * libFuzzer entry point: every input is a sheet and engine parameters, see
+ * difftest::sheet_from_bytes(). Any disagreement between engines aborts, memory
+ * and undefined-behaviour errors are caught by the sanitizers it is built with.
+ *
+ *   scons -C tests fuzz
+ *   tests/bin/spritecutter_fuzz -max_len=4096 tests/fuzz/corpus
+ */
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    difftest::Sheet sheet;
+    difftest::EngineParams params;
+    if (!difftest::sheet_from_bytes(data, size, sheet, params)) return 0;
+
+    std::string why = difftest::compare_engines(sheet, params);
+    if (!why.empty()) {
+        std::fprintf(stderr, "%dx%d sheet: %s\n", sheet.width, sheet.height, why.c_str());
+        std::abort();
+    }
+    return 0;
+}